@@ -82,6 +82,11 @@ public:
 
 	void processNextBuffer();
 
+	// write audio rendered by the audio engine without taking it from
+	// nextBuffer(), e.g. the output of a single track or several periods
+	// at once, _frames can be more than a period
+	void processBuffer( const surroundSampleFrame * _ab, const fpp_t _frames );
+
 	virtual void startProcessing()
 	{
 		m_inProcess = true;
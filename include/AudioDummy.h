@@ -94,7 +94,8 @@ private:
 		while( true )
 		{
 			timer.reset();
-			const surroundSampleFrame* b = audioEngine()->nextBuffer();
+			fpp_t frames = 0;
+			const surroundSampleFrame* b = audioEngine()->nextBuffer( &frames );
 			if( !b )
 			{
 				break;
@@ -104,7 +105,7 @@ private:
 				delete[] b;
 			}
 
-			const int microseconds = static_cast<int>( audioEngine()->framesPerPeriod() * 1000000.0f / audioEngine()->processingSampleRate() - timer.elapsed() );
+			const int microseconds = static_cast<int>( frames * 1000000.0f / audioEngine()->processingSampleRate() - timer.elapsed() );
 			if( microseconds > 0 )
 			{
 				usleep( microseconds );
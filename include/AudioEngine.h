@@ -27,6 +27,10 @@
 
 #include <QMutex>
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
 #if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
 	#include <QRecursiveMutex>
 #endif
@@ -41,6 +45,8 @@
 #include "LocklessList.h"
 #include "FifoBuffer.h"
 #include "AudioEngineProfiler.h"
+#include "AudioThreadSettings.h"
+#include "EventCount.h"
 #include "PlayHandle.h"
 
 
@@ -51,10 +57,12 @@ class AudioDevice;
 class MidiClient;
 class AudioPort;
 class AudioEngineWorkerThread;
+class Track;
 
 
 const fpp_t MINIMUM_BUFFER_SIZE = 32;
 const fpp_t DEFAULT_BUFFER_SIZE = 256;
+const fpp_t MAXIMUM_BUFFER_SIZE = 4096;
 
 const int BYTES_PER_SAMPLE = sizeof( sample_t );
 const int BYTES_PER_INT_SAMPLE = sizeof( int_sample_t );
@@ -223,14 +231,26 @@ public:
 
 
 	// audio-port-stuff
-	inline void addAudioPort(AudioPort * port)
+	//! Neither function stops the render thread. removeAudioPort() returns
+	//! once the render thread can't be using the port anymore.
+	void addAudioPort(AudioPort * port);
+	void removeAudioPort(AudioPort * port);
+
+	//! Has to be called whenever audio ports or mixer channels are added,
+	//! removed or re-routed, or the latency of a plugin changed. The render
+	//! graph is then recompiled at the start of the next period.
+	void invalidateRenderGraph()
 	{
-		requestChangeInModel();
-		m_audioPorts.push_back(port);
-		doneChangeInModel();
+		m_renderGraphDirty = true;
 	}
 
-	void removeAudioPort(AudioPort * port);
+	//! Frames the master output lags behind the song position because of
+	//! the latency of plugins, which delay compensation keeps the same for
+	//! all tracks. Doesn't include the latency of the audio device.
+	f_cnt_t latency() const
+	{
+		return m_latency;
+	}
 
 
 	// MIDI-client-stuff
@@ -264,6 +284,19 @@ public:
 		return m_framesPerPeriod;
 	}
 
+	//! Upper limit of framesPerPeriod(). Buffers kept across periods have
+	//! to be this long, as the period can change while playing. Larger
+	//! buffer sizes are rendered as several periods of this length.
+	inline fpp_t maxFramesPerPeriod() const
+	{
+		return DEFAULT_BUFFER_SIZE;
+	}
+
+	//! Changes the buffer size without restarting the audio device. The
+	//! new period length applies from the next period on, framesPerPeriodChanged()
+	//! is emitted before that period starts.
+	void setFramesPerPeriod( fpp_t frames );
+
 
 	AudioEngineProfiler& profiler()
 	{
@@ -340,17 +373,41 @@ public:
 		return m_inputBufferFrames[ m_inputBufferRead ];
 	}
 
-	inline const surroundSampleFrame * nextBuffer()
-	{
-		return hasFifoWriter() ? m_fifo->read() : renderNextBuffer();
-	}
+	//! The next rendered period, with its length stored in @p frames if
+	//! given. Periods rendered ahead keep the length they were rendered with.
+	const surroundSampleFrame * nextBuffer( fpp_t * frames = nullptr );
+
+	//! Live input or editing is going on: keep the latency at the device
+	//! period for a while. What has been rendered ahead gets dropped and
+	//! the song returns to where the first dropped period started, see
+	//! rewindRenderAhead(). Ignored when called by the render thread itself.
+	void markLiveActivity();
+	//! Drops the periods that have been rendered ahead but not played yet,
+	//! e.g. because the song position jumped
+	void invalidateRenderAhead();
 
 	void changeQuality(const struct qualitySettings & qs);
 
 	inline bool isMetronomeActive() const { return m_metronomeActive; }
 	inline void setMetronomeActive(bool value = true) { m_metronomeActive = value; }
 
+	//! Counts render periods, odd while one is in progress. Data the render
+	//! thread may still use can be freed once isRenderPeriodOver() returns
+	//! true for the epoch at the time the data was replaced.
+	std::uint64_t renderEpoch() const
+	{
+		return m_renderEpoch.load();
+	}
+
+	bool isRenderPeriodOver( std::uint64_t epoch ) const
+	{
+		// replaced outside of a period, or that period is over
+		return epoch % 2 == 0 || epoch != m_renderEpoch.load();
+	}
+
 	//! Block until a change in model can be done (i.e. wait for audio thread)
+	//! Audio ports and play handles don't need this, see addAudioPort(),
+	//! removeAudioPort(), removePlayHandle() and removePlayHandlesOfTypes()
 	void requestChangeInModel();
 	void doneChangeInModel();
 
@@ -366,11 +423,38 @@ public:
 signals:
 	void qualitySettingsChanged();
 	void sampleRateChanged();
+	//! Emitted while the render thread is paused. Slots connected directly
+	//! can reconfigure anything depending on framesPerPeriod().
+	void framesPerPeriodChanged();
 	void nextAudioBuffer( const lmms::surroundSampleFrame * buffer );
 
 
+private slots:
+	//! Grows the delay lines of latency compensation that were too short
+	//! when compiling the render graph
+	void reserveLatencyCompensation();
+
+
 private:
-	using Fifo = FifoBuffer<surroundSampleFrame*>;
+	struct RenderedPeriod
+	{
+		surroundSampleFrame * buffer;
+		fpp_t frames;
+		// generation of m_renderAheadState when the period was rendered
+		unsigned int generation;
+		std::uint32_t sequence;
+	} ;
+	//! Where in the song a period that may be rendered ahead started
+	struct PeriodStart
+	{
+		std::uint32_t sequence;
+		unsigned int generation;
+		int playMode;
+		tick_t ticks;
+		float currentFrame;
+		fpp_t frames;
+	} ;
+	using Fifo = FifoBuffer<RenderedPeriod>;
 
 	class fifoWriter : public QThread
 	{
@@ -387,7 +471,7 @@ private:
 
 		void run() override;
 
-		void write( surroundSampleFrame * buffer );
+		void write( const RenderedPeriod & period );
 	} ;
 
 
@@ -410,13 +494,80 @@ private:
 
 	void clearInternal();
 
+	using AudioPortList = std::vector<AudioPort *>;
+
+	//! Updates the dependency counts between audio ports and mixer channels
+	void compileRenderGraph( const AudioPortList & ports );
+
+	//! Request from another thread to take play handles out of the render
+	//! thread's list. Applied at the start of the next period.
+	struct PlayHandleRemoval
+	{
+		PlayHandle * handle;	// single handle, or nullptr for all handles
+		std::uint64_t id;		// of handle, in case its memory got reused
+		const Track * track;	// of track with one of types
+		AudioPort * port;		// of track, if it has one
+		quint8 types;
+		bool deleteHandle;		// delete/release in the render thread
+		bool async;				// nobody waits, the render thread deletes the request
+		bool removed;
+		std::atomic_bool done;
+		PlayHandleRemoval * next;
+	} ;
+
+	void postPlayHandleRemoval( PlayHandleRemoval * removal );
+	void waitForPlayHandleRemoval( const PlayHandleRemoval & removal );
+	void applyPlayHandleRemovals();
+	//! Moves the play handles added since the last period to m_playHandles
+	void adoptNewPlayHandles();
+	void deletePlayHandle( PlayHandle * handle );
+	//! Deletes the play handles of @p track with one of @p types. Only
+	//! looks at the handles of @p port, all of them if it's nullptr.
+	bool deletePlayHandlesOfTrack( const Track * track, AudioPort * port, quint8 types );
+
+	//! Whether the calling thread can't run into the render thread, i.e. is
+	//! the render thread, holds requestChangeInModel() or nothing renders
+	bool canChangeModelDirectly() const;
+	//! Waits until the render thread has finished the period it is in, if
+	//! any. Returns immediately in the render thread itself.
+	void waitForRenderPeriod();
+	void freeRetiredAudioPorts();
+
+	//! Number of periods the fifo writer may currently render ahead
+	int renderAheadDepth() const;
+	//! Called by the fifo writer before the song is processed. Drops the
+	//! periods not played yet if markLiveActivity() asked for it and moves
+	//! the song back to where the first of them started, so they get
+	//! rendered again instead of being skipped. Then records where the
+	//! coming period starts.
+	void rewindRenderAhead();
+
+	static unsigned int renderAheadGeneration( std::uint64_t state )
+	{
+		return static_cast<unsigned int>( state >> 32 );
+	}
+
 	//! Called by the audio thread to give control to other threads,
 	//! such that they can do changes in the model (like e.g. removing effects)
 	void runChangesInModel();
 
 	bool m_renderOnly;
 
-	QVector<AudioPort *> m_audioPorts;
+	// audio ports as seen by the render thread. Writers publish a modified
+	// copy; replaced lists are freed once no period can be using them.
+	std::atomic<const AudioPortList *> m_audioPorts;
+	std::vector<std::pair<const AudioPortList *, std::uint64_t>> m_retiredAudioPorts;
+	QMutex m_audioPortsWriteMutex;
+	std::atomic_bool m_renderGraphDirty;
+	// list the render graph was compiled for, which isn't freed before
+	// another one has been compiled, so no new list can get its address
+	std::atomic<const AudioPortList *> m_compiledAudioPorts;
+
+	// odd while the render thread is inside a period
+	std::atomic<std::uint64_t> m_renderEpoch;
+	// notified whenever the render thread made progress other threads
+	// could be waiting for
+	EventCount m_renderProgress;
 
 	fpp_t m_framesPerPeriod;
 
@@ -430,6 +581,7 @@ private:
 	surroundSampleFrame * m_outputBufferWrite;
 
 	// worker thread stuff
+	AudioThreadSettings m_threadSettings;
 	QVector<AudioEngineWorkerThread *> m_workers;
 	int m_numWorkers;
 
@@ -437,7 +589,7 @@ private:
 	PlayHandleList m_playHandles;
 	// place where new playhandles are added temporarily
 	LocklessList<PlayHandle *> m_newPlayHandles;
-	ConstPlayHandleList m_playHandlesToRemove;
+	std::atomic<PlayHandleRemoval *> m_playHandleRemovals;
 
 
 	struct qualitySettings m_qualitySettings;
@@ -459,6 +611,25 @@ private:
 	// FIFO stuff
 	Fifo * m_fifo;
 	fifoWriter * m_fifoWriter;
+	// fifo depth requested by the buffer size setting
+	int m_liveFifoDepth;
+	// fifo depth while nothing is played or edited live
+	int m_renderAheadDepth;
+	// generation in the upper 32 bits, bumped whenever queued periods
+	// become stale, and in the lower ones the sequence number of the last
+	// period handed to the audio device. Changed together, so a period
+	// can't be played while the generation is bumped.
+	std::atomic<std::uint64_t> m_renderAheadState;
+	// set by markLiveActivity(), see rewindRenderAhead()
+	std::atomic_bool m_renderAheadRewind;
+	// start of the periods that may still be in the fifo, by sequence
+	// number. Only used by the fifo writer.
+	std::vector<PeriodStart> m_periodStarts;
+	std::uint32_t m_periodSequence;
+	// plugin latency of the master output, see latency()
+	std::atomic<f_cnt_t> m_latency;
+	// steady clock time of the last live activity in milliseconds
+	std::atomic<std::int64_t> m_lastLiveActivity;
 
 	AudioEngineProfiler m_profiler;
 
@@ -483,6 +654,7 @@ private:
 	friend class Engine;
 	friend class AudioEngineWorkerThread;
 	friend class ProjectRenderer;
+	friend class TrackFreezer;
 } ;
 
 } // namespace lmms
@@ -44,19 +44,28 @@ public:
 		m_periodTimer.reset();
 	}
 
-	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod );
+	//! @param schedulingTime time in microseconds the worker threads spent
+	//! on distributing jobs during this period
+	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod, int schedulingTime = 0 );
 
 	int cpuLoad() const
 	{
 		return m_cpuLoad;
 	}
 
+	//! Smoothed per-period job scheduling overhead in microseconds
+	int schedulingOverhead() const
+	{
+		return m_schedulingOverhead;
+	}
+
 	void setOutputFile( const QString& outputFile );
 
 
 private:
 	MicroTimer m_periodTimer;
 	int m_cpuLoad;
+	int m_schedulingOverhead;
 	QFile m_outputFile;
 };
 
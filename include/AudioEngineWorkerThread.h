@@ -28,8 +28,12 @@
 #include <QThread>
 
 #include <atomic>
+#include <memory>
+#include <vector>
 
-class QWaitCondition;
+#include "AudioThreadSettings.h"
+#include "EventCount.h"
+#include "WorkStealingQueue.h"
 
 namespace lmms
 {
@@ -42,38 +46,74 @@ class AudioEngineWorkerThread : public QThread
 	Q_OBJECT
 public:
 	// internal representation of the job queue - all functions are thread-safe
+	//
+	// Every thread taking part in processing (the worker threads plus the
+	// thread calling startAndWaitForJobs()) owns a work-stealing deque.
+	// Jobs are pushed onto the deque of the thread that adds them and idle
+	// threads steal from the others, so nobody has to scan the whole queue.
+	//
+	// Idle threads spin for a while and then sleep. Only as many of them
+	// are woken as there are new jobs.
 	class JobQueue
 	{
 	public:
 		enum OperationMode
 		{
-			Static,	// no jobs added while processing queue
-			Dynamic	// jobs can be added while processing queue
+			Static,	// no jobs added while processing queue, workers are
+					// woken by startAndWaitForJobs()
+			Dynamic	// jobs can be added while processing queue, each
+					// new job wakes a worker
 		} ;
 
 		static constexpr size_t JOB_QUEUE_SIZE = 8192;
 
 		JobQueue() :
-			m_items(),
-			m_writeIndex( 0 ),
+			m_queues(),
+			m_itemsQueued( 0 ),
 			m_itemsDone( 0 ),
-			m_opMode( Static )
+			m_opMode( Static ),
+			m_schedulingTime( 0 )
 		{
-			std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
 		}
 
+		// creates the deque for another participating thread and returns its index
+		int addThread();
+
 		void reset( OperationMode _opMode );
 
 		void addJob( ThreadableJob * _job );
 
+		//! Processes jobs until none are left to take
 		void run();
+		//! Processes jobs until all queued jobs are done
 		void wait();
+		//! Spins and then sleeps until jobs are available or @p quit is set
+		void park( const std::atomic_bool & quit );
+
+		//! Wakes sleeping threads for the jobs queued so far
+		void wakeWorkers();
+		//! Wakes all sleeping threads, e.g. to let them quit
+		void wakeAll();
+
+		//! Time in microseconds all threads spent looking for jobs instead
+		//! of processing them since the last call
+		int takeSchedulingTime();
 
 	private:
-		std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
-		std::atomic_int m_writeIndex;
+		ThreadableJob * takeJob( int self );
+		void finishJob();
+		bool hasJobs() const;
+		int currentQueue() const;
+
+		std::vector<std::unique_ptr<WorkStealingQueue<ThreadableJob *>>> m_queues;
+		std::atomic_int m_itemsQueued;
 		std::atomic_int m_itemsDone;
 		OperationMode m_opMode;
+		std::atomic<std::int64_t> m_schedulingTime;
+		// workers sleep here while there are no jobs
+		EventCount m_jobsAvailable;
+		// the thread in wait() sleeps here until the last job is done
+		EventCount m_allDone;
 	} ;
 
 
@@ -108,15 +148,24 @@ public:
 
 	static void startAndWaitForJobs();
 
+	static int takeSchedulingTime()
+	{
+		return globalJobQueue.takeSchedulingTime();
+	}
+
+	//! Whether the calling thread is one of the worker threads
+	static bool isWorkerThread();
+
 
 private:
 	void run() override;
 
 	static JobQueue globalJobQueue;
-	static QWaitCondition * queueReadyWaitCond;
 	static QList<AudioEngineWorkerThread *> workerThreads;
 
-	volatile bool m_quit;
+	int m_queueIndex;
+	AudioThreadSettings m_threadSettings;
+	std::atomic_bool m_quit;
 } ;
 
 } // namespace lmms
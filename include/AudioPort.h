@@ -25,10 +25,12 @@
 #ifndef AUDIO_PORT_H
 #define AUDIO_PORT_H
 
+#include <atomic>
 #include <memory>
 #include <QString>
 #include <QMutex>
 
+#include "LatencyCompensator.h"
 #include "MemoryManager.h"
 #include "PlayHandle.h"
 
@@ -36,6 +38,7 @@ namespace lmms
 {
 
 class EffectChain;
+class MixerChannel;
 class FloatModel;
 class BoolModel;
 
@@ -53,6 +56,42 @@ public:
 		return m_portBuffer;
 	}
 
+	//! Whether output() holds output for our mixer channel this period.
+	//! The channel pulls it in once we signalled it.
+	inline bool hasOutput() const
+	{
+		return m_hasOutput;
+	}
+
+	//! buffer() delayed for aligning it with the other inputs of our
+	//! mixer channel, see setCompensationDelay()
+	inline const sampleFrame * output() const
+	{
+		return m_compensator.delay() > 0 ? m_compensator.output() : m_portBuffer;
+	}
+
+	//! Frames buffer() lags behind the song: the latency of what the play
+	//! handles deliver plus the latency of our effects
+	f_cnt_t latency() const;
+
+	//! Sets the latency of what the play handles deliver, e.g. the one of
+	//! the instrument
+	void setInputLatency( f_cnt_t frames );
+
+	//! Called by the mixer when compiling the render graph, not while the
+	//! port is processed. Returns false if reserveCompensationDelay() has
+	//! to be called for the delay to apply completely.
+	bool setCompensationDelay( f_cnt_t frames )
+	{
+		return m_compensator.setDelay( frames );
+	}
+
+	//! Allocates the delay line, not to be called while the port is processed
+	void reserveCompensationDelay()
+	{
+		m_compensator.reserve();
+	}
+
 	inline void lockBuffer()
 	{
 		m_portBufferLock.lock();
@@ -85,9 +124,19 @@ public:
 		return m_effects.get();
 	}
 
-	void setNextMixerChannel( const mix_ch_t _chnl )
+	void setNextMixerChannel( const mix_ch_t _chnl );
+
+	// volume, panning and the effects are skipped, so buffer() holds what
+	// the play handles deliver, e.g. while rendering the audio of a track
+	// to be frozen
+	inline bool isPreFader() const
 	{
-		m_nextMixerChannel = _chnl;
+		return m_preFader;
+	}
+
+	inline void setPreFader( bool preFader )
+	{
+		m_preFader = preFader;
 	}
 
 
@@ -111,21 +160,55 @@ public:
 	void addPlayHandle( PlayHandle * handle );
 	void removePlayHandle( PlayHandle * handle );
 
+	//! Play handles added to us, including ones the audio engine will
+	//! only start processing next period. Lock while iterating.
+	const PortPlayHandleList & playHandles() const
+	{
+		return m_playHandles;
+	}
+
+	inline void lockPlayHandles() const
+	{
+		m_playHandleLock.lock();
+	}
+
+	inline void unlockPlayHandles() const
+	{
+		m_playHandleLock.unlock();
+	}
+
+	//! Called by each of our play handles after it has been processed.
+	//! Queues this port once all of them are done.
+	void inputDone();
+
 private:
+	void signalMixerChannel();
+
 	volatile bool m_bufferUsage;
+	// m_portBuffer holds only zeros, so it doesn't need to be cleared
+	bool m_bufferSilent;
+	bool m_hasOutput;
 
 	sampleFrame * m_portBuffer;
 	QMutex m_portBufferLock;
 
 	bool m_extOutputEnabled;
 	mix_ch_t m_nextMixerChannel;
+	bool m_preFader;
+
+	// render graph state, maintained by AudioEngine
+	MixerChannel * m_mixerChannel;
+	std::atomic_int m_pendingInputs;
+
+	std::atomic<f_cnt_t> m_inputLatency;
+	LatencyCompensator m_compensator;
 
 	QString m_name;
 
 	std::unique_ptr<EffectChain> m_effects;
 
-	PlayHandleList m_playHandles;
-	QMutex m_playHandleLock;
+	PortPlayHandleList m_playHandles;
+	mutable QMutex m_playHandleLock;
 
 	FloatModel * m_volumeModel;
 	FloatModel * m_panningModel;
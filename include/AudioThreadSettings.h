@@ -0,0 +1,92 @@
+/*
+ * AudioThreadSettings.h - worker count, CPU affinity and scheduling
+ *                         priority of the audio engine threads
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AUDIO_THREAD_SETTINGS_H
+#define AUDIO_THREAD_SETTINGS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+ * Scheduling settings for the render thread and the AudioEngineWorkerThreads.
+ *
+ * The settings are read from the "audioengine" section of the configuration
+ * file ("workers", "cpuset", "rtpriority"). Options given on the command line
+ * take precedence and are never written back to the configuration.
+ */
+class LMMS_EXPORT AudioThreadSettings
+{
+public:
+	AudioThreadSettings();
+
+	//! Number of worker threads, 0 picks one less than there are CPUs
+	int workers;
+	//! CPUs to pin the audio threads to, e.g. "2-5,8". Empty means no pinning
+	QString cpuSet;
+	//! SCHED_FIFO priority for the audio threads, 0 means no realtime scheduling
+	int realtimePriority;
+
+	//! The configured settings with command line overrides applied
+	static AudioThreadSettings current();
+
+	// command line overrides
+	static void overrideWorkers( int workers );
+	static void overrideCpuSet( const QString & cpuSet );
+	static void overrideRealtimePriority( int priority );
+
+	//! Number of worker threads to start besides the rendering thread
+	int numWorkers() const;
+
+	//! Pins the calling thread to the configured CPUs and, if @p realtime
+	//! is set, asks for SCHED_FIFO scheduling (through rtkit if the thread
+	//! isn't allowed to do so on its own). Records and returns a description
+	//! of what was actually granted.
+	QString applyToCurrentThread( const QString & threadName, bool realtime = true ) const;
+
+	//! Whatever applyToCurrentThread() could get for each audio thread
+	static QStringList grantedReport();
+
+	//! Forgets the reports of threads that are gone, called before the
+	//! audio engine starts its threads
+	static void clearGrantedReport();
+
+	//! Parses lists like "0,2-5", returns an empty vector on errors
+	static QVector<int> parseCpuSet( const QString & cpuSet );
+
+private:
+	static int s_workersOverride;
+	static QString s_cpuSetOverride;
+	static int s_realtimePriorityOverride;
+} ;
+
+} // namespace lmms
+
+#endif
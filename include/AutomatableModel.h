@@ -28,6 +28,11 @@
 #include <QMap>
 #include <QMutex>
 
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
 #include "JournallingObject.h"
 #include "Model.h"
 #include "TimePos.h"
@@ -505,6 +510,56 @@ public:
 
 using AutomatedValueMap = QMap<AutomatableModel*, float>;
 
+//! Automated models and their values, sorted by model. The song collects
+//! them every tick, which doesn't allocate once the vector is large enough.
+class AutomatedValues
+{
+public:
+	using Entry = std::pair<AutomatableModel*, float>;
+	using const_iterator = std::vector<Entry>::const_iterator;
+
+	//! Sets the value of @p model, replacing the one set before
+	void set(AutomatableModel* model, float value)
+	{
+		const auto it = std::lower_bound(m_values.begin(), m_values.end(), model, lessThan);
+		if (it != m_values.end() && it->first == model)
+		{
+			it->second = value;
+		}
+		else
+		{
+			m_values.insert(it, { model, value });
+		}
+	}
+
+	bool contains(const AutomatableModel* model) const
+	{
+		const auto it = std::lower_bound(m_values.begin(), m_values.end(), model, lessThan);
+		return it != m_values.end() && it->first == model;
+	}
+
+	void clear()
+	{
+		m_values.clear();
+	}
+
+	void swap(AutomatedValues& other)
+	{
+		m_values.swap(other.m_values);
+	}
+
+	const_iterator begin() const { return m_values.begin(); }
+	const_iterator end() const { return m_values.end(); }
+
+private:
+	static bool lessThan(const Entry& entry, const AutomatableModel* model)
+	{
+		return std::less<const AutomatableModel*>()(entry.first, model);
+	}
+
+	std::vector<Entry> m_values;
+} ;
+
 } // namespace lmms
 
 #endif
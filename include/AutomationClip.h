@@ -33,6 +33,11 @@
 	#include <QRecursiveMutex>
 #endif
 
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "AutomationNode.h"
 #include "Clip.h"
 
@@ -66,9 +71,57 @@ public:
 
 	using TimemapIterator = timeMap::const_iterator;
 
+	/**
+	 * Immutable copy of the nodes of a clip in a flat array. Every edit of
+	 * the clip publishes a new one, so the render thread can evaluate the
+	 * automation without taking the clip's mutex.
+	 */
+	class Curve
+	{
+	public:
+		bool isEmpty() const
+		{
+			return m_nodes.empty();
+		}
+
+		//! Value at @p time relative to the start of the clip
+		float valueAt( int time ) const;
+		//! Like valueAt(), continuing the search at node @p hint, which
+		//! gets updated. Amortized O(1) while time moves forward.
+		float valueAt( int time, int & hint ) const;
+
+	private:
+		struct Node
+		{
+			int pos;
+			float inValue;
+			float outValue;
+			float inTangent;
+			float outTangent;
+		} ;
+
+		Curve( ProgressionTypes progressionType, float tension ) :
+			m_progressionType( progressionType ),
+			m_tension( tension )
+		{
+		}
+
+		//! Index of the last node at or before @p time, -1 if there is none
+		int lastNodeAt( int time ) const;
+		float valueAtNode( int node, int time ) const;
+		//! Value @p offset ticks after @p node, which isn't the last one
+		float valueBetween( int node, int offset ) const;
+
+		std::vector<Node> m_nodes;
+		ProgressionTypes m_progressionType;
+		float m_tension;
+
+		friend class AutomationClip;
+	} ;
+
 	AutomationClip( AutomationTrack * _auto_track );
 	AutomationClip( const AutomationClip & _clip_to_copy );
-	~AutomationClip() override = default;
+	~AutomationClip() override;
 
 	bool addObject( AutomatableModel * _obj, bool _search_dup = true );
 
@@ -154,6 +207,20 @@ public:
 	float valueAt( const TimePos & _time ) const;
 	float *valuesAfter( const TimePos & _time ) const;
 
+	//! The nodes as of the last edit. For the render thread, which can
+	//! use it until the end of the period.
+	const Curve * curve() const
+	{
+		return m_curve.load();
+	}
+
+	//! valueAt() for song playback, without locking. Only to be called
+	//! by the render thread.
+	float playbackValueAt( const TimePos & time ) const
+	{
+		return curve()->valueAt( time, m_playbackHint );
+	}
+
 	const QString name() const;
 
 	// settings-management
@@ -188,7 +255,11 @@ private:
 	void cleanObjects();
 	void generateTangents();
 	void generateTangents(timeMap::iterator it, int numToGenerate);
-	float valueAt( timeMap::const_iterator v, int offset ) const;
+	void computeTangents(timeMap::iterator it, int numToGenerate);
+
+	//! Makes the current nodes the curve the render thread reads.
+	//! Call with m_clipMutex held after every change.
+	void publishCurve();
 
 	// Mutex to make methods involving automation clips thread safe
 	// Mutable so we can lock it from const objects
@@ -214,6 +285,11 @@ private:
 	bool m_isRecording;
 	float m_lastRecordedValue;
 
+	std::atomic<const Curve *> m_curve;
+	// replaced curves and the render epoch at that time
+	std::vector<std::pair<const Curve *, std::uint64_t>> m_retiredCurves;
+	mutable int m_playbackHint;
+
 	static int s_quantization;
 
 	static const float DEFAULT_MIN_VALUE;
@@ -33,10 +33,36 @@ namespace lmms
 {
 
 
+/**
+ * Hands out buffers of one period for play handles, audio ports and mixer
+ * channels.
+ *
+ * The buffers come from a fixed-capacity pool of cache-line aligned
+ * buffers. Every thread keeps a few released buffers for itself, so most
+ * acquire() and release() calls don't touch any shared state. Buffers can
+ * be released by any thread, the pool's shared free list is lock-free.
+ * When the pool runs dry, buffers are allocated from the heap - the
+ * statistics tell how often that happened.
+ */
 class LMMS_EXPORT BufferManager
 {
 public:
-	static void init( fpp_t fpp );
+	static constexpr int DefaultCapacity = 1024;
+
+	struct Statistics
+	{
+		int capacity;
+		//! Most buffers ever taken from the pool at once, including the
+		//! ones cached by threads
+		int highWaterMark;
+		//! Number of buffers allocated from the heap because the pool
+		//! was empty
+		int misses;
+	} ;
+
+	//! Creates a new pool for periods of @p fpp frames. Buffers of the
+	//! previous pool stay valid and go back to it when released.
+	static void init( fpp_t fpp, int capacity = DefaultCapacity );
 	static sampleFrame * acquire();
 	// audio-buffer-mgm
 	static void clear( sampleFrame * ab, const f_cnt_t frames,
@@ -47,8 +73,7 @@ public:
 #endif
 	static void release( sampleFrame * buf );
 
-private:
-	static fpp_t s_framesPerPeriod;
+	static Statistics statistics();
 };
 
 
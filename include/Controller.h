@@ -153,6 +153,8 @@ protected:
 	virtual float value( int _offset );
 
 	virtual void updateValueBuffer();
+	//! Adapts the buffer to the current period length and updates it
+	void refreshValueBuffer();
 
 	// buffer for storing sample-exact values in case there
 	// are more than one model wanting it, so we don't have to create it
@@ -38,6 +38,7 @@ namespace lmms
 
 class EffectChain;
 class EffectControls;
+class PlanarBuffer;
 
 namespace gui
 {
@@ -69,6 +70,28 @@ public:
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 						const fpp_t _frames ) = 0;
 
+	//! Whether processPlanarAudioBuffer() can be used right now
+	virtual bool supportsPlanarBuffers() const
+	{
+		return false;
+	}
+
+	//! Same as processAudioBuffer() for effects which work on separate
+	//! channels anyway. The chain uses this for consecutive effects, so
+	//! the buffer is only converted once for all of them.
+	virtual bool processPlanarAudioBuffer( PlanarBuffer & buf )
+	{
+		Q_UNUSED( buf );
+		return false;
+	}
+
+	//! Frames the output of processAudioBuffer() lags behind its input,
+	//! e.g. because of lookahead. Other signals get delayed accordingly.
+	virtual f_cnt_t latency() const
+	{
+		return 0;
+	}
+
 	inline ch_cnt_t processorCount() const
 	{
 		return m_processors;
@@ -180,6 +203,10 @@ protected:
 	*/
 	void checkGate( double _out_sum );
 
+	//! Effects have to call this whenever latency() changes. Can be
+	//! called from any thread.
+	void notifyLatencyChanged();
+
 	gui::PluginView* instantiateView( QWidget * ) override;
 
 	// some effects might not be capable of higher sample-rates so they can
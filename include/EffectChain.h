@@ -29,6 +29,7 @@
 #include "Model.h"
 #include "SerializingObject.h"
 #include "AutomatableModel.h"
+#include "PlanarBuffer.h"
 
 namespace lmms
 {
@@ -64,6 +65,11 @@ public:
 	void moveUp( Effect * _effect );
 	bool processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, bool hasInputNoise );
 	void startRunning();
+	//! Whether an effect is still producing a tail, i.e. processing
+	//! silent input would change the buffer
+	bool isRunning() const;
+	//! Sum of the latencies of all enabled effects
+	f_cnt_t latency() const;
 
 	void clear();
 
@@ -74,6 +80,9 @@ private:
 
 	BoolModel m_enabledModel;
 
+	// the buffer while effects supporting planar buffers run
+	PlanarBuffer m_planarBuffer;
+
 
 	friend class gui::EffectRackView;
 
@@ -0,0 +1,90 @@
+/*
+ * EventCount.h - lets threads sleep until a lock-free condition may have changed
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef EVENT_COUNT_H
+#define EVENT_COUNT_H
+
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "lmmsconfig.h"
+
+namespace lmms
+{
+
+/**
+ * Sleeping counterpart for lock-free data structures.
+ *
+ * A waiting thread calls prepareWait(), checks its condition once more and
+ * then either calls cancelWait() or wait(). A notifying thread first makes
+ * the condition true and then calls one of the notify functions. Notifying
+ * is a single atomic load as long as nobody sleeps, so it can be done on
+ * every change. On Linux sleeping is done on a futex, elsewhere on a
+ * condition variable.
+ */
+class EventCount
+{
+public:
+	using Key = std::uint32_t;
+
+	EventCount() :
+		m_epoch( 0 ),
+		m_waiters( 0 )
+	{
+	}
+
+	Key prepareWait();
+	void cancelWait();
+	//! Sleeps unless somebody notified after prepareWait() returned @p key
+	void wait( Key key );
+
+	//! Wakes up to @p count sleeping threads
+	void notify( int count );
+
+	void notifyOne()
+	{
+		notify( 1 );
+	}
+
+	void notifyAll()
+	{
+		notify( INT_MAX );
+	}
+
+private:
+	std::atomic<std::uint32_t> m_epoch;
+	std::atomic_int m_waiters;
+
+#ifndef LMMS_BUILD_LINUX
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+#endif
+} ;
+
+} // namespace lmms
+
+#endif
@@ -27,6 +27,8 @@
 
 #include <QSemaphore>
 
+#include <algorithm>
+
 
 namespace lmms
 {
@@ -41,7 +43,8 @@ public:
 		m_writeSem(size),
 		m_readIndex(0),
 		m_writeIndex(0),
-		m_size(size)
+		m_size(size),
+		m_reserved(0)
 	{
 		m_buffer = new T[size];
 		m_readSem.acquire(size);
@@ -72,8 +75,8 @@ public:
 
 	void waitUntilRead()
 	{
-		m_writeSem.acquire(m_size);
-		m_writeSem.release(m_size);
+		m_writeSem.acquire(m_size - m_reserved);
+		m_writeSem.release(m_size - m_reserved);
 	}
 
 	bool available()
@@ -81,6 +84,32 @@ public:
 		return m_readSem.available();
 	}
 
+	int size() const
+	{
+		return m_size;
+	}
+
+	//! Limits the number of elements the writer may queue to @p depth.
+	//! Writer only. Slots that are still filled when the depth is lowered
+	//! are taken away on later calls, once the reader has emptied them.
+	void setDepth(int depth)
+	{
+		const int reserve = m_size - std::max(1, std::min(depth, m_size));
+		if (reserve > m_reserved)
+		{
+			const int free = std::min(reserve - m_reserved, m_writeSem.available());
+			if (free > 0 && m_writeSem.tryAcquire(free))
+			{
+				m_reserved += free;
+			}
+		}
+		else if (reserve < m_reserved)
+		{
+			m_writeSem.release(m_reserved - reserve);
+			m_reserved = reserve;
+		}
+	}
+
 
 private:
 	QSemaphore m_readSem;
@@ -88,6 +117,7 @@ private:
 	int m_readIndex;
 	int m_writeIndex;
 	int m_size;
+	int m_reserved;
 	T * m_buffer;
 } ;
 
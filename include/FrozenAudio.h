@@ -0,0 +1,84 @@
+/*
+ * FrozenAudio.h - pre-rendered output of a frozen track
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FROZEN_AUDIO_H
+#define FROZEN_AUDIO_H
+
+#include <QTemporaryFile>
+
+#include <vector>
+
+#include "lmms_basics.h"
+
+namespace lmms
+{
+
+/**
+ * Audio of a frozen track, rendered from the start of the song.
+ *
+ * The frames are written to a temporary file while rendering and mapped
+ * into memory afterwards, so they don't take up RAM the system can't
+ * reclaim. For each period the song position it started at is kept,
+ * which maps song positions to frames even if the tempo changes.
+ */
+class FrozenAudio
+{
+public:
+	FrozenAudio(fpp_t framesPerPeriod, sample_rate_t sampleRate);
+	~FrozenAudio();
+
+	//! Creates the backing file, returns false on errors
+	bool open();
+	//! Appends a period that started at song position @p ticks
+	bool append(const sampleFrame* frames, double ticks);
+	//! Maps the audio into memory, call after the last append()
+	bool finish();
+
+	//! Frame song position @p ticks was rendered at, -1 if it is past the end
+	f_cnt_t frameAt(tick_t ticks) const;
+	//! Copies @p count frames starting at @p frame, silence past the end
+	void read(f_cnt_t frame, sampleFrame* dst, fpp_t count) const;
+
+	sample_rate_t sampleRate() const
+	{
+		return m_sampleRate;
+	}
+
+	f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+private:
+	QTemporaryFile m_file;
+	const fpp_t m_framesPerPeriod;
+	const sample_rate_t m_sampleRate;
+	f_cnt_t m_frames;
+	std::vector<double> m_periodTicks;
+	const sampleFrame* m_data;
+} ;
+
+} // namespace lmms
+
+#endif
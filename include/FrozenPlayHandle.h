@@ -0,0 +1,89 @@
+/*
+ * FrozenPlayHandle.h - plays the pre-rendered audio of a frozen track
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FROZEN_PLAY_HANDLE_H
+#define FROZEN_PLAY_HANDLE_H
+
+#include <array>
+#include <memory>
+
+#include "FrozenAudio.h"
+#include "PlayHandle.h"
+
+namespace lmms
+{
+
+class InstrumentTrack;
+
+
+class FrozenPlayHandle : public PlayHandle
+{
+public:
+	FrozenPlayHandle(InstrumentTrack* track, std::unique_ptr<FrozenAudio> audio);
+	~FrozenPlayHandle() override = default;
+
+	//! Called by the track when the song starts playing tick @p ticks
+	//! at frame @p offset of the current period
+	void tickStarted(tick_t ticks, f_cnt_t offset);
+
+	const FrozenAudio* audio() const
+	{
+		return m_audio.get();
+	}
+
+	void play(sampleFrame* buffer) override;
+
+	bool isFinished() const override
+	{
+		return false;
+	}
+
+	bool isFromTrack(const Track* track) const override;
+
+private:
+	struct TickStart
+	{
+		tick_t ticks;
+		f_cnt_t offset;
+	} ;
+
+	// continues playing at m_position
+	void playFrames(sampleFrame* buffer, fpp_t frames);
+
+	InstrumentTrack* m_track;
+	std::unique_ptr<FrozenAudio> m_audio;
+
+	// ticks started in the current period, even at 999 BPM there are
+	// only a few of them
+	std::array<TickStart, 64> m_tickStarts;
+	int m_numTickStarts;
+
+	// next frame of m_audio to play, -1 while the song doesn't play
+	f_cnt_t m_position;
+} ;
+
+
+} // namespace lmms
+
+#endif
@@ -105,6 +105,13 @@ public:
 		return NoFlags;
 	}
 
+	// frames the output of the instrument lags behind the notes and MIDI
+	// events it gets, the mixer delays other tracks accordingly
+	virtual f_cnt_t latency() const
+	{
+		return 0;
+	}
+
 	// sub-classes can re-implement this for receiving all incoming
 	// MIDI-events
 	inline virtual bool handleMidiEvent( const MidiEvent&, const TimePos& = TimePos(), f_cnt_t offset = 0 )
@@ -142,6 +149,9 @@ protected:
 	// desiredReleaseFrames() frames are left
 	void applyRelease( sampleFrame * buf, const NotePlayHandle * _n );
 
+	// instruments have to call this whenever latency() changes
+	void notifyLatencyChanged();
+
 
 private:
 	InstrumentTrack * m_instrumentTrack;
@@ -26,6 +26,11 @@
 #ifndef INSTRUMENT_TRACK_H
 #define INSTRUMENT_TRACK_H
 
+#include <QDomDocument>
+
+#include <atomic>
+#include <vector>
+
 #include "AudioPort.h"
 #include "InstrumentFunctions.h"
 #include "InstrumentSoundShaping.h"
@@ -45,6 +50,10 @@ namespace lmms
 
 class Instrument;
 class DataFile;
+class FrozenAudio;
+class FrozenPlayHandle;
+class MidiClip;
+class PatternTrack;
 
 namespace gui
 {
@@ -149,6 +158,11 @@ public:
 		return &m_audioPort;
 	}
 
+	const AudioPort * audioPort() const
+	{
+		return &m_audioPort;
+	}
+
 	MidiPort * midiPort()
 	{
 		return &m_midiPort;
@@ -235,6 +249,23 @@ public:
 
 	void autoAssignMidiDevice( bool );
 
+	bool isFrozen() const
+	{
+		return m_frozenPlayHandle != nullptr;
+	}
+
+	//! Plays @p audio (see TrackFreezer) instead of the instrument until
+	//! unfreeze() is called. The instrument gets unloaded unless some of
+	//! its controls are automated or controlled.
+	void freeze( std::unique_ptr<FrozenAudio> audio );
+
+public slots:
+	void unfreeze();
+
+	//! Makes song playback look at the clips and notes again, to be
+	//! called whenever one of them changes
+	void invalidateNoteSchedule();
+
 signals:
 	void instrumentChanged();
 	void midiNoteOn( const lmms::Note& );
@@ -258,11 +289,27 @@ protected slots:
 	void updatePitch();
 	void updatePitchRange();
 	void updateMixerChannel();
+	void checkFrozenSampleRate();
+	void watchClip( lmms::Clip* clip );
 
 
 private:
+	//! A note of a MIDI clip, at the tick of the song it starts at
+	struct ScheduledNote
+	{
+		tick_t tick;
+		MidiClip* clip;
+		Note* note;
+	} ;
+
 	void processCCEvent(int controller);
 
+	void compileNoteSchedule();
+	void playNote( MidiClip* clip, const Note& note, f_cnt_t offset, bool inSong, PatternTrack* patternTrack );
+
+	void saveInstrument( QDomDocument & doc, QDomNode & parent );
+	void dropFrozenAudio();
+
 	MidiPort m_midiPort;
 
 	NotePlayHandle* m_notes[NumKeys];
@@ -286,6 +333,13 @@ private:
 
 	NotePlayHandleList m_processHandles;
 
+	// the notes of all our clips in the order song playback reaches
+	// them, so a tick doesn't have to look at the clips at all
+	std::vector<ScheduledNote> m_noteSchedule;
+	std::size_t m_noteScheduleCursor;	// first note at m_noteScheduleTick or later
+	tick_t m_noteScheduleTick;			// tick the cursor expects next
+	std::atomic_bool m_noteScheduleDirty;
+
 	FloatModel m_volumeModel;
 	FloatModel m_panningModel;
 
@@ -305,6 +359,10 @@ private:
 
 	Microtuner m_microtuner;
 
+	FrozenPlayHandle * m_frozenPlayHandle;
+	// saved state of the instrument while it is unloaded for freezing
+	QDomDocument m_frozenInstrument;
+
 	std::unique_ptr<BoolModel> m_midiCCEnable;
 	std::unique_ptr<FloatModel> m_midiCCModel[MidiControllerCount];
 
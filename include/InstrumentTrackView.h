@@ -79,6 +79,7 @@ protected:
 private slots:
 	void toggleInstrumentWindow( bool _on );
 	void toggleMidiCCRack();
+	void toggleFrozen();
 	void activityIndicatorPressed();
 	void activityIndicatorReleased();
 
@@ -0,0 +1,171 @@
+/*
+ * IntrusiveList.h - doubly linked list threaded through its elements
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <cstddef>
+
+namespace lmms
+{
+
+//! Links of an element in one IntrusiveList, a member of the element
+template<typename T>
+struct IntrusiveListHook
+{
+	T * prev = nullptr;
+	T * next = nullptr;
+	bool linked = false;
+} ;
+
+
+/**
+ * List which keeps its links in the elements themselves, so adding and
+ * removing an element is O(1) and never allocates. An element can be in
+ * as many lists as it has hooks, but only once in each.
+ *
+ * @p Hook is a type with a static function get(T *) returning the
+ * IntrusiveListHook used by this list, which allows keeping the hooks
+ * private to T.
+ *
+ * The list doesn't own its elements and is not thread-safe.
+ */
+template<typename T, typename Hook>
+class IntrusiveList
+{
+public:
+	class Iterator
+	{
+	public:
+		explicit Iterator( T * node = nullptr ) :
+			m_node( node )
+		{
+		}
+
+		T * operator*() const
+		{
+			return m_node;
+		}
+
+		Iterator & operator++()
+		{
+			m_node = Hook::get( m_node ).next;
+			return *this;
+		}
+
+		bool operator==( const Iterator & other ) const
+		{
+			return m_node == other.m_node;
+		}
+
+		bool operator!=( const Iterator & other ) const
+		{
+			return m_node != other.m_node;
+		}
+
+	private:
+		T * m_node;
+	} ;
+
+	IntrusiveList() = default;
+	IntrusiveList( const IntrusiveList & ) = delete;
+	IntrusiveList & operator=( const IntrusiveList & ) = delete;
+
+	Iterator begin() const
+	{
+		return Iterator( m_first );
+	}
+
+	Iterator end() const
+	{
+		return Iterator();
+	}
+
+	bool isEmpty() const
+	{
+		return m_first == nullptr;
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	//! Whether @p element is in a list using the same hook, which is
+	//! this one as long as the element is never put in another one
+	bool contains( T * element ) const
+	{
+		return Hook::get( element ).linked;
+	}
+
+	void append( T * element )
+	{
+		auto & hook = Hook::get( element );
+		hook.prev = m_last;
+		hook.next = nullptr;
+		hook.linked = true;
+		if( m_last )
+		{
+			Hook::get( m_last ).next = element;
+		}
+		else
+		{
+			m_first = element;
+		}
+		m_last = element;
+		++m_size;
+	}
+
+	//! Takes @p element out of the list and returns the one after it.
+	//! Does nothing for elements which aren't in the list.
+	T * remove( T * element )
+	{
+		auto & hook = Hook::get( element );
+		if( !hook.linked )
+		{
+			return nullptr;
+		}
+
+		T * next = hook.next;
+		( hook.prev ? Hook::get( hook.prev ).next : m_first ) = next;
+		( next ? Hook::get( next ).prev : m_last ) = hook.prev;
+		hook = IntrusiveListHook<T>();
+		--m_size;
+		return next;
+	}
+
+	Iterator erase( Iterator it )
+	{
+		return Iterator( remove( *it ) );
+	}
+
+private:
+	T * m_first = nullptr;
+	T * m_last = nullptr;
+	std::size_t m_size = 0;
+} ;
+
+} // namespace lmms
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * LatencyCompensator.h - delays a signal to align it with later ones
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LATENCY_COMPENSATOR_H
+#define LATENCY_COMPENSATOR_H
+
+#include <vector>
+
+#include "lmms_basics.h"
+
+namespace lmms
+{
+
+
+/**
+ * Delays a stereo signal by a whole number of frames, so it lines up with
+ * signals that went through plugins with more latency. The delayed signal
+ * is written to a buffer of its own, the input is left untouched, so the
+ * same input can be delayed differently for several receivers.
+ *
+ * Neither setDelay() nor process() allocate, so the delay can change on the
+ * render thread. A delay longer than the delay line is limited to its
+ * length until reserve() has been called, which must happen while
+ * process() isn't running.
+ */
+class LatencyCompensator
+{
+public:
+	LatencyCompensator() = default;
+
+	f_cnt_t delay() const
+	{
+		return m_delay;
+	}
+
+	//! Changes the delay, which clears the delay line if it differs from
+	//! the current one. Returns false if the delay line is too short for
+	//! @p frames, see reserve().
+	bool setDelay(f_cnt_t frames);
+
+	//! Whether the last delay passed to setDelay() didn't fit
+	bool needsReserve() const
+	{
+		return m_requestedDelay > capacity();
+	}
+
+	//! Grows the delay line to the last delay passed to setDelay() and
+	//! applies that delay
+	void reserve();
+
+	f_cnt_t capacity() const
+	{
+		return static_cast<f_cnt_t>(m_line.size());
+	}
+
+	//! Delays @p frames frames of @p input, which is taken as silence if
+	//! @p hasInput is false. Returns whether output() holds anything but
+	//! silence; if not, output() is undefined.
+	bool process(const sampleFrame* input, fpp_t frames, bool hasInput);
+
+	const sampleFrame* output() const
+	{
+		return m_output.data();
+	}
+
+private:
+	std::vector<sampleFrame> m_line;
+	std::vector<sampleFrame> m_output;
+	f_cnt_t m_delay = 0;
+	f_cnt_t m_requestedDelay = 0;
+	// next frame of m_line to be read and overwritten
+	f_cnt_t m_position = 0;
+	// frames to be read until m_line only holds silence
+	f_cnt_t m_tail = 0;
+} ;
+
+
+} // namespace lmms
+
+#endif
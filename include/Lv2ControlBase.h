@@ -42,6 +42,7 @@ namespace lmms
 
 
 class Lv2Proc;
+class PlanarBuffer;
 class PluginIssue;
 
 /**
@@ -122,6 +123,11 @@ protected:
 	void copyBuffersToLmms(sampleFrame *buf, fpp_t frames) const;
 	//! Run the Lv2 plugin instance for @param frames frames
 	void run(fpp_t frames);
+	//! Run the Lv2 plugin instances on planar buffers, reading from @p in
+	//! and writing to @p out, without copying where possible
+	void run(const PlanarBuffer &in, PlanarBuffer &out);
+	//! Latency in frames of the slowest processor, as of the last run
+	f_cnt_t latency() const;
 
 	/*
 		load/save, must be called from virtuals
@@ -131,6 +137,8 @@ protected:
 	void loadFile(const QString &file);
 	//! TODO: not implemented
 	void reloadPlugin();
+	//! Inform all processors about a new period size
+	void updateBlockLength();
 
 	/*
 		more functions that must be called from virtuals
@@ -76,6 +76,14 @@ public:
 		initOption(cache[key], sizeof(Opt), cache[Lv2UridCache::IdForType<Opt>::value],
 			std::make_shared<Opt>(std::forward<Arg>(value)), context, subject);
 	}
+	//! Change the value of an initialized option, which is visible through
+	//! the feature afterwards
+	template<typename Opt, typename Arg>
+	void updateOption(Lv2UridCache::Id key, Arg&& value)
+	{
+		const Lv2UridCache& cache = Engine::getLv2Manager()->uridCache();
+		*static_cast<Opt*>(m_optionValues.at(cache[key]).get()) = std::forward<Arg>(value);
+	}
 	//! Fill m_options and m_optionPointers with all options
 	void createOptionVectors();
 	//! Return the feature
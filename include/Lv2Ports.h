@@ -193,6 +193,10 @@ struct Audio : public VisitablePort<Audio, PortBase>
 	//! @param channel channel index into each sample frame
 	void copyBuffersToCore(sampleFrame *lmmsBuf,
 		unsigned channel, fpp_t frames) const;
+	//! Variants for a channel of a planar buffer
+	void copyBuffersFromCore(const sample_t *lmmsChannel, fpp_t frames);
+	void averageWithBuffersFromCore(const sample_t *lmmsChannel, fpp_t frames);
+	void copyBuffersToCore(sample_t *lmmsChannel, fpp_t frames) const;
 
 	bool isSideChain() const { return m_sidechain; }
 	bool isOptional() const { return m_optional; }
@@ -44,6 +44,7 @@
 namespace lmms
 {
 
+class PlanarBuffer;
 class PluginIssue;
 
 // forward declare port structs/enums
@@ -144,8 +145,31 @@ public:
 	 */
 	void copyBuffersToCore(sampleFrame *buf, unsigned firstChan, unsigned num,
 								fpp_t frames) const;
+	//! Variants of the above for planar buffers
+	void copyBuffersFromCore(const PlanarBuffer &buf,
+								unsigned firstChan, unsigned num);
+	void copyBuffersToCore(PlanarBuffer &buf, unsigned firstChan,
+								unsigned num) const;
 	//! Run the Lv2 plugin instance for @param frames frames
 	void run(fpp_t frames);
+	/**
+	 * Run the Lv2 plugin instance on the channels of planar buffers
+	 * @param in buffer to read channels @p firstChan to
+	 *   @p firstChan + @p num - 1 from
+	 * @param out buffer to write the same channels to, with as many frames
+	 *   as @p in
+	 *
+	 * If the plugin has a port for each channel, they are connected to the
+	 * channels directly for this run, otherwise the channels are copied.
+	 */
+	void run(const PlanarBuffer &in, PlanarBuffer &out,
+								unsigned firstChan, unsigned num);
+	//! Pass the engine's new period size as nominal block length, or
+	//! instantiate plugins relying on a fixed block length anew.
+	//! Must not be called while the plugin runs.
+	void updateBlockLength();
+	//! Latency in frames the plugin reported in its last run
+	f_cnt_t latency() const;
 
 	void handleMidiInputEvent(const class MidiEvent &event,
 		const TimePos &time, f_cnt_t offset);
@@ -163,6 +187,8 @@ protected:
 	*/
 	//! Create ports and instance, connect ports, activate plugin
 	void initPlugin();
+	//! Create instance, connect ports, activate plugin
+	void instantiate();
 	//! Deactivate instance
 	void shutdownPlugin();
 
@@ -179,6 +205,9 @@ private:
 	// quick reference to specific, unique ports
 	StereoPortRef m_inPorts, m_outPorts;
 	Lv2Ports::AtomSeq *m_midiIn = nullptr, *m_midiOut = nullptr;
+	Lv2Ports::Control* m_latencyPort = nullptr;
+	//! whether the plugin relies on the block length never changing
+	bool m_fixedBlockLength = false;
 
 	// MIDI
 	// many things here may be moved into the `Instrument` class
@@ -208,6 +237,10 @@ private:
 	void createPort(std::size_t portNum);
 	//! connect m_ports[portNum] with Lv2
 	void connectPort(std::size_t num);
+	//! connect @p port with @p location instead of its own buffer, until
+	//! connectPort() is called for it
+	void connectAudioPort(const Lv2Ports::Audio *port, const sample_t *location);
+	std::size_t portIndex(const Lv2Ports::PortBase *port) const;
 
 	void dumpPort(std::size_t num);
 
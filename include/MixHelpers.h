@@ -34,6 +34,26 @@ class ValueBuffer;
 namespace MixHelpers
 {
 
+/*! \brief Instruction sets the functions below have optimized versions for */
+enum class InstructionSet
+{
+	Generic,
+	SSE2,
+	AVX2,
+	AVX512,
+	NEON
+} ;
+
+/*! \brief Whether both this build and the CPU support @p set */
+bool isSupported( InstructionSet set );
+
+/*! \brief The instruction set in use, by default the best supported one */
+InstructionSet instructionSet();
+
+/*! \brief Use @p set from now on, returns false if it isn't supported.
+ *  For comparing the versions against each other, not thread-safe. */
+bool setInstructionSet( InstructionSet set );
+
 bool isSilent( const sampleFrame* src, int frames );
 
 bool useNaNHandler();
@@ -76,6 +96,20 @@ void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float c
 /*! \brief Multiply dst by coeffDst and add samples from srcLeft/srcRight multiplied by coeffSrc */
 void multiplyAndAddMultipliedJoined( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames );
 
+/*! \brief Apply volume and panning given in percent to dst. volumeBuf and panningBuf
+ *  are used instead of volume and panning unless they are nullptr. */
+void multiplyByVolumeAndPanning( sampleFrame* dst, float volume, const ValueBuffer * volumeBuf,
+					float panning, const ValueBuffer * panningBuf, int frames );
+
+/*! \brief Copy the channels of src into the separate buffers left and right */
+void deinterleave( sample_t* left, sample_t* right, const sampleFrame* src, int frames );
+
+/*! \brief Copy the separate buffers left and right into the channels of dst */
+void interleave( sampleFrame* dst, const sample_t* left, const sample_t* right, int frames );
+
+/*! \brief Get the largest absolute value of each channel in src, 0 for silence */
+void peakValues( const sampleFrame* src, int frames, float& peakLeft, float& peakRight );
+
 } // namespace MixHelpers
 
 
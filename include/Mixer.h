@@ -28,9 +28,11 @@
 #include "Model.h"
 #include "EffectChain.h"
 #include "JournallingObject.h"
+#include "LatencyCompensator.h"
 #include "ThreadableJob.h"
 
 #include <atomic>
+#include <vector>
 
 #include <QColor>
 
@@ -38,6 +40,7 @@ namespace lmms
 {
 
 
+class AudioPort;
 class MixerRoute;
 using MixerRouteVector = QVector<MixerRoute*>;
 
@@ -49,10 +52,13 @@ class MixerChannel : public ThreadableJob
 
 		EffectChain m_fxChain;
 
-		// set to true when input fed from mixToChannel or child channel
+		// set to true when input fed from an audio port or child channel
 		bool m_hasInput;
 		// set to true if any effect in the channel is enabled and running
 		bool m_stillRunning;
+		// m_buffer holds only zeros, i.e. neither inputs nor effects
+		// wrote to it since it was last cleared
+		bool m_silent;
 
 		float m_peakLeft;
 		float m_peakRight;
@@ -62,10 +68,12 @@ class MixerChannel : public ThreadableJob
 		BoolModel m_soloModel;
 		FloatModel m_volumeModel;
 		QString m_name;
-		QMutex m_lock;
 		int m_channelIndex; // what channel index are we
 		bool m_queued; // are we queued up for rendering yet?
-		bool m_muted; // are we muted? updated per period so we don't have to call m_muteModel.value() twice
+		bool m_muted; // are we muted? updated when the schedule is compiled, muted channels aren't part of it
+		// gets a copy of the channel's output (with its volume applied) in
+		// every masterMix() if set, used for exporting the channel as a stem
+		sampleFrame * m_capture;
 
 		// pointers to other channels that this one sends to
 		MixerRouteVector m_sends;
@@ -73,6 +81,15 @@ class MixerChannel : public ThreadableJob
 		// pointers to other channels that send to this one
 		MixerRouteVector m_receives;
 
+		// audio ports routed to this channel, updated whenever the render
+		// graph is compiled. Their output is summed in this order.
+		std::vector<AudioPort *> m_inputPorts;
+
+		// frames our output lags behind the song, i.e. the latency of our
+		// slowest input plus the one of our effects. Updated whenever the
+		// render graph is compiled.
+		f_cnt_t m_latency;
+
 		bool requiresProcessing() const override { return true; }
 		void unmuteForSolo();
 
@@ -88,6 +105,9 @@ class MixerChannel : public ThreadableJob
 		bool m_hasColor;
 
 	
+		// number of audio ports and unmuted channels feeding this one,
+		// updated whenever the render graph is compiled
+		int m_dependencies;
 		std::atomic_int m_dependenciesMet;
 		void incrementDeps();
 		void processed();
@@ -130,11 +150,19 @@ class MixerRoute : public QObject
 	}
 	
 	void updateName();
+
+	//! Delays the sender's output for aligning it with the other inputs
+	//! of the receiver
+	LatencyCompensator & compensator()
+	{
+		return m_compensator;
+	}
 		
 	private:
 		MixerChannel * m_from;
 		MixerChannel * m_to;
 		FloatModel m_amount;
+		LatencyCompensator m_compensator;
 };
 
 
@@ -145,9 +173,25 @@ public:
 	Mixer();
 	~Mixer() override;
 
-	void mixToChannel( const sampleFrame * _buf, mix_ch_t _ch );
-
 	void prepareMasterMix();
+	//! Sorts the unmuted channels topologically by their sends and counts
+	//! the unmuted senders of each one. Called by the audio engine when
+	//! compiling the render graph, i.e. after routes or mute states changed.
+	void compileSchedule();
+	//! Delays the inputs of each channel in the schedule so they line up
+	//! with its slowest one and returns the latency of the master channel.
+	//! Called after the audio engine assigned the audio ports. Sets
+	//! @p needsReserve if a delay line is too short, see
+	//! reserveLatencyCompensation().
+	f_cnt_t compensateLatency( bool & needsReserve );
+	//! Allocates the delay lines compensateLatency() found too short, not
+	//! to be called while the mixer is processed
+	void reserveLatencyCompensation();
+	//! Queues the channels of the first level of the schedule that don't
+	//! have to wait for any audio port. All other channels get queued by
+	//! their last input through dependency counting.
+	void scheduleChannels();
+	//! Copies the processed master channel to _buf and resets all channels
 	void masterMix( sampleFrame * _buf );
 
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
@@ -221,6 +265,12 @@ private:
 	void allocateChannelsTo(int num);
 
 	int m_lastSoloed;
+
+	// the unmuted channels in topological order, sorted by their level,
+	// i.e. the length of the longest chain of unmuted senders before them
+	std::vector<MixerChannel *> m_schedule;
+	// number of channels at the start of m_schedule without unmuted senders
+	std::size_t m_firstLevelSize;
 } ;
 
 
@@ -34,8 +34,6 @@
 #include "Track.h"
 #include "MemoryManager.h"
 
-class QReadWriteLock;
-
 namespace lmms
 {
 
@@ -194,6 +192,12 @@ public:
 		return m_hasParent;
 	}
 
+	/*! Returns the note this one is part of the chord or arpeggio of, if any */
+	const NotePlayHandle* parent() const
+	{
+		return m_hasParent ? m_parent : nullptr;
+	}
+
 	/*! Returns origin of note */
 	Origin origin() const
 	{
@@ -336,12 +340,29 @@ private:
 
 
 const int INITIAL_NPH_CACHE = 256;
-const int NPH_CACHE_INCREMENT = 16;
+// the pool grows by slabs of this many note play handles
+const int NPH_CACHE_INCREMENT = 64;
 
+/**
+ * Recycles the memory of note play handles without locking.
+ *
+ * The handles live in slabs that are never moved or freed while running,
+ * the pool only grows by adding slabs. Free handles form a lock-free list,
+ * and every thread keeps a small magazine of released handles in front of
+ * it, so acquiring and releasing mostly doesn't touch any shared state.
+ */
 class NotePlayHandleManager
 {
 	MM_OPERATORS
 public:
+	struct Statistics
+	{
+		int capacity;
+		//! Most handles ever taken from the shared list at once,
+		//! including the ones in magazines
+		int highWaterMark;
+	} ;
+
 	static void init();
 	static NotePlayHandle * acquire( InstrumentTrack* instrumentTrack,
 					const f_cnt_t offset,
@@ -351,14 +372,9 @@ public:
 					int midiEventChannel = -1,
 					NotePlayHandle::Origin origin = NotePlayHandle::OriginMidiClip );
 	static void release( NotePlayHandle * nph );
-	static void extend( int i );
 	static void free();
 
-private:
-	static NotePlayHandle ** s_available;
-	static QReadWriteLock s_mutex;
-	static std::atomic_int s_availableIndex;
-	static int s_size;
+	static Statistics statistics();
 };
 
 
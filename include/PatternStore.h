@@ -93,7 +93,7 @@ public:
 	void fixIncorrectPositions();
 	void createClipsForPattern(int pattern);
 
-	AutomatedValueMap automatedValuesAt(TimePos time, int clipNum) const override;
+	void collectAutomatedValues(TimePos time, int clipNum, AutomatedValues & values) const override;
 
 public slots:
 	void play();
@@ -0,0 +1,116 @@
+/*
+ * PlanarBuffer.h - audio buffer keeping each channel's samples together
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PLANAR_BUFFER_H
+#define PLANAR_BUFFER_H
+
+#include <vector>
+
+#include "lmms_basics.h"
+#include "MixHelpers.h"
+
+namespace lmms
+{
+
+
+/**
+ * Stereo buffer in planar (channel-separated) layout: all samples of the
+ * left channel, followed by all samples of the right one. This is the
+ * layout LV2 and LADSPA ports use, so plugins can read and write a channel
+ * with a plain copy, or even work on it directly.
+ *
+ * The memory for up to the given number of frames is allocated once, so
+ * it can be filled in the audio threads.
+ */
+class PlanarBuffer
+{
+public:
+	PlanarBuffer( fpp_t maxFrames = 0 ) :
+		m_samples( static_cast<std::size_t>( maxFrames ) * DEFAULT_CHANNELS ),
+		m_frames( maxFrames )
+	{
+	}
+
+	fpp_t frames() const
+	{
+		return m_frames;
+	}
+
+	fpp_t maxFrames() const
+	{
+		return static_cast<fpp_t>( m_samples.size() / DEFAULT_CHANNELS );
+	}
+
+	//! Changes the number of frames the channels hold, which must not
+	//! exceed maxFrames(). The content is undefined afterwards.
+	void setFrames( fpp_t frames )
+	{
+		m_frames = frames;
+	}
+
+	//! Allocates memory for @p maxFrames frames, not for the audio threads
+	void reserve( fpp_t maxFrames )
+	{
+		m_samples.resize( static_cast<std::size_t>( maxFrames ) * DEFAULT_CHANNELS );
+	}
+
+	sample_t * channel( ch_cnt_t ch )
+	{
+		return m_samples.data() + ch * m_frames;
+	}
+
+	const sample_t * channel( ch_cnt_t ch ) const
+	{
+		return m_samples.data() + ch * m_frames;
+	}
+
+	//! Takes the @p frames frames of the interleaved buffer @p src
+	void copyFrom( const sampleFrame * src, fpp_t frames )
+	{
+		setFrames( frames );
+		MixHelpers::deinterleave( channel( 0 ), channel( 1 ), src, frames );
+	}
+
+	//! Writes all frames to the interleaved buffer @p dst
+	void copyTo( sampleFrame * dst ) const
+	{
+		MixHelpers::interleave( dst, channel( 0 ), channel( 1 ), m_frames );
+	}
+
+	//! Strips infs and nans like MixHelpers::sanitize(), which works on
+	//! any number of samples as long as they're contiguous
+	bool sanitize()
+	{
+		return MixHelpers::sanitize( reinterpret_cast<sampleFrame *>( m_samples.data() ), m_frames );
+	}
+
+private:
+	std::vector<sample_t> m_samples;
+	fpp_t m_frames;
+} ;
+
+
+} // namespace lmms
+
+#endif
@@ -28,9 +28,12 @@
 #include <QList>
 #include <QMutex>
 
+#include <cstdint>
+
 #include "lmms_export.h"
 
 
+#include "IntrusiveList.h"
 #include "ThreadableJob.h"
 #include "lmms_basics.h"
 
@@ -50,7 +53,8 @@ public:
 		TypeNotePlayHandle = 0x01,
 		TypeInstrumentPlayHandle = 0x02,
 		TypeSamplePlayHandle = 0x04,
-		TypePresetPreviewHandle = 0x08
+		TypePresetPreviewHandle = 0x08,
+		TypeFrozenPlayHandle = 0x10
 	} ;
 	using Type = Types;
 
@@ -88,6 +92,13 @@ public:
 		return m_type;
 	}
 
+	//! Unique among all play handles ever created, unlike the address,
+	//! which gets reused by the NotePlayHandle pool
+	std::uint64_t id() const
+	{
+		return m_id;
+	}
+
 	// required for ThreadableJob
 	void doProcessing() override;
 
@@ -150,8 +161,27 @@ public:
 	
 	sampleFrame * buffer();
 
+	//! Hook of AudioEngine's list of all play handles
+	struct EngineHook
+	{
+		static IntrusiveListHook<PlayHandle> & get( PlayHandle * handle )
+		{
+			return handle->m_engineHook;
+		}
+	} ;
+
+	//! Hook of the list of play handles of our audio port
+	struct PortHook
+	{
+		static IntrusiveListHook<PlayHandle> & get( PlayHandle * handle )
+		{
+			return handle->m_portHook;
+		}
+	} ;
+
 private:
 	Type m_type;
+	std::uint64_t m_id;
 	f_cnt_t m_offset;
 	QThread* m_affinity;
 	QMutex m_processingLock;
@@ -159,9 +189,13 @@ private:
 	bool m_bufferReleased;
 	bool m_usesBuffer;
 	AudioPort * m_audioPort;
+
+	IntrusiveListHook<PlayHandle> m_engineHook;
+	IntrusiveListHook<PlayHandle> m_portHook;
 } ;
 
-using PlayHandleList = QList<PlayHandle*>;
+using PlayHandleList = IntrusiveList<PlayHandle, PlayHandle::EngineHook>;
+using PortPlayHandleList = IntrusiveList<PlayHandle, PlayHandle::PortHook>;
 using ConstPlayHandleList = QList<const PlayHandle*>;
 
 } // namespace lmms
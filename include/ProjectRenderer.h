@@ -25,6 +25,9 @@
 #ifndef PROJECT_RENDERER_H
 #define PROJECT_RENDERER_H
 
+#include <memory>
+#include <vector>
+
 #include "AudioFileDevice.h"
 #include "lmmsconfig.h"
 #include "AudioEngine.h"
@@ -35,6 +38,9 @@
 namespace lmms
 {
 
+class AudioPort;
+class MixerChannel;
+
 
 class LMMS_EXPORT ProjectRenderer : public QThread
 {
@@ -71,6 +77,24 @@ public:
 		return m_fileDev != nullptr;
 	}
 
+	//! Writes the output of @p port into its own file along with the
+	//! master output, returns false if the file couldn't be created
+	bool addStem( AudioPort * port, const QString & outputFilename );
+	//! Same for the output of mixer channel @p channel
+	bool addStem( mix_ch_t channel, const QString & outputFilename );
+
+	//! Length of the rendered audio and the wall-clock time it took,
+	//! both in seconds, valid once rendering has finished
+	double renderedSeconds() const
+	{
+		return m_renderedSeconds;
+	}
+
+	double elapsedSeconds() const
+	{
+		return m_elapsedSeconds;
+	}
+
 	static ExportFileFormats getFileFormatFromExtension(
 							const QString & _ext );
 
@@ -90,14 +114,69 @@ signals:
 
 
 private:
+	//! Collects rendered periods and passes them to a device in blocks of
+	//! several periods, so encoding overhead is paid per block
+	class BlockWriter
+	{
+	public:
+		BlockWriter( AudioDevice * device, fpp_t blockFrames );
+
+		//! Leaves out the next @p frames frames passed to write(), e.g. the
+		//! silence a plugin latency puts in front of the song
+		void skip( f_cnt_t frames )
+		{
+			m_skip = frames;
+		}
+
+		void write( const surroundSampleFrame * buffer, fpp_t frames );
+		void flush();
+
+		f_cnt_t framesWritten() const
+		{
+			return m_written;
+		}
+
+	private:
+		AudioDevice * m_device;
+		std::vector<surroundSampleFrame> m_block;
+		fpp_t m_frames;
+		f_cnt_t m_skip;
+		f_cnt_t m_written;
+	} ;
+
+	struct Stem
+	{
+		std::unique_ptr<AudioFileDevice> device;
+		std::unique_ptr<BlockWriter> writer;
+		// either the port or the mixer channel being recorded
+		AudioPort * port;
+		MixerChannel * channel;
+		std::unique_ptr<sampleFrame[]> capture;
+		// frames still to be written once the song is done
+		f_cnt_t tailFrames;
+	} ;
+
 	void run() override;
 
+	AudioFileDevice * createFileDevice( const QString & outputFilename ) const;
+	//! Writes the period just rendered to the stem files, once the song is
+	//! done only to those still having some of their latency left
+	void writeStems( bool exportDone );
+
+	const OutputSettings m_outputSettings;
+	const ExportFileFormats m_fileFormat;
+
 	AudioFileDevice * m_fileDev;
 	AudioEngine::qualitySettings m_qualitySettings;
 
+	std::vector<Stem> m_stems;
+
 	volatile int m_progress;
 	volatile bool m_abort;
 
+	double m_renderedSeconds;
+	double m_elapsedSeconds;
+
 } ;
 
 
@@ -25,6 +25,12 @@
 #ifndef REMOTE_PLUGIN_H
 #define REMOTE_PLUGIN_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "RemotePluginBase.h"
 #include "SharedMemory.h"
 
@@ -37,12 +43,13 @@ namespace lmms
 
 
 class RemotePlugin;
+class RemotePluginProcess;
 
 class ProcessWatcher : public QThread
 {
 	Q_OBJECT
 public:
-	ProcessWatcher( RemotePlugin * );
+	ProcessWatcher( RemotePluginProcess * );
 	~ProcessWatcher() override = default;
 
 	void stop()
@@ -59,12 +66,150 @@ public:
 private:
 	void run() override;
 
-	RemotePlugin * m_plugin;
+	RemotePluginProcess * m_process;
 	volatile bool m_quit;
 
 } ;
 
 
+#ifndef SYNC_WITH_SHM_FIFO
+//! The channel through which a process hosting several plugins gets the
+//! periods of all of them, see RemotePluginProcess::startPeriod()
+class RemotePluginBatch : public RemotePluginBase
+{
+public:
+	RemotePluginBatch();
+	~RemotePluginBatch() override;
+
+	//! What the process needs to connect, sent with IdStartBatch
+	std::string channel() const
+	{
+		return m_socketFile.toStdString();
+	}
+
+	//! Waits for the process to connect after it got channel()
+	bool accept();
+
+	//! Waits until the process has processed @p batch and all before it
+	void waitFor( std::uint64_t batch );
+
+	bool processMessage( const message & _m ) override;
+
+private:
+	QMutex m_waitMutex;
+	std::atomic<std::uint64_t> m_batchesDone;
+
+	int m_server;
+	QString m_socketFile;
+
+	friend class RemotePluginProcess;
+} ;
+#endif // not SYNC_WITH_SHM_FIFO
+
+
+//! The process the remote part of one or more RemotePlugins runs in.
+//! Executables which handle IdAddInstance can host several plugins, which
+//! then share this object, each talking over its own channel.
+//!
+//! Pipelined plugins of such a process get their periods through one more
+//! channel, in batches: instead of a round trip per plugin and period, the
+//! process runs the periods of all of them and answers once.
+//!
+//! Plugins are only attached to processes started for the current period
+//! size, as the ones of a process may have to be restarted all together
+//! when it changes.
+class RemotePluginProcess : public QObject
+{
+	Q_OBJECT
+public:
+	RemotePluginProcess( const QString & exec, const QStringList & extraArgs );
+	~RemotePluginProcess() override;
+
+	//! Makes the process available to share()
+	static void makeShareable( const std::shared_ptr<RemotePluginProcess> & process );
+
+	//! Attaches @p plugin to a running, shareable process of @p exec with
+	//! @p extraArgs hosting less than @p maxInstances plugins, and returns
+	//! that process or nullptr if there's none
+	static std::shared_ptr<RemotePluginProcess> share( RemotePlugin * plugin,
+		const QString & exec, const QStringList & extraArgs, int maxInstances );
+
+	//! Starts the process for @p plugin, with the arguments for its channel
+	void start( RemotePlugin * plugin, const QStringList & channelArgs );
+
+	//! Asks the running process to host the attached @p plugin, whose
+	//! remote part then connects to the channel given by @p channelArgs.
+	//! Fails if no other plugin can pass on the request.
+	bool addInstance( RemotePlugin * plugin, const QStringList & channelArgs );
+
+	void detach( RemotePlugin * plugin );
+
+	bool isRunning() const
+	{
+		return m_process.state() != QProcess::NotRunning;
+	}
+
+	//! Lets the attached @p plugin get its periods in batches, opening the
+	//! batch channel through it if needed. Returns the number the plugin
+	//! has in the batches, or -1 if it has to go on on its own.
+	int joinBatch( RemotePlugin * plugin );
+	//! Must be called once the joined @p plugin has no periods left
+	void leaveBatch( RemotePlugin * plugin );
+
+	//! Adds the period of the joined @p plugin in the slot starting at
+	//! @p offset to the next batch, and returns the number of that batch.
+	//! A batch is sent once all joined plugins have started a period, or
+	//! at the end of the engine's period at the latest.
+	std::uint64_t startPeriod( RemotePlugin * plugin, int offset );
+	//! Waits until @p batch has been processed, sending it if necessary
+	void waitForBatch( std::uint64_t batch );
+	//! Sends @p m for the joined @p plugin through the batch channel, so it
+	//! stays in order with the periods
+	void sendToBatch( RemotePlugin * plugin, const RemotePluginBase::message & m );
+
+private:
+	//! Whether any of the plugins has messages left to be processed
+	bool messagesLeft();
+	void invalidateInstances();
+	//! m_batchMutex must be held
+	void sendPendingBatch();
+
+	QProcess m_process;
+	ProcessWatcher m_watcher;
+
+	const QString m_exec;
+	const QStringList m_extraArgs;
+	const f_cnt_t m_framesPerPeriod;
+	QStringList m_args;
+
+	QMutex m_instancesMutex;
+	QList<RemotePlugin *> m_instances;
+
+#ifndef SYNC_WITH_SHM_FIFO
+	std::unique_ptr<RemotePluginBatch> m_batch;
+#endif
+	// serializes joining, which waits for the process
+	QMutex m_joinMutex;
+	QMutex m_batchMutex;
+	int m_joinedInstances;
+	int m_nextBatchNumber;
+	// number and slot offset of the periods for the next batch
+	std::vector<std::pair<int, int>> m_pendingPeriods;
+	std::uint64_t m_batchesSent;
+
+	static QMutex s_sharedMutex;
+	static std::vector<std::weak_ptr<RemotePluginProcess>> s_shared;
+
+	friend class ProcessWatcher;
+
+
+private slots:
+	void processFinished( int exitCode, QProcess::ExitStatus exitStatus );
+	void processErrored(QProcess::ProcessError err );
+	void flushBatch();
+} ;
+
+
 class LMMS_EXPORT RemotePlugin : public QObject, public RemotePluginBase
 {
 	Q_OBJECT
@@ -77,7 +222,7 @@ public:
 #ifdef DEBUG_REMOTE_PLUGIN
 		return true;
 #else
-		return m_process.state() != QProcess::NotRunning;
+		return m_hostProcess && m_hostProcess->isRunning();
 #endif // DEBUG_REMOTE_PLUGIN
 	}
 
@@ -92,12 +237,24 @@ public:
 	inline void waitForInitDone( bool _busyWaiting = true )
 	{
 		m_failed = waitForMessage( IdInitDone, _busyWaiting ).id != IdInitDone;
+		joinBatch();
 	}
 
 	bool processMessage( const message & _m ) override;
 
+	//! Runs the plugin for one period. In pipelined mode this only starts
+	//! the period and returns the output of the previous one, so the plugin
+	//! runs in parallel to the engine.
 	bool process( const sampleFrame * _in_buf, sampleFrame * _out_buf );
 
+	bool isPipelined() const
+	{
+		return m_pipelined;
+	}
+
+	//! Frames the output of process() lags behind its input
+	virtual f_cnt_t latency() const;
+
 	void processMidiEvent( const MidiEvent&, const f_cnt_t _offset );
 
 	void updateSampleRate( sample_rate_t _sr )
@@ -108,6 +265,10 @@ public:
 		unlock();
 	}
 
+	//! Tell the plugin the engine's period size, which is also the layout
+	//! of the shared audio buffer from the next process() on
+	void updateBufferSize();
+
 
 	virtual void toggleUI()
 	{
@@ -144,23 +305,39 @@ public slots:
 	virtual void showUI();
 	virtual void hideUI();
 
+signals:
+	void latencyChanged();
+
 protected:
 	inline void setSplittedChannels( bool _on )
 	{
 		m_splitChannels = _on;
 	}
 
+	//! Lets init() put the plugin into a process hosting other instances
+	//! of the same executable, as configured by the user. Only for remote
+	//! executables handling IdAddInstance.
+	void allowSharedProcess();
+
+	//! Sends @p m, which has to stay in order with the periods, e.g. a
+	//! MIDI event or a parameter change
+	void sendEvent( const message & m );
+
 
 	bool m_failed;
 private:
 	void resizeSharedProcessingMemory();
+	//! Waits until the plugin has finished all periods it got, whose
+	//! output is dropped
+	void finishPendingPeriods();
+	//! Gets the periods of pipelined plugins in shared processes batched
+	void joinBatch();
+	void leaveBatch();
 
 
-	QProcess m_process;
-	ProcessWatcher m_watcher;
-
-	QString m_exec;
-	QStringList m_args;
+	std::shared_ptr<RemotePluginProcess> m_hostProcess;
+	// plugins a process may host, 1 for a process of its own
+	int m_instancesPerProcess;
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
 	QRecursiveMutex m_commMutex;
@@ -172,6 +349,21 @@ private:
 	SharedMemory<float[]> m_audioBuffer;
 	std::size_t m_audioBufferSize;
 
+	// double buffering: the plugin works on one slot of m_audioBuffer
+	// while the next period's input is written to the other one
+	const bool m_pipelined;
+	std::size_t m_slotSize;
+	int m_currentSlot;
+	// periods sent to the plugin for which IdProcessingDone is missing
+	int m_periodsInFlight;
+	// whether the other slot holds output of the last period
+	bool m_pendingOutput;
+	// number in the batches of the process, -1 if not batched, and the
+	// batches with the last two periods
+	int m_batchNumber;
+	std::uint64_t m_lastBatch;
+	std::uint64_t m_previousBatch;
+
 	int m_inputCount;
 	int m_outputCount;
 
@@ -180,12 +372,7 @@ private:
 	QString m_socketFile;
 #endif // not SYNC_WITH_SHM_FIFO
 
-	friend class ProcessWatcher;
-
-
-private slots:
-	void processFinished( int exitCode, QProcess::ExitStatus exitStatus );
-	void processErrored(QProcess::ProcessError err );
+	friend class RemotePluginProcess;
 } ;
 
 
@@ -27,6 +27,7 @@
 
 #include "MidiEvent.h"
 
+#include <algorithm>
 #include <atomic>
 #include <vector>
 #include <cstdio>
@@ -84,267 +85,13 @@
 #endif // BUILD_REMOTE_PLUGIN_CLIENT
 
 #ifdef SYNC_WITH_SHM_FIFO
-#include "SharedMemory.h"
+#include "ShmFifo.h"
 #endif
 
 namespace lmms
 {
 
 
-#ifdef SYNC_WITH_SHM_FIFO
-
-
-// sometimes we need to exchange bigger messages (e.g. for VST parameter dumps)
-// so set a usable value here
-const int SHM_FIFO_SIZE = 512*1024;
-
-
-// implements a FIFO inside a shared memory segment
-class shmFifo
-{
-	// need this union to handle different sizes of sem_t on 32 bit
-	// and 64 bit platforms
-	union sem32_t
-	{
-		int semKey;
-		char fill[32];
-	} ;
-	struct shmData
-	{
-		sem32_t dataSem;	// semaphore for locking this
-					// FIFO management data
-		sem32_t messageSem;	// semaphore for incoming messages
-		int32_t startPtr; // current start of FIFO in memory
-		int32_t endPtr;   // current end of FIFO in memory
-		char data[SHM_FIFO_SIZE];  // actual data
-	} ;
-
-public:
-	// constructor for master-side
-	shmFifo() :
-		m_invalid( false ),
-		m_master( true ),
-		m_dataSem( QString() ),
-		m_messageSem( QString() ),
-		m_lockDepth( 0 )
-	{
-		m_data.create(QUuid::createUuid().toString().toStdString());
-		m_data->startPtr = m_data->endPtr = 0;
-		static int k = 0;
-		m_data->dataSem.semKey = ( getpid()<<10 ) + ++k;
-		m_data->messageSem.semKey = ( getpid()<<10 ) + ++k;
-		m_dataSem.setKey( QString::number( m_data->dataSem.semKey ),
-						1, QSystemSemaphore::Create );
-		m_messageSem.setKey( QString::number(
-						m_data->messageSem.semKey ),
-						0, QSystemSemaphore::Create );
-	}
-
-	// constructor for remote-/client-side - use _shm_key for making up
-	// the connection to master
-	shmFifo(const std::string& shmKey) :
-		m_invalid( false ),
-		m_master( false ),
-		m_dataSem( QString() ),
-		m_messageSem( QString() ),
-		m_lockDepth( 0 )
-	{
-		m_data.attach(shmKey);
-		m_dataSem.setKey( QString::number( m_data->dataSem.semKey ) );
-		m_messageSem.setKey( QString::number(
-						m_data->messageSem.semKey ) );
-	}
-
-	inline bool isInvalid() const
-	{
-		return m_invalid;
-	}
-
-	void invalidate()
-	{
-		m_invalid = true;
-	}
-
-	// do we act as master (i.e. not as remote-process?)
-	inline bool isMaster() const
-	{
-		return m_master;
-	}
-
-	// recursive lock
-	inline void lock()
-	{
-		if( !isInvalid() && m_lockDepth.fetch_add( 1 ) == 0 )
-		{
-			m_dataSem.acquire();
-		}
-	}
-
-	// recursive unlock
-	inline void unlock()
-	{
-		if( m_lockDepth.fetch_sub( 1 ) <= 1 )
-		{
-			m_dataSem.release();
-		}
-	}
-
-	// wait until message-semaphore is available
-	inline void waitForMessage()
-	{
-		if( !isInvalid() )
-		{
-			m_messageSem.acquire();
-		}
-	}
-
-	// increase message-semaphore
-	inline void messageSent()
-	{
-		m_messageSem.release();
-	}
-
-
-	inline int32_t readInt()
-	{
-		int32_t i;
-		read( &i, sizeof( i ) );
-		return i;
-	}
-
-	inline void writeInt( const int32_t & _i )
-	{
-		write( &_i, sizeof( _i ) );
-	}
-
-	inline std::string readString()
-	{
-		const int len = readInt();
-		if( len )
-		{
-			char * sc = new char[len + 1];
-			read( sc, len );
-			sc[len] = 0;
-			std::string s( sc );
-			delete[] sc;
-			return s;
-		}
-		return std::string();
-	}
-
-
-	inline void writeString( const std::string & _s )
-	{
-		const int len = _s.size();
-		writeInt( len );
-		write( _s.c_str(), len );
-	}
-
-
-	inline bool messagesLeft()
-	{
-		if( isInvalid() )
-		{
-			return false;
-		}
-		lock();
-		const bool empty = ( m_data->startPtr == m_data->endPtr );
-		unlock();
-		return !empty;
-	}
-
-
-	const std::string& shmKey() const
-	{
-		return m_data.key();
-	}
-
-
-private:
-	static inline void fastMemCpy( void * _dest, const void * _src,
-							const int _len )
-	{
-		// calling memcpy() for just an integer is obsolete overhead
-		if( _len == 4 )
-		{
-			*( (int32_t *) _dest ) = *( (int32_t *) _src );
-		}
-		else
-		{
-			memcpy( _dest, _src, _len );
-		}
-	}
-
-	void read( void * _buf, int _len )
-	{
-		if( isInvalid() )
-		{
-			memset( _buf, 0, _len );
-			return;
-		}
-		lock();
-		while( isInvalid() == false &&
-				_len > m_data->endPtr - m_data->startPtr )
-		{
-			unlock();
-#ifndef LMMS_BUILD_WIN32
-			usleep( 5 );
-#endif
-			lock();
-		}
-		fastMemCpy( _buf, m_data->data + m_data->startPtr, _len );
-		m_data->startPtr += _len;
-		// nothing left?
-		if( m_data->startPtr == m_data->endPtr )
-		{
-			// then reset to 0
-			m_data->startPtr = m_data->endPtr = 0;
-		}
-		unlock();
-	}
-
-	void write( const void * _buf, int _len )
-	{
-		if( isInvalid() || _len > SHM_FIFO_SIZE )
-		{
-			return;
-		}
-		lock();
-		while( _len > SHM_FIFO_SIZE - m_data->endPtr )
-		{
-			// if no space is left, try to move data to front
-			if( m_data->startPtr > 0 )
-			{
-				memmove( m_data->data,
-					m_data->data + m_data->startPtr,
-					m_data->endPtr - m_data->startPtr );
-				m_data->endPtr = m_data->endPtr -
-							m_data->startPtr;
-				m_data->startPtr = 0;
-			}
-			unlock();
-#ifndef LMMS_BUILD_WIN32
-			usleep( 5 );
-#endif
-			lock();
-		}
-		fastMemCpy( m_data->data + m_data->endPtr, _buf, _len );
-		m_data->endPtr += _len;
-		unlock();
-	}
-
-	volatile bool m_invalid;
-	bool m_master;
-	SharedMemory<shmData> m_data;
-	QSystemSemaphore m_dataSem;
-	QSystemSemaphore m_messageSem;
-	std::atomic_int m_lockDepth;
-
-} ;
-#endif // SYNC_WITH_SHM_FIFO
-
-
-
 enum RemoteMessageIDs
 {
 	IdUndefined,
@@ -374,6 +121,10 @@ enum RemoteMessageIDs
 	IdLoadPresetFile,
 	IdDebugMessage,
 	IdIdle,
+	IdAddInstance,
+	IdStartBatch,
+	IdJoinBatch,
+	IdBatchedMessage,
 	IdUserBase = 64
 } ;
 
@@ -432,6 +183,11 @@ public:
 		}
 #endif
 
+		inline int size() const
+		{
+			return data.size();
+		}
+
 		inline int getInt( int _p = 0 ) const
 		{
 			return atoi( data[_p].c_str() );
@@ -538,6 +294,10 @@ public:
 #ifdef SYNC_WITH_SHM_FIFO
 		return m_in->messagesLeft();
 #else
+		if( m_receivePos != m_receiveEnd )
+		{
+			return true;
+		}
 		struct pollfd pollin;
 		pollin.fd = m_socket;
 		pollin.events = POLLIN;
@@ -593,6 +353,15 @@ protected:
 
 
 #ifndef SYNC_WITH_SHM_FIFO
+	//! Makes @p socket the channel, dropping anything buffered from the
+	//! previous one
+	void setSocket( int socket )
+	{
+		m_socket = socket;
+		m_receivePos = 0;
+		m_receiveEnd = 0;
+	}
+
 	int m_socket;
 #endif
 
@@ -610,6 +379,8 @@ private:
 	shmFifo * m_in;
 	shmFifo * m_out;
 #else
+	// reads through m_receiveBuffer, so that a message usually takes a
+	// single ::read() instead of one per field
 	void read( void * _buf, int _len )
 	{
 		if( isInvalid() )
@@ -621,19 +392,37 @@ private:
 		int remaining = _len;
 		while ( remaining )
 		{
-			ssize_t nread = ::read( m_socket, buf, remaining );
-			switch ( nread )
+			if( m_receivePos == m_receiveEnd )
 			{
-				case -1:
-					fprintf( stderr,
-						"Error while reading.\n" );
-				case 0:
-					invalidate();
-					memset( _buf, 0, _len );
-					return;
+				// large reads go straight to the caller
+				const bool direct = remaining >= ReceiveBufferSize;
+				ssize_t nread = ::read( m_socket,
+					direct ? buf : m_receiveBuffer,
+					direct ? remaining : ReceiveBufferSize );
+				switch ( nread )
+				{
+					case -1:
+						fprintf( stderr,
+							"Error while reading.\n" );
+					case 0:
+						invalidate();
+						memset( _buf, 0, _len );
+						return;
+				}
+				if( direct )
+				{
+					buf += nread;
+					remaining -= nread;
+					continue;
+				}
+				m_receivePos = 0;
+				m_receiveEnd = nread;
 			}
-			buf += nread;
-			remaining -= nread;
+			const int n = std::min( remaining, m_receiveEnd - m_receivePos );
+			memcpy( buf, m_receiveBuffer + m_receivePos, n );
+			m_receivePos += n;
+			buf += n;
+			remaining -= n;
 		}
 	}
 
@@ -667,6 +456,14 @@ private:
 
 	pthread_mutex_t m_receiveMutex;
 	pthread_mutex_t m_sendMutex;
+
+	static constexpr int ReceiveBufferSize = 16384;
+	// what has been read from m_socket but not been received yet
+	char m_receiveBuffer[ReceiveBufferSize];
+	int m_receivePos;
+	int m_receiveEnd;
+	// whole messages, written with a single ::write()
+	std::vector<char> m_sendBuffer;
 #endif // SYNC_WITH_SHM_FIFO
 
 } ;
@@ -119,10 +119,34 @@ public:
 		sendMessage( message( IdDebugMessage ).addString( _s ) );
 	}
 
+	// called on the thread of RemotePluginBatchClient for plugins whose
+	// periods the host sends in batches, see IdJoinBatch
+	virtual void processBatchedPeriod( int offset )
+	{
+		doProcessing( offset );
+	}
+
+	virtual void processBatchedMessage( const message & _m )
+	{
+		processMessage( _m );
+	}
+
+
+protected:
+	//! Stops getting periods in batches. Derived classes call this before
+	//! tearing down what process() uses.
+	void leaveBatch();
+
 
 private:
 	void setShmKey(const std::string& key);
-	void doProcessing();
+	//! Processes the period in the slot starting at sample @p offset of
+	//! the shared buffer, the host may fill another one meanwhile
+	void doProcessing( int offset );
+
+#ifndef SYNC_WITH_SHM_FIFO
+	static int connectToHost( const char * socketPath );
+#endif
 
 	SharedMemory<float[]> m_audioBuffer;
 	SharedMemory<const VstSyncData> m_vstSyncData;
@@ -132,7 +156,47 @@ private:
 
 	sample_rate_t m_sampleRate;
 	fpp_t m_bufferSize;
+
+	friend class RemotePluginBatchClient;
+} ;
+
+
+#ifndef SYNC_WITH_SHM_FIFO
+//! The remote end of the channel through which the host sends the periods
+//! of all plugins of this process in batches. Its thread runs the periods
+//! of a batch one after another and answers once for all of them.
+class RemotePluginBatchClient : public RemotePluginBase
+{
+public:
+	//! Connects to the channel given by IdStartBatch @p _m and starts
+	//! the thread
+	static void start( const message & _m );
+	//! Waits for the thread to end, which it does when the host closes
+	//! the channel
+	static void finish();
+
+	static void join( int number, RemotePluginClient * instance );
+	static void leave( RemotePluginClient * instance );
+
+	static bool isBatchThread();
+
+	bool processMessage( const message & _m ) override;
+
+private:
+	RemotePluginBatchClient( const char * socketPath );
+	~RemotePluginBatchClient() override;
+
+	static void * run( void * );
+	//! The instance which joined as @p number, s_instancesMutex must be held
+	static RemotePluginClient * instance( int number );
+
+	static RemotePluginBatchClient * s_batch;
+	static pthread_t s_thread;
+	// held while the thread calls into instances
+	static pthread_mutex_t s_instancesMutex;
+	static std::vector<std::pair<int, RemotePluginClient *>> s_instances;
 } ;
+#endif // SYNC_WITH_SHM_FIFO
 
 #ifndef LMMS_BUILD_WIN32
 class PollParentThread
@@ -188,27 +252,7 @@ RemotePluginClient::RemotePluginClient( const char * socketPath ) :
 	m_bufferSize( 0 )
 {
 #ifndef SYNC_WITH_SHM_FIFO
-	struct sockaddr_un sa;
-	sa.sun_family = AF_LOCAL;
-
-	size_t length = strlen( socketPath );
-	if ( length >= sizeof sa.sun_path )
-	{
-		length = sizeof sa.sun_path - 1;
-		fprintf( stderr, "Socket path too long.\n" );
-	}
-	memcpy( sa.sun_path, socketPath, length );
-	sa.sun_path[length] = '\0';
-
-	m_socket = socket( PF_LOCAL, SOCK_STREAM, 0 );
-	if ( m_socket == -1 )
-	{
-		fprintf( stderr, "Could not connect to local server.\n" );
-	}
-	if ( ::connect( m_socket, (struct sockaddr *) &sa, sizeof sa ) == -1 )
-	{
-		fprintf( stderr, "Could not connect to local server.\n" );
-	}
+	setSocket( connectToHost( socketPath ) );
 #endif
 }
 
@@ -217,6 +261,7 @@ RemotePluginClient::RemotePluginClient( const char * socketPath ) :
 
 RemotePluginClient::~RemotePluginClient()
 {
+	leaveBatch();
 	sendMessage( IdQuit );
 
 #ifndef SYNC_WITH_SHM_FIFO
@@ -271,11 +316,12 @@ bool RemotePluginClient::processMessage( const message & _m )
 			break;
 
 		case IdBufferSizeInformation:
-			// Should LMMS gain the ability to change buffer size
-			// without a restart, it must wait for this message to
-			// complete processing or else risk VST crashes
+			// LMMS waits for the reply before processing the next
+			// period with the new buffer size
 			m_bufferSize = _m.getInt();
 			updateBufferSize();
+			reply_message.id = IdInformationUpdated;
+			reply = true;
 			break;
 
 		case IdQuit:
@@ -292,7 +338,7 @@ bool RemotePluginClient::processMessage( const message & _m )
 			break;
 
 		case IdStartProcessing:
-			doProcessing();
+			doProcessing( _m.getInt() );
 			reply_message.id = IdProcessingDone;
 			reply = true;
 			break;
@@ -304,6 +350,17 @@ bool RemotePluginClient::processMessage( const message & _m )
 		case IdInitDone:
 			break;
 
+#ifndef SYNC_WITH_SHM_FIFO
+		case IdStartBatch:
+			RemotePluginBatchClient::start( _m );
+			break;
+
+		case IdJoinBatch:
+			RemotePluginBatchClient::join( _m.getInt(), this );
+			reply = true;
+			break;
+#endif
+
 		default:
 		{
 			char buf[64];
@@ -323,6 +380,47 @@ bool RemotePluginClient::processMessage( const message & _m )
 
 
 
+void RemotePluginClient::leaveBatch()
+{
+#ifndef SYNC_WITH_SHM_FIFO
+	RemotePluginBatchClient::leave( this );
+#endif
+}
+
+
+
+
+#ifndef SYNC_WITH_SHM_FIFO
+int RemotePluginClient::connectToHost( const char * socketPath )
+{
+	struct sockaddr_un sa;
+	sa.sun_family = AF_LOCAL;
+
+	size_t length = strlen( socketPath );
+	if ( length >= sizeof sa.sun_path )
+	{
+		length = sizeof sa.sun_path - 1;
+		fprintf( stderr, "Socket path too long.\n" );
+	}
+	memcpy( sa.sun_path, socketPath, length );
+	sa.sun_path[length] = '\0';
+
+	const int sock = socket( PF_LOCAL, SOCK_STREAM, 0 );
+	if ( sock == -1 )
+	{
+		fprintf( stderr, "Could not connect to local server.\n" );
+	}
+	if ( ::connect( sock, (struct sockaddr *) &sa, sizeof sa ) == -1 )
+	{
+		fprintf( stderr, "Could not connect to local server.\n" );
+	}
+	return sock;
+}
+#endif
+
+
+
+
 void RemotePluginClient::setShmKey(const std::string& key)
 {
 	try
@@ -338,13 +436,13 @@ void RemotePluginClient::setShmKey(const std::string& key)
 
 
 
-void RemotePluginClient::doProcessing()
+void RemotePluginClient::doProcessing( int offset )
 {
 	if (m_audioBuffer)
 	{
-		process( (sampleFrame *)( m_inputCount > 0 ? m_audioBuffer.get() : nullptr ),
-				(sampleFrame *)( m_audioBuffer.get() +
-					( m_inputCount*m_bufferSize ) ) );
+		float * slot = m_audioBuffer.get() + offset;
+		process( (sampleFrame *)( m_inputCount > 0 ? slot : nullptr ),
+				(sampleFrame *)( slot + ( m_inputCount*m_bufferSize ) ) );
 	}
 	else
 	{
@@ -353,6 +451,173 @@ void RemotePluginClient::doProcessing()
 }
 
 
+
+#ifndef SYNC_WITH_SHM_FIFO
+RemotePluginBatchClient * RemotePluginBatchClient::s_batch = nullptr;
+pthread_t RemotePluginBatchClient::s_thread;
+pthread_mutex_t RemotePluginBatchClient::s_instancesMutex = PTHREAD_MUTEX_INITIALIZER;
+std::vector<std::pair<int, RemotePluginClient *>> RemotePluginBatchClient::s_instances;
+
+
+
+
+RemotePluginBatchClient::RemotePluginBatchClient( const char * socketPath ) :
+	RemotePluginBase()
+{
+	setSocket( RemotePluginClient::connectToHost( socketPath ) );
+}
+
+
+
+
+RemotePluginBatchClient::~RemotePluginBatchClient()
+{
+	if ( close( m_socket ) == -1)
+	{
+		fprintf( stderr, "Error freeing resources.\n" );
+	}
+}
+
+
+
+
+void RemotePluginBatchClient::start( const message & _m )
+{
+	if( s_batch )
+	{
+		return;
+	}
+	s_batch = new RemotePluginBatchClient( _m.getString( 0 ).c_str() );
+	if( pthread_create( &s_thread, nullptr, run, nullptr ) != 0 )
+	{
+		delete s_batch;
+		s_batch = nullptr;
+	}
+}
+
+
+
+
+void RemotePluginBatchClient::finish()
+{
+	if( s_batch )
+	{
+		pthread_join( s_thread, nullptr );
+		delete s_batch;
+		s_batch = nullptr;
+	}
+}
+
+
+
+
+void RemotePluginBatchClient::join( int number, RemotePluginClient * instance )
+{
+	pthread_mutex_lock( &s_instancesMutex );
+	s_instances.emplace_back( number, instance );
+	pthread_mutex_unlock( &s_instancesMutex );
+}
+
+
+
+
+void RemotePluginBatchClient::leave( RemotePluginClient * instance )
+{
+	// waits for a batch still running the instance
+	pthread_mutex_lock( &s_instancesMutex );
+	s_instances.erase( std::remove_if( s_instances.begin(), s_instances.end(),
+		[instance]( const std::pair<int, RemotePluginClient *> & joined )
+			{ return joined.second == instance; } ),
+		s_instances.end() );
+	pthread_mutex_unlock( &s_instancesMutex );
+}
+
+
+
+
+bool RemotePluginBatchClient::isBatchThread()
+{
+	return s_batch && pthread_equal( pthread_self(), s_thread );
+}
+
+
+
+
+RemotePluginClient * RemotePluginBatchClient::instance( int number )
+{
+	for( const auto & joined : s_instances )
+	{
+		if( joined.first == number )
+		{
+			return joined.second;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+void * RemotePluginBatchClient::run( void * )
+{
+	message m;
+	while( ( m = s_batch->receiveMessage() ).id != IdQuit &&
+							!s_batch->isInvalid() )
+	{
+		s_batch->processMessage( m );
+	}
+	return nullptr;
+}
+
+
+
+
+bool RemotePluginBatchClient::processMessage( const message & _m )
+{
+	switch( _m.id )
+	{
+		case IdStartProcessing:
+		{
+			// the number of periods, then instance and slot of each
+			const int count = _m.getInt( 0 );
+			pthread_mutex_lock( &s_instancesMutex );
+			for( int i = 0; i < count; ++i )
+			{
+				if( auto joined = instance( _m.getInt( 1 + 2 * i ) ) )
+				{
+					joined->processBatchedPeriod( _m.getInt( 2 + 2 * i ) );
+				}
+			}
+			pthread_mutex_unlock( &s_instancesMutex );
+			sendMessage( IdProcessingDone );
+			break;
+		}
+
+		case IdBatchedMessage:
+		{
+			// the instance, then the message it was sent for
+			message m( _m.getInt( 1 ) );
+			for( int i = 2; i < _m.size(); ++i )
+			{
+				m.addString( _m.getString( i ) );
+			}
+			pthread_mutex_lock( &s_instancesMutex );
+			if( auto joined = instance( _m.getInt( 0 ) ) )
+			{
+				joined->processBatchedMessage( m );
+			}
+			pthread_mutex_unlock( &s_instancesMutex );
+			break;
+		}
+
+		default:
+			break;
+	}
+	return true;
+}
+#endif // SYNC_WITH_SHM_FIFO
+
+
 } // namespace lmms
 
 #endif // REMOTE_PLUGIN_CLIENT_H
@@ -54,8 +54,17 @@ public:
 	/// Export all unmuted tracks into individual file
 	void renderTracks();
 
+	/// Export all unmuted tracks into individual files in a single pass,
+	/// along with the master output. The track files hold the output of
+	/// the tracks before the mixer, the mixer channels can be exported too.
+	void renderStems( bool mixerChannels );
+
 	void abortProcessing();
 
+	//! How many times faster than realtime everything rendered so far
+	//! has been rendered
+	double realtimeFactor() const;
+
 signals:
 	void progressChanged( int );
 	void finished();
@@ -66,9 +75,12 @@ private slots:
 
 private:
 	QString pathForTrack( const Track *track, int num );
+	QString pathForStem( const QString & prefix, QString name );
+	QVector<Track*> unmutedTracks() const;
 	void restoreMutedState();
 
 	void render( QString outputPath );
+	void startRenderer();
 
 	const AudioEngine::qualitySettings m_qualitySettings;
 	const AudioEngine::qualitySettings m_oldQualitySettings;
@@ -80,6 +92,9 @@ private:
 
 	QVector<Track*> m_tracksToRender;
 	QVector<Track*> m_unmuted;
+
+	double m_renderedSeconds;
+	double m_elapsedSeconds;
 } ;
 
 
@@ -214,7 +214,7 @@ private:
 		return static_cast<f_cnt_t>( ceilf( ms * (float)m_samplerate * 0.001f ) );
 	}
 
-	const fpp_t m_fpp;
+	const fpp_t m_fpp; // room for the longest period, see AudioEngine::maxFramesPerPeriod()
 	sample_rate_t m_samplerate;
 	size_t m_size;
 	sampleFrame * m_buffer;
@@ -291,9 +291,17 @@ public slots:
 	void sampleRateChanged();
 
 private:
+	struct TakeOriginal {};
+	//! Takes the original data and the settings from @p orig, but not the
+	//! data being played, for decoding it again while @p orig is playing
+	SampleBuffer(SampleBuffer & orig, TakeOriginal);
+
 	static sample_rate_t audioEngineSampleRate();
 
 	void update(bool keepSettings = false);
+	//! Decodes the audio file or copies the original data into m_data,
+	//! returns false if the file was too large or too long
+	bool loadData(bool keepSettings);
 
 	void convertIntToFloat(int_sample_t * & ibuf, f_cnt_t frames, int channels);
 	void directFloatWrite(sample_t * & fbuf, f_cnt_t frames, int channels);
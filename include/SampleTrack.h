@@ -100,6 +100,8 @@ private:
 	AudioPort m_audioPort;
 	bool m_isPlaying;
 
+	clipVector m_endedClips;	// for play(), to not allocate every tick
+
 
 
 	friend class gui::SampleTrackView;
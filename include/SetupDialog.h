@@ -41,6 +41,7 @@ class QComboBox;
 class QLabel;
 class QLineEdit;
 class QSlider;
+class QSpinBox;
 
 
 namespace lmms::gui
@@ -98,6 +99,7 @@ private slots:
 	void vstEmbedMethodChanged();
 	void toggleVSTAlwaysOnTop(bool en);
 	void toggleDisableAutoQuit(bool enabled);
+	void togglePipelineRemotePlugins(bool enabled);
 
 	// Audio settings widget.
 	void audioInterfaceChanged(const QString & driver);
@@ -164,6 +166,8 @@ private:
 	LedCheckBox * m_vstAlwaysOnTopCheckBox;
 	bool m_vstAlwaysOnTop;
 	bool m_disableAutoQuit;
+	bool m_pipelineRemotePlugins;
+	QSpinBox * m_remoteInstancesSpinBox;
 
 	using AswMap = QMap<QString, AudioDeviceSetupWidget*>;
 	using MswMap = QMap<QString, MidiSetupWidget*>;
@@ -178,6 +182,10 @@ private:
 	int m_bufferSize;
 	QSlider * m_bufferSizeSlider;
 	QLabel * m_bufferSizeLbl;
+	QSpinBox * m_renderAheadSpinBox;
+	QSpinBox * m_workersSpinBox;
+	QLineEdit * m_cpuSetLineEdit;
+	QSpinBox * m_rtPrioritySpinBox;
 
 	// MIDI settings widgets.
 	QComboBox * m_midiInterfaces;
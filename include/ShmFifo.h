@@ -0,0 +1,300 @@
+/*
+ * ShmFifo.h - message FIFO inside a shared memory segment
+ *
+ * Copyright (c) 2008-2014 Tobias Doerffel <tobydox/at/users.sourceforge.net>
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SHM_FIFO_H
+#define SHM_FIFO_H
+
+#include "lmmsconfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef USE_MINGW_THREADS_REPLACEMENT
+#	include <mingw.mutex.h>
+#	include <mingw.thread.h>
+#else
+#	include <mutex>
+#	include <thread>
+#endif
+
+#ifdef LMMS_HAVE_PROCESS_H
+#include <process.h>
+#endif
+#ifdef LMMS_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <QString>
+#include <QSystemSemaphore>
+#include <QUuid>
+
+#include "SharedMemory.h"
+
+namespace lmms
+{
+
+
+// sometimes we need to exchange bigger messages (e.g. for VST parameter dumps)
+// so set a usable value here
+const int SHM_FIFO_SIZE = 512*1024;
+
+
+// implements a FIFO inside a shared memory segment
+//
+// Each direction has exactly one writing and one reading process, so the
+// FIFO is a lock-free single-producer/single-consumer ring: the writer only
+// advances writePos, the reader only readPos. Threads of the same process
+// are serialized by a process-local lock. The message semaphore is only
+// touched if the reader actually has to sleep, so messages sent while the
+// reader is busy don't cost any system calls.
+class shmFifo
+{
+	// need this union to handle different sizes of sem_t on 32 bit
+	// and 64 bit platforms
+	union sem32_t
+	{
+		int semKey;
+		char fill[32];
+	} ;
+	// 32 bit atomics, so the layout is the same for 32 bit plugin
+	// processes and a 64 bit host
+	using atomic32_t = std::atomic<int32_t>;
+	static_assert( atomic32_t::is_always_lock_free,
+		"shmFifo needs lock-free atomics to be shared between processes" );
+	struct shmData
+	{
+		sem32_t messageSem;	// semaphore the reader sleeps on
+		atomic32_t messages;	// messages sent but not yet waited
+					// for, negative while the reader sleeps
+		atomic32_t readPos;	// bytes read so far, wrapping around
+		atomic32_t writePos;	// bytes written so far, wrapping around
+		char data[SHM_FIFO_SIZE];  // actual data
+	} ;
+	static_assert( ( SHM_FIFO_SIZE & ( SHM_FIFO_SIZE - 1 ) ) == 0,
+		"the positions wrap around, so the size must be a power of 2" );
+
+public:
+	// constructor for master-side
+	shmFifo() :
+		m_invalid( false ),
+		m_master( true ),
+		m_messageSem( QString() )
+	{
+		m_data.create(QUuid::createUuid().toString().toStdString());
+		m_data->messages = 0;
+		m_data->readPos = 0;
+		m_data->writePos = 0;
+		static int k = 0;
+		m_data->messageSem.semKey = ( getpid()<<10 ) + ++k;
+		m_messageSem.setKey( QString::number(
+						m_data->messageSem.semKey ),
+						0, QSystemSemaphore::Create );
+	}
+
+	// constructor for remote-/client-side - use _shm_key for making up
+	// the connection to master
+	shmFifo(const std::string& shmKey) :
+		m_invalid( false ),
+		m_master( false ),
+		m_messageSem( QString() )
+	{
+		m_data.attach(shmKey);
+		m_messageSem.setKey( QString::number(
+						m_data->messageSem.semKey ) );
+	}
+
+	inline bool isInvalid() const
+	{
+		return m_invalid;
+	}
+
+	void invalidate()
+	{
+		m_invalid = true;
+	}
+
+	// do we act as master (i.e. not as remote-process?)
+	inline bool isMaster() const
+	{
+		return m_master;
+	}
+
+	// recursive lock against other threads of this process, which must
+	// be held while reading or writing a whole message
+	inline void lock()
+	{
+		m_threadLock.lock();
+	}
+
+	inline void unlock()
+	{
+		m_threadLock.unlock();
+	}
+
+	// wait until a message is available
+	inline void waitForMessage()
+	{
+		if( !isInvalid() &&
+			m_data->messages.fetch_sub( 1, std::memory_order_acq_rel ) <= 0 )
+		{
+			m_messageSem.acquire();
+		}
+	}
+
+	// announce a completely written message
+	inline void messageSent()
+	{
+		// wake the reader only if it's sleeping
+		if( m_data->messages.fetch_add( 1, std::memory_order_acq_rel ) < 0 )
+		{
+			m_messageSem.release();
+		}
+	}
+
+
+	inline int32_t readInt()
+	{
+		int32_t i;
+		read( &i, sizeof( i ) );
+		return i;
+	}
+
+	inline void writeInt( const int32_t & _i )
+	{
+		write( &_i, sizeof( _i ) );
+	}
+
+	inline std::string readString()
+	{
+		const int len = readInt();
+		if( len )
+		{
+			std::string s( len, '\0' );
+			read( &s[0], len );
+			return s;
+		}
+		return std::string();
+	}
+
+
+	inline void writeString( const std::string & _s )
+	{
+		const int len = _s.size();
+		writeInt( len );
+		write( _s.c_str(), len );
+	}
+
+
+	inline bool messagesLeft()
+	{
+		return !isInvalid() &&
+			m_data->messages.load( std::memory_order_acquire ) > 0;
+	}
+
+
+	const std::string& shmKey() const
+	{
+		return m_data.key();
+	}
+
+
+private:
+	static inline uint32_t offset( uint32_t pos )
+	{
+		return pos & ( SHM_FIFO_SIZE - 1 );
+	}
+
+	// waiting for the other side: the first rounds only give up the time
+	// slice, as the other side is usually about to catch up, then sleep so
+	// that a long wait doesn't keep a core busy
+	static void backOff( int round )
+	{
+		if( round < 64 )
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+		}
+	}
+
+	void read( void * _buf, int _len )
+	{
+		if( isInvalid() )
+		{
+			memset( _buf, 0, _len );
+			return;
+		}
+		const uint32_t pos = m_data->readPos.load( std::memory_order_relaxed );
+		int rounds = 0;
+		// the whole message is there once it has been announced, so
+		// this only waits for messages bigger than the FIFO
+		while( isInvalid() == false && static_cast<uint32_t>( _len ) >
+			m_data->writePos.load( std::memory_order_acquire ) - pos )
+		{
+			backOff( rounds++ );
+		}
+		const uint32_t first = std::min<uint32_t>( _len, SHM_FIFO_SIZE - offset( pos ) );
+		memcpy( _buf, m_data->data + offset( pos ), first );
+		memcpy( static_cast<char *>( _buf ) + first, m_data->data, _len - first );
+		m_data->readPos.store( pos + _len, std::memory_order_release );
+	}
+
+	void write( const void * _buf, int _len )
+	{
+		if( isInvalid() || _len > SHM_FIFO_SIZE )
+		{
+			return;
+		}
+		const uint32_t pos = m_data->writePos.load( std::memory_order_relaxed );
+		int rounds = 0;
+		// wait for the reader to make room
+		while( isInvalid() == false && static_cast<uint32_t>( _len ) >
+			SHM_FIFO_SIZE - ( pos - m_data->readPos.load( std::memory_order_acquire ) ) )
+		{
+			backOff( rounds++ );
+		}
+		const uint32_t first = std::min<uint32_t>( _len, SHM_FIFO_SIZE - offset( pos ) );
+		memcpy( m_data->data + offset( pos ), _buf, first );
+		memcpy( m_data->data, static_cast<const char *>( _buf ) + first, _len - first );
+		m_data->writePos.store( pos + _len, std::memory_order_release );
+	}
+
+	volatile bool m_invalid;
+	bool m_master;
+	SharedMemory<shmData> m_data;
+	QSystemSemaphore m_messageSem;
+	std::recursive_mutex m_threadLock;
+
+} ;
+
+
+} // namespace lmms
+
+#endif // SHM_FIFO_H
@@ -26,6 +26,7 @@
 #define SONG_H
 
 #include <memory>
+#include <vector>
 
 #include <QHash>
 #include <QString>
@@ -290,8 +291,7 @@ public:
 		return m_globalAutomationTrack;
 	}
 
-	//TODO: Add Q_DECL_OVERRIDE when Qt4 is dropped
-	AutomatedValueMap automatedValuesAt(TimePos time, int clipNum = -1) const override;
+	void collectAutomatedValues(TimePos time, int clipNum, AutomatedValues & values) const override;
 
 	// file management
 	void createNewProject();
@@ -428,6 +428,11 @@ private:
 	}
 
 	void setPlayPos( tick_t ticks, PlayModes playMode );
+	//! Moves the play position back to where a period rendered ahead
+	//! started, as it gets rendered again. Called by the render thread
+	//! before processNextBuffer(). Returns false if the song has been
+	//! stopped or moved meanwhile.
+	bool rewindPlayPos( PlayModes playMode, tick_t ticks, float currentFrame );
 
 	void saveControllerStates( QDomDocument & doc, QDomElement & element );
 	void restoreControllerStates( const QDomElement & element );
@@ -502,7 +507,11 @@ private:
 	std::shared_ptr<Scale> m_scales[MaxScaleCount];
 	std::shared_ptr<Keymap> m_keymaps[MaxKeymapCount];
 
-	AutomatedValueMap m_oldAutomatedValues;
+	AutomatedValues m_oldAutomatedValues;
+	// filled by processAutomations() every tick
+	AutomatedValues m_automatedValues;
+	std::vector<const AutomatableModel*> m_recordedModels;
+	Track::clipVector m_recordingClips;
 
 	friend class Engine;
 	friend class gui::SongEditor;
@@ -29,6 +29,9 @@
 #include <QVector>
 #include <QColor>
 
+#include <atomic>
+#include <vector>
+
 #include "AutomatableModel.h"
 #include "JournallingObject.h"
 #include "lmms_basics.h"
@@ -123,6 +126,8 @@ public:
 	// -- for usage by Clip only ---------------
 	Clip * addClip( Clip * clip );
 	void removeClip( Clip * clip );
+	//! Called after the position or the length of @p clip changed
+	void updateClipIndex( Clip * clip );
 	// -------------------------------------------------------
 	void deleteClips();
 
@@ -134,8 +139,15 @@ public:
 	{
 		return m_clips;
 	}
+	//! Appends the clips intersecting [start, end] to @p clipV, keeping
+	//! it sorted by position
 	void getClipsInRange( clipVector & clipV, const TimePos & start,
 							const TimePos & end );
+	//! Appends the clips starting at or before @p time to @p clipV, keeping
+	//! it sorted by position. For automation, whose clips hold their last
+	//! value after their end. The search continues where the last one
+	//! stopped, so playback costs amortized O(1) per tick.
+	void getClipsUpTo( clipVector & clipV, const TimePos & time );
 	void swapPositionOfClips( int clipNum1, int clipNum2 );
 
 	void createClipsForPattern(int pattern);
@@ -222,7 +234,20 @@ public slots:
 	void setColor(const QColor& c);
 	void resetColor();
 
+protected:
+	//! The clips intersecting [start, end] sorted by position, like
+	//! getClipsInRange(). For playback, which asks for one tick after
+	//! the other: the search continues where the last one stopped, so
+	//! a tick costs amortized O(1). Only to be called by the render
+	//! thread. Sets @p restarted if the search had to start over after
+	//! an edit or a jump, otherwise @p ended gets the clips which ended
+	//! before @p start since the last call.
+	const clipVector & playbackClips( const TimePos & start, const TimePos & end,
+						bool * restarted = nullptr, clipVector * ended = nullptr );
+
 private:
+	void indexClipsFrom( int index );
+
 	TrackContainer* m_trackContainer;
 	TrackTypes m_type;
 	QString m_name;
@@ -239,6 +264,23 @@ private:
 
 	clipVector m_clips;
 
+	// m_clips sorted by start position and the highest end position of
+	// each clip and the ones before it. Only changed while the audio
+	// engine doesn't render.
+	clipVector m_clipsByPosition;
+	std::vector<tick_t> m_clipEnds;
+	unsigned int m_clipIndexRevision;
+
+	// state of playbackClips()
+	clipVector m_cursorClips;
+	int m_cursorNext;
+	tick_t m_cursorStart;
+	tick_t m_cursorEnd;
+	unsigned int m_cursorRevision;
+	// number of clips getClipsUpTo() found last time, only a hint as
+	// automation may be collected by other threads, too
+	std::atomic<int> m_clipsUpToHint;
+
 	QMutex m_processingLock;
 	
 	QColor m_color;
@@ -101,13 +101,24 @@ public:
 		return m_TrackContainerType;
 	}
 
-	virtual AutomatedValueMap automatedValuesAt(TimePos time, int clipNum = -1) const;
+	//! Values of the models automated at @p time
+	AutomatedValueMap automatedValuesAt(TimePos time, int clipNum = -1) const;
+
+	//! Sets the values of the models automated at @p time in @p values,
+	//! clips later in the song taking precedence
+	virtual void collectAutomatedValues(TimePos time, int clipNum, AutomatedValues & values) const;
 
 signals:
 	void trackAdded( lmms::Track * _track );
 
 protected:
-	static AutomatedValueMap automatedValuesFromTracks(const TrackList &tracks, TimePos timeStart, int clipNum = -1);
+	//! Cleared vector for the clips collectAutomatedValuesFromClips() gets
+	//! called with, which keeps its capacity between ticks
+	static Track::clipVector & automationClips(int clipNum);
+	//! Adds the clips of @p track that may automate anything at @p time,
+	//! sorted by position
+	static void addAutomationClips(Track * track, TimePos time, int clipNum, Track::clipVector & clips);
+	static void collectAutomatedValuesFromClips(const Track::clipVector & clips, TimePos time, AutomatedValues & values);
 
 	mutable QReadWriteLock m_tracksMutex;
 
@@ -0,0 +1,91 @@
+/*
+ * TrackFreezer.h - renders the output of an instrument track for freezing it
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef TRACK_FREEZER_H
+#define TRACK_FREEZER_H
+
+#include <QThread>
+#include <QVector>
+
+#include <memory>
+
+#include "FrozenAudio.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class InstrumentTrack;
+class Track;
+
+
+/**
+ * Renders the whole song offline, like ProjectRenderer, and records what
+ * the instrument of an instrument track delivers to its AudioPort. Volume,
+ * panning and the track's effects are left out, they keep being applied
+ * live while the track is frozen. All other tracks except automation tracks
+ * are muted meanwhile.
+ *
+ * The audio device is replaced while rendering, the original one, the
+ * port and the muted state of the tracks are restored when the freezer is
+ * destroyed.
+ */
+class LMMS_EXPORT TrackFreezer : public QThread
+{
+	Q_OBJECT
+public:
+	TrackFreezer(InstrumentTrack* track);
+	~TrackFreezer() override;
+
+	//! Returns false if the temporary file couldn't be created
+	bool startProcessing();
+
+	//! The rendered audio, nullptr if rendering failed or was aborted
+	std::unique_ptr<FrozenAudio> takeAudio();
+
+public slots:
+	void abortProcessing();
+
+signals:
+	void progressChanged(int);
+
+private:
+	void run() override;
+
+	InstrumentTrack* m_track;
+	std::unique_ptr<FrozenAudio> m_audio;
+
+	QVector<Track*> m_muted;
+	bool m_trackWasMuted;
+	bool m_deviceStored;
+
+	int m_progress;
+	volatile bool m_abort;
+	bool m_succeeded;
+} ;
+
+
+} // namespace lmms
+
+#endif
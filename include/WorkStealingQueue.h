@@ -0,0 +1,146 @@
+/*
+ * WorkStealingQueue.h - lock-free work-stealing deque
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef WORK_STEALING_QUEUE_H
+#define WORK_STEALING_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace lmms
+{
+
+/**
+ * Fixed-capacity Chase-Lev deque.
+ *
+ * The owning thread pushes and pops at the bottom end, any other thread may
+ * steal from the top end. All operations are lock-free; steal() may fail
+ * spuriously when it races with another thief or with the owner taking the
+ * last element, callers simply try again or look elsewhere.
+ *
+ * T has to be a pointer type, nullptr is used to signal "no item".
+ */
+template<typename T>
+class WorkStealingQueue
+{
+	static_assert(std::is_pointer<T>::value, "WorkStealingQueue only holds pointers");
+
+public:
+	//! @param capacity must be a power of two
+	explicit WorkStealingQueue(std::size_t capacity) :
+		m_top(0),
+		m_bottom(0),
+		m_mask(static_cast<std::int64_t>(capacity) - 1),
+		m_items(new std::atomic<T>[capacity])
+	{
+		for (std::size_t i = 0; i < capacity; ++i)
+		{
+			m_items[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	//! Owner only. Returns false if the queue is full.
+	bool push(T item)
+	{
+		const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+		const std::int64_t t = m_top.load(std::memory_order_acquire);
+		if (b - t > m_mask)
+		{
+			return false;
+		}
+		m_items[b & m_mask].store(item, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	//! Owner only. Takes the most recently pushed item.
+	T pop()
+	{
+		const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		std::int64_t t = m_top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			// queue was empty
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T item = m_items[b & m_mask].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// last item - race against thieves
+			if (!m_top.compare_exchange_strong(t, t + 1,
+					std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				item = nullptr;
+			}
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return item;
+	}
+
+	//! Any thread. Takes the oldest item.
+	T steal()
+	{
+		std::int64_t t = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const std::int64_t b = m_bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+		{
+			return nullptr;
+		}
+
+		T item = m_items[t & m_mask].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return item;
+	}
+
+	bool empty() const
+	{
+		return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+	}
+
+private:
+	// top and bottom are written by different threads - keep them apart
+	alignas(64) std::atomic<std::int64_t> m_top;
+	alignas(64) std::atomic<std::int64_t> m_bottom;
+	alignas(64) const std::int64_t m_mask;
+	std::unique_ptr<std::atomic<T>[]> m_items;
+} ;
+
+} // namespace lmms
+
+#endif
@@ -216,6 +216,8 @@ CarlaInstrument::CarlaInstrument(InstrumentTrack* const instrumentTrack, const D
 #endif
 
     connect(Engine::audioEngine(), SIGNAL(sampleRateChanged()), this, SLOT(sampleRateChanged()));
+    // emitted while the engine is paused between two periods
+    connect(Engine::audioEngine(), SIGNAL(framesPerPeriodChanged()), this, SLOT(bufferSizeChanged()), Qt::DirectConnection);
 }
 
 CarlaInstrument::~CarlaInstrument()
@@ -604,6 +606,11 @@ void CarlaInstrument::sampleRateChanged()
     fDescriptor->dispatcher(fHandle, NATIVE_PLUGIN_OPCODE_SAMPLE_RATE_CHANGED, 0, 0, nullptr, handleGetSampleRate());
 }
 
+void CarlaInstrument::bufferSizeChanged()
+{
+    fDescriptor->dispatcher(fHandle, NATIVE_PLUGIN_OPCODE_BUFFER_SIZE_CHANGED, 0, handleGetBufferSize(), nullptr, 0.0f);
+}
+
 // -------------------------------------------------------------------
 
 namespace gui
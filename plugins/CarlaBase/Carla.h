@@ -203,6 +203,7 @@ signals:
 
 private slots:
     void sampleRateChanged();
+    void bufferSizeChanged();
     void refreshParams(bool init = false);
     void clearParamModels();
     void paramModelChanged(uint32_t index);
@@ -90,6 +90,9 @@ CompressorEffect::CompressorEffect(Model* parent, const Descriptor::SubPluginFea
 	connect(&m_compressorControls.m_kneeModel, SIGNAL(dataChanged()), this, SLOT(calcAutoMakeup()), Qt::DirectConnection);
 	connect(&m_compressorControls.m_autoMakeupModel, SIGNAL(dataChanged()), this, SLOT(calcAutoMakeup()), Qt::DirectConnection);
 
+	connect(&m_compressorControls.m_lookaheadModel, &BoolModel::dataChanged,
+		this, [this] { notifyLatencyChanged(); }, Qt::DirectConnection);
+
 	connect(Engine::audioEngine(), SIGNAL(sampleRateChanged()), this, SLOT(changeSampleRate()));
 	changeSampleRate();
 }
@@ -646,6 +649,8 @@ void CompressorEffect::changeSampleRate()
 	calcInGain();
 	calcTiltCoeffs();
 	calcMix();
+
+	notifyLatencyChanged();
 }
 
 
@@ -45,6 +45,12 @@ public:
 	~CompressorEffect() override = default;
 	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
 
+	//! Lookahead delays the whole signal by 20 ms
+	f_cnt_t latency() const override
+	{
+		return m_compressorControls.m_lookaheadModel.value() ? m_lookaheadDelayLength : 0;
+	}
+
 	EffectControls* controls() override
 	{
 		return &m_compressorControls;
@@ -37,6 +37,7 @@
 #include "LadspaSubPluginFeatures.h"
 #include "AutomationClip.h"
 #include "MemoryManager.h"
+#include "PlanarBuffer.h"
 #include "ValueBuffer.h"
 #include "Song.h"
 
@@ -153,6 +154,56 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 				Engine::audioEngine()->processingSampleRate();
 	}
 
+	processChannels( _buf[0].data(), frames, 1, DEFAULT_CHANNELS );
+
+	if( o_buf != nullptr )
+	{
+		sampleBack( _buf, o_buf, m_maxSampleRate );
+	}
+
+	bool is_running = isRunning();
+	m_pluginMutex.unlock();
+	return( is_running );
+}
+
+
+
+
+bool LadspaEffect::supportsPlanarBuffers() const
+{
+	// the resampling for plugins with a lower maximum rate is interleaved
+	return m_maxSampleRate >= Engine::audioEngine()->processingSampleRate();
+}
+
+
+
+
+bool LadspaEffect::processPlanarAudioBuffer( PlanarBuffer & _buf )
+{
+	m_pluginMutex.lock();
+	if( !isOkay() || dontRun() || !isRunning() || !isEnabled() )
+	{
+		m_pluginMutex.unlock();
+		return( false );
+	}
+
+	processChannels( _buf.channel( 0 ), _buf.frames(), _buf.frames(), 1 );
+
+	bool is_running = isRunning();
+	m_pluginMutex.unlock();
+	return( is_running );
+}
+
+
+
+
+void LadspaEffect::processChannels( sample_t * _samples, const fpp_t _frames,
+					int _channelStride, int _frameStride )
+{
+	const fpp_t frames = _frames;
+	// contiguous channels are read by the plugin itself
+	const bool connectInputs = _frameStride == 1;
+
 	// Copy the LMMS audio buffer to the LADSPA input buffer and initialize
 	// the control ports.  
 	ch_cnt_t channel = 0;
@@ -164,14 +215,24 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 			switch( pp->rate )
 			{
 				case CHANNEL_IN:
-					for( fpp_t frame = 0; 
-						frame < frames; ++frame )
+				{
+					sample_t * in = _samples + channel * _channelStride;
+					if( connectInputs )
 					{
-						pp->buffer[frame] = 
-							_buf[frame][channel];
+						( m_descriptor->connect_port )( m_handles[proc], port, in );
+					}
+					else
+					{
+						for( fpp_t frame = 0; 
+							frame < frames; ++frame )
+						{
+							pp->buffer[frame] = 
+								in[frame * _frameStride];
+						}
 					}
 					++channel;
 					break;
+				}
 				case AUDIO_RATE_INPUT:
 				{
 					ValueBuffer * vb = pp->control->valueBuffer();
@@ -235,18 +296,27 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 			switch( pp->rate )
 			{
 				case CHANNEL_IN:
+					if( connectInputs )
+					{
+						( m_descriptor->connect_port )( m_handles[proc], port, pp->buffer );
+					}
+					break;
 				case AUDIO_RATE_INPUT:
 				case CONTROL_RATE_INPUT:
 					break;
 				case CHANNEL_OUT:
+				{
+					sample_t * out = _samples + channel * _channelStride;
 					for( fpp_t frame = 0; 
 						frame < frames; ++frame )
 					{
-						_buf[frame][channel] = d * _buf[frame][channel] + w * pp->buffer[frame];
-						out_sum += _buf[frame][channel] * _buf[frame][channel];
+						sample_t & s = out[frame * _frameStride];
+						s = d * s + w * pp->buffer[frame];
+						out_sum += s * s;
 					}
 					++channel;
 					break;
+				}
 				case AUDIO_RATE_OUTPUT:
 				case CONTROL_RATE_OUTPUT:
 					break;
@@ -256,17 +326,7 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 		}
 	}
 
-	if( o_buf != nullptr )
-	{
-		sampleBack( _buf, o_buf, m_maxSampleRate );
-	}
-
 	checkGate( out_sum / frames );
-
-
-	bool is_running = isRunning();
-	m_pluginMutex.unlock();
-	return( is_running );
 }
 
 
@@ -326,7 +386,7 @@ void LadspaEffect::pluginInstantiation()
 					manager->isPortInput( m_key, port ) )
 				{
 					p->rate = CHANNEL_IN;
-					p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->framesPerPeriod() );
+					p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->maxFramesPerPeriod() );
 					inbuf[ inputch ] = p->buffer;
 					inputch++;
 				}
@@ -341,19 +401,19 @@ void LadspaEffect::pluginInstantiation()
 					}
 					else
 					{
-						p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->framesPerPeriod() );
+						p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->maxFramesPerPeriod() );
 						m_inPlaceBroken = true;
 					}
 				}
 				else if( manager->isPortInput( m_key, port ) )
 				{
 					p->rate = AUDIO_RATE_INPUT;
-					p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->framesPerPeriod() );
+					p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->maxFramesPerPeriod() );
 				}
 				else
 				{
 					p->rate = AUDIO_RATE_OUTPUT;
-					p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->framesPerPeriod() );
+					p->buffer = MM_ALLOC<LADSPA_Data>( Engine::audioEngine()->maxFramesPerPeriod() );
 				}
 			}
 			else
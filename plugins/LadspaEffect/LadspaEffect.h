@@ -49,6 +49,8 @@ public:
 
 	bool processAudioBuffer( sampleFrame * _buf,
 							const fpp_t _frames ) override;
+	bool supportsPlanarBuffers() const override;
+	bool processPlanarAudioBuffer( PlanarBuffer & _buf ) override;
 	
 	void setControl( int _control, LADSPA_Data _data );
 
@@ -71,6 +73,12 @@ private:
 	void pluginInstantiation();
 	void pluginDestruction();
 
+	//! Runs the plugin on the channels starting at @p _samples, with the
+	//! given distances between channels and between frames in samples.
+	//! Contiguous channels are connected to the input ports directly.
+	void processChannels( sample_t * _samples, const fpp_t _frames,
+					int _channelStride, int _frameStride );
+
 	static sample_rate_t maxSamplerate( const QString & _name );
 
 
@@ -60,7 +60,8 @@ Plugin::Descriptor PLUGIN_EXPORT lv2effect_plugin_descriptor =
 Lv2Effect::Lv2Effect(Model* parent, const Descriptor::SubPluginFeatures::Key *key) :
 	Effect(&lv2effect_plugin_descriptor, parent, key),
 	m_controls(this, key->attributes["uri"]),
-	m_tmpOutputSmps(Engine::audioEngine()->framesPerPeriod())
+	m_tmpOutputSmps(Engine::audioEngine()->maxFramesPerPeriod()),
+	m_tmpOutputPlanar(Engine::audioEngine()->maxFramesPerPeriod())
 {
 }
 
@@ -78,6 +79,7 @@ bool Lv2Effect::processAudioBuffer(sampleFrame *buf, const fpp_t frames)
 //	m_pluginMutex.lock();
 	m_controls.run(frames);
 //	m_pluginMutex.unlock();
+	updateLatency();
 
 	m_controls.copyModelsToLmms();
 	m_controls.copyBuffersToLmms(m_tmpOutputSmps.data(), frames);
@@ -102,6 +104,54 @@ bool Lv2Effect::processAudioBuffer(sampleFrame *buf, const fpp_t frames)
 
 
 
+void Lv2Effect::updateLatency()
+{
+	// plugins report their latency in each run, it may change with controls
+	const f_cnt_t latency = m_controls.latency();
+	if (m_latency.exchange(latency) != latency) { notifyLatencyChanged(); }
+}
+
+
+
+
+bool Lv2Effect::processPlanarAudioBuffer(PlanarBuffer& buf)
+{
+	if (!isEnabled() || !isRunning()) { return false; }
+	const fpp_t frames = buf.frames();
+	Q_ASSERT(frames <= m_tmpOutputPlanar.maxFrames());
+
+	m_controls.copyModelsFromLmms();
+
+	// the plugin reads buf and writes m_tmpOutputPlanar itself
+	m_tmpOutputPlanar.setFrames(frames);
+	m_controls.run(buf, m_tmpOutputPlanar);
+	updateLatency();
+
+	m_controls.copyModelsToLmms();
+
+	double outSum = .0;
+	bool corrupt = wetLevel() < 0; // #3261 - if w < 0, bash w := 0, d := 1
+	const float d = corrupt ? 1 : dryLevel();
+	const float w = corrupt ? 0 : wetLevel();
+	for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		sample_t* out = buf.channel(ch);
+		const sample_t* wet = m_tmpOutputPlanar.channel(ch);
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			out[f] = d * out[f] + w * wet[f];
+			auto s = static_cast<double>(out[f]);
+			outSum += s*s;
+		}
+	}
+	checkGate(outSum / frames);
+
+	return isRunning();
+}
+
+
+
+
 extern "C"
 {
 
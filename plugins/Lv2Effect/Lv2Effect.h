@@ -25,8 +25,11 @@
 #ifndef LV2_EFFECT_H
 #define LV2_EFFECT_H
 
+#include <atomic>
+
 #include "Effect.h"
 #include "Lv2FxControls.h"
+#include "PlanarBuffer.h"
 
 namespace lmms
 {
@@ -45,14 +48,21 @@ public:
 	bool isValid() const { return m_controls.isValid(); }
 
 	bool processAudioBuffer( sampleFrame* buf, const fpp_t frames ) override;
+	bool supportsPlanarBuffers() const override { return true; }
+	bool processPlanarAudioBuffer(PlanarBuffer& buf) override;
 	EffectControls* controls() override { return &m_controls; }
+	f_cnt_t latency() const override { return m_latency; }
 
 	Lv2FxControls* lv2Controls() { return &m_controls; }
 	const Lv2FxControls* lv2Controls() const { return &m_controls; }
 
 private:
+	void updateLatency();
+
 	Lv2FxControls m_controls;
+	std::atomic<f_cnt_t> m_latency{0};
 	std::vector<sampleFrame> m_tmpOutputSmps;
+	PlanarBuffer m_tmpOutputPlanar;
 };
 
 
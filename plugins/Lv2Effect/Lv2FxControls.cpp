@@ -42,6 +42,9 @@ Lv2FxControls::Lv2FxControls(class Lv2Effect *effect, const QString& uri) :
 	{
 		connect(Engine::audioEngine(), &AudioEngine::sampleRateChanged,
 			this, [this](){Lv2ControlBase::reloadPlugin();});
+		// emitted while the engine is paused between two periods
+		connect(Engine::audioEngine(), &AudioEngine::framesPerPeriodChanged,
+			this, [this](){Lv2ControlBase::updateBlockLength();}, Qt::DirectConnection);
 	}
 }
 
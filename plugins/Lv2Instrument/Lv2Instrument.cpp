@@ -82,6 +82,9 @@ Lv2Instrument::Lv2Instrument(InstrumentTrack *instrumentTrackArg,
 			this, SLOT(updatePitchRange()), Qt::DirectConnection);
 		connect(Engine::audioEngine(), &AudioEngine::sampleRateChanged,
 			this, [this](){Lv2ControlBase::reloadPlugin();});
+		// emitted while the engine is paused between two periods
+		connect(Engine::audioEngine(), &AudioEngine::framesPerPeriodChanged,
+			this, [this](){Lv2ControlBase::updateBlockLength();}, Qt::DirectConnection);
 
 		// now we need a play-handle which cares for calling play()
 		auto iph = new InstrumentPlayHandle(this, instrumentTrackArg);
@@ -162,6 +165,9 @@ void Lv2Instrument::play(sampleFrame *buf)
 
 	run(fpp);
 
+	const f_cnt_t latency = Lv2ControlBase::latency();
+	if (m_latency.exchange(latency) != latency) { notifyLatencyChanged(); }
+
 	copyModelsToLmms();
 	copyBuffersToLmms(buf, fpp);
 
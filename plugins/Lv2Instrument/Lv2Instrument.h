@@ -25,6 +25,7 @@
 #ifndef LV2_INSTRUMENT_H
 #define LV2_INSTRUMENT_H
 
+#include <atomic>
 #include <QString>
 
 #include "Instrument.h"
@@ -78,6 +79,8 @@ public:
 	void playNote(NotePlayHandle *nph, sampleFrame *) override;
 #endif
 	void play(sampleFrame *buf) override;
+	//! Latency the plugin reported in its last run
+	f_cnt_t latency() const override { return m_latency; }
 
 	/*
 		misc
@@ -103,6 +106,7 @@ private:
 #ifdef LV2_INSTRUMENT_USE_MIDI
 	std::array<int, NumKeys> m_runningNotes = {};
 #endif
+	std::atomic<f_cnt_t> m_latency{0};
 
 	friend class gui::Lv2InsView;
 };
@@ -1007,7 +1007,7 @@ MonstroInstrument::MonstroInstrument( InstrumentTrack * _instrument_track ) :
 
 	connect( Engine::audioEngine(), SIGNAL( sampleRateChanged() ), this, SLOT( updateSamplerate() ) );
 
-	m_fpp = Engine::audioEngine()->framesPerPeriod();
+	m_fpp = Engine::audioEngine()->maxFramesPerPeriod();
 
 	updateSamplerate();
 	updateVolume1();
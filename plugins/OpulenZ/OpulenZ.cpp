@@ -158,9 +158,8 @@ OpulenzInstrument::OpulenzInstrument( InstrumentTrack * _instrument_track ) :
 
 	updatePatch();
 
-	// Can the buffer size change suddenly? I bet that would break lots of stuff
-	frameCount = Engine::audioEngine()->framesPerPeriod();
-	renderbuffer = new short[frameCount];
+	// The period size can change between two calls of play()
+	renderbuffer = new short[Engine::audioEngine()->maxFramesPerPeriod()];
 
 	// Some kind of sane defaults
 	pitchbend = 0;
@@ -400,6 +399,8 @@ gui::PluginView* OpulenzInstrument::instantiateView( QWidget * _parent )
 
 void OpulenzInstrument::play( sampleFrame * _working_buffer )
 {
+	const fpp_t frameCount = Engine::audioEngine()->framesPerPeriod();
+
 	emulatorMutex.lock();
 	theEmulator->update(renderbuffer, frameCount);
 
@@ -129,7 +129,6 @@ private slots:
 private:
 	Copl *theEmulator;
 	QString storedname;
-	fpp_t frameCount;
 	short *renderbuffer;
 	int voiceNote[OPL2_VOICES];
 	// Least recently used voices
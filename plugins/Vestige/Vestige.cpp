@@ -155,6 +155,7 @@ VestigeInstrument::VestigeInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &vestige_plugin_descriptor ),
 	m_plugin( nullptr ),
 	m_pluginMutex(),
+	m_latency( 0 ),
 	m_subWindow( nullptr ),
 	m_scrollArea( nullptr ),
 	knobFModel( nullptr ),
@@ -385,6 +386,10 @@ void VestigeInstrument::loadFile( const QString & _file )
 		instrumentTrack()->setName( m_plugin->name() );
 	}
 
+	connect( m_plugin, SIGNAL( latencyChanged() ),
+			this, SLOT( updateLatency() ), Qt::DirectConnection );
+	updateLatency();
+
 	m_pluginMutex.unlock();
 
 	emit dataChanged();
@@ -476,6 +481,21 @@ void VestigeInstrument::closePlugin( void )
 	delete m_plugin;
 	m_plugin = nullptr;
 	m_pluginMutex.unlock();
+
+	if( m_latency.exchange( 0 ) != 0 )
+	{
+		notifyLatencyChanged();
+	}
+}
+
+
+
+
+void VestigeInstrument::updateLatency()
+{
+	// called with m_pluginMutex locked
+	m_latency = m_plugin != nullptr ? m_plugin->latency() : 0;
+	notifyLatencyChanged();
 }
 
 
@@ -27,6 +27,8 @@
 #define _VESTIGE_H
 
 
+#include <atomic>
+
 #include <QMdiSubWindow>
 #include <QMutex>
 
@@ -77,6 +79,11 @@ public:
 
 	virtual bool handleMidiEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset = 0 );
 
+	virtual f_cnt_t latency() const
+	{
+		return m_latency;
+	}
+
 	virtual gui::PluginView* instantiateView( QWidget * _parent );
 
 protected slots:
@@ -84,12 +91,17 @@ protected slots:
 	void handleConfigChange( QString cls, QString attr, QString value );
 	void reloadPlugin();
 
+private slots:
+	void updateLatency();
+
 private:
 	void closePlugin();
 
 
 	VstPlugin * m_plugin;
 	QMutex m_pluginMutex;
+	// copy of the plugin's latency, m_plugin may be replaced meanwhile
+	std::atomic<f_cnt_t> m_latency;
 
 	QString m_pluginDLL;
 	QMdiSubWindow * m_subWindow;
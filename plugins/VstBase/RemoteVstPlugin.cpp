@@ -139,13 +139,10 @@ namespace lmms
 class RemoteVstPlugin;
 }
 
-lmms::RemoteVstPlugin * __plugin = nullptr;
-
 #ifndef NATIVE_LINUX_VST
+// processes using Win32 host a single plugin
+lmms::RemoteVstPlugin * __plugin = nullptr;
 HWND __MessageHwnd = nullptr;
-DWORD __processingThreadId = 0;
-#else
-pthread_t __processingThreadId = 0;
 #endif
 
 namespace lmms
@@ -227,6 +224,8 @@ public:
 		return m_initialized;
 	}
 
+	bool startProcessingThread();
+
 
 	// set given tempo
 	void setBPM( const bpm_t _bpm )
@@ -309,6 +308,16 @@ public:
 	// has to be called as soon as input- or output-count changes
 	int updateInOutCount();
 
+	// tells the host how many frames the plugin delays its output
+	void updateLatency()
+	{
+		if( m_plugin )
+		{
+			sendMessage( message( IdVstPluginLatency ).
+					addInt( m_plugin->initialDelay ) );
+		}
+	}
+
 	inline void lockShm()
 	{
 		m_shmLock.lock();
@@ -381,7 +390,10 @@ public:
 #ifndef NATIVE_LINUX_VST
 	static DWORD WINAPI guiEventLoop();
 #else
-	void guiEventLoop();
+	//! Runs the GUI of all instances until none is left
+	static void guiEventLoop();
+	//! Hosts another plugin, whose channel @p _m gives, see IdAddInstance
+	static void addInstance( const message & _m );
 #endif
 	
 #ifndef NATIVE_LINUX_VST
@@ -416,6 +428,11 @@ private:
 		bool m_resumed;
 	};
 
+	//! The instance hosting @p _effect
+	static RemoteVstPlugin * instance( AEffect * _effect );
+
+	bool isProcessingThread() const;
+
 	// callback used by plugin for being able to communicate with it's host
 	static intptr_t VST_CALL_CONV hostCallback( AEffect * _effect, int32_t _opcode,
 					int32_t _index, intptr_t _value,
@@ -461,7 +478,10 @@ private:
 
 	bool m_processing;
 
-#ifdef NATIVE_LINUX_VST
+#ifndef NATIVE_LINUX_VST
+	DWORD m_processingThreadId = 0;
+#else
+	pthread_t m_processingThread = 0;
 	pthread_mutex_t message_mutex = PTHREAD_MUTEX_INITIALIZER;
 	bool m_shouldQuit = false;
 #endif
@@ -478,6 +498,14 @@ private:
 	using VstMidiEventList = std::vector<VstMidiEvent>;
 	VstMidiEventList m_midiEvents;
 
+	// since MIDI-events are not received immediately, we have to have
+	// them stored somewhere even after dispatcher-call
+	static constexpr int MidiEventBufferCount = 1024;
+	char m_eventsBuffer[sizeof( VstEvents ) + sizeof( VstMidiEvent * ) * MidiEventBufferCount];
+	VstMidiEvent m_vme[MidiEventBufferCount];
+
+	VstTimeInfo m_timeInfo;
+
 	bpm_t m_bpm;
 	double m_currentSamplePos;
 	int m_currentProgram;
@@ -491,9 +519,21 @@ private:
 	} ;
 
 	in * m_in;
+
+	// all instances of this process, which only the GUI thread adds and
+	// removes
+	static std::vector<RemoteVstPlugin *> s_instances;
+	static std::mutex s_instancesMutex;
+	// the instance whose plugin is being loaded
+	static RemoteVstPlugin * s_loading;
 };
 
 
+std::vector<RemoteVstPlugin *> RemoteVstPlugin::s_instances;
+std::mutex RemoteVstPlugin::s_instancesMutex;
+RemoteVstPlugin * RemoteVstPlugin::s_loading = nullptr;
+
+
 
 
 #ifdef SYNC_WITH_SHM_FIFO
@@ -522,7 +562,12 @@ RemoteVstPlugin::RemoteVstPlugin( const char * socketPath ) :
 	m_currentProgram( -1 ),
 	m_in( nullptr )
 {
+#ifndef NATIVE_LINUX_VST
 	__plugin = this;
+#endif
+	s_instancesMutex.lock();
+	s_instances.push_back( this );
+	s_instancesMutex.unlock();
 
 	m_in = ( in* ) new char[ sizeof( in ) ];
 	m_in->lastppqPos = 0;
@@ -546,6 +591,7 @@ RemoteVstPlugin::RemoteVstPlugin( const char * socketPath ) :
 
 RemoteVstPlugin::~RemoteVstPlugin()
 {
+	leaveBatch();
 	destroyEditor();
 	setResumed( false );
 	pluginDispatch( effClose );
@@ -562,6 +608,68 @@ RemoteVstPlugin::~RemoteVstPlugin()
 
 	delete[] m_inputs;
 	delete[] m_outputs;
+
+	s_instancesMutex.lock();
+	s_instances.erase( std::find( s_instances.begin(), s_instances.end(), this ) );
+	s_instancesMutex.unlock();
+}
+
+
+
+
+bool RemoteVstPlugin::startProcessingThread()
+{
+#ifndef NATIVE_LINUX_VST
+	return CreateThread( nullptr, 0, processingThread, this, 0, nullptr ) != nullptr;
+#else
+	return pthread_create( &m_processingThread, nullptr, processingThread, this ) == 0;
+#endif
+}
+
+
+
+
+RemoteVstPlugin * RemoteVstPlugin::instance( AEffect * _effect )
+{
+	const std::lock_guard<std::mutex> lock( s_instancesMutex );
+	for( auto plugin : s_instances )
+	{
+		if( plugin->m_plugin == _effect )
+		{
+			return plugin;
+		}
+	}
+	// workaround for early callbacks by some plugins, which come before
+	// their main entry returned the effect
+	if( s_loading )
+	{
+		if( s_loading->m_plugin == nullptr )
+		{
+			s_loading->m_plugin = _effect;
+		}
+		return s_loading;
+	}
+	return s_instances.size() == 1 ? s_instances.front() : nullptr;
+}
+
+
+
+
+bool RemoteVstPlugin::isProcessingThread() const
+{
+#ifndef NATIVE_LINUX_VST
+	if( GetCurrentThreadId() == m_processingThreadId )
+#else
+	if( pthread_equal( pthread_self(), m_processingThread ) )
+#endif
+	{
+		return true;
+	}
+#ifndef SYNC_WITH_SHM_FIFO
+	return RemotePluginBatchClient::isBatchThread();
+#else
+	return false;
+#endif
 }
 
 
@@ -710,8 +818,12 @@ bool RemoteVstPlugin::processMessage( const message & _m )
 #endif
 			break;
 		}
-		
+
 #ifdef NATIVE_LINUX_VST
+		case IdAddInstance:
+			addInstance( _m );
+			break;
+
 		case IdQuit:
 		{
 			m_shouldQuit = true;
@@ -768,6 +880,7 @@ void RemoteVstPlugin::init( const std::string & _plugin_file )
 					addString( pluginProductString() ) );
 	sendMessage( message( IdVstParameterCount ).
 					addInt( m_plugin->numParams ) );
+	updateLatency();
 
 	sendMessage( IdInitDone );
 
@@ -997,7 +1110,14 @@ bool RemoteVstPlugin::load( const std::string & _plugin_file )
 		return false;
 	}
 
-	m_plugin = mainEntry( hostCallback );
+	s_instancesMutex.lock();
+	s_loading = this;
+	s_instancesMutex.unlock();
+	AEffect * effect = mainEntry( hostCallback );
+	s_instancesMutex.lock();
+	s_loading = nullptr;
+	m_plugin = effect;
+	s_instancesMutex.unlock();
 	if( m_plugin == nullptr )
 	{
 		debugMessage( "mainEntry procedure returned nullptr\n" );
@@ -1032,14 +1152,7 @@ void RemoteVstPlugin::process( const sampleFrame * _in, sampleFrame * _out )
 	// first we gonna post all MIDI-events we enqueued so far
 	if( m_midiEvents.size() )
 	{
-		// since MIDI-events are not received immediately, we
-		// have to have them stored somewhere even after
-		// dispatcher-call, so we create static copies of the
-		// data and post them
-#define MIDI_EVENT_BUFFER_COUNT		1024
-		static char eventsBuffer[sizeof( VstEvents ) + sizeof( VstMidiEvent * ) * MIDI_EVENT_BUFFER_COUNT];
-		static VstMidiEvent vme[MIDI_EVENT_BUFFER_COUNT];
-
+		// we post copies of the data, see m_eventsBuffer
 		// first sort events chronologically, since some plugins
 		// (e.g. Sinnah) can hang if they're out of order
 		std::stable_sort( m_midiEvents.begin(), m_midiEvents.end(),
@@ -1048,15 +1161,15 @@ void RemoteVstPlugin::process( const sampleFrame * _in, sampleFrame * _out )
 					return a.deltaFrames < b.deltaFrames;
 				} );
 
-		auto events = (VstEvents*)eventsBuffer;
+		auto events = (VstEvents*)m_eventsBuffer;
 		events->reserved = 0;
 		events->numEvents = m_midiEvents.size();
 
 		int idx = 0;
 		for( VstMidiEventList::iterator it = m_midiEvents.begin(); it != m_midiEvents.end(); ++it, ++idx )
 		{
-			memcpy( &vme[idx], &*it, sizeof( VstMidiEvent ) );
-			events->events[idx] = (VstEvent *) &vme[idx];
+			memcpy( &m_vme[idx], &*it, sizeof( VstMidiEvent ) );
+			events->events[idx] = (VstEvent *) &m_vme[idx];
 		}
 
 		m_midiEvents.clear();
@@ -1665,11 +1778,7 @@ int RemoteVstPlugin::updateInOutCount()
 		return 1;
 	}
 	
-#ifndef NATIVE_LINUX_VST
-	if( GetCurrentThreadId() == __processingThreadId )
-#else
-	if( pthread_equal(pthread_self(), __processingThreadId) )
-#endif
+	if( isProcessingThread() )
 	{
 		debugMessage( "Plugin requested I/O change from processing "
 			"thread. Request denied; stability may suffer.\n" );
@@ -1711,7 +1820,7 @@ int RemoteVstPlugin::updateInOutCount()
 
 //#define DEBUG_CALLBACKS
 #ifdef DEBUG_CALLBACKS
-#define SHOW_CALLBACK __plugin->debugMessage
+#define SHOW_CALLBACK plugin->debugMessage
 #else
 #define SHOW_CALLBACK(...)
 #endif
@@ -1728,19 +1837,17 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 					int32_t _index, intptr_t _value,
 						void * _ptr, float _opt )
 {
-	static VstTimeInfo _timeInfo;
+	RemoteVstPlugin * plugin = instance( _effect );
+	if( plugin == nullptr )
+	{
+		return 0;
+	}
 #ifdef DEBUG_CALLBACKS
 	char buf[64];
 	sprintf( buf, "host-callback, opcode = %d\n", (int) _opcode );
 	SHOW_CALLBACK( buf );
 #endif
 
-	// workaround for early callbacks by some plugins
-	if( __plugin && __plugin->m_plugin == nullptr )
-	{
-		__plugin->m_plugin = _effect;
-	}
-
 	switch( _opcode )
 	{
 		case audioMasterAutomate:
@@ -1765,7 +1872,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 #ifndef NATIVE_LINUX_VST
 			PostMessage( __MessageHwnd, WM_USER, GiveIdle, 0 );
 #else
-			__plugin->sendX11Idle();
+			plugin->sendX11Idle();
 #endif
 			return 0;
 
@@ -1786,11 +1893,12 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			// fields are required (see valid masks above), as some
 			// items may require extensive conversions
 
-			const auto syncData = __plugin->getVstSyncData();
+			const auto syncData = plugin->getVstSyncData();
+			VstTimeInfo & _timeInfo = plugin->m_timeInfo;
 			assert(syncData != nullptr);
 
 			memset( &_timeInfo, 0, sizeof( _timeInfo ) );
-			_timeInfo.samplePos = __plugin->m_currentSamplePos;
+			_timeInfo.samplePos = plugin->m_currentSamplePos;
 			_timeInfo.sampleRate = syncData->m_sampleRate;
 			_timeInfo.flags = 0;
 			_timeInfo.tempo = syncData->m_bpm;
@@ -1807,19 +1915,19 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 				_timeInfo.flags |= kVstTransportCycleActive;
 			}
 
-			if (syncData->ppqPos != __plugin->m_in->m_Timestamp)
+			if (syncData->ppqPos != plugin->m_in->m_Timestamp)
 			{
 				_timeInfo.ppqPos = syncData->ppqPos;
-				__plugin->m_in->lastppqPos = syncData->ppqPos;
-				__plugin->m_in->m_Timestamp = syncData->ppqPos;
+				plugin->m_in->lastppqPos = syncData->ppqPos;
+				plugin->m_in->m_Timestamp = syncData->ppqPos;
 			}
 			else if (syncData->isPlaying)
 			{
-				__plugin->m_in->lastppqPos +=
+				plugin->m_in->lastppqPos +=
 					syncData->m_bpm / 60.0
 					* syncData->m_bufferSize
 					/ syncData->m_sampleRate;
-				_timeInfo.ppqPos = __plugin->m_in->lastppqPos;
+				_timeInfo.ppqPos = plugin->m_in->lastppqPos;
 			}
 //			_timeInfo.ppqPos = syncData->ppqPos;
 			_timeInfo.flags |= kVstPpqPosValid;
@@ -1835,12 +1943,12 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			_timeInfo.flags |= kVstBarsValid;
 
 			if ((_timeInfo.flags & (kVstTransportPlaying | kVstTransportCycleActive))
-				!= (__plugin->m_in->m_lastFlags & (kVstTransportPlaying | kVstTransportCycleActive))
+				!= (plugin->m_in->m_lastFlags & (kVstTransportPlaying | kVstTransportCycleActive))
 				|| syncData->m_playbackJumped)
 			{
 				_timeInfo.flags |= kVstTransportChanged;
 			}
-			__plugin->m_in->m_lastFlags = _timeInfo.flags;
+			plugin->m_in->m_lastFlags = _timeInfo.flags;
 
 			return (intptr_t) &_timeInfo;
 		}
@@ -1853,7 +1961,8 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterIOChanged:
 			SHOW_CALLBACK( "amc: audioMasterIOChanged\n" );
 			// numInputs, numOutputs, and/or latency has changed
-			return __plugin->updateInOutCount();
+			plugin->updateLatency();
+			return plugin->updateInOutCount();
 
 #ifdef OLD_VST_SDK
 		case audioMasterWantMidi:
@@ -1869,7 +1978,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 
 		case audioMasterTempoAt:
 			SHOW_CALLBACK( "amc: audioMasterTempoAt\n" );
-			return __plugin->m_bpm * 10000;
+			return plugin->m_bpm * 10000;
 
 		case audioMasterGetNumAutomatableParameters:
 			SHOW_CALLBACK( "amc: audioMasterGetNumAutomatable"
@@ -1942,14 +2051,14 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterSizeWindow:
 		{
 			SHOW_CALLBACK( "amc: audioMasterSizeWindow\n" );
-			if( __plugin->m_window == 0 )
+			if( plugin->m_window == 0 )
 			{
 				return 0;
 			}
-			__plugin->m_windowWidth = _index;
-			__plugin->m_windowHeight = _value;
+			plugin->m_windowWidth = _index;
+			plugin->m_windowHeight = _value;
 #ifndef NATIVE_LINUX_VST
-			HWND window = __plugin->m_window;
+			HWND window = plugin->m_window;
 			DWORD dwStyle = GetWindowLongPtr( window, GWL_STYLE );
 			RECT windowSize = { 0, 0, (int) _index, (int) _value };
 			AdjustWindowRect( &windowSize, dwStyle, false );
@@ -1959,32 +2068,32 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 					SWP_NOACTIVATE | SWP_NOMOVE |
 					SWP_NOOWNERZORDER | SWP_NOZORDER );
 #else
-			XResizeWindow(__plugin->m_display, __plugin->m_window, (int) _index, (int) _value);
-			XFlush(__plugin->m_display);
+			XResizeWindow(plugin->m_display, plugin->m_window, (int) _index, (int) _value);
+			XFlush(plugin->m_display);
 #endif
-			__plugin->sendMessage(
+			plugin->sendMessage(
 				message( IdVstPluginEditorGeometry ).
-					addInt( __plugin->m_windowWidth ).
-					addInt( __plugin->m_windowHeight ) );
+					addInt( plugin->m_windowWidth ).
+					addInt( plugin->m_windowHeight ) );
 			return 1;
 		}
 
 		case audioMasterGetSampleRate:
 			SHOW_CALLBACK( "amc: audioMasterGetSampleRate\n" );
-			return __plugin->sampleRate();
+			return plugin->sampleRate();
 
 		case audioMasterGetBlockSize:
 			SHOW_CALLBACK( "amc: audioMasterGetBlockSize\n" );
 
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetInputLatency:
 			SHOW_CALLBACK( "amc: audioMasterGetInputLatency\n" );
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetOutputLatency:
 			SHOW_CALLBACK( "amc: audioMasterGetOutputLatency\n" );
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetCurrentProcessLevel:
 			SHOW_CALLBACK( "amc: audioMasterGetCurrentProcess"
@@ -2079,7 +2188,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 #ifndef NATIVE_LINUX_VST
 			PostMessage( __MessageHwnd, WM_USER, GiveIdle, 0 );
 #else
-			__plugin->sendX11Idle();
+			plugin->sendX11Idle();
 #endif
 			return 0;
 
@@ -2205,14 +2314,13 @@ DWORD WINAPI RemoteVstPlugin::processingThread( LPVOID _param )
 void * RemoteVstPlugin::processingThread(void * _param)
 #endif
 {
+	RemoteVstPlugin * _this = static_cast<RemoteVstPlugin *>( _param );
 #ifndef NATIVE_LINUX_VST
-	__processingThreadId = GetCurrentThreadId();
+	_this->m_processingThreadId = GetCurrentThreadId();
 #else
-	__processingThreadId = pthread_self();
+	_this->m_processingThread = pthread_self();
 #endif
 
-	RemoteVstPlugin * _this = static_cast<RemoteVstPlugin *>( _param );
-
 	RemotePluginClient::message m;
 	while( ( m = _this->receiveMessage() ).id != IdQuit )
 	{
@@ -2303,37 +2411,68 @@ void RemoteVstPlugin::guiEventLoop()
 	XEvent e;
 	while(true)
 	{
-		//if (XQLength(m_display) > 0)
-		if (m_display && XPending(m_display) > 0)
+		s_instancesMutex.lock();
+		// instances are only added and removed here, so it's safe to
+		// work on a copy
+		const std::vector<RemoteVstPlugin *> instances = s_instances;
+		s_instancesMutex.unlock();
+		if (instances.empty())
 		{
-			XNextEvent(m_display, &e);
-		
-			if (e.type == ClientMessage && e.xclient.data.l[0] == m_wmDeleteMessage)
-			{
-				hideEditor();
-			}
+			break;
 		}
 
-		// needed by ZynAddSubFX UI
-		if (__plugin->isInitialized())
+		for (auto plugin : instances)
 		{
-			__plugin->idle();
-		}
-		
-		if(__plugin->isInitialized() && !__plugin->isProcessing() )
-		{
-			__plugin->processUIThreadMessages();
+			//if (XQLength(plugin->m_display) > 0)
+			if (plugin->m_display && XPending(plugin->m_display) > 0)
+			{
+				XNextEvent(plugin->m_display, &e);
+
+				if (e.type == ClientMessage && e.xclient.data.l[0] == plugin->m_wmDeleteMessage)
+				{
+					plugin->hideEditor();
+				}
+			}
+
+			// needed by ZynAddSubFX UI
+			if (plugin->isInitialized())
+			{
+				plugin->idle();
+			}
+
+			if(plugin->isInitialized() && !plugin->isProcessing() )
+			{
+				plugin->processUIThreadMessages();
+			}
 		}
-		
+
 		nanosleep(&tim, &tim2);
-		
-		if (m_shouldQuit) 
+
+		for (auto plugin : instances)
 		{
-			__plugin->hideEditor();
-			break;
+			if (plugin->m_shouldQuit)
+			{
+				plugin->hideEditor();
+				pthread_join(plugin->m_processingThread, nullptr);
+				delete plugin;
+			}
 		}
 	}
 }
+
+
+
+
+void RemoteVstPlugin::addInstance( const message & _m )
+{
+	// processes messages until the plugin is loaded, like the first
+	// instance
+	auto plugin = new RemoteVstPlugin( _m.getString( 0 ).c_str() );
+	if( !plugin->isInitialized() || !plugin->startProcessingThread() )
+	{
+		delete plugin;
+	}
+}
 #endif // NATIVE_LINUX_VST
 
 
@@ -2505,38 +2644,36 @@ int main( int _argc, char * * _argv )
 	// constructor automatically will process messages until it receives
 	// a IdVstLoadPlugin message and processes it
 #ifdef SYNC_WITH_SHM_FIFO
-	__plugin = new RemoteVstPlugin( _argv[1], _argv[2] );
+	auto plugin = new RemoteVstPlugin( _argv[1], _argv[2] );
 #else
-	__plugin = new RemoteVstPlugin( _argv[1] );
+	auto plugin = new RemoteVstPlugin( _argv[1] );
 #endif
 
-	if( __plugin->isInitialized() )
+	if( plugin->isInitialized() )
 	{
 		if( RemoteVstPlugin::setupMessageWindow() == false )
 		{
 			return -1;
 		}
-#ifndef NATIVE_LINUX_VST
-		if( CreateThread( nullptr, 0, RemoteVstPlugin::processingThread,
-						__plugin, 0, nullptr ) == nullptr )
-#else
-		int err = 0;
-		err = pthread_create(&__processingThreadId, nullptr, &RemoteVstPlugin::processingThread, __plugin);
-		if (err != 0)
-#endif
+		if( !plugin->startProcessingThread() )
 		{
-			__plugin->debugMessage( "could not create "
+			plugin->debugMessage( "could not create "
 							"processingThread\n" );
 			return -1;
 		}
 
-		__plugin->guiEventLoop();
+		RemoteVstPlugin::guiEventLoop();
 #ifdef NATIVE_LINUX_VST
-		pthread_join(__processingThreadId, nullptr);
+		// further instances are created when the host asks for them, the
+		// loop deletes all of them when they quit
+		plugin = nullptr;
 #endif
 	}
 
-	delete __plugin;
+	delete plugin;
+#ifndef SYNC_WITH_SHM_FIFO
+	lmms::RemotePluginBatchClient::finish();
+#endif
 #ifndef NATIVE_LINUX_VST
 	OleUninitialize();
 #endif
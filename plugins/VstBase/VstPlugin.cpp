@@ -128,6 +128,7 @@ VstPlugin::VstPlugin( const QString & _plugin ) :
 			? ConfigManager::inst()->vstEmbedMethod()
 			: "headless" ),
 	m_version( 0 ),
+	m_latency( 0 ),
 	m_currentProgram()
 {
 	setSplittedChannels( true );
@@ -172,6 +173,8 @@ VstPlugin::VstPlugin( const QString & _plugin ) :
 		break;
 #ifdef LMMS_BUILD_LINUX
 	case ExecutableType::Linux64:
+		// only the native host handles IdAddInstance
+		allowSharedProcess();
 		tryLoad( NATIVE_LINUX_REMOTE_VST_PLUGIN_FILEPATH_64 ); // Default: NativeLinuxRemoteVstPlugin32
 		break;
 #endif
@@ -326,9 +329,7 @@ void VstPlugin::toggleUI()
 
 void VstPlugin::setTempo( bpm_t _bpm )
 {
-	lock();
-	sendMessage( message( IdVstSetTempo ).addInt( _bpm ) );
-	unlock();
+	sendEvent( message( IdVstSetTempo ).addInt( _bpm ) );
 }
 
 
@@ -465,6 +466,16 @@ bool VstPlugin::processMessage( const message & _m )
 			m_allParameterDisplays = _m.getQString();
 			break;
 
+		case IdVstPluginLatency:
+		{
+			const int latency = _m.getInt();
+			if( m_latency.exchange( latency ) != latency )
+			{
+				emit latencyChanged();
+			}
+			break;
+		}
+
 		case IdVstPluginUniqueID:
 			// TODO: display graphically in case of failure
 			printf("unique ID: %s\n", _m.getString().c_str() );
@@ -620,10 +631,8 @@ void VstPlugin::savePreset()
 
 void VstPlugin::setParam( int i, float f )
 {
-	lock();
-	sendMessage( message( IdVstSetParameter ).addInt( i ).addFloat( f ) );
+	sendEvent( message( IdVstSetParameter ).addInt( i ).addFloat( f ) );
 	//waitForMessage( IdVstSetParameter, true );
-	unlock();
 }
 
 
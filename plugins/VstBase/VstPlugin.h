@@ -25,6 +25,8 @@
 #ifndef _VST_PLUGIN_H
 #define _VST_PLUGIN_H
 
+#include <atomic>
+
 #include <QMap>
 #include <QPointer>
 #include <QSize>
@@ -71,6 +73,12 @@ public:
 		return m_version;
 	}
 	
+	//! Frames the plugin delays its output, may change at any time
+	f_cnt_t latency() const override
+	{
+		return m_latency + RemotePlugin::latency();
+	}
+
 	inline const QString & vendorString() const
 	{
 		return m_vendorString;
@@ -156,6 +164,7 @@ private:
 
 	QString m_name;
 	int m_version;
+	std::atomic<int> m_latency;
 	QString m_vendorString;
 	QString m_productString;
 	QString m_currentProgramName;
@@ -144,6 +144,15 @@ void VstEffect::openPlugin( const QString & _plugin )
 
 	delete tf;
 
+	// the plugin may report a new latency whenever it processes
+	auto updateLatency = [this, plugin = m_plugin.data()]() {
+		m_latency = plugin->latency();
+		notifyLatencyChanged();
+	};
+	QObject::connect( m_plugin.data(), &VstPlugin::latencyChanged,
+				m_plugin.data(), updateLatency, Qt::DirectConnection );
+	updateLatency();
+
 	m_key.attributes["file"] = _plugin;
 }
 
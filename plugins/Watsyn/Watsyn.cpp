@@ -332,7 +332,7 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 	if ( _n->totalFramesPlayed() == 0 || _n->m_pluginData == nullptr )
 	{
 		auto w = new WatsynObject(&A1_wave[0], &A2_wave[0], &B1_wave[0], &B2_wave[0], m_amod.value(), m_bmod.value(),
-			Engine::audioEngine()->processingSampleRate(), _n, Engine::audioEngine()->framesPerPeriod(), this);
+			Engine::audioEngine()->processingSampleRate(), _n, Engine::audioEngine()->maxFramesPerPeriod(), this);
 
 		_n->m_pluginData = w;
 	}
@@ -45,10 +45,12 @@ namespace lmms
 
 
 int LocalZynAddSubFx::s_instanceCount = 0;
+int LocalZynAddSubFx::s_denormalKillBufSize = 0;
 
 
 LocalZynAddSubFx::LocalZynAddSubFx() :
 	m_master( nullptr ),
+	m_bufferSize( 0 ),
 	m_ioEngine( nullptr )
 {
 	if( s_instanceCount == 0 )
@@ -69,11 +71,7 @@ LocalZynAddSubFx::LocalZynAddSubFx() :
 
 		srand( time( nullptr ) );
 
-		denormalkillbuf = new float[synth->buffersize];
-		for( int i = 0; i < synth->buffersize; ++i )
-		{
-			denormalkillbuf[i] = (RND-0.5)*1e-16;
-		}
+		allocDenormalKillBuf();
 	}
 
 	++s_instanceCount;
@@ -82,6 +80,7 @@ LocalZynAddSubFx::LocalZynAddSubFx() :
 
 	m_master = new Master();
 	m_master->swaplr = false;
+	m_bufferSize = synth->buffersize;
 }
 
 
@@ -95,7 +94,23 @@ LocalZynAddSubFx::~LocalZynAddSubFx()
 	if( --s_instanceCount == 0 )
 	{
 		delete[] denormalkillbuf;
+		denormalkillbuf = nullptr;
+		s_denormalKillBufSize = 0;
+	}
+}
+
+
+
+
+void LocalZynAddSubFx::allocDenormalKillBuf()
+{
+	delete[] denormalkillbuf;
+	denormalkillbuf = new float[synth->buffersize];
+	for( int i = 0; i < synth->buffersize; ++i )
+	{
+		denormalkillbuf[i] = (RND-0.5)*1e-16;
 	}
+	s_denormalKillBufSize = synth->buffersize;
 }
 
 
@@ -122,8 +137,25 @@ void LocalZynAddSubFx::setSampleRate( int sampleRate )
 
 void LocalZynAddSubFx::setBufferSize( int bufferSize )
 {
+	if( bufferSize == m_bufferSize )
+	{
+		return;
+	}
+
 	synth->buffersize = bufferSize;
 	synth->alias();
+	if( bufferSize > s_denormalKillBufSize )
+	{
+		allocDenormalKillBuf();
+	}
+
+	// everything the master allocated, including the buffers of playing
+	// notes and effects, has the old size
+	delete m_master;
+	m_master = new Master();
+	m_master->swaplr = false;
+	m_bufferSize = bufferSize;
+	m_runningNotes = {};
 }
 
 
@@ -45,6 +45,10 @@ public:
 	void initConfig();
 
 	void setSampleRate( int _sampleRate );
+	//! ZynAddSubFX allocates its buffers with the period size all instances
+	//! of the process share, so the master gets created anew, losing its
+	//! settings. Other instances must not process before they got the new
+	//! size as well.
 	void setBufferSize( int _bufferSize );
 
 	void saveXML( const std::string & _filename );
@@ -68,12 +72,17 @@ public:
 
 
 protected:
+	static void allocDenormalKillBuf();
+
 	static int s_instanceCount;
+	static int s_denormalKillBufSize;
 
 	std::string m_presetsDir;
 
 	std::array<int, NumKeys> m_runningNotes = {};
 	Master * m_master;
+	// the period size m_master has been created for
+	int m_bufferSize;
 	NulEngine* m_ioEngine;
 
 } ;
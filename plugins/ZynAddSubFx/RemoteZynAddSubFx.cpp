@@ -27,7 +27,10 @@
 #include <winsock2.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <queue>
+#include <vector>
 
 #undef CursorShape // is, by mistake, not undefed in FL
 
@@ -51,22 +54,27 @@ public:
 		RemotePluginClient( socketPath ),
 #endif
 		LocalZynAddSubFx(),
-		m_guiSleepTime( 100 ),
+		m_ui( nullptr ),
+		m_exitProgram( 0 ),
 		m_guiExit( false )
 	{
-		Nio::start();
-
 		setInputCount( 0 );
 		sendMessage( IdInitDone );
 		waitForMessage( IdInitDone );
 
 		pthread_mutex_init( &m_guiMutex, nullptr );
-		pthread_create( &m_messageThreadHandle, nullptr, messageLoop, this );
 	}
 
 	~RemoteZynAddSubFx() override
 	{
-		Nio::stop();
+		leaveBatch();
+		pthread_join( m_messageThreadHandle, nullptr );
+		pthread_mutex_destroy( &m_guiMutex );
+	}
+
+	void startMessageLoop()
+	{
+		pthread_create( &m_messageThreadHandle, nullptr, messageLoop, this );
 	}
 
 	void updateSampleRate() override
@@ -82,8 +90,16 @@ public:
 	void messageLoop()
 	{
 		message m;
-		while( ( m = receiveMessage() ).id != IdQuit )
+		while( ( m = receiveMessage() ).id != IdQuit && !isInvalid() )
 		{
+			// replaces the master, see LocalZynAddSubFx::setBufferSize().
+			// The host restarts us on period size changes, so this only
+			// happens before the UI is shown.
+			if( m.id == IdBufferSizeInformation )
+			{
+				processMessage( m );
+				continue;
+			}
 			pthread_mutex_lock( &m_master->mutex );
 			processMessage( m );
 			pthread_mutex_unlock( &m_master->mutex );
@@ -98,6 +114,10 @@ public:
 			case IdQuit:
 				break;
 
+			case IdAddInstance:
+				addInstance( _m );
+				break;
+
 			case IdShowUI:
 			case IdHideUI:
 			case IdLoadSettingsFromFile:
@@ -132,6 +152,20 @@ public:
 		return true;
 	}
 
+	void processBatchedPeriod( int offset ) override
+	{
+		pthread_mutex_lock( &m_master->mutex );
+		RemotePluginClient::processBatchedPeriod( offset );
+		pthread_mutex_unlock( &m_master->mutex );
+	}
+
+	void processBatchedMessage( const message & _m ) override
+	{
+		pthread_mutex_lock( &m_master->mutex );
+		processMessage( _m );
+		pthread_mutex_unlock( &m_master->mutex );
+	}
+
 	// all functions are called while m_master->mutex is held
 	void processMidiEvent( const MidiEvent& event, const f_cnt_t /* _offset */ ) override
 	{
@@ -153,103 +187,235 @@ public:
 		return nullptr;
 	}
 
-	void guiLoop();
+	//! Creates the first instance, which gets its channel from the
+	//! command line
+	static void createFirstInstance( char * * _argv );
+
+	//! Runs the GUI of all instances until none is left
+	static void guiLoop();
 
 private:
-	const int m_guiSleepTime;
+	//! Creates an instance for the channel in @p _m on a thread of its
+	//! own, as it needs the host to answer while this one waits for it
+	static void addInstance( const message & _m );
+	static void * createInstance( void * _arg );
+
+	void processGuiMessages();
+
+	static constexpr int GuiSleepTime = 100;
+
+	// all instances of this process, which are only deleted by the GUI
+	// thread
+	static std::vector<RemoteZynAddSubFx *> s_instances;
+	// instances being created
+	static int s_pendingInstances;
+	static pthread_mutex_t s_instancesMutex;
+	// LocalZynAddSubFx's instance counting is not thread-safe
+	static pthread_mutex_t s_creationMutex;
+
+	MasterUI * m_ui;
+	int m_exitProgram;
 
 	pthread_t m_messageThreadHandle;
 	pthread_mutex_t m_guiMutex;
 	std::queue<RemotePluginClient::message> m_guiMessages;
-	bool m_guiExit;
+	std::atomic<bool> m_guiExit;
 
 } ;
 
 
+std::vector<RemoteZynAddSubFx *> RemoteZynAddSubFx::s_instances;
+int RemoteZynAddSubFx::s_pendingInstances = 0;
+pthread_mutex_t RemoteZynAddSubFx::s_instancesMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t RemoteZynAddSubFx::s_creationMutex = PTHREAD_MUTEX_INITIALIZER;
 
 
-void RemoteZynAddSubFx::guiLoop()
+
+
+void RemoteZynAddSubFx::createFirstInstance( char * * _argv )
 {
-	int exitProgram = 0;
-	MasterUI * ui = nullptr;
+#ifdef SYNC_WITH_SHM_FIFO
+	auto instance = new RemoteZynAddSubFx( _argv[1], _argv[2] );
+#else
+	auto instance = new RemoteZynAddSubFx( _argv[1] );
+#endif
+	Nio::start();
+
+	pthread_mutex_lock( &s_instancesMutex );
+	s_instances.push_back( instance );
+	pthread_mutex_unlock( &s_instancesMutex );
+
+	instance->startMessageLoop();
+}
+
+
+
+
+void RemoteZynAddSubFx::addInstance( const message & _m )
+{
+	pthread_mutex_lock( &s_instancesMutex );
+	++s_pendingInstances;
+	pthread_mutex_unlock( &s_instancesMutex );
+
+	pthread_t thread;
+	pthread_create( &thread, nullptr, createInstance, new message( _m ) );
+	pthread_detach( thread );
+}
+
+
+
+
+void * RemoteZynAddSubFx::createInstance( void * _arg )
+{
+	const auto channel = static_cast<message *>( _arg );
+
+	pthread_mutex_lock( &s_creationMutex );
+#ifdef SYNC_WITH_SHM_FIFO
+	auto instance = new RemoteZynAddSubFx( channel->getString( 0 ),
+						channel->getString( 1 ) );
+#else
+	auto instance = new RemoteZynAddSubFx( channel->getString( 0 ).c_str() );
+#endif
+	pthread_mutex_unlock( &s_creationMutex );
+	delete channel;
+
+	pthread_mutex_lock( &s_instancesMutex );
+	s_instances.push_back( instance );
+	--s_pendingInstances;
+	pthread_mutex_unlock( &s_instancesMutex );
+
+	instance->startMessageLoop();
+	return nullptr;
+}
 
-	while( !m_guiExit )
+
+
+
+void RemoteZynAddSubFx::guiLoop()
+{
+	while( true )
 	{
-		if( ui )
+		pthread_mutex_lock( &s_instancesMutex );
+		if( s_instances.empty() && s_pendingInstances == 0 )
+		{
+			pthread_mutex_unlock( &s_instancesMutex );
+			break;
+		}
+		// new instances are only added to the end, so it's safe to
+		// work on a copy
+		const std::vector<RemoteZynAddSubFx *> instances = s_instances;
+		pthread_mutex_unlock( &s_instancesMutex );
+
+		const bool hasUI = std::any_of( instances.begin(), instances.end(),
+			[]( RemoteZynAddSubFx * instance ) { return instance->m_ui != nullptr; } );
+		if( hasUI )
 		{
-			Fl::wait( m_guiSleepTime / 1000.0 );
+			Fl::wait( GuiSleepTime / 1000.0 );
 		}
 		else
 		{
 #ifdef LMMS_BUILD_WIN32
-			Sleep( m_guiSleepTime );
+			Sleep( GuiSleepTime );
 #else
-			usleep( m_guiSleepTime*1000 );
+			usleep( GuiSleepTime*1000 );
 #endif
 		}
-		if( exitProgram == 1 )
+
+		for( auto instance : instances )
 		{
-			pthread_mutex_lock( &m_master->mutex );
-			sendMessage( IdHideUI );
-			exitProgram = 0;
-			pthread_mutex_unlock( &m_master->mutex );
+			if( !instance->m_guiExit )
+			{
+				instance->processGuiMessages();
+				continue;
+			}
+
+			pthread_mutex_lock( &s_instancesMutex );
+			s_instances.erase( std::find( s_instances.begin(),
+						s_instances.end(), instance ) );
+			// nobody can ask for another instance anymore
+			const bool last = s_instances.empty() && s_pendingInstances == 0;
+			pthread_mutex_unlock( &s_instancesMutex );
+
+			if( instance->m_ui )
+			{
+				Fl::flush();
+				delete instance->m_ui;
+			}
+			if( last )
+			{
+				Nio::stop();
+			}
+			pthread_mutex_lock( &s_creationMutex );
+			delete instance;
+			pthread_mutex_unlock( &s_creationMutex );
 		}
-		pthread_mutex_lock( &m_guiMutex );
-		while( m_guiMessages.size() )
+	}
+}
+
+
+
+
+void RemoteZynAddSubFx::processGuiMessages()
+{
+	if( m_exitProgram == 1 )
+	{
+		pthread_mutex_lock( &m_master->mutex );
+		sendMessage( IdHideUI );
+		m_exitProgram = 0;
+		pthread_mutex_unlock( &m_master->mutex );
+	}
+	pthread_mutex_lock( &m_guiMutex );
+	while( m_guiMessages.size() )
+	{
+		RemotePluginClient::message m = m_guiMessages.front();
+		m_guiMessages.pop();
+		switch( m.id )
 		{
-			RemotePluginClient::message m = m_guiMessages.front();
-			m_guiMessages.pop();
-			switch( m.id )
-			{
-				case IdShowUI:
-					// we only create GUI
-					if( !ui )
-					{
-						Fl::scheme( "plastic" );
-						ui = new MasterUI( m_master, &exitProgram );
-					}
-					ui->showUI();
-					ui->refresh_master_ui();
-					break;
-
-				case IdLoadSettingsFromFile:
+			case IdShowUI:
+				// we only create GUI
+				if( !m_ui )
 				{
-					LocalZynAddSubFx::loadXML( m.getString() );
-					if( ui )
-					{
-						ui->refresh_master_ui();
-					}
-					pthread_mutex_lock( &m_master->mutex );
-					sendMessage( IdLoadSettingsFromFile );
-					pthread_mutex_unlock( &m_master->mutex );
-					break;
+					Fl::scheme( "plastic" );
+					m_ui = new MasterUI( m_master, &m_exitProgram );
 				}
+				m_ui->showUI();
+				m_ui->refresh_master_ui();
+				break;
 
-				case IdLoadPresetFile:
+			case IdLoadSettingsFromFile:
+			{
+				LocalZynAddSubFx::loadXML( m.getString() );
+				if( m_ui )
 				{
-					LocalZynAddSubFx::loadPreset( m.getString(), ui ?
-											ui->npartcounter->value()-1 : 0 );
-					if( ui )
-					{
-						ui->npartcounter->do_callback();
-						ui->updatepanel();
-						ui->refresh_master_ui();
-					}
-					pthread_mutex_lock( &m_master->mutex );
-					sendMessage( IdLoadPresetFile );
-					pthread_mutex_unlock( &m_master->mutex );
-					break;
+					m_ui->refresh_master_ui();
 				}
+				pthread_mutex_lock( &m_master->mutex );
+				sendMessage( IdLoadSettingsFromFile );
+				pthread_mutex_unlock( &m_master->mutex );
+				break;
+			}
 
-				default:
-					break;
+			case IdLoadPresetFile:
+			{
+				LocalZynAddSubFx::loadPreset( m.getString(), m_ui ?
+										m_ui->npartcounter->value()-1 : 0 );
+				if( m_ui )
+				{
+					m_ui->npartcounter->do_callback();
+					m_ui->updatepanel();
+					m_ui->refresh_master_ui();
+				}
+				pthread_mutex_lock( &m_master->mutex );
+				sendMessage( IdLoadPresetFile );
+				pthread_mutex_unlock( &m_master->mutex );
+				break;
 			}
+
+			default:
+				break;
 		}
-		pthread_mutex_unlock( &m_guiMutex );
 	}
-	Fl::flush();
-
-	delete ui;
+	pthread_mutex_unlock( &m_guiMutex );
 }
 
 
@@ -279,18 +445,14 @@ int main( int _argc, char * * _argv )
 #endif
 #endif // LMMS_BUILD_WIN32
 
-
-#ifdef SYNC_WITH_SHM_FIFO
-	RemoteZynAddSubFx * remoteZASF =
-		new RemoteZynAddSubFx( _argv[1], _argv[2] );
-#else
-	auto remoteZASF = new RemoteZynAddSubFx(_argv[1]);
+	// further instances are created when the host asks for them, the
+	// process ends with the last one
+	RemoteZynAddSubFx::createFirstInstance( _argv );
+	RemoteZynAddSubFx::guiLoop();
+#ifndef SYNC_WITH_SHM_FIFO
+	RemotePluginBatchClient::finish();
 #endif
 
-	remoteZASF->guiLoop();
-
-	delete remoteZASF;
-
 
 #ifdef LMMS_BUILD_WIN32
 #ifndef __WINPTHREADS_VERSION
@@ -79,7 +79,14 @@ Plugin::Descriptor PLUGIN_EXPORT zynaddsubfx_plugin_descriptor =
 ZynAddSubFxRemotePlugin::ZynAddSubFxRemotePlugin() :
 	RemotePlugin()
 {
+	// RemoteZynAddSubFx can host several instances
+	allowSharedProcess();
 	init( "RemoteZynAddSubFx", false );
+
+	// the instrument starts us anew instead of telling the running
+	// instance about another period size
+	disconnect( Engine::audioEngine(), &AudioEngine::framesPerPeriodChanged,
+		this, &RemotePlugin::updateBufferSize );
 }
 
 
@@ -108,6 +115,7 @@ ZynAddSubFxInstrument::ZynAddSubFxInstrument(
 	m_hasGUI( false ),
 	m_plugin( nullptr ),
 	m_remotePlugin( nullptr ),
+	m_latency( 0 ),
 	m_portamentoModel( 0, 0, 127, 1, this, tr( "Portamento" ) ),
 	m_filterFreqModel( 64, 0, 127, 1, this, tr( "Filter frequency" ) ),
 	m_filterQModel( 64, 0, 127, 1, this, tr( "Filter resonance" ) ),
@@ -140,6 +148,11 @@ ZynAddSubFxInstrument::ZynAddSubFxInstrument(
 
 	connect( Engine::audioEngine(), SIGNAL( sampleRateChanged() ),
 			this, SLOT( reloadPlugin() ) );
+	// ZynAddSubFX allocates its buffers for a fixed period size. Emitted
+	// while the engine is paused between two periods, so the old instance
+	// doesn't get to process a period of the new size.
+	connect( Engine::audioEngine(), SIGNAL( framesPerPeriodChanged() ),
+			this, SLOT( reloadPlugin() ), Qt::DirectConnection );
 
 	connect( instrumentTrack()->pitchRangeModel(), SIGNAL( dataChanged() ),
 			this, SLOT( updatePitchRange() ), Qt::DirectConnection );
@@ -457,7 +470,7 @@ void ZynAddSubFxInstrument::initPlugin()
 
 		// temporary workaround until the VST synchronization feature gets stripped out of the RemotePluginClient class
 		// causing not to send buffer size information requests
-		m_remotePlugin->sendMessage( RemotePlugin::message( IdBufferSizeInformation ).addInt( Engine::audioEngine()->framesPerPeriod() ) );
+		m_remotePlugin->updateBufferSize();
 
 		m_remotePlugin->showUI();
 		m_remotePlugin->unlock();
@@ -469,7 +482,10 @@ void ZynAddSubFxInstrument::initPlugin()
 		m_plugin->setBufferSize( Engine::audioEngine()->framesPerPeriod() );
 	}
 
+	m_latency = m_remotePlugin ? m_remotePlugin->latency() : 0;
 	m_pluginMutex.unlock();
+
+	notifyLatencyChanged();
 }
 
 
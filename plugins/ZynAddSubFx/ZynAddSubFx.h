@@ -25,6 +25,8 @@
 #ifndef ZYNADDSUBFX_H
 #define ZYNADDSUBFX_H
 
+#include <atomic>
+
 #include <QMap>
 #include <QMutex>
 
@@ -91,6 +93,11 @@ public:
 		return IsSingleStreamed | IsMidiBased;
 	}
 
+	f_cnt_t latency() const override
+	{
+		return m_latency;
+	}
+
 	gui::PluginView* instantiateView( QWidget * _parent ) override;
 
 
@@ -116,6 +123,8 @@ private:
 	QMutex m_pluginMutex;
 	LocalZynAddSubFx * m_plugin;
 	ZynAddSubFxRemotePlugin * m_remotePlugin;
+	// the remote plugin's latency, which is replaced on reload
+	std::atomic<f_cnt_t> m_latency;
 
 	FloatModel m_portamentoModel;
 	FloatModel m_filterFreqModel;
@@ -40,7 +40,9 @@ RemotePluginBase::RemotePluginBase( shmFifo * _in, shmFifo * _out ) :
 #else
 RemotePluginBase::RemotePluginBase() :
 	m_socket( -1 ),
-	m_invalid( false )
+	m_invalid( false ),
+	m_receivePos( 0 ),
+	m_receiveEnd( 0 )
 #endif
 {
 #ifdef LMMS_HAVE_LOCALE_H
@@ -86,15 +88,30 @@ int RemotePluginBase::sendMessage( const message & _m )
 	m_out->unlock();
 	m_out->messageSent();
 #else
-	pthread_mutex_lock( &m_sendMutex );
-	writeInt( _m.id );
-	writeInt( _m.data.size() );
 	int j = 8;
 	for (const auto& str : _m.data)
 	{
-		writeString(str);
 		j += 4 + str.size();
 	}
+
+	pthread_mutex_lock( &m_sendMutex );
+	// one ::write() per message instead of one per field
+	m_sendBuffer.resize( j );
+	char * p = m_sendBuffer.data();
+	const auto put = [&p]( const void * data, std::size_t len )
+	{
+		memcpy( p, data, len );
+		p += len;
+	};
+	const int32_t header[2] = { _m.id, static_cast<int32_t>( _m.data.size() ) };
+	put( header, sizeof( header ) );
+	for (const auto& str : _m.data)
+	{
+		const int32_t len = str.size();
+		put( &len, sizeof( len ) );
+		put( str.data(), len );
+	}
+	write( m_sendBuffer.data(), j );
 	pthread_mutex_unlock( &m_sendMutex );
 #endif
 
@@ -24,15 +24,20 @@
 
 #include "AudioEngine.h"
 
+#include <chrono>
+
 #include "denormals.h"
 
 #include "lmmsconfig.h"
 
 #include "AudioEngineWorkerThread.h"
 #include "AudioPort.h"
+#include "InstrumentTrack.h"
 #include "Mixer.h"
+#include "SampleTrack.h"
 #include "Song.h"
 #include "EnvelopeAndLfoParameters.h"
+#include "MixHelpers.h"
 #include "NotePlayHandle.h"
 #include "ConfigManager.h"
 #include "SamplePlayHandle.h"
@@ -67,26 +72,50 @@ namespace lmms
 using LocklessListElement = LocklessList<PlayHandle*>::Element;
 
 static thread_local bool s_renderingThread;
+// nesting depth of requestChangeInModel() in the current thread
+static thread_local int s_modelChangeDepth = 0;
+
+// how long live activity keeps the fifo writer from rendering ahead
+static const std::int64_t RenderAheadLiveHold = 2000;
+
+static std::int64_t steadyMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
 
 
 
 
 AudioEngine::AudioEngine( bool renderOnly ) :
 	m_renderOnly( renderOnly ),
+	m_audioPorts( new AudioPortList ),
+	m_renderGraphDirty( true ),
+	m_compiledAudioPorts( nullptr ),
+	m_renderEpoch( 0 ),
 	m_framesPerPeriod( DEFAULT_BUFFER_SIZE ),
 	m_inputBufferRead( 0 ),
 	m_inputBufferWrite( 1 ),
 	m_outputBufferRead(nullptr),
 	m_outputBufferWrite(nullptr),
+	m_threadSettings( AudioThreadSettings::current() ),
 	m_workers(),
-	m_numWorkers( QThread::idealThreadCount()-1 ),
+	m_numWorkers( m_threadSettings.numWorkers() ),
 	m_newPlayHandles( PlayHandle::MaxNumber ),
+	m_playHandleRemovals( nullptr ),
 	m_qualitySettings( qualitySettings::Mode_Draft ),
 	m_masterGain( 1.0f ),
 	m_isProcessing( false ),
 	m_audioDev( nullptr ),
 	m_oldAudioDev( nullptr ),
 	m_audioDevStartFailed( false ),
+	m_liveFifoDepth( 1 ),
+	m_renderAheadDepth( 0 ),
+	m_renderAheadState( 0 ),
+	m_renderAheadRewind( false ),
+	m_periodSequence( 0 ),
+	m_latency( 0 ),
+	m_lastLiveActivity( 0 ),
 	m_profiler(),
 	m_metronomeActive(false),
 	m_clearSignal( false ),
@@ -107,6 +136,7 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 
 	// determine FIFO size and number of frames per period
 	int fifoSize = 1;
+	int renderAhead = 0;
 
 	// if not only rendering (that is, using the GUI), load the buffer
 	// size from user configuration
@@ -131,29 +161,45 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 			fifoSize = m_framesPerPeriod / DEFAULT_BUFFER_SIZE;
 			m_framesPerPeriod = DEFAULT_BUFFER_SIZE;
 		}
+
+		// number of periods to render ahead of the audio device while
+		// nothing is played or edited live, 0 turns it off
+		renderAhead = ConfigManager::inst()->value( "audioengine", "renderahead", "0" ).toInt();
 	}
 
-	// allocte the FIFO from the determined size
-	m_fifo = new Fifo( fifoSize );
+	// allocate the FIFO for the largest buffer size, so the buffer size
+	// can change without replacing it
+	m_liveFifoDepth = fifoSize;
+	m_renderAheadDepth = renderAhead;
+	m_fifo = new Fifo( qMax( qMax( fifoSize, renderAhead ),
+				MAXIMUM_BUFFER_SIZE / DEFAULT_BUFFER_SIZE ) );
+	// besides the ones in the fifo, the fifo writer may hold a period
+	// waiting for a free slot and render another one
+	m_periodStarts.resize( m_fifo->size() + 2, PeriodStart{} );
 
-	// now that framesPerPeriod is fixed initialize global BufferManager
-	BufferManager::init( m_framesPerPeriod );
+	// buffers are allocated for the longest period, the period itself
+	// can change at any time
+	BufferManager::init( maxFramesPerPeriod() );
 
-	int outputBufferSize = m_framesPerPeriod * sizeof(surroundSampleFrame);
+	int outputBufferSize = maxFramesPerPeriod() * sizeof(surroundSampleFrame);
 	m_outputBufferRead = static_cast<surroundSampleFrame *>(MemoryHelper::alignedMalloc(outputBufferSize));
 	m_outputBufferWrite = static_cast<surroundSampleFrame *>(MemoryHelper::alignedMalloc(outputBufferSize));
 
 	BufferManager::clear(m_outputBufferRead, m_framesPerPeriod);
 	BufferManager::clear(m_outputBufferWrite, m_framesPerPeriod);
 
+	// the threads started below report what they get anew
+	AudioThreadSettings::clearGrantedReport();
+
+	// create all workers before starting any of them, as each one adds
+	// its queue to the global job queue
 	for( int i = 0; i < m_numWorkers+1; ++i )
 	{
-		auto wt = new AudioEngineWorkerThread(this);
-		if( i < m_numWorkers )
-		{
-			wt->start( QThread::TimeCriticalPriority );
-		}
-		m_workers.push_back( wt );
+		m_workers.push_back( new AudioEngineWorkerThread( this ) );
+	}
+	for( int i = 0; i < m_numWorkers; ++i )
+	{
+		m_workers[i]->start( QThread::TimeCriticalPriority );
 	}
 }
 
@@ -178,7 +224,7 @@ AudioEngine::~AudioEngine()
 
 	while( m_fifo->available() )
 	{
-		delete[] m_fifo->read();
+		delete[] m_fifo->read().buffer;
 	}
 	delete m_fifo;
 
@@ -192,6 +238,12 @@ AudioEngine::~AudioEngine()
 	{
 		delete[] input;
 	}
+
+	for( const auto & retired : m_retiredAudioPorts )
+	{
+		delete retired.first;
+	}
+	delete m_audioPorts.load();
 }
 
 
@@ -257,6 +309,176 @@ void AudioEngine::stopProcessing()
 
 
 
+const surroundSampleFrame * AudioEngine::nextBuffer( fpp_t * frames )
+{
+	if( !hasFifoWriter() )
+	{
+		if( frames )
+		{
+			*frames = m_framesPerPeriod;
+		}
+		return renderNextBuffer();
+	}
+
+	// skip periods that were rendered ahead before the last invalidation
+	while( true )
+	{
+		const RenderedPeriod period = m_fifo->read();
+		bool play = period.buffer == nullptr;
+
+		// remember the period as played unless the generation got bumped
+		std::uint64_t state = m_renderAheadState.load( std::memory_order_acquire );
+		while( !play && renderAheadGeneration( state ) == period.generation )
+		{
+			const std::uint64_t played = ( state & ~std::uint64_t( 0xffffffff ) ) | period.sequence;
+			play = m_renderAheadState.compare_exchange_weak( state, played, std::memory_order_acq_rel );
+		}
+
+		if( play )
+		{
+			if( frames )
+			{
+				*frames = period.frames;
+			}
+			return period.buffer;
+		}
+		delete[] period.buffer;
+	}
+}
+
+
+
+
+void AudioEngine::markLiveActivity()
+{
+	// instruments and effects changing their own models while rendering
+	// aren't live activity
+	if( s_renderingThread || AudioEngineWorkerThread::isWorkerThread() )
+	{
+		return;
+	}
+
+	// the periods rendered ahead so far don't contain what's played or
+	// changed now, so have them rendered again instead of letting it be
+	// heard late
+	const bool renderingAhead = renderAheadDepth() > m_liveFifoDepth;
+	m_lastLiveActivity.store( steadyMilliseconds(), std::memory_order_relaxed );
+	if( renderingAhead )
+	{
+		m_renderAheadRewind = true;
+	}
+}
+
+
+
+
+void AudioEngine::invalidateRenderAhead()
+{
+	// the song has been moved somewhere else, returning to where the
+	// dropped periods started would undo that
+	m_renderAheadRewind = false;
+	m_renderAheadState.fetch_add( std::uint64_t( 1 ) << 32, std::memory_order_acq_rel );
+}
+
+
+
+
+void AudioEngine::rewindRenderAhead()
+{
+	Song * song = Engine::getSong();
+
+	if( m_renderAheadRewind.exchange( false ) )
+	{
+		// bump the generation and take the last period played in one step,
+		// so none of the dropped periods gets played meanwhile
+		std::uint64_t state = m_renderAheadState.load( std::memory_order_acquire );
+		while( !m_renderAheadState.compare_exchange_weak( state, state + ( std::uint64_t( 1 ) << 32 ),
+							std::memory_order_acq_rel ) )
+		{
+		}
+		const unsigned int generation = renderAheadGeneration( state );
+		const std::uint32_t lastPlayed = static_cast<std::uint32_t>( state );
+
+		// periods of older generations, e.g. from before a jump, would
+		// have been dropped anyway
+		const PeriodStart * first = nullptr;
+		f_cnt_t frames = 0;
+		for( const PeriodStart & start : m_periodStarts )
+		{
+			const std::uint32_t age = start.sequence - lastPlayed;
+			if( age == 0 || age > m_periodSequence - lastPlayed || start.generation != generation )
+			{
+				continue;
+			}
+			frames += start.frames;
+			if( first == nullptr || age < first->sequence - lastPlayed )
+			{
+				first = &start;
+			}
+		}
+
+		if( first && song->rewindPlayPos( static_cast<Song::PlayModes>( first->playMode ),
+							first->ticks, first->currentFrame ) )
+		{
+			// the song starts its notes of the dropped periods again.
+			// Chords and arpeggios go before the notes they belong to.
+			const auto startedBySong = []( const NotePlayHandle * nph )
+			{
+				while( nph->parent() )
+				{
+					nph = nph->parent();
+				}
+				return nph->origin() == NotePlayHandle::OriginMidiClip;
+			};
+			for( const bool subNotes : { true, false } )
+			{
+				for( PlayHandleList::Iterator it = m_playHandles.begin(); it != m_playHandles.end(); )
+				{
+					const auto nph = dynamic_cast<NotePlayHandle *>( *it );
+					if( nph && nph->hasParent() == subNotes &&
+						nph->totalFramesPlayed() <= frames && startedBySong( nph ) &&
+						!( nph->affinityMatters() && nph->affinity() != QThread::currentThread() ) )
+					{
+						it = m_playHandles.erase( it );
+						deletePlayHandle( nph );
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+		}
+	}
+
+	// remember where the coming period starts, the fifo writer adds its
+	// generation once it has been rendered
+	PeriodStart & start = m_periodStarts[++m_periodSequence % m_periodStarts.size()];
+	start.sequence = m_periodSequence;
+	start.playMode = song->playMode();
+	start.ticks = song->getPlayPos().getTicks();
+	start.currentFrame = song->getPlayPos().currentFrame();
+	start.frames = m_framesPerPeriod;
+}
+
+
+
+
+int AudioEngine::renderAheadDepth() const
+{
+	// there's nothing to anticipate while the song doesn't play, and
+	// live input has to be heard with the latency of the buffer size
+	if( !Engine::getSong()->isPlaying() ||
+		steadyMilliseconds() - m_lastLiveActivity.load( std::memory_order_relaxed ) < RenderAheadLiveHold )
+	{
+		return m_liveFifoDepth;
+	}
+	return qMax( m_liveFifoDepth, m_renderAheadDepth );
+}
+
+
+
+
 sample_rate_t AudioEngine::baseSampleRate() const
 {
 	sample_rate_t sr = ConfigManager::inst()->value( "audioengine", "samplerate" ).toInt();
@@ -306,6 +528,7 @@ bool AudioEngine::criticalXRuns() const
 
 void AudioEngine::pushInputFrames( sampleFrame * _ab, const f_cnt_t _frames )
 {
+	markLiveActivity();
 	requestChangeInModel();
 
 	f_cnt_t frames = m_inputBufferFrames[ m_inputBufferWrite ];
@@ -339,6 +562,7 @@ const surroundSampleFrame * AudioEngine::renderNextBuffer()
 	m_profiler.startPeriod();
 
 	s_renderingThread = true;
+	++m_renderEpoch;
 
 	if( m_clearSignal )
 	{
@@ -346,28 +570,6 @@ const surroundSampleFrame * AudioEngine::renderNextBuffer()
 		clearInternal();
 	}
 
-	// remove all play-handles that have to be deleted and delete
-	// them if they still exist...
-	// maybe this algorithm could be optimized...
-	ConstPlayHandleList::Iterator it_rem = m_playHandlesToRemove.begin();
-	while( it_rem != m_playHandlesToRemove.end() )
-	{
-		PlayHandleList::Iterator it = std::find( m_playHandles.begin(), m_playHandles.end(), *it_rem );
-
-		if( it != m_playHandles.end() )
-		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			m_playHandles.erase( it );
-		}
-
-		it_rem = m_playHandlesToRemove.erase( it_rem );
-	}
-
 	swapBuffers();
 
 	// prepare master mix (clear internal buffers etc.)
@@ -376,41 +578,83 @@ const surroundSampleFrame * AudioEngine::renderNextBuffer()
 
 	handleMetronome();
 
+	if( hasFifoWriter() )
+	{
+		rewindRenderAhead();
+	}
+
 	// create play-handles for new notes, samples etc.
 	Engine::getSong()->processNextBuffer();
 
-	// add all play-handles that have to be added
-	for( LocklessListElement * e = m_newPlayHandles.popList(); e; )
+	// add all play-handles that have to be added and take out the ones
+	// other threads asked to remove
+	applyPlayHandleRemovals();
+
+	// run all play handles, audio ports and mixer channels as one
+	// dependency graph: play handle -> audio port -> mixer channel ->
+	// receiving channels. Each job gets queued as soon as its last input
+	// is done, so a slow voice only holds up its own track's chain.
+	// A port list published before the flag got set is compiled as well,
+	// as it isn't the one the graph was compiled for.
+	const bool renderGraphDirty = m_renderGraphDirty.exchange( false );
+	const AudioPortList * audioPortList = m_audioPorts.load();
+	if( renderGraphDirty || audioPortList != m_compiledAudioPorts.load() )
 	{
-		m_playHandles += e->value;
-		LocklessListElement * next = e->next;
-		m_newPlayHandles.free( e );
-		e = next;
+		compileRenderGraph( *audioPortList );
+		m_compiledAudioPorts.store( audioPortList );
+	}
+	const AudioPortList & audioPorts = *audioPortList;
+
+	AudioEngineWorkerThread::resetJobQueue( AudioEngineWorkerThread::JobQueue::Dynamic );
+
+	// count the inputs of every audio port before queueing anything
+	for( AudioPort * port : audioPorts )
+	{
+		port->m_pendingInputs = 0;
+	}
+	for( PlayHandle * ph : m_playHandles )
+	{
+		if( ph->requiresProcessing() && ph->audioPort() )
+		{
+			++ph->audioPort()->m_pendingInputs;
+		}
+	}
+
+	mixer->scheduleChannels();
+
+	// ports without any play handle still have to run their effects
+	for( AudioPort * port : audioPorts )
+	{
+		if( port->m_pendingInputs == 0 )
+		{
+			AudioEngineWorkerThread::addJob( port );
+		}
+	}
+	for( PlayHandle * ph : m_playHandles )
+	{
+		AudioEngineWorkerThread::addJob( ph );
 	}
 
-	// STAGE 1: run and render all play handles
-	AudioEngineWorkerThread::fillJobQueue<PlayHandleList>( m_playHandles );
 	AudioEngineWorkerThread::startAndWaitForJobs();
 
+	// do master mix in mixer
+	mixer->masterMix(m_outputBufferWrite);
+
 	// removed all play handles which are done
 	for( PlayHandleList::Iterator it = m_playHandles.begin();
 						it != m_playHandles.end(); )
 	{
-		if( ( *it )->affinityMatters() &&
-			( *it )->affinity() != QThread::currentThread() )
+		PlayHandle * ph = *it;
+		if( ph->affinityMatters() &&
+			ph->affinity() != QThread::currentThread() )
 		{
 			++it;
 			continue;
 		}
-		if( ( *it )->isFinished() )
+		if( ph->isFinished() )
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
 			it = m_playHandles.erase( it );
+			deletePlayHandle( ph );
 		}
 		else
 		{
@@ -418,17 +662,14 @@ const surroundSampleFrame * AudioEngine::renderNextBuffer()
 		}
 	}
 
-	// STAGE 2: process effects of all instrument- and sampletracks
-	AudioEngineWorkerThread::fillJobQueue<QVector<AudioPort *> >( m_audioPorts );
-	AudioEngineWorkerThread::startAndWaitForJobs();
-
-
-	// STAGE 3: do master mix in mixer
-	mixer->masterMix(m_outputBufferWrite);
-
 
 	emit nextAudioBuffer(m_outputBufferRead);
 
+	// the period is over as far as other threads are concerned - nothing
+	// below touches audio ports or play handles
+	++m_renderEpoch;
+	m_renderProgress.notifyAll();
+
 	runChangesInModel();
 
 	// and trigger LFOs
@@ -438,7 +679,8 @@ const surroundSampleFrame * AudioEngine::renderNextBuffer()
 
 	s_renderingThread = false;
 
-	m_profiler.finishPeriod( processingSampleRate(), m_framesPerPeriod );
+	m_profiler.finishPeriod( processingSampleRate(), m_framesPerPeriod,
+				AudioEngineWorkerThread::takeSchedulingTime() );
 
 	return m_outputBufferRead;
 }
@@ -446,6 +688,71 @@ const surroundSampleFrame * AudioEngine::renderNextBuffer()
 
 
 
+void AudioEngine::compileRenderGraph( const AudioPortList & ports )
+{
+	Mixer * mixer = Engine::mixer();
+	mixer->compileSchedule();
+
+	for( AudioPort * port : ports )
+	{
+		const mix_ch_t target = port->nextMixerChannel();
+		port->m_mixerChannel = target < mixer->numChannels()
+			? mixer->mixerChannel( target )
+			: nullptr;
+		// ports don't signal muted channels, see signalMixerChannel()
+		if( port->m_mixerChannel && !port->m_mixerChannel->m_muted )
+		{
+			++port->m_mixerChannel->m_dependencies;
+			port->m_mixerChannel->m_inputPorts.push_back( port );
+		}
+		else
+		{
+			port->setCompensationDelay( 0 );
+		}
+	}
+
+	// plugin delay compensation: all inputs of a channel get delayed to
+	// the slowest one, so the master output lags behind the song by the
+	// latency of its slowest path
+	bool needsReserve = false;
+	m_latency = mixer->compensateLatency( needsReserve );
+	if( needsReserve )
+	{
+		if( Engine::getSong()->isExporting() )
+		{
+			// there's no deadline to miss
+			reserveLatencyCompensation();
+		}
+		else
+		{
+			// the delays are limited to the current delay lines until
+			// they have been grown outside of the render thread
+			QMetaObject::invokeMethod( this, "reserveLatencyCompensation", Qt::QueuedConnection );
+		}
+	}
+}
+
+
+
+
+void AudioEngine::reserveLatencyCompensation()
+{
+	requestChangeInModel();
+	m_audioPortsWriteMutex.lock();
+	for( AudioPort * port : *m_audioPorts.load() )
+	{
+		port->reserveCompensationDelay();
+	}
+	m_audioPortsWriteMutex.unlock();
+	Engine::mixer()->reserveLatencyCompensation();
+	doneChangeInModel();
+
+	invalidateRenderGraph();
+}
+
+
+
+
 void AudioEngine::swapBuffers()
 {
 	m_inputBufferWrite = (m_inputBufferWrite + 1) % 2;
@@ -532,11 +839,17 @@ void AudioEngine::clearNewPlayHandles()
 void AudioEngine::clearInternal()
 {
 	// TODO: m_midiClient->noteOffAll();
-	for (auto ph : m_playHandles)
+	for (PlayHandleList::Iterator it = m_playHandles.begin(); it != m_playHandles.end(); )
 	{
+		PlayHandle * ph = *it;
 		if (ph->type() != PlayHandle::TypeInstrumentPlayHandle)
 		{
-			m_playHandlesToRemove.push_back(ph);
+			it = m_playHandles.erase(it);
+			deletePlayHandle(ph);
+		}
+		else
+		{
+			++it;
 		}
 	}
 }
@@ -546,25 +859,36 @@ void AudioEngine::clearInternal()
 
 AudioEngine::StereoSample AudioEngine::getPeakValues(sampleFrame * ab, const f_cnt_t frames) const
 {
-	sample_t peakLeft = 0.0f;
-	sample_t peakRight = 0.0f;
+	sample_t peakLeft;
+	sample_t peakRight;
+	MixHelpers::peakValues(ab, frames, peakLeft, peakRight);
 
-	for (f_cnt_t f = 0; f < frames; ++f)
-	{
-		float const absLeft = qAbs(ab[f][0]);
-		float const absRight = qAbs(ab[f][1]);
-		if (absLeft > peakLeft)
-		{
-			peakLeft = absLeft;
-		}
+	return StereoSample(peakLeft, peakRight);
+}
 
-		if (absRight > peakRight)
-		{
-			peakRight = absRight;
-		}
+
+
+
+void AudioEngine::setFramesPerPeriod( fpp_t frames )
+{
+	frames = qBound( MINIMUM_BUFFER_SIZE, frames, MAXIMUM_BUFFER_SIZE );
+
+	// like in the constructor, larger buffer sizes are rendered as
+	// several periods which the FIFO holds
+	const int fifoDepth = qMax( 1, frames / maxFramesPerPeriod() );
+	frames = qMin( frames, maxFramesPerPeriod() );
+	if( frames == m_framesPerPeriod && fifoDepth == m_liveFifoDepth )
+	{
+		return;
 	}
 
-	return StereoSample(peakLeft, peakRight);
+	// all buffers are long enough already, so the render thread only has
+	// to be paused between two periods
+	requestChangeInModel();
+	m_framesPerPeriod = frames;
+	m_liveFifoDepth = fifoDepth;
+	emit framesPerPeriodChanged();
+	doneChangeInModel();
 }
 
 
@@ -659,21 +983,105 @@ void AudioEngine::restoreAudioDevice()
 
 
 
+void AudioEngine::addAudioPort(AudioPort * port)
+{
+	m_audioPortsWriteMutex.lock();
+	const AudioPortList * ports = m_audioPorts.load();
+	auto updated = new AudioPortList(*ports);
+	updated->push_back(port);
+	m_audioPorts.store(updated);
+	m_retiredAudioPorts.emplace_back(ports, m_renderEpoch.load());
+	freeRetiredAudioPorts();
+	m_audioPortsWriteMutex.unlock();
+
+	invalidateRenderGraph();
+}
+
+
+
+
 void AudioEngine::removeAudioPort(AudioPort * port)
 {
-	requestChangeInModel();
+	m_audioPortsWriteMutex.lock();
+	const AudioPortList * ports = m_audioPorts.load();
+	if (std::find(ports->begin(), ports->end(), port) == ports->end())
+	{
+		m_audioPortsWriteMutex.unlock();
+		return;
+	}
+	auto updated = new AudioPortList;
+	updated->reserve(ports->size() - 1);
+	std::remove_copy(ports->begin(), ports->end(), std::back_inserter(*updated), port);
+	m_audioPorts.store(updated);
+	m_retiredAudioPorts.emplace_back(ports, m_renderEpoch.load());
+	freeRetiredAudioPorts();
+	m_audioPortsWriteMutex.unlock();
+
+	invalidateRenderGraph();
 
-	QVector<AudioPort *>::Iterator it = std::find(m_audioPorts.begin(), m_audioPorts.end(), port);
-	if (it != m_audioPorts.end())
+	// the caller is about to delete the port
+	waitForRenderPeriod();
+}
+
+
+
+
+void AudioEngine::freeRetiredAudioPorts()
+{
+	auto it = m_retiredAudioPorts.begin();
+	while (it != m_retiredAudioPorts.end())
 	{
-		m_audioPorts.erase(it);
+		if (isRenderPeriodOver(it->second) && it->first != m_compiledAudioPorts.load())
+		{
+			delete it->first;
+			it = m_retiredAudioPorts.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+
+
+
+bool AudioEngine::canChangeModelDirectly() const
+{
+	return s_renderingThread || s_modelChangeDepth > 0 || !m_isProcessing;
+}
+
+
+
+
+void AudioEngine::waitForRenderPeriod()
+{
+	if (s_renderingThread)
+	{
+		return;
+	}
+
+	const std::uint64_t epoch = m_renderEpoch.load();
+	while (epoch % 2 == 1 && m_renderEpoch.load() == epoch)
+	{
+		const EventCount::Key key = m_renderProgress.prepareWait();
+		if (m_renderEpoch.load() != epoch)
+		{
+			m_renderProgress.cancelWait();
+			break;
+		}
+		m_renderProgress.wait(key);
 	}
-	doneChangeInModel();
 }
 
 
 bool AudioEngine::addPlayHandle( PlayHandle* handle )
 {
+	if( handle->type() == PlayHandle::TypePresetPreviewHandle )
+	{
+		markLiveActivity();
+	}
+
 	if( criticalXRuns() == false )
 	{
 		m_newPlayHandles.push( handle );
@@ -691,14 +1099,160 @@ bool AudioEngine::addPlayHandle( PlayHandle* handle )
 }
 
 
+
+
+void AudioEngine::deletePlayHandle(PlayHandle * handle)
+{
+	handle->audioPort()->removePlayHandle(handle);
+	if (handle->type() == PlayHandle::TypeNotePlayHandle)
+	{
+		NotePlayHandleManager::release(static_cast<NotePlayHandle *>(handle));
+	}
+	else
+	{
+		delete handle;
+	}
+}
+
+
+
+
+void AudioEngine::postPlayHandleRemoval(PlayHandleRemoval * removal)
+{
+	removal->removed = false;
+	removal->done = false;
+	removal->next = m_playHandleRemovals.load(std::memory_order_relaxed);
+	while (!m_playHandleRemovals.compare_exchange_weak(removal->next, removal,
+					std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+
+
+void AudioEngine::applyPlayHandleRemovals()
+{
+	// take the requests before the new play handles: a handle added
+	// before a request to remove it is then guaranteed to be found
+	PlayHandleRemoval * removal = m_playHandleRemovals.exchange(nullptr, std::memory_order_acquire);
+
+	adoptNewPlayHandles();
+
+	while (removal)
+	{
+		PlayHandleRemoval * next = removal->next;
+		PlayHandle * ph = removal->handle;
+		if (!ph)
+		{
+			removal->removed = deletePlayHandlesOfTrack(removal->track, removal->port, removal->types);
+		}
+		// the handle may have finished in the meantime and its memory
+		// may now hold a new note
+		else if (m_playHandles.contains(ph) && ph->id() == removal->id)
+		{
+			m_playHandles.remove(ph);
+			removal->removed = true;
+			if (removal->deleteHandle)
+			{
+				deletePlayHandle(ph);
+			}
+		}
+
+		if (removal->async)
+		{
+			// nobody is waiting for this one
+			delete removal;
+		}
+		else
+		{
+			removal->done.store(true, std::memory_order_release);
+		}
+		removal = next;
+	}
+
+	m_renderProgress.notifyAll();
+}
+
+
+
+
+void AudioEngine::adoptNewPlayHandles()
+{
+	for( LocklessListElement * e = m_newPlayHandles.popList(); e; )
+	{
+		m_playHandles.append( e->value );
+		LocklessListElement * next = e->next;
+		m_newPlayHandles.free( e );
+		e = next;
+	}
+}
+
+
+
+
+void AudioEngine::waitForPlayHandleRemoval(const PlayHandleRemoval & removal)
+{
+	while (!removal.done.load(std::memory_order_acquire))
+	{
+		const EventCount::Key key = m_renderProgress.prepareWait();
+		if (removal.done.load(std::memory_order_acquire))
+		{
+			m_renderProgress.cancelWait();
+			break;
+		}
+		m_renderProgress.wait(key);
+	}
+}
+
+
+
+
 void AudioEngine::removePlayHandle(PlayHandle * ph)
 {
-	requestChangeInModel();
 	// check thread affinity as we must not delete play-handles
 	// which were created in a thread different than the audio engine thread
-	if (ph->affinityMatters() && ph->affinity() == QThread::currentThread())
+	const bool deleteHere = ph->affinityMatters() && ph->affinity() == QThread::currentThread();
+
+	if (!canChangeModelDirectly())
+	{
+		if (deleteHere)
+		{
+			// the render thread only takes it out of its list,
+			// deleting it is up to us once that's done
+			PlayHandleRemoval removal;
+			removal.handle = ph;
+			removal.id = ph->id();
+			removal.track = nullptr;
+			removal.port = nullptr;
+			removal.types = 0;
+			removal.deleteHandle = false;
+			removal.async = false;
+			postPlayHandleRemoval(&removal);
+			waitForPlayHandleRemoval(removal);
+			if (removal.removed)
+			{
+				deletePlayHandle(ph);
+			}
+		}
+		else
+		{
+			auto removal = new PlayHandleRemoval;
+			removal->handle = ph;
+			removal->id = ph->id();
+			removal->track = nullptr;
+			removal->port = nullptr;
+			removal->types = 0;
+			removal->deleteHandle = true;
+			removal->async = true;
+			postPlayHandleRemoval(removal);
+		}
+		return;
+	}
+
+	requestChangeInModel();
+	if (deleteHere)
 	{
-		ph->audioPort()->removePlayHandle(ph);
 		bool removedFromList = false;
 		// Check m_newPlayHandles first because doing it the other way around
 		// creates a race condition
@@ -721,10 +1275,9 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 			}
 		}
 		// Now check m_playHandles
-		PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), ph);
-		if (it != m_playHandles.end())
+		if (m_playHandles.contains(ph))
 		{
-			m_playHandles.erase(it);
+			m_playHandles.remove(ph);
 			removedFromList = true;
 		}
 		// Only deleting PlayHandles that were actually found in the list
@@ -732,16 +1285,20 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 		// (See tobydox's 2008 commit 4583e48)
 		if ( removedFromList )
 		{
-			if (ph->type() == PlayHandle::TypeNotePlayHandle)
-			{
-				NotePlayHandleManager::release(dynamic_cast<NotePlayHandle*>(ph));
-			}
-			else { delete ph; }
+			deletePlayHandle(ph);
 		}
 	}
 	else
 	{
-		m_playHandlesToRemove.push_back(ph);
+		auto removal = new PlayHandleRemoval;
+		removal->handle = ph;
+		removal->id = ph->id();
+		removal->track = nullptr;
+		removal->port = nullptr;
+		removal->types = 0;
+		removal->deleteHandle = true;
+		removal->async = true;
+		postPlayHandleRemoval(removal);
 	}
 	doneChangeInModel();
 }
@@ -751,31 +1308,96 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 
 void AudioEngine::removePlayHandlesOfTypes(Track * track, const quint8 types)
 {
+	// all handles of instrument and sample tracks play through the
+	// track's audio port, so only its list has to be searched. Handles
+	// of pattern tracks are spread over the tracks of the pattern.
+	AudioPort * port = nullptr;
+	if (auto instrumentTrack = dynamic_cast<InstrumentTrack *>(track))
+	{
+		port = instrumentTrack->audioPort();
+	}
+	else if (auto sampleTrack = dynamic_cast<SampleTrack *>(track))
+	{
+		port = sampleTrack->audioPort();
+	}
+
+	if (!canChangeModelDirectly())
+	{
+		// the caller usually deletes the track next, so wait
+		// until the render thread has let go of its handles
+		PlayHandleRemoval removal;
+		removal.handle = nullptr;
+		removal.id = 0;
+		removal.track = track;
+		removal.port = port;
+		removal.types = types;
+		removal.deleteHandle = true;
+		removal.async = false;
+		postPlayHandleRemoval(&removal);
+		waitForPlayHandleRemoval(removal);
+		return;
+	}
+
 	requestChangeInModel();
-	PlayHandleList::Iterator it = m_playHandles.begin();
-	while( it != m_playHandles.end() )
+	// handles added meanwhile are already in the port's list, they must
+	// not be left to the render thread once the track is gone
+	adoptNewPlayHandles();
+	deletePlayHandlesOfTrack(track, port, types);
+	doneChangeInModel();
+}
+
+
+
+
+bool AudioEngine::deletePlayHandlesOfTrack(const Track * track, AudioPort * port, const quint8 types)
+{
+	// collect the handles first: deleting them takes them out of the
+	// port's list, which needs the lock we hold while searching it.
+	// Once out of m_playHandles their engine hook is free to use.
+	PlayHandleList doomed;
+
+	if (port)
 	{
-		if ((*it)->isFromTrack(track) && ((*it)->type() & types))
+		port->lockPlayHandles();
+		for (PlayHandle * ph : port->playHandles())
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
+			if (m_playHandles.contains(ph) && ph->isFromTrack(track) && (ph->type() & types))
 			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
+				m_playHandles.remove(ph);
+				doomed.append(ph);
 			}
-			else delete *it;
-			it = m_playHandles.erase( it );
 		}
-		else
+		port->unlockPlayHandles();
+	}
+	else
+	{
+		for (PlayHandleList::Iterator it = m_playHandles.begin(); it != m_playHandles.end(); )
 		{
+			PlayHandle * ph = *it;
 			++it;
+			if (ph->isFromTrack(track) && (ph->type() & types))
+			{
+				m_playHandles.remove(ph);
+				doomed.append(ph);
+			}
 		}
 	}
-	doneChangeInModel();
+
+	const bool removed = !doomed.isEmpty();
+	for (PlayHandleList::Iterator it = doomed.begin(); it != doomed.end(); )
+	{
+		PlayHandle * ph = *it;
+		it = doomed.erase(it);
+		deletePlayHandle(ph);
+	}
+	return removed;
 }
 
 
 
 
+
+
 void AudioEngine::requestChangeInModel()
 {
 	if( s_renderingThread )
@@ -793,6 +1415,8 @@ void AudioEngine::requestChangeInModel()
 		m_changesRequestCondition.wait( &m_waitChangesMutex );
 	}
 	m_waitChangesMutex.unlock();
+
+	++s_modelChangeDepth;
 }
 
 
@@ -803,6 +1427,8 @@ void AudioEngine::doneChangeInModel()
 	if( s_renderingThread )
 		return;
 
+	--s_modelChangeDepth;
+
 	m_changesMutex.lock();
 	bool moreChanges = --m_changes;
 	m_changesMutex.unlock();
@@ -1247,42 +1873,42 @@ void AudioEngine::fifoWriter::run()
 {
 	disable_denormals();
 
-#if 0
-#if defined(LMMS_BUILD_LINUX) || defined(LMMS_BUILD_FREEBSD)
-#ifdef LMMS_HAVE_SCHED_H
-	cpu_set_t mask;
-	CPU_ZERO( &mask );
-	CPU_SET( 0, &mask );
-	sched_setaffinity( 0, sizeof( mask ), &mask );
-#endif
-#endif
-#endif
+	m_audioEngine->m_threadSettings.applyToCurrentThread( "render thread" );
 
-	const fpp_t frames = m_audioEngine->framesPerPeriod();
 	while( m_writing )
 	{
+		m_fifo->setDepth( m_audioEngine->renderAheadDepth() );
+
+		// the period length only changes between two periods
+		const fpp_t frames = m_audioEngine->framesPerPeriod();
 		auto buffer = new surroundSampleFrame[frames];
 		const surroundSampleFrame * b = m_audioEngine->renderNextBuffer();
+		// taken before other threads get the chance to change the model
+		// in write(), so changes they make invalidate this period as well
+		PeriodStart & start = m_audioEngine->m_periodStarts[
+			m_audioEngine->m_periodSequence % m_audioEngine->m_periodStarts.size()];
+		start.generation = renderAheadGeneration(
+			m_audioEngine->m_renderAheadState.load( std::memory_order_acquire ) );
 		memcpy( buffer, b, frames * sizeof( surroundSampleFrame ) );
-		write( buffer );
+		write( { buffer, frames, start.generation, start.sequence } );
 	}
 
 	// Let audio backend stop processing
-	write( nullptr );
+	write( { nullptr, 0, 0, 0 } );
 	m_fifo->waitUntilRead();
 }
 
 
 
 
-void AudioEngine::fifoWriter::write( surroundSampleFrame * buffer )
+void AudioEngine::fifoWriter::write( const RenderedPeriod & period )
 {
 	m_audioEngine->m_waitChangesMutex.lock();
 	m_audioEngine->m_waitingForWrite = true;
 	m_audioEngine->m_waitChangesMutex.unlock();
 	m_audioEngine->runChangesInModel();
 
-	m_fifo->write( buffer );
+	m_fifo->write( period );
 
 	m_audioEngine->m_doChangesMutex.lock();
 	m_audioEngine->m_waitingForWrite = false;
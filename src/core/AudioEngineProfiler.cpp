@@ -24,28 +24,37 @@
 
 #include "AudioEngineProfiler.h"
 
+#include "BufferManager.h"
+#include "NotePlayHandle.h"
+
 namespace lmms
 {
 
 AudioEngineProfiler::AudioEngineProfiler() :
 	m_periodTimer(),
 	m_cpuLoad( 0 ),
+	m_schedulingOverhead( 0 ),
 	m_outputFile()
 {
 }
 
 
 
-void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod )
+void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod, int schedulingTime )
 {
 	int periodElapsed = m_periodTimer.elapsed();
 
 	const float newCpuLoad = periodElapsed / 10000.0f * sampleRate / framesPerPeriod;
     m_cpuLoad = qBound<int>( 0, ( newCpuLoad * 0.1f + m_cpuLoad * 0.9f ), 100 );
+	m_schedulingOverhead = schedulingTime * 0.1f + m_schedulingOverhead * 0.9f;
 
 	if( m_outputFile.isOpen() )
 	{
-		m_outputFile.write( QString( "%1\n" ).arg( periodElapsed ).toLatin1() );
+		const BufferManager::Statistics buffers = BufferManager::statistics();
+		const NotePlayHandleManager::Statistics notes = NotePlayHandleManager::statistics();
+		m_outputFile.write( QString( "%1 %2 %3 %4 %5 %6\n" ).arg( periodElapsed ).arg( schedulingTime )
+					.arg( buffers.highWaterMark ).arg( buffers.misses )
+					.arg( notes.capacity ).arg( notes.highWaterMark ).toLatin1() );
 	}
 }
 
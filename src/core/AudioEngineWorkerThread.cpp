@@ -24,9 +24,10 @@
 
 #include "AudioEngineWorkerThread.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include <QDebug>
-#include <QMutex>
-#include <QWaitCondition>
 
 #include "denormals.h"
 #include "AudioEngine.h"
@@ -41,13 +42,66 @@ namespace lmms
 {
 
 AudioEngineWorkerThread::JobQueue AudioEngineWorkerThread::globalJobQueue;
-QWaitCondition * AudioEngineWorkerThread::queueReadyWaitCond = nullptr;
 QList<AudioEngineWorkerThread *> AudioEngineWorkerThread::workerThreads;
 
+// index of the deque owned by the current thread, -1 for the thread
+// running the last worker "inline" (see startAndWaitForJobs())
+static thread_local int s_queueIndex = -1;
+
+static inline std::int64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void cpuRelax()
+{
+#ifdef __SSE__
+	_mm_pause();
+#endif
+}
+
+// Number of polling rounds before an idle thread goes to sleep. It adapts
+// per thread: finding work while spinning lets the thread spin longer the
+// next time, having to sleep makes it give up earlier. Dependent jobs
+// usually show up within microseconds, so at small buffer sizes threads
+// mostly stay awake, while an idle engine quickly stops burning CPU.
+static constexpr int MIN_SPIN_ROUNDS = 16;
+static constexpr int MAX_SPIN_ROUNDS = 4096;
+static thread_local int s_spinRounds = MIN_SPIN_ROUNDS * 8;
+
+static inline void spinSucceeded()
+{
+	s_spinRounds = std::min( s_spinRounds * 2, MAX_SPIN_ROUNDS );
+}
+
+static inline void spinFailed()
+{
+	s_spinRounds = std::max( s_spinRounds / 2, MIN_SPIN_ROUNDS );
+}
+
+// Realtime threads may only run for so long without sleeping (RLIMIT_RTTIME)
+// before the kernel sends SIGXCPU and finally kills the process, and spinning
+// doesn't count as sleeping. A thread which spun for this long since it last
+// slept goes to sleep right away the next time it runs out of work.
+static constexpr std::int64_t MAX_SPIN_TIME = 1000000; // 1 ms
+static thread_local std::int64_t s_spinTime = 0;
+
+
+
 // implementation of internal JobQueue
+int AudioEngineWorkerThread::JobQueue::addThread()
+{
+	m_queues.emplace_back( new WorkStealingQueue<ThreadableJob *>( JOB_QUEUE_SIZE ) );
+	return m_queues.size() - 1;
+}
+
+
+
+
 void AudioEngineWorkerThread::JobQueue::reset( OperationMode _opMode )
 {
-	m_writeIndex = 0;
+	m_itemsQueued = 0;
 	m_itemsDone = 0;
 	m_opMode = _opMode;
 }
@@ -61,73 +115,243 @@ void AudioEngineWorkerThread::JobQueue::addJob( ThreadableJob * _job )
 	{
 		// update job state
 		_job->queue();
-		// actually queue the job via atomic operations
-		auto index = m_writeIndex++;
-		if (index < JOB_QUEUE_SIZE) {
-			m_items[index] = _job;
-		} else {
+		// count the job before publishing it, so wait() can't see
+		// a finished queue in between
+		++m_itemsQueued;
+		if( !m_queues[currentQueue()]->push( _job ) )
+		{
 			qWarning() << "Job queue is full!";
-			++m_itemsDone;
+			finishJob();
+		}
+		else if( m_opMode == Dynamic )
+		{
+			m_jobsAvailable.notifyOne();
 		}
 	}
 }
 
 
 
+
+int AudioEngineWorkerThread::JobQueue::currentQueue() const
+{
+	return s_queueIndex >= 0 ? s_queueIndex : m_queues.size() - 1;
+}
+
+
+
+
+bool AudioEngineWorkerThread::isWorkerThread()
+{
+	return s_queueIndex >= 0;
+}
+
+
+
+
+ThreadableJob * AudioEngineWorkerThread::JobQueue::takeJob( int self )
+{
+	// own jobs first, most recently added ones are likely still in cache
+	ThreadableJob * job = m_queues[self]->pop();
+	if( job )
+	{
+		return job;
+	}
+
+	const int count = m_queues.size();
+	for( int i = 1; i < count; ++i )
+	{
+		job = m_queues[( self + i ) % count]->steal();
+		if( job )
+		{
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::finishJob()
+{
+	// a job adds its dependents before it's done, so once the counts
+	// match nothing can be added anymore
+	if( ++m_itemsDone == m_itemsQueued )
+	{
+		m_allDone.notifyAll();
+	}
+}
+
+
+
+
+bool AudioEngineWorkerThread::JobQueue::hasJobs() const
+{
+	for( const auto & queue : m_queues )
+	{
+		if( !queue->empty() )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
 void AudioEngineWorkerThread::JobQueue::run()
 {
-	bool processedJob = true;
-	while (processedJob && m_itemsDone < m_writeIndex)
+	const int self = currentQueue();
+	std::int64_t idleSince = now();
+	std::int64_t schedulingTime = 0;
+
+	while( ThreadableJob * job = takeJob( self ) )
+	{
+		schedulingTime += now() - idleSince;
+		job->process();
+		finishJob();
+		idleSince = now();
+	}
+
+	m_schedulingTime += schedulingTime + now() - idleSince;
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::wait()
+{
+	const int self = currentQueue();
+	std::int64_t idleSince = now();
+	std::int64_t schedulingTime = 0;
+	std::int64_t spinStart = 0;
+	int spin = 0;
+
+	// help out instead of just waiting for the other threads
+	while( m_itemsDone < m_itemsQueued )
 	{
-		processedJob = false;
-		for( int i = 0; i < m_writeIndex && i < JOB_QUEUE_SIZE; ++i )
+		ThreadableJob * job = takeJob( self );
+		if( job )
+		{
+			if( spin > 0 )
+			{
+				spinSucceeded();
+				s_spinTime += now() - spinStart;
+			}
+			spin = 0;
+			schedulingTime += now() - idleSince;
+			job->process();
+			finishJob();
+			idleSince = now();
+		}
+		else if( spin < s_spinRounds && s_spinTime < MAX_SPIN_TIME )
+		{
+			if( spin++ == 0 )
+			{
+				spinStart = now();
+			}
+			cpuRelax();
+		}
+		else
 		{
-			ThreadableJob * job = m_items[i].exchange(nullptr);
-			if( job )
+			// the remaining jobs are being processed - sleep until the
+			// last one is done
+			if( spin > 0 )
+			{
+				spinFailed();
+				s_spinTime += now() - spinStart;
+			}
+			spin = 0;
+			const EventCount::Key key = m_allDone.prepareWait();
+			if( m_itemsDone < m_itemsQueued && !hasJobs() )
+			{
+				m_allDone.wait( key );
+				s_spinTime = 0;
+			}
+			else
 			{
-				job->process();
-				processedJob = true;
-				++m_itemsDone;
+				m_allDone.cancelWait();
 			}
 		}
-		// always exit loop if we're not in dynamic mode
-		processedJob = processedJob && ( m_opMode == Dynamic );
 	}
+
+	m_schedulingTime += schedulingTime + now() - idleSince;
 }
 
 
 
 
-void AudioEngineWorkerThread::JobQueue::wait()
+void AudioEngineWorkerThread::JobQueue::park( const std::atomic_bool & quit )
 {
-	while (m_itemsDone < m_writeIndex)
+	if( s_spinTime < MAX_SPIN_TIME )
 	{
-#ifdef __SSE__
-		_mm_pause();
-#endif
+		const std::int64_t spinStart = now();
+		for( int spin = 0; spin < s_spinRounds; ++spin )
+		{
+			if( hasJobs() )
+			{
+				spinSucceeded();
+				s_spinTime += now() - spinStart;
+				return;
+			}
+			cpuRelax();
+		}
+		spinFailed();
+		s_spinTime += now() - spinStart;
+	}
+
+	const EventCount::Key key = m_jobsAvailable.prepareWait();
+	if( hasJobs() || quit )
+	{
+		m_jobsAvailable.cancelWait();
+		return;
 	}
+	m_jobsAvailable.wait( key );
+	s_spinTime = 0;
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::wakeWorkers()
+{
+	m_jobsAvailable.notify( m_itemsQueued - m_itemsDone );
 }
 
 
 
 
+void AudioEngineWorkerThread::JobQueue::wakeAll()
+{
+	m_jobsAvailable.notifyAll();
+}
+
+
+
+
+int AudioEngineWorkerThread::JobQueue::takeSchedulingTime()
+{
+	return m_schedulingTime.exchange( 0 ) / 1000;
+}
+
+
+
 
 // implementation of worker threads
 
 AudioEngineWorkerThread::AudioEngineWorkerThread( AudioEngine* audioEngine ) :
 	QThread( audioEngine ),
+	m_queueIndex( -1 ),
+	m_threadSettings( audioEngine->m_threadSettings ),
 	m_quit( false )
 {
-	// initialize global static data
-	if( queueReadyWaitCond == nullptr )
-	{
-		queueReadyWaitCond = new QWaitCondition;
-	}
-
 	// keep track of all instantiated worker threads - this is used for
 	// processing the last worker thread "inline", see comments in
 	// AudioEngineWorkerThread::startAndWaitForJobs() for details
 	workerThreads << this;
+	m_queueIndex = globalJobQueue.addThread();
 
 	resetJobQueue();
 }
@@ -146,7 +370,7 @@ AudioEngineWorkerThread::~AudioEngineWorkerThread()
 void AudioEngineWorkerThread::quit()
 {
 	m_quit = true;
-	resetJobQueue();
+	globalJobQueue.wakeAll();
 }
 
 
@@ -154,11 +378,12 @@ void AudioEngineWorkerThread::quit()
 
 void AudioEngineWorkerThread::startAndWaitForJobs()
 {
-	queueReadyWaitCond->wakeAll();
+	// Jobs queued in Dynamic mode have woken workers already, this only
+	// wakes as many workers as there are jobs left.
+	globalJobQueue.wakeWorkers();
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global AudioEngine thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
-	globalJobQueue.run();
 	globalJobQueue.wait();
 }
 
@@ -170,13 +395,13 @@ void AudioEngineWorkerThread::run()
 	MemoryManager::ThreadGuard mmThreadGuard; Q_UNUSED(mmThreadGuard);
 	disable_denormals();
 
-	QMutex m;
+	s_queueIndex = m_queueIndex;
+	m_threadSettings.applyToCurrentThread( QString( "worker %1" ).arg( m_queueIndex ) );
+
 	while( m_quit == false )
 	{
-		m.lock();
-		queueReadyWaitCond->wait( &m );
+		globalJobQueue.park( m_quit );
 		globalJobQueue.run();
-		m.unlock();
 	}
 }
 
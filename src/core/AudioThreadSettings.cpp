@@ -0,0 +1,455 @@
+/*
+ * AudioThreadSettings.cpp - worker count, CPU affinity and scheduling
+ *                           priority of the audio engine threads
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AudioThreadSettings.h"
+
+#include <QMutex>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "lmmsconfig.h"
+#include "ConfigManager.h"
+
+#if defined(LMMS_HAVE_PTHREAD_H) && defined(LMMS_HAVE_SCHED_H) && !defined(LMMS_BUILD_WIN32)
+#	define USE_PTHREAD_SCHED
+#	include <pthread.h>
+#	include <sched.h>
+#	include <cstring>
+#	ifdef LMMS_BUILD_LINUX
+#		define USE_CPU_AFFINITY
+#		define HANDLE_SIGXCPU
+#		include <atomic>
+#		include <cerrno>
+#		include <csignal>
+#		include <sys/resource.h>
+#		include <sys/syscall.h>
+#		include <unistd.h>
+#	endif
+#endif
+
+#ifdef LMMS_HAVE_RTKIT
+#	include <QDBusConnection>
+#	include <QDBusInterface>
+#	include <QDBusMessage>
+#endif
+
+namespace lmms
+{
+
+int AudioThreadSettings::s_workersOverride = -1;
+QString AudioThreadSettings::s_cpuSetOverride;
+int AudioThreadSettings::s_realtimePriorityOverride = -1;
+
+static QMutex s_reportMutex;
+static QStringList s_report;
+
+
+#ifdef HANDLE_SIGXCPU
+// Realtime threads which run for longer than the soft RLIMIT_RTTIME limit
+// without sleeping get SIGXCPU, at the hard limit the kernel kills the whole
+// process. The signal is sent to the process, not to the thread which ran
+// too long, so all audio threads we made realtime are dropped to SCHED_OTHER.
+static constexpr int MAX_REALTIME_THREADS = 64;
+static std::atomic<pid_t> s_realtimeThreads[MAX_REALTIME_THREADS];
+static std::atomic_bool s_realtimeRevoked( false );
+
+static void dropRealtimeScheduling( int )
+{
+	const int savedErrno = errno;
+	struct sched_param param;
+	param.sched_priority = 0;
+	for( auto & thread : s_realtimeThreads )
+	{
+		const pid_t tid = thread.load();
+		if( tid != 0 )
+		{
+			sched_setscheduler( tid, SCHED_OTHER, &param );
+		}
+	}
+	if( !s_realtimeRevoked.exchange( true ) )
+	{
+		static const char message[] = "Notice: an audio thread exceeded "
+			"RLIMIT_RTTIME, realtime scheduling revoked\n";
+		const ssize_t written = write( STDERR_FILENO, message, sizeof( message ) - 1 );
+		Q_UNUSED( written );
+	}
+	errno = savedErrno;
+}
+
+
+
+
+// makes sure the calling realtime thread gets SIGXCPU before it gets killed
+static void watchRealtimeThread()
+{
+	static std::atomic_bool installed( false );
+	if( !installed.exchange( true ) )
+	{
+		struct sigaction action;
+		memset( &action, 0, sizeof( action ) );
+		action.sa_handler = dropRealtimeScheduling;
+		action.sa_flags = SA_RESTART;
+		sigemptyset( &action.sa_mask );
+		sigaction( SIGXCPU, &action, nullptr );
+	}
+
+	// leave room between the soft and the hard limit - with both being the
+	// same the kernel doesn't send SIGXCPU at all
+	struct rlimit limit;
+	if( getrlimit( RLIMIT_RTTIME, &limit ) == 0 && limit.rlim_max != RLIM_INFINITY &&
+		limit.rlim_cur >= limit.rlim_max )
+	{
+		limit.rlim_cur = limit.rlim_max / 2;
+		setrlimit( RLIMIT_RTTIME, &limit );
+	}
+
+	const pid_t self = static_cast<pid_t>( syscall( SYS_gettid ) );
+	for( auto & thread : s_realtimeThreads )
+	{
+		if( thread.load() == self )
+		{
+			return;
+		}
+	}
+	// take the slot of a thread which is gone, e.g. after the audio
+	// device was restarted
+	for( auto & thread : s_realtimeThreads )
+	{
+		pid_t tid = thread.load();
+		if( ( tid == 0 || ( syscall( SYS_tgkill, getpid(), tid, 0 ) != 0 && errno == ESRCH ) ) &&
+			thread.compare_exchange_strong( tid, self ) )
+		{
+			return;
+		}
+	}
+}
+#endif
+
+
+
+
+AudioThreadSettings::AudioThreadSettings() :
+	workers( 0 ),
+	cpuSet(),
+	realtimePriority( 0 )
+{
+}
+
+
+
+
+AudioThreadSettings AudioThreadSettings::current()
+{
+	AudioThreadSettings settings;
+	settings.workers = qMax( 0, ConfigManager::inst()->value( "audioengine", "workers", "0" ).toInt() );
+	settings.cpuSet = ConfigManager::inst()->value( "audioengine", "cpuset" );
+	settings.realtimePriority = qMax( 0, ConfigManager::inst()->value( "audioengine", "rtpriority", "0" ).toInt() );
+
+	if( s_workersOverride >= 0 )
+	{
+		settings.workers = s_workersOverride;
+	}
+	if( !s_cpuSetOverride.isNull() )
+	{
+		settings.cpuSet = s_cpuSetOverride;
+	}
+	if( s_realtimePriorityOverride >= 0 )
+	{
+		settings.realtimePriority = s_realtimePriorityOverride;
+	}
+	return settings;
+}
+
+
+
+
+void AudioThreadSettings::overrideWorkers( int workers )
+{
+	s_workersOverride = workers;
+}
+
+
+
+
+void AudioThreadSettings::overrideCpuSet( const QString & cpuSet )
+{
+	s_cpuSetOverride = cpuSet.isNull() ? QString( "" ) : cpuSet;
+}
+
+
+
+
+void AudioThreadSettings::overrideRealtimePriority( int priority )
+{
+	s_realtimePriorityOverride = priority;
+}
+
+
+
+
+int AudioThreadSettings::numWorkers() const
+{
+	if( workers > 0 )
+	{
+		return workers;
+	}
+
+	// one thread less than available CPUs, as the rendering thread
+	// processes jobs as well
+	const int cpus = parseCpuSet( cpuSet ).size();
+	return qMax( 0, ( cpus > 0 ? cpus : QThread::idealThreadCount() ) - 1 );
+}
+
+
+
+
+QVector<int> AudioThreadSettings::parseCpuSet( const QString & cpuSet )
+{
+	QVector<int> cpus;
+#if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
+	const QStringList parts = cpuSet.split( ',', Qt::SkipEmptyParts );
+#else
+	const QStringList parts = cpuSet.split( ',', QString::SkipEmptyParts );
+#endif
+	for( const QString & part : parts )
+	{
+		const QStringList range = part.trimmed().split( '-' );
+		bool okFirst = false, okLast = true;
+		const int first = range[0].toInt( &okFirst );
+		const int last = range.size() == 2 ? range[1].toInt( &okLast ) : first;
+		if( !okFirst || !okLast || range.size() > 2 || first < 0 || last < first )
+		{
+			return QVector<int>();
+		}
+		for( int cpu = first; cpu <= last; ++cpu )
+		{
+			if( !cpus.contains( cpu ) )
+			{
+				cpus.push_back( cpu );
+			}
+		}
+	}
+	return cpus;
+}
+
+
+
+
+#ifdef LMMS_HAVE_RTKIT
+// ask rtkit (org.freedesktop.RealtimeKit1) to make the calling thread
+// realtime - used if we're not allowed to do it ourselves
+static bool makeRealtimeWithRtKit( int priority, QString & error )
+{
+	QDBusInterface rtkit( "org.freedesktop.RealtimeKit1",
+				"/org/freedesktop/RealtimeKit1",
+				"org.freedesktop.RealtimeKit1",
+				QDBusConnection::systemBus() );
+	if( !rtkit.isValid() )
+	{
+		error = "rtkit not available";
+		return false;
+	}
+
+	const QVariant maxPriority = rtkit.property( "MaxRealtimePriority" );
+	if( maxPriority.isValid() )
+	{
+		priority = qMin( priority, maxPriority.toInt() );
+	}
+
+	// rtkit only handles processes that limit their realtime CPU time. The
+	// soft limit is lower, so we get SIGXCPU before being killed.
+	struct rlimit limit;
+	if( getrlimit( RLIMIT_RTTIME, &limit ) == 0 && limit.rlim_max == RLIM_INFINITY )
+	{
+		const QVariant maxTime = rtkit.property( "RTTimeUSecMax" );
+		limit.rlim_max = maxTime.isValid() ? maxTime.toLongLong() : 200000;
+		limit.rlim_cur = limit.rlim_max / 2;
+		setrlimit( RLIMIT_RTTIME, &limit );
+	}
+
+	const QDBusMessage reply = rtkit.call( "MakeThreadRealtime",
+				static_cast<quint64>( syscall( SYS_gettid ) ),
+				static_cast<quint32>( priority ) );
+	if( reply.type() == QDBusMessage::ErrorMessage )
+	{
+		error = reply.errorMessage();
+		return false;
+	}
+	return true;
+}
+#endif
+
+
+
+
+QString AudioThreadSettings::applyToCurrentThread( const QString & threadName, bool realtime ) const
+{
+	QStringList granted;
+
+#ifdef USE_CPU_AFFINITY
+	const QVector<int> cpus = parseCpuSet( cpuSet );
+	if( !cpus.isEmpty() )
+	{
+		cpu_set_t mask;
+		CPU_ZERO( &mask );
+		for( int cpu : cpus )
+		{
+			CPU_SET( cpu, &mask );
+		}
+		const int err = pthread_setaffinity_np( pthread_self(), sizeof( mask ), &mask );
+		if( err != 0 )
+		{
+			granted << QString( "pinning to %1 failed: %2" ).arg( cpuSet, strerror( err ) );
+		}
+	}
+	else if( !cpuSet.trimmed().isEmpty() )
+	{
+		granted << QString( "invalid CPU set \"%1\"" ).arg( cpuSet );
+	}
+#endif
+
+#ifdef USE_PTHREAD_SCHED
+	if( realtime && realtimePriority > 0 )
+	{
+		struct sched_param param;
+		param.sched_priority = qBound( sched_get_priority_min( SCHED_FIFO ),
+						realtimePriority,
+						sched_get_priority_max( SCHED_FIFO ) );
+		const int err = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+		if( err != 0 )
+		{
+			QString error = strerror( err );
+#ifdef LMMS_HAVE_RTKIT
+			if( makeRealtimeWithRtKit( param.sched_priority, error ) )
+			{
+				error.clear();
+			}
+#endif
+			if( !error.isEmpty() )
+			{
+				granted << QString( "realtime scheduling denied: %1" ).arg( error );
+			}
+		}
+	}
+
+	// report what we actually got, not what we asked for
+	int policy = 0;
+	struct sched_param param;
+	if( pthread_getschedparam( pthread_self(), &policy, &param ) == 0 )
+	{
+#ifdef HANDLE_SIGXCPU
+		if( policy == SCHED_FIFO || policy == SCHED_RR )
+		{
+			watchRealtimeThread();
+		}
+#endif
+		granted.prepend( policy == SCHED_FIFO
+			? QString( "SCHED_FIFO priority %1" ).arg( param.sched_priority )
+			: policy == SCHED_RR
+				? QString( "SCHED_RR priority %1" ).arg( param.sched_priority )
+				: QString( "SCHED_OTHER" ) );
+	}
+#endif
+
+#ifdef USE_CPU_AFFINITY
+	cpu_set_t actual;
+	if( pthread_getaffinity_np( pthread_self(), sizeof( actual ), &actual ) == 0 )
+	{
+		QStringList actualCpus;
+		for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+		{
+			if( CPU_ISSET( cpu, &actual ) )
+			{
+				actualCpus << QString::number( cpu );
+			}
+		}
+		granted.insert( qMin( 1, granted.size() ), QString( "CPUs %1" ).arg( actualCpus.join( ',' ) ) );
+	}
+#endif
+
+	if( granted.isEmpty() )
+	{
+		granted << "scheduling settings not supported on this platform";
+	}
+
+	const QString report = QString( "%1: %2" ).arg( threadName, granted.join( ", " ) );
+
+	// a thread started again, e.g. after restarting the audio device,
+	// replaces what it got before
+	const QString prefix = threadName + ": ";
+	s_reportMutex.lock();
+	auto it = std::find_if( s_report.begin(), s_report.end(),
+		[&prefix]( const QString & line ) { return line.startsWith( prefix ); } );
+	if( it != s_report.end() )
+	{
+		*it = report;
+	}
+	else
+	{
+		s_report << report;
+	}
+	s_reportMutex.unlock();
+
+	if( realtimePriority > 0 || !cpuSet.isEmpty() )
+	{
+		printf( "Notice: audio thread %s\n", report.toUtf8().constData() );
+	}
+
+	return report;
+}
+
+
+
+
+QStringList AudioThreadSettings::grantedReport()
+{
+	s_reportMutex.lock();
+	QStringList report = s_report;
+	s_reportMutex.unlock();
+#ifdef HANDLE_SIGXCPU
+	if( s_realtimeRevoked )
+	{
+		report << "realtime scheduling revoked: an audio thread exceeded RLIMIT_RTTIME";
+	}
+#endif
+	return report;
+}
+
+
+
+
+void AudioThreadSettings::clearGrantedReport()
+{
+	s_reportMutex.lock();
+	s_report.clear();
+	s_reportMutex.unlock();
+#ifdef HANDLE_SIGXCPU
+	s_realtimeRevoked = false;
+#endif
+}
+
+} // namespace lmms
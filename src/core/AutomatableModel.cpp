@@ -60,6 +60,9 @@ AutomatableModel::AutomatableModel(
 	m_useControllerValue(true)
 
 {
+	// the period can get longer while playing
+	m_valueBuffer.reserve( Engine::audioEngine()->maxFramesPerPeriod() );
+
 	m_value = fittedValue( val );
 	setInitValue( val );
 }
@@ -304,6 +307,9 @@ void AutomatableModel::setValue( const float value )
 		// add changes to history so user can undo it
 		addJournalCheckPoint();
 
+		// also while not journalling, e.g. when dragging a knob
+		Engine::audioEngine()->markLiveActivity();
+
 		// notify linked models
 		for (const auto& linkedModel : m_linkedModels)
 		{
@@ -611,6 +617,9 @@ ValueBuffer * AutomatableModel::valueBuffer()
 
 	float val = m_value; // make sure our m_value doesn't change midway
 
+	// follow changes of the period length, never reallocates
+	m_valueBuffer.resize( Engine::audioEngine()->framesPerPeriod() );
+
 	ValueBuffer * vb;
 	if (m_controllerConnection && m_useControllerValue && m_controllerConnection->getController()->isSampleExact())
 	{
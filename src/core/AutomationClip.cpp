@@ -26,15 +26,18 @@
 
 #include "AutomationClip.h"
 
+#include "AudioEngine.h"
 #include "AutomationNode.h"
 #include "AutomationClipView.h"
 #include "AutomationTrack.h"
+#include "Engine.h"
 #include "LocaleHelper.h"
 #include "Note.h"
 #include "PatternStore.h"
 #include "ProjectJournal.h"
 #include "Song.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace lmms
@@ -56,7 +59,9 @@ AutomationClip::AutomationClip( AutomationTrack * _auto_track ) :
 	m_progressionType( DiscreteProgression ),
 	m_dragging( false ),
 	m_isRecording( false ),
-	m_lastRecordedValue( 0 )
+	m_lastRecordedValue( 0 ),
+	m_curve( new Curve( DiscreteProgression, 1.0f ) ),
+	m_playbackHint( -1 )
 {
 	changeLength( TimePos( 1, 0 ) );
 	if( getTrack() )
@@ -87,7 +92,9 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 	m_autoTrack( _clip_to_copy.m_autoTrack ),
 	m_objects( _clip_to_copy.m_objects ),
 	m_tension( _clip_to_copy.m_tension ),
-	m_progressionType( _clip_to_copy.m_progressionType )
+	m_progressionType( _clip_to_copy.m_progressionType ),
+	m_curve( nullptr ),
+	m_playbackHint( -1 )
 {
 	// Locks the mutex of the copied AutomationClip to make sure it
 	// doesn't change while it's being copied
@@ -101,6 +108,8 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 		// Sets the node's clip to this one
 		m_timeMap[POS(it)].setClip(this);
 	}
+	publishCurve();
+
 	if (!getTrack()){ return; }
 	switch( getTrack()->trackContainer()->type() )
 	{
@@ -116,6 +125,21 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 	}
 }
 
+
+
+
+AutomationClip::~AutomationClip()
+{
+	delete m_curve.load();
+	for( const auto & retired : m_retiredCurves )
+	{
+		delete retired.first;
+	}
+}
+
+
+
+
 bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 {
 	QMutexLocker m(&m_clipMutex);
@@ -156,6 +180,7 @@ void AutomationClip::setProgressionType(
 		_new_progression_type == CubicHermiteProgression )
 	{
 		m_progressionType = _new_progression_type;
+		publishCurve();
 		emit dataChanged();
 	}
 }
@@ -173,6 +198,7 @@ void AutomationClip::setTension( QString _new_tension )
 	if( ok && nt > -0.01 && nt < 1.01 )
 	{
 		m_tension = nt;
+		publishCurve();
 	}
 }
 
@@ -517,83 +543,7 @@ float AutomationClip::valueAt( const TimePos & _time ) const
 {
 	QMutexLocker m(&m_clipMutex);
 
-	if( m_timeMap.isEmpty() )
-	{
-		return 0;
-	}
-
-	// If we have a node at that time, just return its value
-	if (m_timeMap.contains(_time))
-	{
-		// When the time is exactly the node's time, we want the inValue
-		return m_timeMap[_time].getInValue();
-	}
-
-	// lowerBound returns next value with equal or greater key. Since we already
-	// checked if the key contains a node, we know the returned node has a greater
-	// key than _time. Therefore we take the previous element to calculate the current value
-	timeMap::const_iterator v = m_timeMap.lowerBound(_time);
-
-	if( v == m_timeMap.begin() )
-	{
-		return 0;
-	}
-	if( v == m_timeMap.end() )
-	{
-		// When the time is after the last node, we want the outValue of it
-		return OUTVAL(v - 1);
-	}
-
-	return valueAt(v - 1, _time - POS(v - 1));
-}
-
-
-
-
-// This method will get the value at an offset from a node, so we use the outValue of
-// that node and the inValue of the next node for the calculations.
-float AutomationClip::valueAt( timeMap::const_iterator v, int offset ) const
-{
-	QMutexLocker m(&m_clipMutex);
-
-	// We never use it with offset 0, but doesn't hurt to return a correct
-	// value if we do
-	if (offset == 0) { return INVAL(v); }
-
-	if (m_progressionType == DiscreteProgression)
-	{
-		return OUTVAL(v);
-	}
-	else if( m_progressionType == LinearProgression )
-	{
-		float slope =
-			(INVAL(v + 1) - OUTVAL(v))
-			/ (POS(v + 1) - POS(v));
-
-		return OUTVAL(v) + offset * slope;
-	}
-	else /* CubicHermiteProgression */
-	{
-		// Implements a Cubic Hermite spline as explained at:
-		// http://en.wikipedia.org/wiki/Cubic_Hermite_spline#Unit_interval_.280.2C_1.29
-		//
-		// Note that we are not interpolating a 2 dimensional point over
-		// time as the article describes.  We are interpolating a single
-		// value: y.  To make this work we map the values of x that this
-		// segment spans to values of t for t = 0.0 -> 1.0 and scale the
-		// tangents _m1 and _m2
-		int numValues = (POS(v + 1) - POS(v));
-		float t = (float) offset / (float) numValues;
-		float m1 = OUTTAN(v) * numValues * m_tension;
-		float m2 = INTAN(v + 1) * numValues * m_tension;
-
-		auto t2 = pow(t, 2);
-		auto t3 = pow(t, 3);
-		return (2 * t3 - 3 * t2 + 1) * OUTVAL(v)
-			+ (t3 - 2 * t2 + t) * m1
-			+ (-2 * t3 + 3 * t2) * INVAL(v + 1)
-			+ (t3 - t2) * m2;
-	}
+	return curve()->valueAt( _time );
 }
 
 
@@ -603,18 +553,19 @@ float *AutomationClip::valuesAfter( const TimePos & _time ) const
 {
 	QMutexLocker m(&m_clipMutex);
 
-	timeMap::const_iterator v = m_timeMap.lowerBound(_time);
-	if( v == m_timeMap.end() || (v+1) == m_timeMap.end() )
+	const Curve * c = curve();
+	const int node = c->lastNodeAt( _time - 1 ) + 1;
+	if( node + 1 >= static_cast<int>( c->m_nodes.size() ) )
 	{
 		return nullptr;
 	}
 
-	int numValues = POS(v + 1) - POS(v);
+	int numValues = c->m_nodes[node + 1].pos - c->m_nodes[node].pos;
 	auto ret = new float[numValues];
 
 	for( int i = 0; i < numValues; i++ )
 	{
-		ret[i] = valueAt( v, i );
+		ret[i] = c->valueBetween( node, i );
 	}
 
 	return ret;
@@ -1045,6 +996,7 @@ void AutomationClip::clear()
 	QMutexLocker m(&m_clipMutex);
 
 	m_timeMap.clear();
+	publishCurve();
 
 	emit dataChanged();
 }
@@ -1116,6 +1068,15 @@ void AutomationClip::generateTangents(timeMap::iterator it, int numToGenerate)
 {
 	QMutexLocker m(&m_clipMutex);
 
+	computeTangents(it, numToGenerate);
+	publishCurve();
+}
+
+
+
+
+void AutomationClip::computeTangents(timeMap::iterator it, int numToGenerate)
+{
 	if( m_timeMap.size() < 2 && numToGenerate > 0 )
 	{
 		it.value().setInTangent(0);
@@ -1173,4 +1134,166 @@ void AutomationClip::generateTangents(timeMap::iterator it, int numToGenerate)
 	}
 }
 
+
+
+
+void AutomationClip::publishCurve()
+{
+	auto c = new Curve( m_progressionType, m_tension );
+	c->m_nodes.reserve( m_timeMap.size() );
+	for( timeMap::const_iterator it = m_timeMap.begin(); it != m_timeMap.end(); ++it )
+	{
+		c->m_nodes.push_back( { POS(it), INVAL(it), OUTVAL(it), INTAN(it), OUTTAN(it) } );
+	}
+
+	AudioEngine * audioEngine = Engine::audioEngine();
+	const Curve * old = m_curve.exchange( c );
+	if( old == nullptr )
+	{
+		return;
+	}
+	if( audioEngine == nullptr )
+	{
+		delete old;
+		return;
+	}
+
+	// the render thread may still read the old curve until the end of the
+	// current period
+	m_retiredCurves.emplace_back( old, audioEngine->renderEpoch() );
+	auto it = m_retiredCurves.begin();
+	while( it != m_retiredCurves.end() )
+	{
+		if( audioEngine->isRenderPeriodOver( it->second ) )
+		{
+			delete it->first;
+			it = m_retiredCurves.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+
+
+
+int AutomationClip::Curve::lastNodeAt( int time ) const
+{
+	auto it = std::upper_bound( m_nodes.begin(), m_nodes.end(), time,
+		[]( int t, const Node & node ) { return t < node.pos; } );
+	return static_cast<int>( it - m_nodes.begin() ) - 1;
+}
+
+
+
+
+float AutomationClip::Curve::valueAt( int time ) const
+{
+	return valueAtNode( lastNodeAt( time ), time );
+}
+
+
+
+
+float AutomationClip::Curve::valueAt( int time, int & hint ) const
+{
+	const int size = static_cast<int>( m_nodes.size() );
+	if( hint < -1 || hint >= size || ( hint >= 0 && m_nodes[hint].pos > time ) )
+	{
+		// moved backwards or the curve changed
+		hint = lastNodeAt( time );
+	}
+	else
+	{
+		// usually the same node as last time or the next one, search
+		// the rest if it's further ahead
+		int steps = 0;
+		while( hint + 1 < size && m_nodes[hint + 1].pos <= time )
+		{
+			if( ++steps > 2 )
+			{
+				hint = lastNodeAt( time );
+				break;
+			}
+			++hint;
+		}
+	}
+	return valueAtNode( hint, time );
+}
+
+
+
+
+float AutomationClip::Curve::valueAtNode( int node, int time ) const
+{
+	if( node < 0 )
+	{
+		return 0;
+	}
+	const Node & n = m_nodes[node];
+	if( n.pos == time )
+	{
+		// When the time is exactly the node's time, we want the inValue
+		return n.inValue;
+	}
+	if( node + 1 == static_cast<int>( m_nodes.size() ) )
+	{
+		// When the time is after the last node, we want the outValue of it
+		return n.outValue;
+	}
+	return valueBetween( node, time - n.pos );
+}
+
+
+
+
+// This method will get the value at an offset from a node, so we use the outValue of
+// that node and the inValue of the next node for the calculations.
+float AutomationClip::Curve::valueBetween( int node, int offset ) const
+{
+	const Node & v = m_nodes[node];
+
+	// We never use it with offset 0, but doesn't hurt to return a correct
+	// value if we do
+	if (offset == 0) { return v.inValue; }
+
+	const Node & next = m_nodes[node + 1];
+	if (m_progressionType == DiscreteProgression)
+	{
+		return v.outValue;
+	}
+	else if( m_progressionType == LinearProgression )
+	{
+		float slope =
+			(next.inValue - v.outValue)
+			/ (next.pos - v.pos);
+
+		return v.outValue + offset * slope;
+	}
+	else /* CubicHermiteProgression */
+	{
+		// Implements a Cubic Hermite spline as explained at:
+		// http://en.wikipedia.org/wiki/Cubic_Hermite_spline#Unit_interval_.280.2C_1.29
+		//
+		// Note that we are not interpolating a 2 dimensional point over
+		// time as the article describes.  We are interpolating a single
+		// value: y.  To make this work we map the values of x that this
+		// segment spans to values of t for t = 0.0 -> 1.0 and scale the
+		// tangents _m1 and _m2
+		int numValues = (next.pos - v.pos);
+		float t = (float) offset / (float) numValues;
+		float m1 = v.outTangent * numValues * m_tension;
+		float m2 = next.inTangent * numValues * m_tension;
+
+		auto t2 = pow(t, 2);
+		auto t3 = pow(t, 3);
+		return (2 * t3 - 3 * t2 + 1) * v.outValue
+			+ (t3 - 2 * t2 + t) * m1
+			+ (-2 * t3 + 3 * t2) * next.inValue
+			+ (t3 - t2) * m2;
+	}
+}
+
 } // namespace lmms
\ No newline at end of file
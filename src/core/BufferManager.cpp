@@ -26,24 +26,233 @@
 
 #include "BufferManager.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
 
 #include "MemoryManager.h"
 
 namespace lmms
 {
 
-fpp_t BufferManager::s_framesPerPeriod;
+namespace
+{
+
+constexpr std::size_t CacheLineSize = 64;
+
+// released buffers a thread keeps for itself before it gives half of them
+// back to the pool
+constexpr int ThreadCacheSize = 32;
+
+class BufferPool;
+
+// occupies the cache line in front of each buffer
+struct BufferHeader
+{
+	// nullptr for buffers allocated from the heap
+	BufferPool * pool;
+} ;
+
+static_assert( sizeof( BufferHeader ) <= CacheLineSize, "BufferHeader has to fit in front of the buffer" );
 
-void BufferManager::init( fpp_t fpp )
+sampleFrame * bufferOf( char * block )
 {
-	s_framesPerPeriod = fpp;
+	return reinterpret_cast<sampleFrame *>( block + CacheLineSize );
+}
+
+char * blockOf( sampleFrame * buf )
+{
+	return reinterpret_cast<char *>( buf ) - CacheLineSize;
+}
+
+
+
+
+/**
+ * Fixed number of buffers in one allocation, the free ones form a
+ * lock-free stack. The stack's head holds the index of the top buffer
+ * (plus one, 0 means empty) in its lower half and a tag in its upper half.
+ * The tag changes with every update, so a thread that got preempted
+ * between reading the head and swapping it can't restore a stale stack.
+ */
+class BufferPool
+{
+public:
+	BufferPool( fpp_t fpp, int capacity ) :
+		m_framesPerPeriod( fpp ),
+		m_capacity( capacity ),
+		m_stride( CacheLineSize + ( ( fpp * sizeof( sampleFrame ) + CacheLineSize - 1 ) & ~( CacheLineSize - 1 ) ) ),
+		m_memory( static_cast<char *>( ::operator new( m_stride * capacity, std::align_val_t( CacheLineSize ) ) ) ),
+		m_next( new std::atomic<std::uint32_t>[capacity] ),
+		m_head( capacity > 0 ? 1 : 0 ),
+		m_taken( 0 ),
+		m_highWaterMark( 0 ),
+		m_misses( 0 )
+	{
+		for( int i = 0; i < capacity; ++i )
+		{
+			new( m_memory + i * m_stride ) BufferHeader{ this };
+			m_next[i].store( i + 1 < capacity ? i + 2 : 0, std::memory_order_relaxed );
+		}
+	}
+
+	~BufferPool()
+	{
+		::operator delete( m_memory, std::align_val_t( CacheLineSize ) );
+	}
+
+	sampleFrame * pop()
+	{
+		std::uint64_t head = m_head.load( std::memory_order_acquire );
+		while( true )
+		{
+			const auto index = static_cast<std::uint32_t>( head & IndexMask );
+			if( index == 0 )
+			{
+				return nullptr;
+			}
+			const std::uint32_t next = m_next[index - 1].load( std::memory_order_relaxed );
+			if( m_head.compare_exchange_weak( head, nextTag( head ) | next,
+					std::memory_order_acquire, std::memory_order_acquire ) )
+			{
+				countTaken();
+				return bufferOf( m_memory + ( index - 1 ) * m_stride );
+			}
+		}
+	}
+
+	void push( sampleFrame * buf )
+	{
+		const auto index = static_cast<std::uint32_t>( ( blockOf( buf ) - m_memory ) / m_stride ) + 1;
+		std::uint64_t head = m_head.load( std::memory_order_relaxed );
+		do
+		{
+			m_next[index - 1].store( static_cast<std::uint32_t>( head & IndexMask ),
+							std::memory_order_relaxed );
+		}
+		while( !m_head.compare_exchange_weak( head, nextTag( head ) | index,
+					std::memory_order_release, std::memory_order_relaxed ) );
+		m_taken.fetch_sub( 1, std::memory_order_relaxed );
+	}
+
+	sampleFrame * allocateMiss()
+	{
+		m_misses.fetch_add( 1, std::memory_order_relaxed );
+		char * block = MM_ALLOC<char>( CacheLineSize + m_framesPerPeriod * sizeof( sampleFrame ) );
+		new( block ) BufferHeader{ nullptr };
+		return bufferOf( block );
+	}
+
+	BufferManager::Statistics statistics() const
+	{
+		return { m_capacity,
+			m_highWaterMark.load( std::memory_order_relaxed ),
+			m_misses.load( std::memory_order_relaxed ) };
+	}
+
+private:
+	static constexpr std::uint64_t IndexMask = 0xffffffff;
+
+	static std::uint64_t nextTag( std::uint64_t head )
+	{
+		return ( ( head >> 32 ) + 1 ) << 32;
+	}
+
+	void countTaken()
+	{
+		const int taken = m_taken.fetch_add( 1, std::memory_order_relaxed ) + 1;
+		int highWaterMark = m_highWaterMark.load( std::memory_order_relaxed );
+		while( taken > highWaterMark &&
+			!m_highWaterMark.compare_exchange_weak( highWaterMark, taken, std::memory_order_relaxed ) )
+		{
+		}
+	}
+
+	const fpp_t m_framesPerPeriod;
+	const int m_capacity;
+	const std::size_t m_stride;
+	char * const m_memory;
+	const std::unique_ptr<std::atomic<std::uint32_t>[]> m_next;
+
+	alignas( CacheLineSize ) std::atomic<std::uint64_t> m_head;
+	alignas( CacheLineSize ) std::atomic_int m_taken;
+	std::atomic_int m_highWaterMark;
+	std::atomic_int m_misses;
+} ;
+
+
+
+
+struct ThreadCache
+{
+	~ThreadCache()
+	{
+		flush();
+	}
+
+	//! Gives all cached buffers back if they belong to another pool
+	void use( BufferPool * current )
+	{
+		if( pool != current )
+		{
+			flush();
+			pool = current;
+		}
+	}
+
+	void flush()
+	{
+		while( count > 0 )
+		{
+			pool->push( buffers[--count] );
+		}
+	}
+
+	BufferPool * pool = nullptr;
+	std::array<sampleFrame *, ThreadCacheSize> buffers;
+	int count = 0;
+} ;
+
+
+thread_local ThreadCache t_cache;
+
+std::atomic<BufferPool *> s_pool( nullptr );
+
+// pools replaced by init() are kept as long as the program runs, other
+// threads may still be about to take buffers from them
+std::vector<std::unique_ptr<BufferPool>> s_pools;
+std::mutex s_poolsMutex;
+
+} // namespace
+
+
+
+
+void BufferManager::init( fpp_t fpp, int capacity )
+{
+	std::lock_guard<std::mutex> guard( s_poolsMutex );
+	s_pools.push_back( std::make_unique<BufferPool>( fpp, capacity ) );
+	s_pool.store( s_pools.back().get(), std::memory_order_release );
 }
 
 
 sampleFrame * BufferManager::acquire()
 {
-	return MM_ALLOC<sampleFrame>( s_framesPerPeriod );
+	BufferPool * pool = s_pool.load( std::memory_order_acquire );
+	ThreadCache & cache = t_cache;
+	cache.use( pool );
+	if( cache.count > 0 )
+	{
+		return cache.buffers[--cache.count];
+	}
+
+	sampleFrame * buf = pool->pop();
+	return buf ? buf : pool->allocateMiss();
 }
 
 void BufferManager::clear( sampleFrame *ab, const f_cnt_t frames, const f_cnt_t offset )
@@ -62,7 +271,44 @@ void BufferManager::clear( surroundSampleFrame * ab, const f_cnt_t frames,
 
 void BufferManager::release( sampleFrame * buf )
 {
-	MM_FREE( buf );
+	if( buf == nullptr )
+	{
+		return;
+	}
+
+	BufferPool * owner = reinterpret_cast<BufferHeader *>( blockOf( buf ) )->pool;
+	if( owner == nullptr )
+	{
+		MM_FREE( blockOf( buf ) );
+		return;
+	}
+
+	BufferPool * pool = s_pool.load( std::memory_order_acquire );
+	if( owner != pool )
+	{
+		// acquired before the last init()
+		owner->push( buf );
+		return;
+	}
+
+	ThreadCache & cache = t_cache;
+	cache.use( pool );
+	if( cache.count == ThreadCacheSize )
+	{
+		// leave some for the other threads
+		while( cache.count > ThreadCacheSize / 2 )
+		{
+			pool->push( cache.buffers[--cache.count] );
+		}
+	}
+	cache.buffers[cache.count++] = buf;
+}
+
+
+BufferManager::Statistics BufferManager::statistics()
+{
+	const BufferPool * pool = s_pool.load( std::memory_order_acquire );
+	return pool ? pool->statistics() : Statistics{ 0, 0, 0 };
 }
 
 } // namespace lmms
@@ -97,6 +97,10 @@ void Clip::movePosition( const TimePos & pos )
 	{
 		Engine::audioEngine()->requestChangeInModel();
 		m_startPosition = newPos;
+		if( getTrack() )
+		{
+			getTrack()->updateClipIndex( this );
+		}
 		Engine::audioEngine()->doneChangeInModel();
 		Engine::getSong()->updateLength();
 		emit positionChanged();
@@ -115,7 +119,16 @@ void Clip::movePosition( const TimePos & pos )
  */
 void Clip::changeLength( const TimePos & length )
 {
-	m_length = length;
+	if( m_length != length )
+	{
+		Engine::audioEngine()->requestChangeInModel();
+		m_length = length;
+		if( getTrack() )
+		{
+			getTrack()->updateClipIndex( this );
+		}
+		Engine::audioEngine()->doneChangeInModel();
+	}
 	Engine::getSong()->updateLength();
 	emit lengthChanged();
 }
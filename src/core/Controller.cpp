@@ -53,6 +53,9 @@ Controller::Controller( ControllerTypes _type, Model * _parent,
 	m_connectionCount( 0 ),
 	m_type( _type )
 {
+	// the period can get longer while playing
+	m_valueBuffer.reserve( Engine::audioEngine()->maxFramesPerPeriod() );
+
 	if( _type != DummyController && _type != MidiController )
 	{
 		s_controllers.append( this );
@@ -115,7 +118,7 @@ float Controller::value( int offset )
 {
 	if( m_bufferLastUpdated != s_periods )
 	{
-		updateValueBuffer();
+		refreshValueBuffer();
 	}
 	return m_valueBuffer.values()[ offset ];
 }
@@ -125,12 +128,21 @@ ValueBuffer * Controller::valueBuffer()
 {
 	if( m_bufferLastUpdated != s_periods )
 	{
-		updateValueBuffer();
+		refreshValueBuffer();
 	}
 	return &m_valueBuffer;
 }
 
 
+
+void Controller::refreshValueBuffer()
+{
+	// follow changes of the period length, never reallocates
+	m_valueBuffer.resize( Engine::audioEngine()->framesPerPeriod() );
+	updateValueBuffer();
+}
+
+
 void Controller::updateValueBuffer()
 {
 	m_valueBuffer.fill(0.5f);
@@ -59,6 +59,10 @@ Effect::Effect( const Plugin::Descriptor * _desc,
 	{
 		m_autoQuitDisabled = true;
 	}
+
+	// disabled effects are bypassed without any latency
+	connect( &m_enabledModel, &BoolModel::dataChanged, this,
+		[this]() { if( latency() > 0 ) { notifyLatencyChanged(); } }, Qt::DirectConnection );
 }
 
 
@@ -165,6 +169,14 @@ void Effect::checkGate( double _out_sum )
 
 
 
+void Effect::notifyLatencyChanged()
+{
+	Engine::audioEngine()->invalidateRenderGraph();
+}
+
+
+
+
 gui::PluginView * Effect::instantiateView( QWidget * _parent )
 {
 	return new gui::EffectView( this, _parent );
@@ -38,8 +38,12 @@ namespace lmms
 EffectChain::EffectChain( Model * _parent ) :
 	Model( _parent ),
 	SerializingObject(),
-	m_enabledModel( false, nullptr, tr( "Effects enabled" ) )
+	m_enabledModel( false, nullptr, tr( "Effects enabled" ) ),
+	m_planarBuffer( Engine::audioEngine()->maxFramesPerPeriod() )
 {
+	// the latency of the chain depends on it
+	connect( &m_enabledModel, &BoolModel::dataChanged, this,
+		[]() { Engine::audioEngine()->invalidateRenderGraph(); }, Qt::DirectConnection );
 }
 
 
@@ -111,6 +115,7 @@ void EffectChain::loadSettings( const QDomElement & _this )
 		}
 		node = node.nextSibling();
 	}
+	Engine::audioEngine()->invalidateRenderGraph();
 
 	emit dataChanged();
 }
@@ -122,6 +127,7 @@ void EffectChain::appendEffect( Effect * _effect )
 {
 	Engine::audioEngine()->requestChangeInModel();
 	m_effects.append( _effect );
+	Engine::audioEngine()->invalidateRenderGraph();
 	Engine::audioEngine()->doneChangeInModel();
 
 	m_enabledModel.setValue( true );
@@ -143,6 +149,7 @@ void EffectChain::removeEffect( Effect * _effect )
 		return;
 	}
 	m_effects.erase( found );
+	Engine::audioEngine()->invalidateRenderGraph();
 
 	Engine::audioEngine()->doneChangeInModel();
 
@@ -190,14 +197,40 @@ bool EffectChain::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, b
 
 	MixHelpers::sanitize( _buf, _frames );
 
+	// consecutive effects which support it share one planar copy of the
+	// buffer instead of each deinterleaving and interleaving it
+	const bool canUsePlanar = _frames <= m_planarBuffer.maxFrames();
+	bool planar = false;
+
 	bool moreEffects = false;
 	for (const auto& effect : m_effects)
 	{
-		if (hasInputNoise || effect->isRunning())
+		if (!hasInputNoise && !effect->isRunning()) { continue; }
+
+		if (canUsePlanar && effect->supportsPlanarBuffers())
 		{
-			moreEffects |= effect->processAudioBuffer(_buf, _frames);
-			MixHelpers::sanitize(_buf, _frames);
+			if (!planar)
+			{
+				m_planarBuffer.copyFrom(_buf, _frames);
+				planar = true;
+			}
+			moreEffects |= effect->processPlanarAudioBuffer(m_planarBuffer);
+			m_planarBuffer.sanitize();
+			continue;
 		}
+
+		if (planar)
+		{
+			m_planarBuffer.copyTo(_buf);
+			planar = false;
+		}
+		moreEffects |= effect->processAudioBuffer(_buf, _frames);
+		MixHelpers::sanitize(_buf, _frames);
+	}
+
+	if (planar)
+	{
+		m_planarBuffer.copyTo(_buf);
 	}
 
 	return moreEffects;
@@ -222,6 +255,47 @@ void EffectChain::startRunning()
 
 
 
+bool EffectChain::isRunning() const
+{
+	if( m_enabledModel.value() == false )
+	{
+		return false;
+	}
+
+	for (const auto& effect : m_effects)
+	{
+		if (effect->isRunning())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+f_cnt_t EffectChain::latency() const
+{
+	if( m_enabledModel.value() == false )
+	{
+		return 0;
+	}
+
+	f_cnt_t latency = 0;
+	for (const auto& effect : m_effects)
+	{
+		if (effect->isEnabled())
+		{
+			latency += effect->latency();
+		}
+	}
+	return latency;
+}
+
+
+
+
 void EffectChain::clear()
 {
 	emit aboutToClear();
@@ -234,6 +308,7 @@ void EffectChain::clear()
 		m_effects.pop_back();
 		delete e;
 	}
+	Engine::audioEngine()->invalidateRenderGraph();
 
 	Engine::audioEngine()->doneChangeInModel();
 
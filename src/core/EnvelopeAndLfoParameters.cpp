@@ -163,7 +163,7 @@ EnvelopeAndLfoParameters::EnvelopeAndLfoParameters(
 
 
 	m_lfoShapeData =
-		new sample_t[Engine::audioEngine()->framesPerPeriod()];
+		new sample_t[Engine::audioEngine()->maxFramesPerPeriod()];
 
 	updateSampleVars();
 }
@@ -0,0 +1,118 @@
+/*
+ * EventCount.cpp - lets threads sleep until a lock-free condition may have changed
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "EventCount.h"
+
+#ifdef LMMS_BUILD_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lmms
+{
+
+#ifdef LMMS_BUILD_LINUX
+static_assert( sizeof( std::atomic<std::uint32_t> ) == sizeof( std::uint32_t ),
+				"futex needs a plain 32 bit word" );
+
+static inline std::uint32_t * futexWord( std::atomic<std::uint32_t> & word )
+{
+	return reinterpret_cast<std::uint32_t *>( &word );
+}
+#endif
+
+
+
+
+EventCount::Key EventCount::prepareWait()
+{
+	m_waiters.fetch_add( 1, std::memory_order_seq_cst );
+	// pairs with the fence in notify(): either the notifier sees us
+	// waiting, or our re-check of the condition sees its change
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	return m_epoch.load( std::memory_order_acquire );
+}
+
+
+
+
+void EventCount::cancelWait()
+{
+	m_waiters.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+
+
+
+void EventCount::wait( Key key )
+{
+#ifdef LMMS_BUILD_LINUX
+	// returns immediately if the epoch has moved on in the meantime,
+	// loop to filter out spurious wakeups and signals
+	while( m_epoch.load( std::memory_order_acquire ) == key )
+	{
+		syscall( SYS_futex, futexWord( m_epoch ), FUTEX_WAIT_PRIVATE,
+							key, nullptr, nullptr, 0 );
+	}
+#else
+	std::unique_lock<std::mutex> lock( m_mutex );
+	m_cond.wait( lock, [this, key]
+		{ return m_epoch.load( std::memory_order_acquire ) != key; } );
+#endif
+	m_waiters.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+
+
+
+void EventCount::notify( int count )
+{
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	if( count <= 0 || m_waiters.load( std::memory_order_relaxed ) == 0 )
+	{
+		return;
+	}
+
+#ifdef LMMS_BUILD_LINUX
+	m_epoch.fetch_add( 1, std::memory_order_release );
+	syscall( SYS_futex, futexWord( m_epoch ), FUTEX_WAKE_PRIVATE,
+						count, nullptr, nullptr, 0 );
+#else
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_epoch.fetch_add( 1, std::memory_order_release );
+	}
+	if( count == 1 )
+	{
+		m_cond.notify_one();
+	}
+	else
+	{
+		m_cond.notify_all();
+	}
+#endif
+}
+
+} // namespace lmms
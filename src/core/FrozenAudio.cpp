@@ -0,0 +1,134 @@
+/*
+ * FrozenAudio.cpp - pre-rendered output of a frozen track
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FrozenAudio.h"
+
+#include <QDir>
+
+#include <algorithm>
+#include <cstring>
+
+namespace lmms
+{
+
+
+FrozenAudio::FrozenAudio(fpp_t framesPerPeriod, sample_rate_t sampleRate) :
+	m_file(QDir::temp().filePath("lmms-freeze-XXXXXX.raw")),
+	m_framesPerPeriod(framesPerPeriod),
+	m_sampleRate(sampleRate),
+	m_frames(0),
+	m_data(nullptr)
+{
+}
+
+
+
+
+FrozenAudio::~FrozenAudio()
+{
+	if (m_data)
+	{
+		m_file.unmap(reinterpret_cast<uchar*>(const_cast<sampleFrame*>(m_data)));
+	}
+}
+
+
+
+
+bool FrozenAudio::open()
+{
+	return m_file.open();
+}
+
+
+
+
+bool FrozenAudio::append(const sampleFrame* frames, double ticks)
+{
+	const qint64 size = m_framesPerPeriod * sizeof(sampleFrame);
+	if (m_file.write(reinterpret_cast<const char*>(frames), size) != size)
+	{
+		return false;
+	}
+	m_periodTicks.push_back(ticks);
+	m_frames += m_framesPerPeriod;
+	return true;
+}
+
+
+
+
+bool FrozenAudio::finish()
+{
+	if (m_frames == 0 || !m_file.flush())
+	{
+		return false;
+	}
+	m_data = reinterpret_cast<const sampleFrame*>(m_file.map(0, m_frames * sizeof(sampleFrame)));
+	return m_data != nullptr;
+}
+
+
+
+
+f_cnt_t FrozenAudio::frameAt(tick_t ticks) const
+{
+	const auto next = std::upper_bound(m_periodTicks.begin(), m_periodTicks.end(), static_cast<double>(ticks));
+	if (next == m_periodTicks.begin())
+	{
+		return 0;
+	}
+	if (next == m_periodTicks.end())
+	{
+		return -1;
+	}
+
+	// the tempo doesn't change within a period, so positions in between
+	// can be interpolated
+	const auto period = static_cast<f_cnt_t>(next - m_periodTicks.begin() - 1);
+	const double start = m_periodTicks[period];
+	const double fraction = *next > start ? (ticks - start) / (*next - start) : 0;
+	return period * m_framesPerPeriod + static_cast<f_cnt_t>(fraction * m_framesPerPeriod + 0.5);
+}
+
+
+
+
+void FrozenAudio::read(f_cnt_t frame, sampleFrame* dst, fpp_t count) const
+{
+	const f_cnt_t available = m_data && frame >= 0 ? std::max<f_cnt_t>(0, m_frames - frame) : 0;
+	const fpp_t copied = static_cast<fpp_t>(std::min<f_cnt_t>(count, available));
+
+	if (copied > 0)
+	{
+		memcpy(dst, m_data + frame, copied * sizeof(sampleFrame));
+	}
+	if (copied < count)
+	{
+		memset(dst + copied, 0, (count - copied) * sizeof(sampleFrame));
+	}
+}
+
+
+} // namespace lmms
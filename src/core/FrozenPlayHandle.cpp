@@ -0,0 +1,117 @@
+/*
+ * FrozenPlayHandle.cpp - plays the pre-rendered audio of a frozen track
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FrozenPlayHandle.h"
+
+#include <cstdlib>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "InstrumentTrack.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+// frameAt() interpolates, so consecutive ticks may be off by a frame or
+// two - only larger differences are jumps or loops
+static const f_cnt_t ResyncThreshold = 8;
+
+
+FrozenPlayHandle::FrozenPlayHandle(InstrumentTrack* track, std::unique_ptr<FrozenAudio> audio) :
+	PlayHandle(TypeFrozenPlayHandle),
+	m_track(track),
+	m_audio(std::move(audio)),
+	m_numTickStarts(0),
+	m_position(-1)
+{
+	setAudioPort(track->audioPort());
+}
+
+
+
+
+void FrozenPlayHandle::tickStarted(tick_t ticks, f_cnt_t offset)
+{
+	if (m_numTickStarts < static_cast<int>(m_tickStarts.size()))
+	{
+		m_tickStarts[m_numTickStarts++] = { ticks, offset };
+	}
+}
+
+
+
+
+void FrozenPlayHandle::play(sampleFrame* buffer)
+{
+	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+
+	// the song calls tickStarted() before any play handle is processed
+	fpp_t done = 0;
+	for (int i = 0; i < m_numTickStarts; ++i)
+	{
+		const TickStart& tickStart = m_tickStarts[i];
+		playFrames(buffer + done, tickStart.offset - done);
+		done = tickStart.offset;
+
+		const f_cnt_t frame = m_audio->frameAt(tickStart.ticks);
+		if (m_position < 0 || frame < 0 || std::abs(frame - m_position) > ResyncThreshold)
+		{
+			m_position = frame;
+		}
+	}
+	m_numTickStarts = 0;
+
+	playFrames(buffer + done, frames - done);
+}
+
+
+
+
+bool FrozenPlayHandle::isFromTrack(const Track* track) const
+{
+	return track == m_track;
+}
+
+
+
+
+void FrozenPlayHandle::playFrames(sampleFrame* buffer, fpp_t frames)
+{
+	const Song* song = Engine::getSong();
+	if (!song->isPlaying() || song->playMode() != Song::Mode_PlaySong)
+	{
+		m_position = -1;
+	}
+	if (frames <= 0 || m_position < 0)
+	{
+		return;
+	}
+
+	m_audio->read(m_position, buffer, frames);
+	m_position += frames;
+}
+
+
+} // namespace lmms
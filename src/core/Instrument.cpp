@@ -26,6 +26,7 @@
 
 #include <cmath>
 
+#include "AudioPort.h"
 #include "DummyInstrument.h"
 #include "InstrumentTrack.h"
 #include "lmms_constants.h"
@@ -57,6 +58,14 @@ void Instrument::deleteNotePluginData( NotePlayHandle * )
 
 
 
+void Instrument::notifyLatencyChanged()
+{
+	instrumentTrack()->audioPort()->setInputLatency( latency() );
+}
+
+
+
+
 f_cnt_t Instrument::beatLen( NotePlayHandle * ) const
 {
 	return( 0 );
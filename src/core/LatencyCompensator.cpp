@@ -0,0 +1,105 @@
+/*
+ * LatencyCompensator.cpp - delays a signal to align it with later ones
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LatencyCompensator.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+
+namespace lmms
+{
+
+
+bool LatencyCompensator::setDelay(f_cnt_t frames)
+{
+	m_requestedDelay = std::max<f_cnt_t>(frames, 0);
+	frames = std::min(m_requestedDelay, capacity());
+	if (frames != m_delay)
+	{
+		if (frames > 0)
+		{
+			std::memset(m_line.data(), 0, frames * sizeof(sampleFrame));
+		}
+		m_delay = frames;
+		m_position = 0;
+		m_tail = 0;
+	}
+	return m_requestedDelay == m_delay;
+}
+
+
+
+
+void LatencyCompensator::reserve()
+{
+	if (needsReserve())
+	{
+		// value-initialized, i.e. silent
+		m_line.resize(m_requestedDelay);
+		m_output.resize(Engine::audioEngine()->maxFramesPerPeriod());
+	}
+	setDelay(m_requestedDelay);
+}
+
+
+
+
+bool LatencyCompensator::process(const sampleFrame* input, fpp_t frames, bool hasInput)
+{
+	const f_cnt_t size = delay();
+	if (size == 0 || (!hasInput && m_tail == 0))
+	{
+		return false;
+	}
+
+	// the frames read from the line were only silent if the tail has been
+	// read completely, the input passes through if the delay is shorter
+	const bool hasOutput = m_tail > 0 || (hasInput && frames > size);
+
+	f_cnt_t done = 0;
+	while (done < frames)
+	{
+		const f_cnt_t chunk = std::min<f_cnt_t>(frames - done, size - m_position);
+		std::memcpy(m_output.data() + done, m_line.data() + m_position, chunk * sizeof(sampleFrame));
+		if (hasInput)
+		{
+			std::memcpy(m_line.data() + m_position, input + done, chunk * sizeof(sampleFrame));
+		}
+		else
+		{
+			std::memset(m_line.data() + m_position, 0, chunk * sizeof(sampleFrame));
+		}
+		done += chunk;
+		m_position = (m_position + chunk) % size;
+	}
+
+	m_tail = hasInput ? size : std::max<f_cnt_t>(m_tail - frames, 0);
+	return hasOutput;
+}
+
+
+} // namespace lmms
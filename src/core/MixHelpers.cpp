@@ -29,10 +29,19 @@
 #endif
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <QtGlobal>
 
 #include "ValueBuffer.h"
 
+// the optimized versions use the vector extensions of GCC and Clang
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LMMS_MIX_HELPERS_X86
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#define LMMS_MIX_HELPERS_NEON
+#endif
+
 
 
 static bool s_NaNHandler;
@@ -64,7 +73,29 @@ static inline void run( sampleFrame* dst, const sample_t* srcLeft, const sample_
 
 
 
-bool isSilent( const sampleFrame* src, int frames )
+/*! \brief The functions which have optimized versions, all of them
+ *  have to give exactly the same results as the generic ones */
+struct Kernels
+{
+	bool (*isSilent)( const sampleFrame* src, int frames );
+	bool (*sanitize)( sampleFrame* src, int frames );
+	void (*add)( sampleFrame* dst, const sampleFrame* src, int frames );
+	void (*addMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addMultipliedByBuffer)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames );
+	void (*addMultipliedByBuffers)( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames );
+	void (*addSanitizedMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addSanitizedMultipliedByBuffer)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames );
+	void (*addSanitizedMultipliedByBuffers)( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames );
+	void (*multiplyByVolumeAndPanning)( sampleFrame* dst, float volume, const float* volumeBuf, float panning, const float* panningBuf, int frames );
+	void (*peakValues)( const sampleFrame* src, int frames, float& peakLeft, float& peakRight );
+} ;
+
+
+
+namespace generic
+{
+
+static bool isSilent( const sampleFrame* src, int frames )
 {
 	const float silenceThreshold = 0.0000001f;
 
@@ -79,24 +110,9 @@ bool isSilent( const sampleFrame* src, int frames )
 	return true;
 }
 
-bool useNaNHandler()
-{
-	return s_NaNHandler;
-}
-
-void setNaNHandler( bool use )
-{
-	s_NaNHandler = use;
-}
-
 /*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
-bool sanitize( sampleFrame * src, int frames )
+static bool sanitize( sampleFrame * src, int frames )
 {
-	if( !useNaNHandler() )
-	{
-		return false;
-	}
-
 	bool found = false;
 	for( int f = 0; f < frames; ++f )
 	{
@@ -138,7 +154,7 @@ struct AddOp
 	}
 } ;
 
-void add( sampleFrame* dst, const sampleFrame* src, int frames )
+static void add( sampleFrame* dst, const sampleFrame* src, int frames )
 {
 	run<>( dst, src, frames, AddOp() );
 }
@@ -159,101 +175,730 @@ struct AddMultipliedOp
 } ;
 
 
-void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, AddMultipliedOp(coeffSrc) );
 }
 
 
-struct AddSwappedMultipliedOp
+static void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
 {
-	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf[f];
+	}
+}
+
+static void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		dst[f][1] += src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+	}
+
+}
+
+static void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf[f];
+	}
+}
+
+static void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) )
+			? 0.0f
+			: src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) )
+			? 0.0f
+			: src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+	}
+
+}
+
+
+struct AddSanitizedMultipliedOp
+{
+	AddSanitizedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
 
 	void operator()( sampleFrame& dst, const sampleFrame& src ) const
 	{
-		dst[0] += src[1] * m_coeff;
-		dst[1] += src[0] * m_coeff;
+		dst[0] += ( std::isinf( src[0] ) || std::isnan( src[0] ) ) ? 0.0f : src[0] * m_coeff;
+		dst[1] += ( std::isinf( src[1] ) || std::isnan( src[1] ) ) ? 0.0f : src[1] * m_coeff;
 	}
 
 	const float m_coeff;
 };
 
-void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
-	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
+	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
 }
 
 
-void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+static void multiplyByVolumeAndPanning( sampleFrame* dst, float volume, const float* volumeBuf,
+					float panning, const float* panningBuf, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		const float v = ( volumeBuf ? volumeBuf[f] : volume ) * 0.01f;
+		const float p = ( panningBuf ? panningBuf[f] : panning ) * 0.01f;
+		dst[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
+		dst[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
 	}
 }
 
-void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+
+static void peakValues( const sampleFrame* src, int frames, float& peakLeft, float& peakRight )
 {
+	peakLeft = 0.0f;
+	peakRight = 0.0f;
+
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+		float const absLeft = qAbs( src[f][0] );
+		float const absRight = qAbs( src[f][1] );
+		if( absLeft > peakLeft )
+		{
+			peakLeft = absLeft;
+		}
+
+		if( absRight > peakRight )
+		{
+			peakRight = absRight;
+		}
 	}
+}
+
 
+static const Kernels kernels = {
+	isSilent,
+	sanitize,
+	add,
+	addMultiplied,
+	addMultipliedByBuffer,
+	addMultipliedByBuffers,
+	addSanitizedMultiplied,
+	addSanitizedMultipliedByBuffer,
+	addSanitizedMultipliedByBuffers,
+	multiplyByVolumeAndPanning,
+	peakValues
+} ;
+
+} // namespace generic
+
+
+
+#if defined(LMMS_MIX_HELPERS_X86) || defined(LMMS_MIX_HELPERS_NEON)
+
+/*
+ * The optimized versions work on the interleaved samples as one array of
+ * floats, a vector of V at a time, and leave the rest to scalar code. They
+ * do the same operations in the same order as the generic versions, so the
+ * results are bit-exact - the file is built without contracting
+ * multiplications and additions into FMAs for this.
+ *
+ * They are written for any vector size and get compiled for each instruction
+ * set by being inlined into functions with the respective target attribute.
+ */
+namespace vector
+{
+
+using Float4 = float __attribute__((vector_size(16)));
+using Int4 = std::int32_t __attribute__((vector_size(16)));
+using Float8 = float __attribute__((vector_size(32)));
+using Int8 = std::int32_t __attribute__((vector_size(32)));
+using Float16 = float __attribute__((vector_size(64)));
+using Int16 = std::int32_t __attribute__((vector_size(64)));
+
+template<typename V> struct IntVector;
+template<> struct IntVector<Float4> { using Type = Int4; };
+template<> struct IntVector<Float8> { using Type = Int8; };
+template<> struct IntVector<Float16> { using Type = Int16; };
+
+// vectors are passed by reference only, passing them by value from code not
+// compiled for the instruction set would change the ABI. Casts between float
+// and int vectors of the same size reinterpret the bits.
+#define LMMS_MIX_INLINE __attribute__((always_inline)) inline
+
+template<typename V>
+LMMS_MIX_INLINE void load( V& v, const float* p )
+{
+	std::memcpy( &v, p, sizeof( V ) );
 }
 
-void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+template<typename V>
+LMMS_MIX_INLINE void store( float* p, const V& v )
 {
-	if ( !useNaNHandler() )
+	std::memcpy( p, &v, sizeof( V ) );
+}
+
+//! Per-frame coefficients for both channels of the frames in a vector
+template<typename V>
+LMMS_MIX_INLINE void loadPerFrame( V& v, const float* coeffs )
+{
+	for( int i = 0; i < static_cast<int>( sizeof( V ) / sizeof( float ) ); ++i )
 	{
-		addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf,
-								frames );
-		return;
+		v[i] = coeffs[i / 2];
 	}
+}
 
-	for( int f = 0; f < frames; ++f )
+template<typename I>
+LMMS_MIX_INLINE bool anyLane( const I& mask )
+{
+	for( int i = 0; i < static_cast<int>( sizeof( I ) / sizeof( std::int32_t ) ); ++i )
 	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		if( mask[i] )
+		{
+			return true;
+		}
 	}
+	return false;
 }
 
-void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+//! All bits set for the lanes of v which are neither inf nor nan
+template<typename V, typename I = typename IntVector<V>::Type>
+LMMS_MIX_INLINE void finiteMask( I& mask, const V& v )
 {
-	if ( !useNaNHandler() )
+	const I exponent = I{} + 0x7f800000;
+	mask = ( (I) v & exponent ) != exponent;
+}
+
+//! a for the lanes with all bits set in mask, b for the others
+template<typename V, typename I = typename IntVector<V>::Type>
+LMMS_MIX_INLINE void select( V& out, const I& mask, const V& a, const V& b )
+{
+	out = (V) ( ( mask & (I) a ) | ( ~mask & (I) b ) );
+}
+
+
+template<typename V>
+LMMS_MIX_INLINE bool isSilent( const sampleFrame* src, int frames )
+{
+	using I = typename IntVector<V>::Type;
+	constexpr int Lanes = sizeof( V ) / sizeof( float );
+
+	const float* s = reinterpret_cast<const float*>( src );
+	const int samples = frames * DEFAULT_CHANNELS;
+	const V silenceThreshold = V{} + 0.0000001f;
+	const I absMask = I{} + 0x7fffffff;
+
+	int i = 0;
+	for( ; i + Lanes <= samples; i += Lanes )
 	{
-		addMultipliedByBuffers( dst, src, coeffSrcBuf1, coeffSrcBuf2,
-								frames );
-		return;
+		V x;
+		load( x, s + i );
+		const I loud = (V) ( (I) x & absMask ) >= silenceThreshold;
+		if( anyLane( loud ) )
+		{
+			return false;
+		}
+	}
+	for( ; i < samples; ++i )
+	{
+		if( fabsf( s[i] ) >= 0.0000001f )
+		{
+			return false;
+		}
 	}
+	return true;
+}
 
-	for( int f = 0; f < frames; ++f )
+
+template<typename V>
+LMMS_MIX_INLINE bool sanitize( sampleFrame* src, int frames )
+{
+	using I = typename IntVector<V>::Type;
+	constexpr int Lanes = sizeof( V ) / sizeof( float );
+
+	float* s = reinterpret_cast<float*>( src );
+	const int samples = frames * DEFAULT_CHANNELS;
+
+	// a bad value clears the whole buffer, so look for one first
+	I finite = ~I{};
+	int i = 0;
+	for( ; i + Lanes <= samples; i += Lanes )
 	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) )
-			? 0.0f
-			: src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) )
-			? 0.0f
-			: src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+		V x;
+		load( x, s + i );
+		I mask;
+		finiteMask( mask, x );
+		finite &= mask;
+	}
+	bool found = anyLane( ~finite );
+	for( ; i < samples && !found; ++i )
+	{
+		found = std::isinf( s[i] ) || std::isnan( s[i] );
+	}
+	if( found )
+	{
+		return generic::sanitize( src, frames );
 	}
 
+	// same as qBound( -1000.0f, x, 1000.0f )
+	const V upper = V{} + 1000.0f;
+	const V lower = V{} - 1000.0f;
+	for( i = 0; i + Lanes <= samples; i += Lanes )
+	{
+		V x;
+		load( x, s + i );
+		select( x, upper < x, upper, x );
+		select( x, lower < x, x, lower );
+		store( s + i, x );
+	}
+	for( ; i < samples; ++i )
+	{
+		s[i] = qBound( -1000.0f, s[i], 1000.0f );
+	}
+	return false;
 }
 
 
-struct AddSanitizedMultipliedOp
+template<typename V>
+LMMS_MIX_INLINE void add( sampleFrame* dst, const sampleFrame* src, int frames )
 {
-	AddSanitizedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
+	constexpr int Lanes = sizeof( V ) / sizeof( float );
+
+	float* d = reinterpret_cast<float*>( dst );
+	const float* s = reinterpret_cast<const float*>( src );
+	const int samples = frames * DEFAULT_CHANNELS;
+
+	int i = 0;
+	for( ; i + Lanes <= samples; i += Lanes )
+	{
+		V x, y;
+		load( x, d + i );
+		load( y, s + i );
+		x += y;
+		store( d + i, x );
+	}
+	for( ; i < samples; ++i )
+	{
+		d[i] += s[i];
+	}
+}
+
+
+template<typename V, bool Sanitize>
+LMMS_MIX_INLINE void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	using I = typename IntVector<V>::Type;
+	constexpr int Lanes = sizeof( V ) / sizeof( float );
+
+	float* d = reinterpret_cast<float*>( dst );
+	const float* s = reinterpret_cast<const float*>( src );
+	const int samples = frames * DEFAULT_CHANNELS;
+
+	int i = 0;
+	for( ; i + Lanes <= samples; i += Lanes )
+	{
+		V x, y;
+		load( x, d + i );
+		load( y, s + i );
+		V term = y * coeffSrc;
+		if( Sanitize )
+		{
+			I finite;
+			finiteMask( finite, y );
+			select( term, finite, term, V{} );
+		}
+		x += term;
+		store( d + i, x );
+	}
+	for( ; i < samples; ++i )
+	{
+		d[i] += ( Sanitize && ( std::isinf( s[i] ) || std::isnan( s[i] ) ) ) ? 0.0f : s[i] * coeffSrc;
+	}
+}
+
+
+template<typename V, bool Sanitize>
+LMMS_MIX_INLINE void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	using I = typename IntVector<V>::Type;
+	constexpr int FramesPerVector = sizeof( V ) / sizeof( float ) / DEFAULT_CHANNELS;
+
+	int f = 0;
+	for( ; f + FramesPerVector <= frames; f += FramesPerVector )
+	{
+		V x, y, c;
+		load( x, dst[f].data() );
+		load( y, src[f].data() );
+		loadPerFrame( c, coeffSrcBuf + f );
+		V term = y * coeffSrc * c;
+		if( Sanitize )
+		{
+			I finite;
+			finiteMask( finite, y );
+			select( term, finite, term, V{} );
+		}
+		x += term;
+		store( dst[f].data(), x );
+	}
+	if( Sanitize )
+	{
+		generic::addSanitizedMultipliedByBuffer( dst + f, src + f, coeffSrc, coeffSrcBuf + f, frames - f );
+	}
+	else
+	{
+		generic::addMultipliedByBuffer( dst + f, src + f, coeffSrc, coeffSrcBuf + f, frames - f );
+	}
+}
+
+
+template<typename V, bool Sanitize>
+LMMS_MIX_INLINE void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	using I = typename IntVector<V>::Type;
+	constexpr int FramesPerVector = sizeof( V ) / sizeof( float ) / DEFAULT_CHANNELS;
+
+	int f = 0;
+	for( ; f + FramesPerVector <= frames; f += FramesPerVector )
+	{
+		V x, y, c1, c2;
+		load( x, dst[f].data() );
+		load( y, src[f].data() );
+		loadPerFrame( c1, coeffSrcBuf1 + f );
+		loadPerFrame( c2, coeffSrcBuf2 + f );
+		V term = y * c1 * c2;
+		if( Sanitize )
+		{
+			I finite;
+			finiteMask( finite, y );
+			select( term, finite, term, V{} );
+		}
+		x += term;
+		store( dst[f].data(), x );
+	}
+	if( Sanitize )
+	{
+		generic::addSanitizedMultipliedByBuffers( dst + f, src + f, coeffSrcBuf1 + f, coeffSrcBuf2 + f, frames - f );
+	}
+	else
+	{
+		generic::addMultipliedByBuffers( dst + f, src + f, coeffSrcBuf1 + f, coeffSrcBuf2 + f, frames - f );
+	}
+}
+
+
+template<typename V>
+LMMS_MIX_INLINE void multiplyByVolumeAndPanning( sampleFrame* dst, float volume, const float* volumeBuf,
+							float panning, const float* panningBuf, int frames )
+{
+	constexpr int Lanes = sizeof( V ) / sizeof( float );
+	constexpr int FramesPerVector = Lanes / DEFAULT_CHANNELS;
+
+	const bool constantGains = volumeBuf == nullptr && panningBuf == nullptr;
+	V gain;
+
+	int f = 0;
+	for( ; f + FramesPerVector <= frames; f += FramesPerVector )
+	{
+		if( f == 0 || !constantGains )
+		{
+			// the gains of both channels of each frame, without branching
+			// on the panning direction
+			for( int i = 0; i < FramesPerVector; ++i )
+			{
+				const float v = ( volumeBuf ? volumeBuf[f + i] : volume ) * 0.01f;
+				const float p = ( panningBuf ? panningBuf[f + i] : panning ) * 0.01f;
+				gain[2 * i] = ( p <= 0 ? 1.0f : 1.0f - p ) * v;
+				gain[2 * i + 1] = ( p >= 0 ? 1.0f : 1.0f + p ) * v;
+			}
+		}
+		V x;
+		load( x, dst[f].data() );
+		x *= gain;
+		store( dst[f].data(), x );
+	}
+	generic::multiplyByVolumeAndPanning( dst + f, volume, volumeBuf ? volumeBuf + f : nullptr,
+						panning, panningBuf ? panningBuf + f : nullptr, frames - f );
+}
+
+
+template<typename V>
+LMMS_MIX_INLINE void peakValues( const sampleFrame* src, int frames, float& peakLeft, float& peakRight )
+{
+	using I = typename IntVector<V>::Type;
+	constexpr int Lanes = sizeof( V ) / sizeof( float );
+	constexpr int FramesPerVector = Lanes / DEFAULT_CHANNELS;
+
+	const I absMask = I{} + 0x7fffffff;
+	V peak = V{};
+	int f = 0;
+	for( ; f + FramesPerVector <= frames; f += FramesPerVector )
+	{
+		V x;
+		load( x, src[f].data() );
+		const V absValue = (V) ( (I) x & absMask );
+		// nans never compare greater, like in the generic version
+		select( peak, absValue > peak, absValue, peak );
+	}
+
+	generic::peakValues( src + f, frames - f, peakLeft, peakRight );
+	for( int i = 0; i < Lanes; i += DEFAULT_CHANNELS )
+	{
+		peakLeft = qMax( peakLeft, peak[i] );
+		peakRight = qMax( peakRight, peak[i + 1] );
+	}
+}
+
+} // namespace vector
+
+
+// Defines namespace NAME with the versions of the kernels for vector type V
+// compiled with the target attribute TARGET
+#define LMMS_MIX_KERNELS(NAME, TARGET, V) \
+namespace NAME \
+{ \
+TARGET static bool isSilent( const sampleFrame* src, int frames ) \
+{ \
+	return vector::isSilent<V>( src, frames ); \
+} \
+TARGET static bool sanitize( sampleFrame* src, int frames ) \
+{ \
+	return vector::sanitize<V>( src, frames ); \
+} \
+TARGET static void add( sampleFrame* dst, const sampleFrame* src, int frames ) \
+{ \
+	vector::add<V>( dst, src, frames ); \
+} \
+TARGET static void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames ) \
+{ \
+	vector::addMultiplied<V, false>( dst, src, coeffSrc, frames ); \
+} \
+TARGET static void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames ) \
+{ \
+	vector::addMultipliedByBuffer<V, false>( dst, src, coeffSrc, coeffSrcBuf, frames ); \
+} \
+TARGET static void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames ) \
+{ \
+	vector::addMultipliedByBuffers<V, false>( dst, src, coeffSrcBuf1, coeffSrcBuf2, frames ); \
+} \
+TARGET static void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames ) \
+{ \
+	vector::addMultiplied<V, true>( dst, src, coeffSrc, frames ); \
+} \
+TARGET static void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames ) \
+{ \
+	vector::addMultipliedByBuffer<V, true>( dst, src, coeffSrc, coeffSrcBuf, frames ); \
+} \
+TARGET static void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames ) \
+{ \
+	vector::addMultipliedByBuffers<V, true>( dst, src, coeffSrcBuf1, coeffSrcBuf2, frames ); \
+} \
+TARGET static void multiplyByVolumeAndPanning( sampleFrame* dst, float volume, const float* volumeBuf, float panning, const float* panningBuf, int frames ) \
+{ \
+	vector::multiplyByVolumeAndPanning<V>( dst, volume, volumeBuf, panning, panningBuf, frames ); \
+} \
+TARGET static void peakValues( const sampleFrame* src, int frames, float& peakLeft, float& peakRight ) \
+{ \
+	vector::peakValues<V>( src, frames, peakLeft, peakRight ); \
+} \
+static const Kernels kernels = { \
+	isSilent, \
+	sanitize, \
+	add, \
+	addMultiplied, \
+	addMultipliedByBuffer, \
+	addMultipliedByBuffers, \
+	addSanitizedMultiplied, \
+	addSanitizedMultipliedByBuffer, \
+	addSanitizedMultipliedByBuffers, \
+	multiplyByVolumeAndPanning, \
+	peakValues \
+} ; \
+}
+
+#ifdef LMMS_MIX_HELPERS_X86
+LMMS_MIX_KERNELS(sse2, __attribute__((target("sse2"))), vector::Float4)
+LMMS_MIX_KERNELS(avx2, __attribute__((target("avx2"))), vector::Float8)
+LMMS_MIX_KERNELS(avx512, __attribute__((target("avx512f"))), vector::Float16)
+#else
+LMMS_MIX_KERNELS(neon, , vector::Float4)
+#endif
+
+#undef LMMS_MIX_KERNELS
+#undef LMMS_MIX_INLINE
+
+#endif
+
+
+
+static const Kernels * kernelsFor( InstructionSet set )
+{
+	switch( set )
+	{
+#ifdef LMMS_MIX_HELPERS_X86
+		case InstructionSet::SSE2: return &sse2::kernels;
+		case InstructionSet::AVX2: return &avx2::kernels;
+		case InstructionSet::AVX512: return &avx512::kernels;
+#endif
+#ifdef LMMS_MIX_HELPERS_NEON
+		case InstructionSet::NEON: return &neon::kernels;
+#endif
+		default: return &generic::kernels;
+	}
+}
+
+
+static InstructionSet bestInstructionSet()
+{
+	for( auto set : { InstructionSet::AVX512, InstructionSet::AVX2, InstructionSet::SSE2, InstructionSet::NEON } )
+	{
+		if( isSupported( set ) )
+		{
+			return set;
+		}
+	}
+	return InstructionSet::Generic;
+}
+
+
+static InstructionSet s_instructionSet = InstructionSet::Generic;
+static const Kernels * s_kernels = &generic::kernels;
+[[maybe_unused]] static const bool s_instructionSetDetected = setInstructionSet( bestInstructionSet() );
+
+
+
+bool isSupported( InstructionSet set )
+{
+#ifdef LMMS_MIX_HELPERS_X86
+	__builtin_cpu_init();
+#endif
+	switch( set )
+	{
+		case InstructionSet::Generic: return true;
+#ifdef LMMS_MIX_HELPERS_X86
+		case InstructionSet::SSE2: return __builtin_cpu_supports( "sse2" );
+		case InstructionSet::AVX2: return __builtin_cpu_supports( "avx2" );
+		case InstructionSet::AVX512: return __builtin_cpu_supports( "avx512f" );
+#endif
+#ifdef LMMS_MIX_HELPERS_NEON
+		case InstructionSet::NEON: return true;
+#endif
+		default: return false;
+	}
+}
+
+InstructionSet instructionSet()
+{
+	return s_instructionSet;
+}
+
+bool setInstructionSet( InstructionSet set )
+{
+	if( !isSupported( set ) )
+	{
+		return false;
+	}
+	s_instructionSet = set;
+	s_kernels = kernelsFor( set );
+	return true;
+}
+
+
+
+bool isSilent( const sampleFrame* src, int frames )
+{
+	return s_kernels->isSilent( src, frames );
+}
+
+bool useNaNHandler()
+{
+	return s_NaNHandler;
+}
+
+void setNaNHandler( bool use )
+{
+	s_NaNHandler = use;
+}
+
+/*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
+bool sanitize( sampleFrame * src, int frames )
+{
+	if( !useNaNHandler() )
+	{
+		return false;
+	}
+
+	return s_kernels->sanitize( src, frames );
+}
+
+
+void add( sampleFrame* dst, const sampleFrame* src, int frames )
+{
+	s_kernels->add( dst, src, frames );
+}
+
+
+void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	s_kernels->addMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+struct AddSwappedMultipliedOp
+{
+	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
 
 	void operator()( sampleFrame& dst, const sampleFrame& src ) const
 	{
-		dst[0] += ( std::isinf( src[0] ) || std::isnan( src[0] ) ) ? 0.0f : src[0] * m_coeff;
-		dst[1] += ( std::isinf( src[1] ) || std::isnan( src[1] ) ) ? 0.0f : src[1] * m_coeff;
+		dst[0] += src[1] * m_coeff;
+		dst[1] += src[0] * m_coeff;
 	}
 
 	const float m_coeff;
 };
 
+void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
+}
+
+
+void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	s_kernels->addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	s_kernels->addMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf,
+								frames );
+		return;
+	}
+
+	s_kernels->addSanitizedMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultipliedByBuffers( dst, src, coeffSrcBuf1, coeffSrcBuf2,
+								frames );
+		return;
+	}
+
+	s_kernels->addSanitizedMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+
 void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	if ( !useNaNHandler() )
@@ -262,7 +907,7 @@ void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coe
 		return;
 	}
 
-	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
+	s_kernels->addSanitizedMultiplied( dst, src, coeffSrc, frames );
 }
 
 
@@ -328,5 +973,43 @@ void multiplyAndAddMultipliedJoined( sampleFrame* dst,
 	run<>( dst, srcLeft, srcRight, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
 }
 
+
+void multiplyByVolumeAndPanning( sampleFrame* dst, float volume, const ValueBuffer * volumeBuf,
+					float panning, const ValueBuffer * panningBuf, int frames )
+{
+	s_kernels->multiplyByVolumeAndPanning( dst, volume, volumeBuf ? volumeBuf->values() : nullptr,
+						panning, panningBuf ? panningBuf->values() : nullptr, frames );
+}
+
+
+
+void peakValues( const sampleFrame* src, int frames, float& peakLeft, float& peakRight )
+{
+	s_kernels->peakValues( src, frames, peakLeft, peakRight );
+}
+
+
+
+
+void deinterleave( sample_t* left, sample_t* right, const sampleFrame* src, int frames )
+{
+	for( int f = 0; f < frames; ++f )
+	{
+		left[f] = src[f][0];
+		right[f] = src[f][1];
+	}
+}
+
+
+
+void interleave( sampleFrame* dst, const sample_t* left, const sample_t* right, int frames )
+{
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] = left[f];
+		dst[f][1] = right[f];
+	}
+}
+
 } // namespace lmms::MixHelpers
 
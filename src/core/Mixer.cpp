@@ -26,6 +26,7 @@
 
 #include "AudioEngine.h"
 #include "AudioEngineWorkerThread.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Mixer.h"
 #include "MixHelpers.h"
@@ -62,17 +63,21 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_fxChain( nullptr ),
 	m_hasInput( false ),
 	m_stillRunning( false ),
+	m_silent( true ),
 	m_peakLeft( 0.0f ),
 	m_peakRight( 0.0f ),
-	m_buffer( new sampleFrame[Engine::audioEngine()->framesPerPeriod()] ),
+	m_buffer( BufferManager::acquire() ),
 	m_muteModel( false, _parent ),
 	m_soloModel( false, _parent ),
 	m_volumeModel( 1.0, 0.0, 2.0, 0.001, _parent ),
 	m_name(),
-	m_lock(),
 	m_channelIndex( idx ),
 	m_queued( false ),
+	m_muted( false ),
+	m_capture( nullptr ),
 	m_hasColor( false ),
+	m_latency( 0 ),
+	m_dependencies( 0 ),
 	m_dependenciesMet(0)
 {
 	BufferManager::clear( m_buffer, Engine::audioEngine()->framesPerPeriod() );
@@ -83,7 +88,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 
 MixerChannel::~MixerChannel()
 {
-	delete[] m_buffer;
+	BufferManager::release( m_buffer );
 }
 
 
@@ -101,7 +106,7 @@ inline void MixerChannel::processed()
 void MixerChannel::incrementDeps()
 {
 	int i = m_dependenciesMet++ + 1;
-	if( i >= m_receives.size() && ! m_queued )
+	if( i >= m_dependencies && ! m_queued )
 	{
 		m_queued = true;
 		AudioEngineWorkerThread::addJob( this );
@@ -122,20 +127,41 @@ void MixerChannel::doProcessing()
 
 	if( m_muted == false )
 	{
+		// pull the output of our audio ports, which are all done by now
+		for( AudioPort * port : m_inputPorts )
+		{
+			if( port->hasOutput() )
+			{
+				MixHelpers::add( m_buffer, port->output(), fpp );
+				m_hasInput = true;
+				m_silent = false;
+			}
+		}
+
 		for( MixerRoute * senderRoute : m_receives )
 		{
 			MixerChannel * sender = senderRoute->sender();
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			bool senderActive = sender->m_hasInput || sender->m_stillRunning;
+			const sampleFrame * ch_buf = sender->m_buffer;
+
+			// line the sender up with our other inputs
+			LatencyCompensator & compensator = senderRoute->compensator();
+			if( compensator.delay() > 0 )
+			{
+				senderActive = compensator.process( ch_buf, fpp, senderActive );
+				ch_buf = compensator.output();
+			}
+
+			if( senderActive )
 			{
 				// figure out if we're getting sample-exact input
 				ValueBuffer * sendBuf = sendModel->valueBuffer();
 				ValueBuffer * volBuf = sender->m_volumeModel.valueBuffer();
 
 				// mix it's output with this one's output
-				sampleFrame * ch_buf = sender->m_buffer;
 
 				// use sample-exact mixing if sample-exact values are available
 				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
@@ -158,6 +184,7 @@ void MixerChannel::doProcessing()
 					MixHelpers::addSanitizedMultipliedByBuffer( m_buffer, ch_buf, v, sendBuf, fpp );
 				}
 				m_hasInput = true;
+				m_silent = false;
 			}
 		}
 
@@ -170,11 +197,29 @@ void MixerChannel::doProcessing()
 			m_fxChain.startRunning();
 		}
 
-		m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+		// without input the effects only have to run while one of them
+		// is still producing a tail, otherwise the buffer stays silent
+		if( m_hasInput || m_fxChain.isRunning() )
+		{
+			m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+			m_silent = false;
+		}
+		else
+		{
+			m_stillRunning = false;
+		}
 
-		AudioEngine::StereoSample peakSamples = Engine::audioEngine()->getPeakValues(m_buffer, fpp);
-		m_peakLeft = qMax( m_peakLeft, peakSamples.left * v );
-		m_peakRight = qMax( m_peakRight, peakSamples.right * v );
+		if( m_silent )
+		{
+			m_peakLeft = qMax( m_peakLeft, 0.0f );
+			m_peakRight = qMax( m_peakRight, 0.0f );
+		}
+		else
+		{
+			AudioEngine::StereoSample peakSamples = Engine::audioEngine()->getPeakValues(m_buffer, fpp);
+			m_peakLeft = qMax( m_peakLeft, peakSamples.left * v );
+			m_peakRight = qMax( m_peakRight, peakSamples.right * v );
+		}
 	}
 	else
 	{
@@ -190,7 +235,8 @@ void MixerChannel::doProcessing()
 Mixer::Mixer() :
 	Model( nullptr ),
 	JournallingObject(),
-	m_mixerChannels()
+	m_mixerChannels(),
+	m_firstLevelSize( 0 )
 {
 	// create master channel
 	createChannel();
@@ -221,6 +267,11 @@ int Mixer::createChannel()
 	// create new channel
 	m_mixerChannels.push_back( new MixerChannel( index, this ) );
 
+	// muted channels are left out of the schedule, including when muted
+	// for soloing another channel
+	connect( &m_mixerChannels[index]->m_muteModel, &BoolModel::dataChanged, this,
+		[]() { Engine::audioEngine()->invalidateRenderGraph(); }, Qt::DirectConnection );
+
 	// reset channel state
 	clearChannel( index );
 
@@ -364,6 +415,7 @@ void Mixer::deleteChannel( int index )
 		}
 	}
 
+	Engine::audioEngine()->invalidateRenderGraph();
 	Engine::audioEngine()->doneChangeInModel();
 }
 
@@ -477,6 +529,7 @@ MixerRoute * Mixer::createRoute( MixerChannel * from, MixerChannel * to, float a
 
 	// add us to mixer's list
 	Engine::mixer()->m_mixerRoutes.append( route );
+	Engine::audioEngine()->invalidateRenderGraph();
 	Engine::audioEngine()->doneChangeInModel();
 
 	return route;
@@ -512,6 +565,7 @@ void Mixer::deleteChannelSend( MixerRoute * route )
 	// remove us from mixer's list
 	Engine::mixer()->m_mixerRoutes.remove( Engine::mixer()->m_mixerRoutes.indexOf( route ) );
 	delete route;
+	Engine::audioEngine()->invalidateRenderGraph();
 	Engine::audioEngine()->doneChangeInModel();
 }
 
@@ -577,102 +631,210 @@ FloatModel * Mixer::channelSendModel( mix_ch_t fromChannel, mix_ch_t toChannel )
 
 
 
-void Mixer::mixToChannel( const sampleFrame * _buf, mix_ch_t _ch )
+void Mixer::prepareMasterMix()
 {
-	if( m_mixerChannels[_ch]->m_muteModel.value() == false )
+	MixerChannel * master = m_mixerChannels[0];
+	if( !master->m_silent )
 	{
-		m_mixerChannels[_ch]->m_lock.lock();
-		MixHelpers::add( m_mixerChannels[_ch]->m_buffer, _buf, Engine::audioEngine()->framesPerPeriod() );
-		m_mixerChannels[_ch]->m_hasInput = true;
-		m_mixerChannels[_ch]->m_lock.unlock();
+		BufferManager::clear( master->m_buffer, Engine::audioEngine()->framesPerPeriod() );
+		master->m_silent = true;
 	}
 }
 
 
 
-
-void Mixer::prepareMasterMix()
+void Mixer::compileSchedule()
 {
-	BufferManager::clear( m_mixerChannels[0]->m_buffer,
-					Engine::audioEngine()->framesPerPeriod() );
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		ch->m_muted = ch->m_muteModel.value();
+	}
+
+	// the first level: unmuted channels without unmuted senders
+	m_schedule.clear();
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		ch->m_dependencies = 0;
+		ch->m_inputPorts.clear();
+		if( ch->m_muted )
+		{
+			continue;
+		}
+		for( const MixerRoute * route : ch->m_receives )
+		{
+			if( !route->sender()->m_muted )
+			{
+				++ch->m_dependencies;
+			}
+		}
+		if( ch->m_dependencies == 0 )
+		{
+			m_schedule.push_back( ch );
+		}
+	}
+	m_firstLevelSize = m_schedule.size();
+
+	// Kahn's algorithm: append each channel once all its senders are in
+	// the schedule. As the channels are visited in order, the schedule
+	// stays sorted by level. m_dependenciesMet is 0 between periods and
+	// only borrowed for counting here.
+	for( std::size_t i = 0; i < m_schedule.size(); ++i )
+	{
+		for( const MixerRoute * route : m_schedule[i]->m_sends )
+		{
+			MixerChannel * receiver = route->receiver();
+			if( !receiver->m_muted &&
+				++receiver->m_dependenciesMet == receiver->m_dependencies )
+			{
+				m_schedule.push_back( receiver );
+			}
+		}
+	}
+	for( MixerChannel * ch : m_schedule )
+	{
+		ch->m_dependenciesMet = 0;
+	}
 }
 
 
 
-void Mixer::masterMix( sampleFrame * _buf )
+f_cnt_t Mixer::compensateLatency( bool & needsReserve )
 {
-	const int fpp = Engine::audioEngine()->framesPerPeriod();
-
-	// add the channels that have no dependencies (no incoming senders, ie.
-	// no receives) to the jobqueue. The channels that have receives get
-	// added when their senders get processed, which is detected by
-	// dependency counting.
-	// also instantly add all muted channels as they don't need to care
-	// about their senders, and can just increment the deps of their
-	// recipients right away.
-	AudioEngineWorkerThread::resetJobQueue( AudioEngineWorkerThread::JobQueue::Dynamic );
-	for( MixerChannel * ch : m_mixerChannels )
+	// the schedule is sorted topologically, so the latency of all senders
+	// is known when we get to a channel
+	for( MixerChannel * ch : m_schedule )
 	{
-		ch->m_muted = ch->m_muteModel.value();
-		if( ch->m_muted ) // instantly "process" muted channels
+		f_cnt_t inputLatency = 0;
+		for( const AudioPort * port : ch->m_inputPorts )
 		{
-			ch->processed();
-			ch->done();
+			inputLatency = qMax( inputLatency, port->latency() );
 		}
-		else if( ch->m_receives.size() == 0 )
+		for( const MixerRoute * route : ch->m_receives )
 		{
-			ch->m_queued = true;
-			AudioEngineWorkerThread::addJob( ch );
+			if( !route->sender()->m_muted )
+			{
+				inputLatency = qMax( inputLatency, route->sender()->m_latency );
+			}
 		}
-	}
-	while (m_mixerChannels[0]->state() != ThreadableJob::ProcessingState::Done)
-	{
-		bool found = false;
-		for( MixerChannel * ch : m_mixerChannels )
+
+		for( AudioPort * port : ch->m_inputPorts )
 		{
-			const auto s = ch->state();
-			if (s == ThreadableJob::ProcessingState::Queued
-				|| s == ThreadableJob::ProcessingState::InProgress)
+			if( !port->setCompensationDelay( inputLatency - port->latency() ) )
 			{
-				found = true;
-				break;
+				needsReserve = true;
 			}
 		}
-		if( !found )
+		for( MixerRoute * route : ch->m_receives )
 		{
-			break;
+			if( !route->compensator().setDelay( route->sender()->m_muted
+				? 0 : inputLatency - route->sender()->m_latency ) )
+			{
+				needsReserve = true;
+			}
 		}
-		AudioEngineWorkerThread::startAndWaitForJobs();
+
+		ch->m_latency = inputLatency + ch->m_fxChain.latency();
 	}
 
-	// handle sample-exact data in master volume fader
-	ValueBuffer * volBuf = m_mixerChannels[0]->m_volumeModel.valueBuffer();
+	MixerChannel * master = m_mixerChannels[0];
+	return master->m_muted ? 0 : master->m_latency;
+}
+
 
-	if( volBuf )
+
+void Mixer::reserveLatencyCompensation()
+{
+	for( MixerChannel * ch : m_mixerChannels )
 	{
-		for( int f = 0; f < fpp; f++ )
+		for( MixerRoute * route : ch->m_receives )
 		{
-			m_mixerChannels[0]->m_buffer[f][0] *= volBuf->values()[f];
-			m_mixerChannels[0]->m_buffer[f][1] *= volBuf->values()[f];
+			route->compensator().reserve();
 		}
 	}
+}
+
 
-	const float v = volBuf
-		? 1.0f
-		: m_mixerChannels[0]->m_volumeModel.value();
-	MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
 
-	// clear all channel buffers and
-	// reset channel process state
-	for( int i = 0; i < numChannels(); ++i)
+void Mixer::scheduleChannels()
+{
+	// the audio engine added the audio ports to the dependencies, so only
+	// channels without any input can be queued right away
+	for( std::size_t i = 0; i < m_firstLevelSize; ++i )
 	{
-		BufferManager::clear( m_mixerChannels[i]->m_buffer,
-				Engine::audioEngine()->framesPerPeriod() );
-		m_mixerChannels[i]->reset();
-		m_mixerChannels[i]->m_queued = false;
-		// also reset hasInput
-		m_mixerChannels[i]->m_hasInput = false;
-		m_mixerChannels[i]->m_dependenciesMet = 0;
+		MixerChannel * ch = m_schedule[i];
+		if( ch->m_dependencies == 0 )
+		{
+			ch->m_queued = true;
+			AudioEngineWorkerThread::addJob( ch );
+		}
+	}
+}
+
+
+
+void Mixer::masterMix( sampleFrame * _buf )
+{
+	const int fpp = Engine::audioEngine()->framesPerPeriod();
+	MixerChannel * master = m_mixerChannels[0];
+
+	// handle sample-exact data in master volume fader
+	ValueBuffer * volBuf = master->m_volumeModel.valueBuffer();
+
+	if( !master->m_silent )
+	{
+		if( volBuf )
+		{
+			for( int f = 0; f < fpp; f++ )
+			{
+				master->m_buffer[f][0] *= volBuf->values()[f];
+				master->m_buffer[f][1] *= volBuf->values()[f];
+			}
+		}
+
+		const float v = volBuf
+			? 1.0f
+			: master->m_volumeModel.value();
+		MixHelpers::addSanitizedMultiplied( _buf, master->m_buffer, v, fpp );
+	}
+
+	// in one pass over the channels: keep the output of channels exported
+	// as stems, clear the buffers which have been written to and reset
+	// the process state
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		if( ch->m_capture )
+		{
+			BufferManager::clear( ch->m_capture, fpp );
+		}
+		if( ch->m_capture && !ch->m_silent )
+		{
+			ValueBuffer * chVolBuf = ch->m_volumeModel.valueBuffer();
+			// the master channel already has its volume buffer applied
+			if( chVolBuf && ch != master )
+			{
+				MixHelpers::addSanitizedMultipliedByBuffer( ch->m_capture, ch->m_buffer, 1.0f, chVolBuf, fpp );
+			}
+			else
+			{
+				MixHelpers::addSanitizedMultiplied( ch->m_capture, ch->m_buffer,
+						chVolBuf ? 1.0f : ch->m_volumeModel.value(), fpp );
+			}
+		}
+
+		if( !ch->m_silent )
+		{
+			BufferManager::clear( ch->m_buffer, fpp );
+			ch->m_silent = true;
+		}
+		if( ch->m_muted )
+		{
+			// muted channels never run, but their meters have to fall
+			ch->m_peakLeft = ch->m_peakRight = 0.0f;
+		}
+		ch->reset();
+		ch->m_queued = false;
+		ch->m_hasInput = false;
+		ch->m_dependenciesMet = 0;
 	}
 }
 
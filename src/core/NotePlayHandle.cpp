@@ -25,6 +25,12 @@
 
 #include "NotePlayHandle.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
 #include "AudioEngine.h"
 #include "BasicFilters.h"
 #include "DetuningHelper.h"
@@ -455,22 +461,28 @@ void NotePlayHandle::mute()
 
 int NotePlayHandle::index() const
 {
+	// only our track's port has to be searched, see nphsOfInstrumentTrack()
 	const PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
-	int idx = 0;
-	for (const auto& playHandle : playHandles)
+	AudioPort * port = m_instrumentTrack->audioPort();
+	int idx = -1;
+	int i = 0;
+	port->lockPlayHandles();
+	for (const auto& playHandle : port->playHandles())
 	{
 		const auto nph = dynamic_cast<const NotePlayHandle*>(playHandle);
-		if( nph == nullptr || nph->m_instrumentTrack != m_instrumentTrack || nph->isReleased() || nph->hasParent() )
+		if( nph == nullptr || !playHandles.contains( playHandle ) || nph->m_instrumentTrack != m_instrumentTrack || nph->isReleased() || nph->hasParent() )
 		{
 			continue;
 		}
 		if( nph == this )
 		{
-			return idx;
+			idx = i;
+			break;
 		}
-		++idx;
+		++i;
 	}
-	return -1;
+	port->unlockPlayHandles();
+	return idx;
 }
 
 
@@ -478,17 +490,22 @@ int NotePlayHandle::index() const
 
 ConstNotePlayHandleList NotePlayHandle::nphsOfInstrumentTrack( const InstrumentTrack * _it, bool _all_ph )
 {
+	// all notes of a track play through its audio port. Its list also
+	// holds the notes the audio engine doesn't process yet, skip these.
 	const PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
+	const AudioPort * port = _it->audioPort();
 	ConstNotePlayHandleList cnphv;
 
-	for (const auto& playHandle : playHandles)
+	port->lockPlayHandles();
+	for (const auto& playHandle : port->playHandles())
 	{
 		const auto nph = dynamic_cast<const NotePlayHandle*>(playHandle);
-		if( nph != nullptr && nph->m_instrumentTrack == _it && ( ( nph->isReleased() == false && nph->hasParent() == false ) || _all_ph == true ) )
+		if( nph != nullptr && playHandles.contains( playHandle ) && nph->m_instrumentTrack == _it && ( ( nph->isReleased() == false && nph->hasParent() == false ) || _all_ph == true ) )
 		{
 			cnphv.push_back( nph );
 		}
 	}
+	port->unlockPlayHandles();
 	return cnphv;
 }
 
@@ -561,7 +578,9 @@ void NotePlayHandle::processTimePos( const TimePos& time )
 {
 	if( detuning() && time >= songGlobalParentOffset()+pos() )
 	{
-		const float v = detuning()->automationClip()->valueAt( time - songGlobalParentOffset() - pos() );
+		// the detuning clip may be shared with other play handles of the
+		// note, so don't use a playback hint
+		const float v = detuning()->automationClip()->curve()->valueAt( time - songGlobalParentOffset() - pos() );
 		if( !typeInfo<float>::isEqual( v, m_baseDetuning->value() ) )
 		{
 			m_baseDetuning->setValue( v );
@@ -596,25 +615,156 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 }
 
 
-NotePlayHandle ** NotePlayHandleManager::s_available;
-QReadWriteLock NotePlayHandleManager::s_mutex;
-std::atomic_int NotePlayHandleManager::s_availableIndex;
-int NotePlayHandleManager::s_size;
+namespace
+{
 
+// released handles a thread keeps for itself before it gives half of them
+// back to the shared list
+constexpr int MagazineSize = 32;
 
-void NotePlayHandleManager::init()
+constexpr int MaxSlabs = 4096;
+
+// a cache line of its own for every handle, they are processed by
+// different workers
+struct alignas(64) NotePlayHandleSlot
+{
+	alignas(NotePlayHandle) unsigned char storage[sizeof(NotePlayHandle)];
+	std::uint32_t index;
+} ;
+
+struct NotePlayHandleSlab
+{
+	NotePlayHandleSlot slots[NPH_CACHE_INCREMENT];
+	// for free slots: index of the next free slot plus one, 0 ends the list
+	std::atomic<std::uint32_t> next[NPH_CACHE_INCREMENT];
+} ;
+
+std::atomic<NotePlayHandleSlab*> s_slabs[MaxSlabs];
+std::atomic_int s_reservedSlabs( 0 );
+std::atomic_int s_capacity( 0 );
+
+// index of the first free slot plus one in the lower half, a tag that
+// changes with every update in the upper half, so a thread that got
+// preempted in between can't install a stale head
+std::atomic<std::uint64_t> s_freeHead( 0 );
+std::atomic_int s_taken( 0 );
+std::atomic_int s_highWaterMark( 0 );
+
+constexpr std::uint64_t IndexMask = 0xffffffff;
+
+std::uint64_t nextTag( std::uint64_t head )
 {
-	s_available = MM_ALLOC<NotePlayHandle*>( INITIAL_NPH_CACHE );
+	return ( ( head >> 32 ) + 1 ) << 32;
+}
 
-	auto n = MM_ALLOC<NotePlayHandle>(INITIAL_NPH_CACHE);
+NotePlayHandleSlab * slabOf( std::uint32_t index )
+{
+	return s_slabs[index / NPH_CACHE_INCREMENT].load( std::memory_order_acquire );
+}
 
-	for( int i=0; i < INITIAL_NPH_CACHE; ++i )
+// pushes the slots first to last, which have to be chained already
+void pushFree( std::uint32_t first, std::uint32_t last, int count )
+{
+	std::uint64_t head = s_freeHead.load( std::memory_order_relaxed );
+	do
 	{
-		s_available[ i ] = n;
-		++n;
+		slabOf( last )->next[last % NPH_CACHE_INCREMENT].store(
+			static_cast<std::uint32_t>( head & IndexMask ), std::memory_order_relaxed );
+	}
+	while( !s_freeHead.compare_exchange_weak( head, nextTag( head ) | ( first + 1 ),
+				std::memory_order_release, std::memory_order_relaxed ) );
+	s_taken.fetch_sub( count, std::memory_order_relaxed );
+}
+
+NotePlayHandleSlot * popFree()
+{
+	std::uint64_t head = s_freeHead.load( std::memory_order_acquire );
+	while( true )
+	{
+		const auto first = static_cast<std::uint32_t>( head & IndexMask );
+		if( first == 0 )
+		{
+			return nullptr;
+		}
+		NotePlayHandleSlab * slab = slabOf( first - 1 );
+		const std::uint32_t next = slab->next[( first - 1 ) % NPH_CACHE_INCREMENT].load( std::memory_order_relaxed );
+		if( s_freeHead.compare_exchange_weak( head, nextTag( head ) | next,
+				std::memory_order_acquire, std::memory_order_acquire ) )
+		{
+			const int taken = s_taken.fetch_add( 1, std::memory_order_relaxed ) + 1;
+			int highWaterMark = s_highWaterMark.load( std::memory_order_relaxed );
+			while( taken > highWaterMark &&
+				!s_highWaterMark.compare_exchange_weak( highWaterMark, taken, std::memory_order_relaxed ) )
+			{
+			}
+			return &slab->slots[( first - 1 ) % NPH_CACHE_INCREMENT];
+		}
+	}
+}
+
+// adds a slab to the pool, returns false if there's no room for another one
+bool extend()
+{
+	const int slabIndex = s_reservedSlabs.fetch_add( 1, std::memory_order_relaxed );
+	if( slabIndex >= MaxSlabs )
+	{
+		return false;
+	}
+
+	auto slab = new NotePlayHandleSlab;
+	// touch all pages now instead of when constructing handles
+	memset( static_cast<void*>( slab->slots ), 0, sizeof( slab->slots ) );
+
+	const auto first = static_cast<std::uint32_t>( slabIndex * NPH_CACHE_INCREMENT );
+	for( int i = 0; i < NPH_CACHE_INCREMENT; ++i )
+	{
+		slab->slots[i].index = first + i;
+		slab->next[i].store( first + i + 2, std::memory_order_relaxed );
+	}
+	s_slabs[slabIndex].store( slab, std::memory_order_release );
+	s_capacity.fetch_add( NPH_CACHE_INCREMENT, std::memory_order_relaxed );
+
+	// the slots count as taken until they're pushed
+	s_taken.fetch_add( NPH_CACHE_INCREMENT, std::memory_order_relaxed );
+	pushFree( first, first + NPH_CACHE_INCREMENT - 1, NPH_CACHE_INCREMENT );
+	return true;
+}
+
+
+struct Magazine
+{
+	~Magazine()
+	{
+		flush( 0 );
+	}
+
+	//! Gives handles back to the shared list until @p keep are left
+	void flush( int keep )
+	{
+		while( count > keep )
+		{
+			const std::uint32_t index = slots[--count]->index;
+			pushFree( index, index, 1 );
+		}
+	}
+
+	std::array<NotePlayHandleSlot*, MagazineSize> slots;
+	int count = 0;
+} ;
+
+thread_local Magazine t_magazine;
+
+} // namespace
+
+
+
+
+void NotePlayHandleManager::init()
+{
+	for( int i = 0; i < INITIAL_NPH_CACHE; i += NPH_CACHE_INCREMENT )
+	{
+		extend();
 	}
-	s_availableIndex = INITIAL_NPH_CACHE - 1;
-	s_size = INITIAL_NPH_CACHE;
 }
 
 
@@ -626,12 +776,19 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 				int midiEventChannel,
 				NotePlayHandle::Origin origin )
 {
-	// TODO: use some lockless data structures
-	s_mutex.lockForWrite();
-	if (s_availableIndex < 0) { extend(NPH_CACHE_INCREMENT); }
-	NotePlayHandle * nph = s_available[s_availableIndex--];
-	s_mutex.unlock();
+	Magazine & magazine = t_magazine;
+	NotePlayHandleSlot * slot = magazine.count > 0 ? magazine.slots[--magazine.count] : popFree();
+	while( slot == nullptr )
+	{
+		// another thread may take the new handles first, just try again
+		if( !extend() )
+		{
+			qFatal( "NotePlayHandleManager: too many note play handles" );
+		}
+		slot = popFree();
+	}
 
+	auto nph = reinterpret_cast<NotePlayHandle*>( slot->storage );
 	new( (void*)nph ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
 	return nph;
 }
@@ -640,31 +797,40 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 void NotePlayHandleManager::release( NotePlayHandle * nph )
 {
 	nph->NotePlayHandle::~NotePlayHandle();
-	s_mutex.lockForRead();
-	s_available[++s_availableIndex] = nph;
-	s_mutex.unlock();
+
+	Magazine & magazine = t_magazine;
+	if( magazine.count == MagazineSize )
+	{
+		// leave some for the other threads
+		magazine.flush( MagazineSize / 2 );
+	}
+	// the storage is the first member of its slot
+	magazine.slots[magazine.count++] = reinterpret_cast<NotePlayHandleSlot*>( nph );
 }
 
 
-void NotePlayHandleManager::extend( int c )
+void NotePlayHandleManager::free()
 {
-	s_size += c;
-	auto tmp = MM_ALLOC<NotePlayHandle*>(s_size);
-	MM_FREE( s_available );
-	s_available = tmp;
-
-	auto n = MM_ALLOC<NotePlayHandle>(c);
+	// all other threads are gone by now, drop this thread's magazine so it
+	// doesn't touch the slabs when the thread exits
+	t_magazine.count = 0;
 
-	for( int i=0; i < c; ++i )
+	const int slabs = std::min( s_reservedSlabs.load(), MaxSlabs );
+	for( int i = 0; i < slabs; ++i )
 	{
-		s_available[++s_availableIndex] = n;
-		++n;
+		delete s_slabs[i].exchange( nullptr );
 	}
+	s_reservedSlabs = 0;
+	s_capacity = 0;
+	s_freeHead = 0;
+	s_taken = 0;
 }
 
-void NotePlayHandleManager::free()
+
+NotePlayHandleManager::Statistics NotePlayHandleManager::statistics()
 {
-	MM_FREE(s_available);
+	return { s_capacity.load( std::memory_order_relaxed ),
+		s_highWaterMark.load( std::memory_order_relaxed ) };
 }
 
 
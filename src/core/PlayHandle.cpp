@@ -24,22 +24,30 @@
  
 #include "PlayHandle.h"
 #include "AudioEngine.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Engine.h"
 
 #include <QThread>
 
+#include <atomic>
+
 
 namespace lmms
 {
 
+static std::atomic<std::uint64_t> s_nextId(1);
+
+
 PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 		m_type(type),
+		m_id(s_nextId.fetch_add(1, std::memory_order_relaxed)),
 		m_offset(offset),
 		m_affinity(QThread::currentThread()),
 		m_playHandleBuffer(BufferManager::acquire()),
 		m_bufferReleased(true),
-		m_usesBuffer(true)
+		m_usesBuffer(true),
+		m_audioPort(nullptr)
 {
 }
 
@@ -62,6 +70,11 @@ void PlayHandle::doProcessing()
 	{
 		play( nullptr );
 	}
+
+	if( m_audioPort )
+	{
+		m_audioPort->inputDone();
+	}
 }
 
 
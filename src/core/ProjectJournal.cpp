@@ -25,6 +25,7 @@
 #include <cstdlib>
 
 #include "ProjectJournal.h"
+#include "AudioEngine.h"
 #include "Engine.h"
 #include "JournallingObject.h"
 #include "Song.h"
@@ -113,6 +114,10 @@ void ProjectJournal::addJournalCheckPoint( JournallingObject *jo )
 {
 	if( isJournalling() )
 	{
+		// the user edits something - don't let rendered-ahead periods
+		// delay hearing the change
+		Engine::audioEngine()->markLiveActivity();
+
 		m_redoCheckPoints.clear();
 
 		DataFile dataFile( DataFile::JournalData );
@@ -25,7 +25,12 @@
 
 #include <QFile>
 
+#include <algorithm>
+#include <chrono>
+
 #include "ProjectRenderer.h"
+#include "AudioPort.h"
+#include "Mixer.h"
 #include "Song.h"
 #include "PerfLog.h"
 
@@ -38,6 +43,10 @@
 namespace lmms
 {
 
+// frames the encoders get at once when exporting, as a multiple of the
+// period size
+static const int OfflineBlockFrames = 4096;
+
 
 const ProjectRenderer::FileEncodeDevice ProjectRenderer::fileEncodeDevices[] =
 {
@@ -83,26 +92,68 @@ ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySe
 					ExportFileFormats exportFileFormat,
 					const QString & outputFilename ) :
 	QThread( Engine::audioEngine() ),
-	m_fileDev( nullptr ),
+	m_outputSettings( outputSettings ),
+	m_fileFormat( exportFileFormat ),
+	m_fileDev( createFileDevice( outputFilename ) ),
 	m_qualitySettings( qualitySettings ),
 	m_progress( 0 ),
-	m_abort( false )
+	m_abort( false ),
+	m_renderedSeconds( 0 ),
+	m_elapsedSeconds( 0 )
 {
-	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[exportFileFormat].m_getDevInst;
+}
+
+
+
 
-	if (audioEncoderFactory)
+bool ProjectRenderer::addStem( AudioPort * port, const QString & outputFilename )
+{
+	AudioFileDevice * dev = createFileDevice( outputFilename );
+	if( dev == nullptr )
 	{
-		bool successful = false;
+		return false;
+	}
+	m_stems.push_back( { std::unique_ptr<AudioFileDevice>( dev ), nullptr, port, nullptr, nullptr, 0 } );
+	return true;
+}
 
-		m_fileDev = audioEncoderFactory(
-					outputFilename, outputSettings, DEFAULT_CHANNELS,
-					Engine::audioEngine(), successful );
-		if( !successful )
-		{
-			delete m_fileDev;
-			m_fileDev = nullptr;
-		}
+
+
+
+bool ProjectRenderer::addStem( mix_ch_t channel, const QString & outputFilename )
+{
+	AudioFileDevice * dev = createFileDevice( outputFilename );
+	if( dev == nullptr )
+	{
+		return false;
 	}
+	m_stems.push_back( { std::unique_ptr<AudioFileDevice>( dev ), nullptr, nullptr,
+				Engine::mixer()->mixerChannel( channel ), nullptr, 0 } );
+	return true;
+}
+
+
+
+
+AudioFileDevice * ProjectRenderer::createFileDevice( const QString & outputFilename ) const
+{
+	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[m_fileFormat].m_getDevInst;
+	if( !audioEncoderFactory )
+	{
+		return nullptr;
+	}
+
+	bool successful = false;
+
+	AudioFileDevice * dev = audioEncoderFactory(
+				outputFilename, m_outputSettings, DEFAULT_CHANNELS,
+				Engine::audioEngine(), successful );
+	if( !successful )
+	{
+		delete dev;
+		dev = nullptr;
+	}
+	return dev;
 }
 
 
@@ -147,6 +198,18 @@ void ProjectRenderer::startProcessing()
 		// make slots connected to sampleRateChanged()-signals being called immediately.
 		Engine::audioEngine()->setAudioDevice( m_fileDev, m_qualitySettings, false, false );
 
+		// the channel buffers get cleared at the end of each period, so
+		// the mixer has to make a copy for us
+		const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+		for( Stem & stem : m_stems )
+		{
+			if( stem.channel )
+			{
+				stem.capture.reset( new sampleFrame[fpp] );
+				stem.channel->m_capture = stem.capture.get();
+			}
+		}
+
 		start(
 #ifndef LMMS_BUILD_WIN32
 			QThread::HighPriority
@@ -160,32 +223,72 @@ void ProjectRenderer::startProcessing()
 void ProjectRenderer::run()
 {
 	MemoryManager::ThreadGuard mmThreadGuard; Q_UNUSED(mmThreadGuard);
-#if 0
-#if defined(LMMS_BUILD_LINUX) || defined(LMMS_BUILD_FREEBSD)
-#ifdef LMMS_HAVE_SCHED_H
-	cpu_set_t mask;
-	CPU_ZERO( &mask );
-	CPU_SET( 0, &mask );
-	sched_setaffinity( 0, sizeof( mask ), &mask );
-#endif
-#endif
-#endif
+
+	// pin only - exporting keeps the thread busy for a long time, which
+	// realtime scheduling with a limited CPU time budget would not survive
+	Engine::audioEngine()->m_threadSettings.applyToCurrentThread( "export thread", false );
 
 	PerfLogTimer perfLog("Project Render");
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// the engine keeps its period size, so notes, automation and LFOs are
+	// as exact as when playing live, but the encoders get whole blocks
+	AudioEngine * audioEngine = Engine::audioEngine();
+	const fpp_t fpp = audioEngine->framesPerPeriod();
+	const auto blockFrames = static_cast<fpp_t>( qMax( 1, OfflineBlockFrames / fpp ) * fpp );
+	BlockWriter master( m_fileDev, blockFrames );
+	for( Stem & stem : m_stems )
+	{
+		stem.writer = std::make_unique<BlockWriter>( stem.device.get(), blockFrames );
+	}
 
 	Engine::getSong()->startExport();
 	// Skip first empty buffer.
-	Engine::audioEngine()->nextBuffer();
+	audioEngine->nextBuffer();
+
+	// Plugin latencies make every output lag behind the song: leave that
+	// much out at the start and render that much more at the end, so all
+	// files start with the first frame of the song. The master output lags
+	// by the latency of the master channel, a stem by the latency of its
+	// own port or channel.
+	f_cnt_t tailFrames = audioEngine->latency();
+	master.skip( tailFrames );
+	for( Stem & stem : m_stems )
+	{
+		stem.tailFrames = stem.channel ? stem.channel->m_latency : stem.port->latency();
+		stem.writer->skip( stem.tailFrames );
+	}
+
+	// the stems come from the period just rendered, the master output
+	// lags one period behind them
+	writeStems( false );
 
 	m_progress = 0;
 
 	// Now start processing
-	Engine::audioEngine()->startProcessing(false);
+	audioEngine->startProcessing(false);
 
 	// Continually track and emit progress percentage to listeners.
-	while (!Engine::getSong()->isExportDone() && !m_abort)
+	while (!m_abort)
 	{
-		m_fileDev->processNextBuffer();
+		const bool exportDone = Engine::getSong()->isExportDone();
+		bool writeMaster = true;
+		if (exportDone)
+		{
+			const bool stemsLeft = std::any_of( m_stems.begin(), m_stems.end(),
+				[]( const Stem & stem ) { return stem.tailFrames > 0; } );
+			writeMaster = tailFrames > 0;
+			if (!writeMaster && !stemsLeft) { break; }
+			tailFrames -= fpp;
+		}
+
+		// without a fifo writer this renders the period right here
+		const surroundSampleFrame * buffer = audioEngine->nextBuffer();
+		if (writeMaster)
+		{
+			master.write( buffer, fpp );
+		}
+		writeStems( exportDone );
 		const int nprog = Engine::getSong()->getExportProgress();
 		if (m_progress != nprog)
 		{
@@ -194,18 +297,106 @@ void ProjectRenderer::run()
 		}
 	}
 
+	master.flush();
+	for( Stem & stem : m_stems )
+	{
+		stem.writer->flush();
+	}
+
 	// Notify the audio engine of the end of processing.
-	Engine::audioEngine()->stopProcessing();
+	audioEngine->stopProcessing();
 
 	Engine::getSong()->stopExport();
 
 	perfLog.end();
 
+	m_renderedSeconds = static_cast<double>( master.framesWritten() ) / audioEngine->processingSampleRate();
+	m_elapsedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+
+	// close the stem files, the engine takes care of the master one
+	QStringList stemFiles;
+	for( Stem & stem : m_stems )
+	{
+		if( stem.channel )
+		{
+			stem.channel->m_capture = nullptr;
+		}
+		stemFiles << stem.device->outputFile();
+	}
+	m_stems.clear();
+
 	// If the user aborted export-process, the file has to be deleted.
 	const QString f = m_fileDev->outputFile();
 	if( m_abort )
 	{
 		QFile( f ).remove();
+		for( const QString & stemFile : stemFiles )
+		{
+			QFile( stemFile ).remove();
+		}
+	}
+}
+
+
+
+
+void ProjectRenderer::writeStems( bool exportDone )
+{
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	for( Stem & stem : m_stems )
+	{
+		if( exportDone )
+		{
+			if( stem.tailFrames <= 0 )
+			{
+				continue;
+			}
+			stem.tailFrames -= fpp;
+		}
+		stem.writer->write( stem.channel ? stem.capture.get() : stem.port->buffer(), fpp );
+	}
+}
+
+
+
+
+ProjectRenderer::BlockWriter::BlockWriter( AudioDevice * device, fpp_t blockFrames ) :
+	m_device( device ),
+	m_block( blockFrames ),
+	m_frames( 0 ),
+	m_skip( 0 ),
+	m_written( 0 )
+{
+}
+
+
+
+
+void ProjectRenderer::BlockWriter::write( const surroundSampleFrame * buffer, fpp_t frames )
+{
+	const auto skipped = static_cast<fpp_t>( qMin<f_cnt_t>( m_skip, frames ) );
+	m_skip -= skipped;
+	buffer += skipped;
+	frames -= skipped;
+
+	if( m_frames + frames > static_cast<f_cnt_t>( m_block.size() ) )
+	{
+		flush();
+	}
+	std::copy( buffer, buffer + frames, m_block.begin() + m_frames );
+	m_frames += frames;
+	m_written += frames;
+}
+
+
+
+
+void ProjectRenderer::BlockWriter::flush()
+{
+	if( m_frames > 0 )
+	{
+		m_device->processBuffer( m_block.data(), m_frames );
+		m_frames = 0;
 	}
 }
 
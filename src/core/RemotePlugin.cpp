@@ -35,9 +35,12 @@
 
 #include "BufferManager.h"
 #include "AudioEngine.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "Song.h"
 
+#include <algorithm>
+
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
@@ -48,10 +51,80 @@
 #include <sys/un.h>
 #endif
 
-#ifdef LMMS_BUILD_WIN32
-
 namespace {
 
+#ifndef SYNC_WITH_SHM_FIFO
+//! Starts listening at a new socket file, which is returned in @p socketFile
+int startServer( QString & socketFile )
+{
+	struct sockaddr_un sa;
+	sa.sun_family = AF_LOCAL;
+
+	socketFile = QDir::tempPath() + QDir::separator() +
+						QUuid::createUuid().toString();
+	auto path = socketFile.toUtf8();
+	size_t length = path.length();
+	if ( length >= sizeof sa.sun_path )
+	{
+		length = sizeof sa.sun_path - 1;
+		qWarning( "Socket path too long." );
+	}
+	memcpy(sa.sun_path, path.constData(), length );
+	sa.sun_path[length] = '\0';
+
+	const int server = socket( PF_LOCAL, SOCK_STREAM, 0 );
+	if ( server == -1 )
+	{
+		qWarning( "Unable to start the server." );
+	}
+	remove(path.constData());
+	int ret = bind( server, (struct sockaddr *) &sa, sizeof sa );
+	if ( ret == -1 || listen( server, 1 ) == -1 )
+	{
+		qWarning( "Unable to start the server." );
+	}
+	return server;
+}
+
+
+
+
+//! Waits for the remote process to connect to @p server, returns -1 if it
+//! doesn't
+int acceptConnection( int server )
+{
+	struct pollfd pollin;
+	pollin.fd = server;
+	pollin.events = POLLIN;
+
+	switch ( poll( &pollin, 1, 30000 ) )
+	{
+		case -1:
+			qWarning( "Unexpected poll error." );
+			break;
+
+		case 0:
+			qWarning( "Remote plugin did not connect." );
+			break;
+
+		default:
+		{
+			const int sock = accept( server, nullptr, nullptr );
+			if ( sock == -1 )
+			{
+				qWarning( "Unexpected socket error." );
+			}
+			return sock;
+		}
+	}
+	return -1;
+}
+#endif // not SYNC_WITH_SHM_FIFO
+
+
+
+
+#ifdef LMMS_BUILD_WIN32
 HANDLE getRemotePluginJob()
 {
 	static const auto job = []
@@ -67,19 +140,18 @@ HANDLE getRemotePluginJob()
 
 	return job;
 }
+#endif // LMMS_BUILD_WIN32
 
 } // namespace
 
-#endif // LMMS_BUILD_WIN32
-
 namespace lmms
 {
 
-// simple helper thread monitoring our RemotePlugin - if process terminates
-// unexpectedly invalidate plugin so LMMS doesn't lock up
-ProcessWatcher::ProcessWatcher( RemotePlugin * _p ) :
+// simple helper thread monitoring our RemotePluginProcess - if process
+// terminates unexpectedly invalidate its plugins so LMMS doesn't lock up
+ProcessWatcher::ProcessWatcher( RemotePluginProcess * _p ) :
 	QThread(),
-	m_plugin( _p ),
+	m_process( _p ),
 	m_quit( false )
 {
 }
@@ -87,8 +159,8 @@ ProcessWatcher::ProcessWatcher( RemotePlugin * _p ) :
 
 void ProcessWatcher::run()
 {
-	auto& process = m_plugin->m_process;
-	process.start(m_plugin->m_exec, m_plugin->m_args);
+	auto& process = m_process->m_process;
+	process.start(m_process->m_exec, m_process->m_args);
 
 #ifdef LMMS_BUILD_WIN32
 	// Add the process to our job so it is killed if we crash
@@ -114,68 +186,107 @@ void ProcessWatcher::run()
 #endif // LMMS_BUILD_WIN32
 
 	exec();
-	process.moveToThread(m_plugin->thread());
-	while (!m_quit && m_plugin->messagesLeft())
+	process.moveToThread(m_process->thread());
+	while (!m_quit && m_process->messagesLeft())
 	{
 		msleep(200);
 	}
 	if (!m_quit)
 	{
 		fprintf(stderr, "remote plugin died! invalidating now.\n");
-		m_plugin->invalidate();
+		m_process->invalidateInstances();
 	}
 }
 
 
 
 
-
-RemotePlugin::RemotePlugin() :
-	QObject(),
-#ifdef SYNC_WITH_SHM_FIFO
-	RemotePluginBase( new shmFifo(), new shmFifo() ),
-#else
+#ifndef SYNC_WITH_SHM_FIFO
+RemotePluginBatch::RemotePluginBatch() :
 	RemotePluginBase(),
-#endif
-	m_failed( true ),
-	m_watcher( this ),
-#if (QT_VERSION < QT_VERSION_CHECK(5,14,0))
-	m_commMutex(QMutex::Recursive),
-#endif
-	m_splitChannels( false ),
-	m_audioBufferSize( 0 ),
-	m_inputCount( DEFAULT_CHANNELS ),
-	m_outputCount( DEFAULT_CHANNELS )
+	m_batchesDone( 0 )
 {
-#ifndef SYNC_WITH_SHM_FIFO
-	struct sockaddr_un sa;
-	sa.sun_family = AF_LOCAL;
+	m_server = startServer( m_socketFile );
+}
 
-	m_socketFile = QDir::tempPath() + QDir::separator() +
-						QUuid::createUuid().toString();
-	auto path = m_socketFile.toUtf8();
-	size_t length = path.length();
-	if ( length >= sizeof sa.sun_path )
+
+
+
+RemotePluginBatch::~RemotePluginBatch()
+{
+	if( m_socket != -1 )
 	{
-		length = sizeof sa.sun_path - 1;
-		qWarning( "Socket path too long." );
+		// ends the thread of RemotePluginBatchClient
+		sendMessage( IdQuit );
+		close( m_socket );
 	}
-	memcpy(sa.sun_path, path.constData(), length );
-	sa.sun_path[length] = '\0';
+	if ( close( m_server ) == -1)
+	{
+		qWarning( "Error freeing resources." );
+	}
+	remove( m_socketFile.toUtf8().constData() );
+}
+
+
+
+
+bool RemotePluginBatch::accept()
+{
+	setSocket( acceptConnection( m_server ) );
+	return m_socket != -1;
+}
+
+
+
 
-	m_server = socket( PF_LOCAL, SOCK_STREAM, 0 );
-	if ( m_server == -1 )
+void RemotePluginBatch::waitFor( std::uint64_t batch )
+{
+	// only one thread receives, the others find their batch done then
+	QMutexLocker lock( &m_waitMutex );
+	while( m_batchesDone < batch && !isInvalid() )
 	{
-		qWarning( "Unable to start the server." );
+		fetchAndProcessNextMessage();
 	}
-	remove(path.constData());
-	int ret = bind( m_server, (struct sockaddr *) &sa, sizeof sa );
-	if ( ret == -1 || listen( m_server, 1 ) == -1 )
+}
+
+
+
+
+bool RemotePluginBatch::processMessage( const message & _m )
+{
+	switch( _m.id )
 	{
-		qWarning( "Unable to start the server." );
+		case IdUndefined:
+			return false;
+
+		case IdProcessingDone:
+			++m_batchesDone;
+			break;
+
+		default:
+			break;
 	}
-#endif
+	return true;
+}
+#endif // not SYNC_WITH_SHM_FIFO
+
+
+
+
+QMutex RemotePluginProcess::s_sharedMutex;
+std::vector<std::weak_ptr<RemotePluginProcess>> RemotePluginProcess::s_shared;
+
 
+RemotePluginProcess::RemotePluginProcess( const QString & exec, const QStringList & extraArgs ) :
+	QObject(),
+	m_watcher( this ),
+	m_exec( exec ),
+	m_extraArgs( extraArgs ),
+	m_framesPerPeriod( Engine::audioEngine()->framesPerPeriod() ),
+	m_joinedInstances( 0 ),
+	m_nextBatchNumber( 0 ),
+	m_batchesSent( 0 )
+{
 	connect( &m_process, SIGNAL(finished(int,QProcess::ExitStatus)),
 		this, SLOT(processFinished(int,QProcess::ExitStatus)),
 		Qt::DirectConnection );
@@ -189,26 +300,384 @@ RemotePlugin::RemotePlugin() :
 
 
 
-RemotePlugin::~RemotePlugin()
+RemotePluginProcess::~RemotePluginProcess()
 {
+#ifndef SYNC_WITH_SHM_FIFO
+	if( m_batch )
+	{
+		// the render thread may be flushing the batch right now
+		Engine::audioEngine()->requestChangeInModel();
+		disconnect( Engine::audioEngine(), nullptr, this, nullptr );
+		Engine::audioEngine()->doneChangeInModel();
+		// lets the process end
+		m_batch.reset();
+	}
+#endif
+
 	m_watcher.stop();
 	m_watcher.wait();
 
-	if( m_failed == false )
+	// the last plugin has sent IdQuit, so the process ends by itself
+	if( isRunning() )
+	{
+		m_process.waitForFinished( 1000 );
+		if( m_process.state() != QProcess::NotRunning )
+		{
+			m_process.terminate();
+			m_process.kill();
+		}
+	}
+}
+
+
+
+
+void RemotePluginProcess::makeShareable( const std::shared_ptr<RemotePluginProcess> & process )
+{
+	QMutexLocker lock( &s_sharedMutex );
+	// forget about processes which have ended meanwhile
+	s_shared.erase( std::remove_if( s_shared.begin(), s_shared.end(),
+		[]( const std::weak_ptr<RemotePluginProcess> & p ) { return p.expired(); } ),
+		s_shared.end() );
+	s_shared.push_back( process );
+}
+
+
+
+
+std::shared_ptr<RemotePluginProcess> RemotePluginProcess::share( RemotePlugin * plugin,
+	const QString & exec, const QStringList & extraArgs, int maxInstances )
+{
+	QMutexLocker lock( &s_sharedMutex );
+	for( const auto & shared : s_shared )
+	{
+		auto process = shared.lock();
+		if( !process || process->m_exec != exec || process->m_extraArgs != extraArgs ||
+			process->m_framesPerPeriod != Engine::audioEngine()->framesPerPeriod() ||
+			!process->isRunning() )
+		{
+			continue;
+		}
+		QMutexLocker instancesLock( &process->m_instancesMutex );
+		if( process->m_instances.size() < maxInstances )
+		{
+			process->m_instances.append( plugin );
+			return process;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+void RemotePluginProcess::start( RemotePlugin * plugin, const QStringList & channelArgs )
+{
+	m_instancesMutex.lock();
+	m_instances.append( plugin );
+	m_instancesMutex.unlock();
+
+	m_args = channelArgs + m_extraArgs;
+#ifndef DEBUG_REMOTE_PLUGIN
+	m_process.setProcessChannelMode( QProcess::ForwardedChannels );
+	m_process.setWorkingDirectory( QCoreApplication::applicationDirPath() );
+	// we start the process on the watcher thread to work around QTBUG-8819
+	m_process.moveToThread( &m_watcher );
+	m_watcher.start( QThread::LowestPriority );
+#else
+	qDebug() << m_exec << m_args;
+#endif
+}
+
+
+
+
+bool RemotePluginProcess::addInstance( RemotePlugin * plugin, const QStringList & channelArgs )
+{
+	RemotePluginBase::message m( IdAddInstance );
+	for( const auto & arg : channelArgs )
+	{
+		m.addString( arg.toStdString() );
+	}
+
+	QMutexLocker lock( &m_instancesMutex );
+	for( auto instance : m_instances )
 	{
-		if( isRunning() )
+		if( instance != plugin && !instance->failed() && !instance->isInvalid() )
+		{
+			instance->lock();
+			instance->sendMessage( m );
+			instance->unlock();
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+void RemotePluginProcess::detach( RemotePlugin * plugin )
+{
+	QMutexLocker lock( &m_instancesMutex );
+	m_instances.removeAll( plugin );
+}
+
+
+
+
+bool RemotePluginProcess::messagesLeft()
+{
+	QMutexLocker lock( &m_instancesMutex );
+	return std::any_of( m_instances.begin(), m_instances.end(),
+		[]( RemotePlugin * instance ) { return instance->messagesLeft(); } );
+}
+
+
+
+
+void RemotePluginProcess::invalidateInstances()
+{
+	QMutexLocker lock( &m_instancesMutex );
+	for( auto instance : m_instances )
+	{
+		instance->invalidate();
+	}
+#ifndef SYNC_WITH_SHM_FIFO
+	QMutexLocker batchLock( &m_batchMutex );
+	if( m_batch )
+	{
+		m_batch->invalidate();
+	}
+#endif
+}
+
+
+
+
+int RemotePluginProcess::joinBatch( RemotePlugin * plugin )
+{
+#ifdef SYNC_WITH_SHM_FIFO
+	return -1;
+#else
+	// the audio threads only wait for m_batchMutex while the periods are
+	// counted, not while the process answers
+	QMutexLocker joinLock( &m_joinMutex );
+	if( !m_batch )
+	{
+		auto batch = std::make_unique<RemotePluginBatch>();
+		plugin->sendMessage( RemotePluginBase::message( IdStartBatch ).
+						addString( batch->channel() ) );
+		if( !batch->accept() )
+		{
+			return -1;
+		}
+		m_batchMutex.lock();
+		m_batch = std::move( batch );
+		m_batchMutex.unlock();
+		// sends what's left at the end of each period of the engine
+		connect( Engine::audioEngine(), &AudioEngine::nextAudioBuffer,
+			this, &RemotePluginProcess::flushBatch, Qt::DirectConnection );
+	}
+
+	const int number = m_nextBatchNumber++;
+	plugin->sendMessage( RemotePluginBase::message( IdJoinBatch ).addInt( number ) );
+	if( plugin->waitForMessage( IdJoinBatch ).id != IdJoinBatch )
+	{
+		return -1;
+	}
+	QMutexLocker lock( &m_batchMutex );
+	++m_joinedInstances;
+	return number;
+#endif
+}
+
+
+
+
+void RemotePluginProcess::leaveBatch( RemotePlugin * plugin )
+{
+	QMutexLocker lock( &m_batchMutex );
+	m_pendingPeriods.erase( std::remove_if( m_pendingPeriods.begin(), m_pendingPeriods.end(),
+		[plugin]( const std::pair<int, int> & period )
+			{ return period.first == plugin->m_batchNumber; } ),
+		m_pendingPeriods.end() );
+	--m_joinedInstances;
+}
+
+
+
+
+std::uint64_t RemotePluginProcess::startPeriod( RemotePlugin * plugin, int offset )
+{
+	QMutexLocker lock( &m_batchMutex );
+	const int number = plugin->m_batchNumber;
+	if( std::any_of( m_pendingPeriods.begin(), m_pendingPeriods.end(),
+		[number]( const std::pair<int, int> & period ) { return period.first == number; } ) )
+	{
+		// the plugin got two periods before the others got one
+		sendPendingBatch();
+	}
+	m_pendingPeriods.emplace_back( number, offset );
+	const std::uint64_t batch = m_batchesSent + 1;
+	if( static_cast<int>( m_pendingPeriods.size() ) >= m_joinedInstances )
+	{
+		sendPendingBatch();
+	}
+	return batch;
+}
+
+
+
+
+void RemotePluginProcess::waitForBatch( std::uint64_t batch )
+{
+#ifndef SYNC_WITH_SHM_FIFO
+	m_batchMutex.lock();
+	if( batch > m_batchesSent )
+	{
+		sendPendingBatch();
+	}
+	m_batchMutex.unlock();
+	m_batch->waitFor( batch );
+#endif
+}
+
+
+
+
+void RemotePluginProcess::sendToBatch( RemotePlugin * plugin, const RemotePluginBase::message & m )
+{
+#ifndef SYNC_WITH_SHM_FIFO
+	RemotePluginBase::message batched( IdBatchedMessage );
+	batched.addInt( plugin->m_batchNumber ).addInt( m.id );
+	for( int i = 0; i < m.size(); ++i )
+	{
+		batched.addString( m.getString( i ) );
+	}
+
+	QMutexLocker lock( &m_batchMutex );
+	const int number = plugin->m_batchNumber;
+	if( std::any_of( m_pendingPeriods.begin(), m_pendingPeriods.end(),
+		[number]( const std::pair<int, int> & period ) { return period.first == number; } ) )
+	{
+		// the message belongs after the period already started
+		sendPendingBatch();
+	}
+	m_batch->sendMessage( batched );
+#endif
+}
+
+
+
+
+void RemotePluginProcess::sendPendingBatch()
+{
+#ifndef SYNC_WITH_SHM_FIFO
+	if( m_pendingPeriods.empty() )
+	{
+		return;
+	}
+	RemotePluginBase::message m( IdStartProcessing );
+	m.addInt( static_cast<int>( m_pendingPeriods.size() ) );
+	for( const auto & period : m_pendingPeriods )
+	{
+		m.addInt( period.first ).addInt( period.second );
+	}
+	m_batch->sendMessage( m );
+	++m_batchesSent;
+	m_pendingPeriods.clear();
+#endif
+}
+
+
+
+
+void RemotePluginProcess::flushBatch()
+{
+	QMutexLocker lock( &m_batchMutex );
+	sendPendingBatch();
+}
+
+
+
+
+void RemotePluginProcess::processFinished( int exitCode,
+					QProcess::ExitStatus exitStatus )
+{
+	if ( exitStatus == QProcess::CrashExit )
+	{
+		qCritical() << "Remote plugin crashed";
+	}
+	else if ( exitCode )
+	{
+		qCritical() << "Remote plugin exit code: " << exitCode;
+	}
+#ifndef SYNC_WITH_SHM_FIFO
+	invalidateInstances();
+#endif
+}
+
+void RemotePluginProcess::processErrored( QProcess::ProcessError err )
+{
+	qCritical() << "Process error: " << err;
+}
+
+
+
+
+RemotePlugin::RemotePlugin() :
+	QObject(),
+#ifdef SYNC_WITH_SHM_FIFO
+	RemotePluginBase( new shmFifo(), new shmFifo() ),
+#else
+	RemotePluginBase(),
+#endif
+	m_failed( true ),
+	m_instancesPerProcess( 1 ),
+#if (QT_VERSION < QT_VERSION_CHECK(5,14,0))
+	m_commMutex(QMutex::Recursive),
+#endif
+	m_splitChannels( false ),
+	m_audioBufferSize( 0 ),
+	m_pipelined( ConfigManager::inst()->value(
+			"audioengine", "pipelineremoteplugins", "0" ).toInt() ),
+	m_slotSize( 0 ),
+	m_currentSlot( 0 ),
+	m_periodsInFlight( 0 ),
+	m_pendingOutput( false ),
+	m_batchNumber( -1 ),
+	m_lastBatch( 0 ),
+	m_previousBatch( 0 ),
+	m_inputCount( DEFAULT_CHANNELS ),
+	m_outputCount( DEFAULT_CHANNELS )
+{
+#ifndef SYNC_WITH_SHM_FIFO
+	m_server = startServer( m_socketFile );
+#endif
+
+	// emitted while the engine is paused between two periods
+	connect( Engine::audioEngine(), &AudioEngine::framesPerPeriodChanged,
+		this, &RemotePlugin::updateBufferSize, Qt::DirectConnection );
+}
+
+
+
+
+RemotePlugin::~RemotePlugin()
+{
+	if( m_hostProcess )
+	{
+		leaveBatch();
+		m_hostProcess->detach( this );
+		if( m_failed == false && isRunning() )
 		{
 			lock();
 			sendMessage( IdQuit );
-
-			m_process.waitForFinished( 1000 );
-			if( m_process.state() != QProcess::NotRunning )
-			{
-				m_process.terminate();
-				m_process.kill();
-			}
 			unlock();
 		}
+		// ends the process if no other plugin uses it
+		m_hostProcess.reset();
 	}
 
 #ifndef SYNC_WITH_SHM_FIFO
@@ -234,6 +703,8 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 #endif
 		m_failed = false;
 	}
+	m_periodsInFlight = 0;
+	m_pendingOutput = false;
 	QString exec = QFileInfo(QDir("plugins:"), pluginExecutable).absoluteFilePath();
 #ifdef LMMS_BUILD_APPLE
 	// search current directory first
@@ -260,10 +731,14 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 		return failed();
 	}
 
-	// ensure the watcher is ready in case we're running again
-	// (e.g. 32-bit VST plugins on Windows)
-	m_watcher.wait();
-	m_watcher.reset();
+	// when running again (e.g. 32-bit VST plugins on Windows), the old
+	// process has ended or is left to its other plugins
+	if( m_hostProcess )
+	{
+		leaveBatch();
+		m_hostProcess->detach( this );
+		m_hostProcess.reset();
+	}
 
 	QStringList args;
 #ifdef SYNC_WITH_SHM_FIFO
@@ -273,41 +748,29 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 #else
 	args << m_socketFile;
 #endif
-	args << extraArgs;
-#ifndef DEBUG_REMOTE_PLUGIN
-	m_process.setProcessChannelMode( QProcess::ForwardedChannels );
-	m_process.setWorkingDirectory( QCoreApplication::applicationDirPath() );
-	m_exec = exec;
-	m_args = args;
-	// we start the process on the watcher thread to work around QTBUG-8819
-	m_process.moveToThread( &m_watcher );
-	m_watcher.start( QThread::LowestPriority );
-#else
-	qDebug() << exec << args;
-#endif
-
-#ifndef SYNC_WITH_SHM_FIFO
-	struct pollfd pollin;
-	pollin.fd = m_server;
-	pollin.events = POLLIN;
 
-	switch ( poll( &pollin, 1, 30000 ) )
+	if( m_instancesPerProcess > 1 )
 	{
-		case -1:
-			qWarning( "Unexpected poll error." );
-			break;
-
-		case 0:
-			qWarning( "Remote plugin did not connect." );
-			break;
-
-		default:
-			m_socket = accept( m_server, nullptr, nullptr );
-			if ( m_socket == -1 )
-			{
-				qWarning( "Unexpected socket error." );
-			}
+		m_hostProcess = RemotePluginProcess::share( this, exec, extraArgs,
+							m_instancesPerProcess );
+		if( m_hostProcess && !m_hostProcess->addInstance( this, args ) )
+		{
+			m_hostProcess->detach( this );
+			m_hostProcess.reset();
+		}
 	}
+	if( !m_hostProcess )
+	{
+		m_hostProcess = std::make_shared<RemotePluginProcess>( exec, extraArgs );
+		m_hostProcess->start( this, args );
+		if( m_instancesPerProcess > 1 )
+		{
+			RemotePluginProcess::makeShareable( m_hostProcess );
+		}
+	}
+
+#ifndef SYNC_WITH_SHM_FIFO
+	setSocket( acceptConnection( m_server ) );
 #endif
 
 	sendMessage(message(IdSyncKey).addString(Engine::getSong()->syncKey()));
@@ -338,6 +801,15 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 		return false;
 	}
 
+	const bool batched = m_batchNumber >= 0;
+	if( batched )
+	{
+		// otherwise processed while waiting for IdProcessingDone
+		lock();
+		fetchAndProcessAllMessages();
+		unlock();
+	}
+
 	if (!m_audioBuffer)
 	{
 		// m_audioBuffer being zero means we didn't initialize everything so
@@ -357,7 +829,8 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 		return false;
 	}
 
-	memset( m_audioBuffer.get(), 0, m_audioBufferSize );
+	float * slot = m_audioBuffer.get() + m_currentSlot * m_slotSize;
+	memset( slot, 0, m_slotSize * sizeof( float ) );
 
 	ch_cnt_t inputs = qMin<ch_cnt_t>( m_inputCount, DEFAULT_CHANNELS );
 
@@ -369,18 +842,17 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 			{
 				for( fpp_t frame = 0; frame < frames; ++frame )
 				{
-					m_audioBuffer[ch * frames + frame] =
-							_in_buf[frame][ch];
+					slot[ch * frames + frame] = _in_buf[frame][ch];
 				}
 			}
 		}
 		else if( inputs == DEFAULT_CHANNELS )
 		{
-			memcpy( m_audioBuffer.get(), _in_buf, frames * BYTES_PER_FRAME );
+			memcpy( slot, _in_buf, frames * BYTES_PER_FRAME );
 		}
 		else
 		{
-			auto o = (sampleFrame*)m_audioBuffer.get();
+			auto o = (sampleFrame*)slot;
 			for( ch_cnt_t ch = 0; ch < inputs; ++ch )
 			{
 				for( fpp_t frame = 0; frame < frames; ++frame )
@@ -392,7 +864,23 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 	}
 
 	lock();
-	sendMessage( IdStartProcessing );
+	const int offset = static_cast<int>( m_currentSlot * m_slotSize );
+	if( batched )
+	{
+		m_previousBatch = m_lastBatch;
+		m_lastBatch = m_hostProcess->startPeriod( this, offset );
+	}
+	else
+	{
+		sendMessage( message( IdStartProcessing ).addInt( offset ) );
+		++m_periodsInFlight;
+	}
+	if( m_pipelined )
+	{
+		// the next input goes to the other slot, which holds the output
+		// of the previous period once that is done
+		m_currentSlot = 1 - m_currentSlot;
+	}
 
 	if( m_failed || _out_buf == nullptr || m_outputCount == 0 )
 	{
@@ -400,7 +888,30 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 		return false;
 	}
 
-	waitForMessage( IdProcessingDone );
+	// in pipelined mode, the period we just started may keep running
+	// until the next call, only the one before must be done
+	const int periodsToKeep = m_pipelined ? 1 : 0;
+	while( m_periodsInFlight > periodsToKeep && !m_failed && !isInvalid() )
+	{
+		waitForMessage( IdProcessingDone );
+	}
+	if( batched )
+	{
+		m_hostProcess->waitForBatch( m_previousBatch );
+	}
+
+	if( m_pipelined && !m_pendingOutput )
+	{
+		// first period, there's nothing to return yet
+		m_pendingOutput = true;
+		unlock();
+		BufferManager::clear( _out_buf, frames );
+		return true;
+	}
+
+	// the buffer may have been recreated while waiting
+	const float * output = m_audioBuffer.get() +
+				m_currentSlot * m_slotSize + m_inputCount * frames;
 	unlock();
 
 	const ch_cnt_t outputs = qMin<ch_cnt_t>( m_outputCount,
@@ -411,19 +922,17 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 		{
 			for( fpp_t frame = 0; frame < frames; ++frame )
 			{
-				_out_buf[frame][ch] = m_audioBuffer[( m_inputCount+ch )*
-								frames + frame];
+				_out_buf[frame][ch] = output[ch * frames + frame];
 			}
 		}
 	}
 	else if( outputs == DEFAULT_CHANNELS )
 	{
-		memcpy( _out_buf, m_audioBuffer.get() + m_inputCount * frames,
-						frames * BYTES_PER_FRAME );
+		memcpy( _out_buf, output, frames * BYTES_PER_FRAME );
 	}
 	else
 	{
-		auto o = (sampleFrame*)(m_audioBuffer.get() + m_inputCount * frames);
+		auto o = (const sampleFrame*)output;
 		// clear buffer, if plugin didn't fill up both channels
 		BufferManager::clear( _out_buf, frames );
 
@@ -443,6 +952,114 @@ bool RemotePlugin::process( const sampleFrame * _in_buf, sampleFrame * _out_buf
 
 
 
+void RemotePlugin::updateBufferSize()
+{
+	if( m_failed || !isRunning() )
+	{
+		return;
+	}
+
+	lock();
+	// the output of a running period has the old layout
+	finishPendingPeriods();
+	sendMessage( message( IdBufferSizeInformation ).
+			addInt( Engine::audioEngine()->framesPerPeriod() ) );
+	waitForMessage( IdInformationUpdated, true );
+	unlock();
+
+	if( m_pipelined )
+	{
+		emit latencyChanged();
+	}
+}
+
+
+
+
+void RemotePlugin::allowSharedProcess()
+{
+	m_instancesPerProcess = std::max( 1, ConfigManager::inst()->value(
+			"audioengine", "remoteinstancesperprocess", "1" ).toInt() );
+}
+
+
+
+
+f_cnt_t RemotePlugin::latency() const
+{
+	return m_pipelined ? Engine::audioEngine()->framesPerPeriod() : 0;
+}
+
+
+
+
+void RemotePlugin::finishPendingPeriods()
+{
+	lock();
+	while( m_periodsInFlight > 0 && !m_failed && !isInvalid() )
+	{
+		waitForMessage( IdProcessingDone );
+	}
+	if( m_batchNumber >= 0 )
+	{
+		m_hostProcess->waitForBatch( m_lastBatch );
+		m_lastBatch = m_previousBatch = 0;
+	}
+	m_pendingOutput = false;
+	unlock();
+}
+
+
+
+
+void RemotePlugin::joinBatch()
+{
+	if( m_failed || !m_pipelined || m_instancesPerProcess < 2 ||
+		!m_hostProcess || m_batchNumber >= 0 )
+	{
+		return;
+	}
+	lock();
+	m_batchNumber = m_hostProcess->joinBatch( this );
+	unlock();
+}
+
+
+
+
+void RemotePlugin::leaveBatch()
+{
+	if( m_batchNumber < 0 )
+	{
+		return;
+	}
+	finishPendingPeriods();
+	lock();
+	m_hostProcess->leaveBatch( this );
+	m_batchNumber = -1;
+	unlock();
+}
+
+
+
+
+void RemotePlugin::sendEvent( const message & m )
+{
+	lock();
+	if( m_batchNumber >= 0 )
+	{
+		m_hostProcess->sendToBatch( this, m );
+	}
+	else
+	{
+		sendMessage( m );
+	}
+	unlock();
+}
+
+
+
+
 void RemotePlugin::processMidiEvent( const MidiEvent & _e,
 							const f_cnt_t _offset )
 {
@@ -452,9 +1069,7 @@ void RemotePlugin::processMidiEvent( const MidiEvent & _e,
 	m.addInt( _e.param( 0 ) );
 	m.addInt( _e.param( 1 ) );
 	m.addInt( _offset );
-	lock();
-	sendMessage( m );
-	unlock();
+	sendEvent( m );
 }
 
 void RemotePlugin::showUI()
@@ -476,7 +1091,10 @@ void RemotePlugin::hideUI()
 
 void RemotePlugin::resizeSharedProcessingMemory()
 {
-	const size_t s = (m_inputCount + m_outputCount) * Engine::audioEngine()->framesPerPeriod();
+	// large enough for every period size, so it needn't be recreated
+	// when the period size changes, and twice that for double buffering
+	m_slotSize = (m_inputCount + m_outputCount) * Engine::audioEngine()->maxFramesPerPeriod();
+	const size_t s = m_slotSize * ( m_pipelined ? 2 : 1 );
 	try
 	{
 		m_audioBuffer.create(QUuid::createUuid().toString().toStdString(), s);
@@ -488,36 +1106,15 @@ void RemotePlugin::resizeSharedProcessingMemory()
 		return;
 	}
 	m_audioBufferSize = s * sizeof(float);
+	// a period still running writes to the old buffer, start over
+	m_currentSlot = 0;
+	m_pendingOutput = false;
 	sendMessage(message(IdChangeSharedMemoryKey).addString(m_audioBuffer.key()));
 }
 
 
 
 
-void RemotePlugin::processFinished( int exitCode,
-					QProcess::ExitStatus exitStatus )
-{
-	if ( exitStatus == QProcess::CrashExit )
-	{
-		qCritical() << "Remote plugin crashed";
-	}
-	else if ( exitCode )
-	{
-		qCritical() << "Remote plugin exit code: " << exitCode;
-	}
-#ifndef SYNC_WITH_SHM_FIFO
-	invalidate();
-#endif
-}
-
-void RemotePlugin::processErrored( QProcess::ProcessError err )
-{
-	qCritical() << "Process error: " << err;
-}
-
-
-
-
 bool RemotePlugin::processMessage( const message & _m )
 {
 	lock();
@@ -565,6 +1162,10 @@ bool RemotePlugin::processMessage( const message & _m )
 			break;
 
 		case IdProcessingDone:
+			// counted here, as any waitForMessage() may receive it
+			--m_periodsInFlight;
+			break;
+
 		case IdQuit:
 		default:
 			break;
@@ -26,7 +26,10 @@
 
 #include "RenderManager.h"
 
+#include "InstrumentTrack.h"
+#include "Mixer.h"
 #include "PatternStore.h"
+#include "SampleTrack.h"
 #include "Song.h"
 
 
@@ -43,7 +46,9 @@ RenderManager::RenderManager(
 	m_oldQualitySettings( Engine::audioEngine()->currentQualitySettings() ),
 	m_outputSettings(outputSettings),
 	m_format(fmt),
-	m_outputPath(outputPath)
+	m_outputPath(outputPath),
+	m_renderedSeconds(0),
+	m_elapsedSeconds(0)
 {
 	Engine::audioEngine()->storeAudioDevice();
 }
@@ -64,9 +69,19 @@ void RenderManager::abortProcessing()
 	restoreMutedState();
 }
 
+double RenderManager::realtimeFactor() const
+{
+	return m_elapsedSeconds > 0 ? m_renderedSeconds / m_elapsedSeconds : 0;
+}
+
 // Called to render each new track when rendering tracks individually.
 void RenderManager::renderNextTrack()
 {
+	if ( m_activeRenderer )
+	{
+		m_renderedSeconds += m_activeRenderer->renderedSeconds();
+		m_elapsedSeconds += m_activeRenderer->elapsedSeconds();
+	}
 	m_activeRenderer.reset();
 
 	if( m_tracksToRender.isEmpty() )
@@ -97,39 +112,54 @@ void RenderManager::renderNextTrack()
 // Render the song into individual tracks
 void RenderManager::renderTracks()
 {
-	const TrackContainer::TrackList & tl = Engine::getSong()->tracks();
-
 	// find all currently unnmuted tracks -- we want to render these.
-	for (const auto& tk : tl)
+	m_unmuted = unmutedTracks();
+
+	// copy the list of unmuted tracks into our rendering queue.
+	// we need to remember which tracks were unmuted to restore state at the end.
+	m_tracksToRender = m_unmuted;
+
+	renderNextTrack();
+}
+
+// Render the song into individual tracks at once, nothing gets muted
+void RenderManager::renderStems( bool mixerChannels )
+{
+	m_activeRenderer = std::make_unique<ProjectRenderer>(
+			m_qualitySettings,
+			m_outputSettings,
+			m_format,
+			pathForStem( "0", "Master" ));
+
+	const QVector<Track*> tracks = unmutedTracks();
+	for (int i = 0; i < tracks.size(); ++i)
 	{
-		Track::TrackTypes type = tk->type();
+		Track* track = tracks[i];
+		AudioPort* port = track->type() == Track::InstrumentTrack
+			? static_cast<InstrumentTrack*>(track)->audioPort()
+			: static_cast<SampleTrack*>(track)->audioPort();
 
-		// Don't render automation tracks
-		if ( tk->isMuted() == false &&
-				( type == Track::InstrumentTrack || type == Track::SampleTrack ) )
+		if (!m_activeRenderer->addStem( port, pathForTrack(track, i + 1) ))
 		{
-			m_unmuted.push_back(tk);
+			qDebug( "Renderer failed to acquire a file device for track %d!", i + 1 );
 		}
 	}
 
-	const TrackContainer::TrackList t2 = Engine::patternStore()->tracks();
-	for (const auto& tk : t2)
+	if (mixerChannels)
 	{
-		Track::TrackTypes type = tk->type();
-
-		// Don't render automation tracks
-		if ( tk->isMuted() == false &&
-				( type == Track::InstrumentTrack || type == Track::SampleTrack ) )
+		Mixer* mixer = Engine::mixer();
+		for (int ch = 1; ch < mixer->numChannels(); ++ch)
 		{
-			m_unmuted.push_back(tk);
+			MixerChannel* channel = mixer->mixerChannel(ch);
+			if (!channel->m_muteModel.value() &&
+				!m_activeRenderer->addStem( ch, pathForStem( QString( "Mixer%1" ).arg( ch ), channel->m_name ) ))
+			{
+				qDebug( "Renderer failed to acquire a file device for mixer channel %d!", ch );
+			}
 		}
 	}
 
-	// copy the list of unmuted tracks into our rendering queue.
-	// we need to remember which tracks were unmuted to restore state at the end.
-	m_tracksToRender = m_unmuted;
-
-	renderNextTrack();
+	startRenderer();
 }
 
 // Render the song into a single track
@@ -146,6 +176,11 @@ void RenderManager::render(QString outputPath)
 			m_format,
 			outputPath);
 
+	startRenderer();
+}
+
+void RenderManager::startRenderer()
+{
 	if( m_activeRenderer->isReady() )
 	{
 		// pass progress signals through
@@ -179,14 +214,38 @@ void RenderManager::restoreMutedState()
 
 // Determine the output path for a track when rendering tracks individually
 QString RenderManager::pathForTrack(const Track *track, int num)
+{
+	return pathForStem( QString::number( num ), track->name() );
+}
+
+QString RenderManager::pathForStem(const QString & prefix, QString name)
 {
 	QString extension = ProjectRenderer::getFileExtensionFromFormat( m_format );
-	QString name = track->name();
 	name = name.remove(QRegExp(FILENAME_FILTER));
-	name = QString( "%1_%2%3" ).arg( num ).arg( name ).arg( extension );
+	name = QString( "%1_%2%3" ).arg( prefix ).arg( name ).arg( extension );
 	return QDir(m_outputPath).filePath(name);
 }
 
+// Find all unmuted tracks that produce audio -- automation tracks don't
+QVector<Track*> RenderManager::unmutedTracks() const
+{
+	QVector<Track*> tracks;
+	for (const TrackContainer* tc : { static_cast<TrackContainer*>(Engine::getSong()),
+				static_cast<TrackContainer*>(Engine::patternStore()) })
+	{
+		for (const auto& tk : tc->tracks())
+		{
+			Track::TrackTypes type = tk->type();
+			if ( tk->isMuted() == false &&
+					( type == Track::InstrumentTrack || type == Track::SampleTrack ) )
+			{
+				tracks.push_back(tk);
+			}
+		}
+	}
+	return tracks;
+}
+
 void RenderManager::updateConsoleProgress()
 {
 	if ( m_activeRenderer )
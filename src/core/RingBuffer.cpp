@@ -33,7 +33,7 @@ namespace lmms
 
  
 RingBuffer::RingBuffer( f_cnt_t size ) : 
-	m_fpp( Engine::audioEngine()->framesPerPeriod() ),
+	m_fpp( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_samplerate( Engine::audioEngine()->processingSampleRate() ),
 	m_size( size + m_fpp )
 {
@@ -44,7 +44,7 @@ RingBuffer::RingBuffer( f_cnt_t size ) :
 
 
 RingBuffer::RingBuffer( float size ) : 
-	m_fpp( Engine::audioEngine()->framesPerPeriod() ),
+	m_fpp( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_samplerate( Engine::audioEngine()->processingSampleRate() )
 {
 	m_size = msToFrames( size ) + m_fpp;
@@ -102,7 +102,8 @@ void RingBuffer::setSamplerateAware( bool b )
 
 void RingBuffer::advance()
 {
-	m_position = ( m_position + m_fpp ) % m_size;
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	m_position = ( m_position + fpp ) % m_size;
 }
 
 
@@ -120,15 +121,16 @@ void RingBuffer::movePosition( float amount )
 
 void RingBuffer::pop( sampleFrame * dst )
 {
-	if( m_position + m_fpp <= m_size ) // we won't go over the edge so we can just memcpy here
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	if( m_position + fpp <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [ m_position ], m_fpp * sizeof( sampleFrame ) );
-		memset( & m_buffer[m_position], 0, m_fpp * sizeof( sampleFrame ) );
+		memcpy( dst, & m_buffer [ m_position ], fpp * sizeof( sampleFrame ) );
+		memset( & m_buffer[m_position], 0, fpp * sizeof( sampleFrame ) );
 	}
 	else
 	{
 		f_cnt_t first = m_size - m_position;
-		f_cnt_t second = m_fpp - first;
+		f_cnt_t second = fpp - first;
 		
 		memcpy( dst, & m_buffer [ m_position ], first * sizeof( sampleFrame ) );
 		memset( & m_buffer [m_position], 0, first * sizeof( sampleFrame ) );
@@ -137,23 +139,24 @@ void RingBuffer::pop( sampleFrame * dst )
 		memset( m_buffer, 0, second * sizeof( sampleFrame ) );
 	}
 	
-	m_position = ( m_position + m_fpp ) % m_size;
+	m_position = ( m_position + fpp ) % m_size;
 }
 
 
 void RingBuffer::read( sampleFrame * dst, f_cnt_t offset )
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 	f_cnt_t pos = ( m_position + offset ) % m_size;
 	if( pos < 0 ) { pos += m_size; }
 	
-	if( pos + m_fpp <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + fpp <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [pos], m_fpp * sizeof( sampleFrame ) );
+		memcpy( dst, & m_buffer [pos], fpp * sizeof( sampleFrame ) );
 	}
 	else
 	{
 		f_cnt_t first = m_size - pos;
-		f_cnt_t second = m_fpp - first;
+		f_cnt_t second = fpp - first;
 		
 		memcpy( dst, & m_buffer [pos], first * sizeof( sampleFrame ) );
 		
@@ -197,8 +200,9 @@ void RingBuffer::read( sampleFrame * dst, float offset, f_cnt_t length )
 
 void RingBuffer::write( sampleFrame * src, f_cnt_t offset, f_cnt_t length )
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = fpp; }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
@@ -224,8 +228,9 @@ void RingBuffer::write( sampleFrame * src, float offset, f_cnt_t length )
 
 void RingBuffer::writeAdding( sampleFrame * src, f_cnt_t offset, f_cnt_t length )
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = fpp; }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
@@ -251,9 +256,10 @@ void RingBuffer::writeAdding( sampleFrame * src, float offset, f_cnt_t length )
 
 void RingBuffer::writeAddingMultiplied( sampleFrame * src, f_cnt_t offset, f_cnt_t length, float level )
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
 	//qDebug( "pos %d m_pos %d ofs %d siz %d", pos, m_position, offset, m_size );
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = fpp; }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
@@ -280,8 +286,9 @@ void RingBuffer::writeAddingMultiplied( sampleFrame * src, float offset, f_cnt_t
 
 void RingBuffer::writeSwappedAddingMultiplied( sampleFrame * src, f_cnt_t offset, f_cnt_t length, float level )
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = fpp; }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
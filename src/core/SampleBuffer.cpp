@@ -26,6 +26,7 @@
 #include "Oscillator.h"
 
 #include <algorithm>
+#include <utility>
 
 #include <QFile>
 #include <QFileInfo>
@@ -64,6 +65,11 @@
 namespace lmms
 {
 
+// File size and sample length limits
+static const int s_fileSizeMax = 300; // MB
+static const int s_sampleLengthMax = 90; // Minutes
+
+
 SampleBuffer::SampleBuffer() :
 	m_userAntiAliasWaveTable(nullptr),
 	m_audioFile(""),
@@ -166,6 +172,32 @@ SampleBuffer::SampleBuffer(const SampleBuffer& orig)
 
 
 
+SampleBuffer::SampleBuffer(SampleBuffer& orig, TakeOriginal) :
+	m_userAntiAliasWaveTable(nullptr),
+	m_data(nullptr)
+{
+	// only m_data is played, so the rest can be taken away meanwhile
+	orig.m_varLock.lockForWrite();
+
+	m_audioFile = orig.m_audioFile;
+	m_origData = std::exchange(orig.m_origData, nullptr);
+	m_origFrames = std::exchange(orig.m_origFrames, 0);
+	m_frames = orig.m_frames;
+	m_startFrame = orig.m_startFrame;
+	m_endFrame = orig.m_endFrame;
+	m_loopStartFrame = orig.m_loopStartFrame;
+	m_loopEndFrame = orig.m_loopEndFrame;
+	m_amplification = orig.m_amplification;
+	m_reversed = orig.m_reversed;
+	m_frequency = orig.m_frequency;
+	m_sampleRate = orig.m_sampleRate;
+
+	orig.m_varLock.unlock();
+}
+
+
+
+
 void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 {
 	using std::swap;
@@ -235,17 +267,61 @@ sample_rate_t SampleBuffer::audioEngineSampleRate()
 
 void SampleBuffer::update(bool keepSettings)
 {
-	const bool lock = (m_data != nullptr);
-	if (lock)
+	bool fileLoadError = false;
+	if (m_data == nullptr)
 	{
+		// nobody can be playing us yet
+		fileLoadError = !loadData(keepSettings);
+	}
+	else
+	{
+		// Decode into another buffer, so the audio engine only has to
+		// pause for exchanging the data instead of for the whole decoding.
+		// It takes the old data along when it goes out of scope.
+		SampleBuffer decoded(*this, TakeOriginal{});
+		fileLoadError = !decoded.loadData(keepSettings);
 		Engine::audioEngine()->requestChangeInModel();
-		m_varLock.lockForWrite();
-		MM_FREE(m_data);
+		swap(*this, decoded);
+		Engine::audioEngine()->doneChangeInModel();
 	}
 
-	// File size and sample length limits
-	const int fileSizeMax = 300; // MB
-	const int sampleLengthMax = 90; // Minutes
+	emit sampleUpdated();
+
+	// allocate space for anti-aliased wave table
+	if (m_userAntiAliasWaveTable == nullptr)
+	{
+		m_userAntiAliasWaveTable = std::make_unique<OscillatorConstants::waveform_t>();
+	}
+	Oscillator::generateAntiAliasUserWaveTable(this);
+
+	if (fileLoadError)
+	{
+		QString title = tr("Fail to open file");
+		QString message = tr("Audio files are limited to %1 MB "
+				"in size and %2 minutes of playing time"
+				).arg(s_fileSizeMax).arg(s_sampleLengthMax);
+		if (gui::getGUI() != nullptr)
+		{
+			QMessageBox::information(nullptr,
+				title, message,	QMessageBox::Ok);
+		}
+		else
+		{
+			fprintf(stderr, "%s\n", message.toUtf8().constData());
+		}
+	}
+}
+
+
+
+
+bool SampleBuffer::loadData(bool keepSettings)
+{
+	if (m_data != nullptr)
+	{
+		MM_FREE(m_data);
+		m_data = nullptr;
+	}
 
 	bool fileLoadError = false;
 	if (m_audioFile.isEmpty() && m_origData != nullptr && m_origFrames > 0)
@@ -271,7 +347,7 @@ void SampleBuffer::update(bool keepSettings)
 		m_frames = 0;
 
 		const QFileInfo fileInfo(file);
-		if (fileInfo.size() > fileSizeMax * 1024 * 1024)
+		if (fileInfo.size() > s_fileSizeMax * 1024 * 1024)
 		{
 			fileLoadError = true;
 		}
@@ -286,7 +362,7 @@ void SampleBuffer::update(bool keepSettings)
 			{
 				f_cnt_t frames = sfInfo.frames;
 				int rate = sfInfo.samplerate;
-				if (frames / rate > sampleLengthMax * 60)
+				if (frames / rate > s_sampleLengthMax * 60)
 				{
 					fileLoadError = true;
 				}
@@ -348,37 +424,7 @@ void SampleBuffer::update(bool keepSettings)
 		m_loopEndFrame = m_endFrame = 1;
 	}
 
-	if (lock)
-	{
-		m_varLock.unlock();
-		Engine::audioEngine()->doneChangeInModel();
-	}
-
-	emit sampleUpdated();
-
-	// allocate space for anti-aliased wave table
-	if (m_userAntiAliasWaveTable == nullptr)
-	{
-		m_userAntiAliasWaveTable = std::make_unique<OscillatorConstants::waveform_t>();
-	}
-	Oscillator::generateAntiAliasUserWaveTable(this);
-
-	if (fileLoadError)
-	{
-		QString title = tr("Fail to open file");
-		QString message = tr("Audio files are limited to %1 MB "
-				"in size and %2 minutes of playing time"
-				).arg(fileSizeMax).arg(sampleLengthMax);
-		if (gui::getGUI() != nullptr)
-		{
-			QMessageBox::information(nullptr,
-				title, message,	QMessageBox::Ok);
-		}
-		else
-		{
-			fprintf(stderr, "%s\n", message.toUtf8().constData());
-		}
-	}
+	return !fileLoadError;
 }
 
 
@@ -1553,12 +1599,16 @@ void SampleBuffer::setAmplification(float a)
 
 void SampleBuffer::setReversed(bool on)
 {
-	Engine::audioEngine()->requestChangeInModel();
-	m_varLock.lockForWrite();
-	if (m_reversed != on) { std::reverse(m_data, m_data + m_frames); }
-	m_reversed = on;
-	m_varLock.unlock();
-	Engine::audioEngine()->doneChangeInModel();
+	if (m_reversed != on)
+	{
+		// reverse a copy and only pause the audio engine for the exchange
+		SampleBuffer reversed(*this);
+		std::reverse(reversed.m_data, reversed.m_data + reversed.m_frames);
+		reversed.m_reversed = on;
+		Engine::audioEngine()->requestChangeInModel();
+		swap(*this, reversed);
+		Engine::audioEngine()->doneChangeInModel();
+	}
 	emit sampleUpdated();
 }
 
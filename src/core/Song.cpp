@@ -264,11 +264,13 @@ void Song::processNextBuffer()
 	// Ensure playback begins within the loop if it is enabled
 	if (loopEnabled) { enforceLoop(timeline->loopBegin(), timeline->loopEnd()); }
 
-	// Inform VST plugins if the user moved the play head
+	// Inform VST plugins if the user moved the play head, and drop
+	// whatever has been rendered ahead from the old position
 	if (getPlayPos().jumped())
 	{
 		m_vstSyncController.setPlaybackJumped(true);
 		getPlayPos().setJumped(false);
+		Engine::audioEngine()->invalidateRenderAhead();
 	}
 
 	const auto framesPerTick = Engine::framesPerTick();
@@ -358,9 +360,10 @@ void Song::processNextBuffer()
 
 void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp_t)
 {
-	AutomatedValueMap values;
-
-	QSet<const AutomatableModel*> recordedModels;
+	// rebuilt in members every tick, which keeps their capacity
+	AutomatedValues & values = m_automatedValues;
+	values.clear();
+	m_recordedModels.clear();
 
 	TrackContainer* container = this;
 	int clipNum = -1;
@@ -382,14 +385,14 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 		return;
 	}
 
-	values = container->automatedValuesAt(timeStart, clipNum);
-	TrackList tracks = container->tracks();
+	container->collectAutomatedValues(timeStart, clipNum, values);
 
-	Track::clipVector clips;
-	for (Track* track : tracks)
+	Track::clipVector & clips = m_recordingClips;
+	clips.clear();
+	for (Track* track : container->tracks())
 	{
 		if (track->type() == Track::AutomationTrack) {
-			track->getClipsInRange(clips, 0, timeStart);
+			track->getClipsUpTo(clips, timeStart);
 		}
 	}
 
@@ -403,34 +406,36 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 			const AutomatableModel* recordedModel = p->firstObject();
 			p->recordValue(relTime, recordedModel->value<float>());
 
-			recordedModels << recordedModel;
+			m_recordedModels.push_back(recordedModel);
 		}
 	}
 
 	// Checks if an automated model stopped being automated by automation clip
 	// so we can move the control back to any connected controller again
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
+	for (const auto& oldValue : m_oldAutomatedValues)
 	{
-		AutomatableModel * am = it.key();
+		AutomatableModel * am = oldValue.first;
 		if (am->controllerConnection() && !values.contains(am))
 		{
 			am->setUseControllerValue(true);
 		}
 	}
-	m_oldAutomatedValues = values;
 
 	// Apply values
-	for (auto it = values.begin(); it != values.end(); it++)
+	for (const auto& value : values)
 	{
-		if (! recordedModels.contains(it.key()))
+		if (std::find(m_recordedModels.begin(), m_recordedModels.end(), value.first) == m_recordedModels.end())
 		{
-			it.key()->setAutomatedValue(it.value());
+			value.first->setAutomatedValue(value.second);
 		}
-		else if (!it.key()->useControllerValue())
+		else if (!value.first->useControllerValue())
 		{
-			it.key()->setUseControllerValue(true);
+			value.first->setUseControllerValue(true);
 		}
 	}
+
+	// the old values become the vector to fill next tick
+	m_oldAutomatedValues.swap(m_automatedValues);
 }
 
 void Song::setModified(bool value)
@@ -609,6 +614,29 @@ void Song::setPlayPos( tick_t ticks, PlayModes playMode )
 
 
 
+bool Song::rewindPlayPos( PlayModes playMode, tick_t ticks, float currentFrame )
+{
+	PlayPos & pos = m_playPos[playMode];
+	if( !m_playing || playMode != m_playMode || pos.jumped() )
+	{
+		return false;
+	}
+
+	m_elapsedMilliSeconds[playMode] += TimePos::ticksToMilliseconds( ticks - pos.getTicks(), getTempo() );
+	pos.setTicks( ticks );
+	pos.setCurrentFrame( currentFrame );
+	// processNextBuffer() tells VST plugins and drops what has been
+	// rendered from here on meanwhile
+	pos.setJumped( true );
+
+	// sample clips start again from the new position
+	emit updateSampleTracks();
+	return true;
+}
+
+
+
+
 void Song::togglePause()
 {
 	if( m_paused == true )
@@ -620,6 +648,7 @@ void Song::togglePause()
 	{
 		m_playing = false;
 		m_paused = true;
+		Engine::audioEngine()->invalidateRenderAhead();
 	}
 
 	m_vstSyncController.setPlaybackState( m_playing );
@@ -688,15 +717,16 @@ void Song::stop()
 		+ m_playPos[m_playMode].currentFrame()
 		/ (double) Engine::framesPerTick() );
 
-	// remove all note-play-handles that are active
+	// remove all note-play-handles that are active and whatever has
+	// been rendered ahead
 	Engine::audioEngine()->clear();
+	Engine::audioEngine()->invalidateRenderAhead();
 
 	// Moves the control of the models that were processed on the last frame
 	// back to their controllers.
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
+	for (const auto& oldValue : m_oldAutomatedValues)
 	{
-		AutomatableModel * am = it.key();
-		am->setUseControllerValue(true);
+		oldValue.first->setUseControllerValue(true);
 	}
 	m_oldAutomatedValues.clear();
 
@@ -845,9 +875,15 @@ AutomationClip * Song::tempoAutomationClip()
 }
 
 
-AutomatedValueMap Song::automatedValuesAt(TimePos time, int clipNum) const
+void Song::collectAutomatedValues(TimePos time, int clipNum, AutomatedValues & values) const
 {
-	return TrackContainer::automatedValuesFromTracks(TrackList{m_globalAutomationTrack} << tracks(), time, clipNum);
+	Track::clipVector & clips = automationClips(clipNum);
+	addAutomationClips(m_globalAutomationTrack, time, clipNum, clips);
+	for (Track* track : tracks())
+	{
+		addAutomationClips(track, time, clipNum, clips);
+	}
+	collectAutomatedValuesFromClips(clips, time, values);
 }
 
 
@@ -905,7 +941,7 @@ void Song::clearProject()
 	m_masterPitchModel.reset();
 	m_timeSigModel.reset();
 
-	// Clear the m_oldAutomatedValues AutomatedValueMap
+	// Clear the m_oldAutomatedValues AutomatedValues
 	m_oldAutomatedValues.clear();
 
 	AutomationClip::globalAutomationClip( &m_tempoModel )->clear();
@@ -32,6 +32,10 @@
 #include <QDomElement>
 #include <QVariant>
 
+#include <algorithm>
+#include <limits>
+
+#include "AudioEngine.h"
 #include "AutomationClip.h"
 #include "AutomationTrack.h"
 #include "ConfigManager.h"
@@ -65,6 +69,12 @@ Track::Track( TrackTypes type, TrackContainer * tc ) :
 	m_soloModel( false, this, tr( "Solo" ) ), /*!< For controlling track soloing */
 	m_simpleSerializingMode( false ),
 	m_clips(),        /*!< The clips (segments) */
+	m_clipIndexRevision( 0 ),
+	m_cursorNext( 0 ),
+	m_cursorStart( 0 ),
+	m_cursorEnd( 0 ),
+	m_cursorRevision( 0 ),
+	m_clipsUpToHint( 0 ),
 	m_color( 0, 0, 0 ),
 	m_hasColor( false )
 {
@@ -333,7 +343,14 @@ void Track::loadSettings( const QDomElement & element )
  */
 Clip * Track::addClip( Clip * clip )
 {
+	Engine::audioEngine()->requestChangeInModel();
 	m_clips.push_back( clip );
+	const auto it = std::upper_bound( m_clipsByPosition.begin(), m_clipsByPosition.end(),
+						clip, Clip::comparePosition );
+	const int index = it - m_clipsByPosition.begin();
+	m_clipsByPosition.insert( it, clip );
+	indexClipsFrom( index );
+	Engine::audioEngine()->doneChangeInModel();
 
 	emit clipAdded( clip );
 
@@ -352,7 +369,13 @@ void Track::removeClip( Clip * clip )
 	clipVector::iterator it = std::find( m_clips.begin(), m_clips.end(), clip );
 	if( it != m_clips.end() )
 	{
+		Engine::audioEngine()->requestChangeInModel();
 		m_clips.erase( it );
+		const int index = m_clipsByPosition.indexOf( clip );
+		m_clipsByPosition.remove( index );
+		indexClipsFrom( index );
+		Engine::audioEngine()->doneChangeInModel();
+
 		if( Engine::getSong() )
 		{
 			Engine::getSong()->updateLength();
@@ -449,13 +472,19 @@ int Track::getClipNum( const Clip * clip )
 void Track::getClipsInRange( clipVector & clipV, const TimePos & start,
 							const TimePos & end )
 {
-	for( Clip* clip : m_clips )
+	// all clips before the first one reaching start end too early,
+	// all from the first one starting after end start too late
+	const int first = std::lower_bound( m_clipEnds.begin(), m_clipEnds.end(),
+					static_cast<tick_t>( start ) ) - m_clipEnds.begin();
+	for( int i = first; i < m_clipsByPosition.size(); ++i )
 	{
-		int s = clip->startPosition();
-		int e = clip->endPosition();
-		if( ( s <= end ) && ( e >= start ) )
+		Clip * clip = m_clipsByPosition[i];
+		if( clip->startPosition() > end )
+		{
+			break;
+		}
+		if( clip->endPosition() >= start )
 		{
-			// Clip is within given range
 			// Insert sorted by Clip's position
 			clipV.insert(std::upper_bound(clipV.begin(), clipV.end(), clip, Clip::comparePosition),
 						clip);
@@ -466,6 +495,156 @@ void Track::getClipsInRange( clipVector & clipV, const TimePos & start,
 
 
 
+void Track::getClipsUpTo( clipVector & clipV, const TimePos & time )
+{
+	const auto begin = m_clipsByPosition.begin();
+	const auto end = m_clipsByPosition.end();
+	const auto startsAfter = []( const TimePos & pos, const Clip * clip )
+	{
+		return pos < clip->startPosition();
+	};
+
+	// between ticks at most a few clips start, search only after jumps
+	auto last = begin + std::min<int>( m_clipsUpToHint.load( std::memory_order_relaxed ),
+						m_clipsByPosition.size() );
+	if( last != begin && ( *( last - 1 ) )->startPosition() > time )
+	{
+		last = std::upper_bound( begin, last, time, startsAfter );
+	}
+	else
+	{
+		for( int steps = 0; last != end && ( *last )->startPosition() <= time; ++last )
+		{
+			if( ++steps > 4 )
+			{
+				last = std::upper_bound( last, end, time, startsAfter );
+				break;
+			}
+		}
+	}
+	m_clipsUpToHint.store( last - begin, std::memory_order_relaxed );
+
+	// merge with the clips of the tracks before, which is an append
+	// unless they overlap
+	const int count = clipV.size();
+	for( auto it = begin; it != last; ++it )
+	{
+		clipV.push_back( *it );
+	}
+	if( count > 0 && count < clipV.size() &&
+		Clip::comparePosition( clipV[count], clipV[count - 1] ) )
+	{
+		std::inplace_merge( clipV.begin(), clipV.begin() + count, clipV.end(),
+					Clip::comparePosition );
+	}
+}
+
+
+
+
+void Track::updateClipIndex( Clip * clip )
+{
+	int index = m_clipsByPosition.indexOf( clip );
+	if( index < 0 )
+	{
+		return;
+	}
+
+	// move the clip to its new place, as it has been just one of
+	// several moved clips in most cases
+	m_clipsByPosition.remove( index );
+	const auto it = std::upper_bound( m_clipsByPosition.begin(), m_clipsByPosition.end(),
+						clip, Clip::comparePosition );
+	const int newIndex = it - m_clipsByPosition.begin();
+	m_clipsByPosition.insert( it, clip );
+	indexClipsFrom( std::min( index, newIndex ) );
+}
+
+
+
+
+void Track::indexClipsFrom( int index )
+{
+	m_clipEnds.resize( m_clipsByPosition.size() );
+	tick_t end = index > 0 ? m_clipEnds[index - 1] : std::numeric_limits<tick_t>::min();
+	for( int i = index; i < m_clipsByPosition.size(); ++i )
+	{
+		end = std::max<tick_t>( end, m_clipsByPosition[i]->endPosition() );
+		m_clipEnds[i] = end;
+	}
+	++m_clipIndexRevision;
+}
+
+
+
+
+const Track::clipVector & Track::playbackClips( const TimePos & start, const TimePos & end,
+						bool * restarted, clipVector * ended )
+{
+	const bool restart = m_cursorRevision != m_clipIndexRevision || start < m_cursorStart;
+	if( restart )
+	{
+		m_cursorRevision = m_clipIndexRevision;
+		m_cursorClips.clear();
+		m_cursorNext = std::lower_bound( m_clipEnds.begin(), m_clipEnds.end(),
+					static_cast<tick_t>( start ) ) - m_clipEnds.begin();
+	}
+	else
+	{
+		// drop the clips which are over, keeping the order
+		int kept = 0;
+		for( Clip * clip : m_cursorClips )
+		{
+			if( clip->endPosition() >= start )
+			{
+				m_cursorClips[kept++] = clip;
+			}
+			else if( ended )
+			{
+				ended->push_back( clip );
+			}
+		}
+		m_cursorClips.resize( kept );
+
+		if( end < m_cursorEnd )
+		{
+			// the last call looked further ahead, forget about the
+			// clips which don't start yet
+			while( !m_cursorClips.isEmpty() && m_cursorClips.last()->startPosition() > end )
+			{
+				m_cursorClips.removeLast();
+			}
+			m_cursorNext = std::upper_bound( m_clipsByPosition.begin(), m_clipsByPosition.begin() + m_cursorNext,
+					end, []( const TimePos & pos, const Clip * clip ) { return pos < clip->startPosition(); } )
+				- m_clipsByPosition.begin();
+		}
+	}
+
+	for( ; m_cursorNext < m_clipsByPosition.size(); ++m_cursorNext )
+	{
+		Clip * clip = m_clipsByPosition[m_cursorNext];
+		if( clip->startPosition() > end )
+		{
+			break;
+		}
+		if( clip->endPosition() >= start )
+		{
+			m_cursorClips.push_back( clip );
+		}
+	}
+
+	m_cursorStart = start;
+	m_cursorEnd = end;
+	if( restarted )
+	{
+		*restarted = restart;
+	}
+	return m_cursorClips;
+}
+
+
+
+
 /*! \brief Swap the position of two clips.
  *
  *  First, we arrange to swap the positions of the two Clips in the
@@ -252,38 +252,66 @@ bool TrackContainer::isEmpty() const
 
 AutomatedValueMap TrackContainer::automatedValuesAt(TimePos time, int clipNum) const
 {
-	return automatedValuesFromTracks(tracks(), time, clipNum);
+	AutomatedValues values;
+	collectAutomatedValues(time, clipNum, values);
+
+	AutomatedValueMap valueMap;
+	for (const auto& value : values)
+	{
+		valueMap[value.first] = value.second;
+	}
+	return valueMap;
 }
 
 
-AutomatedValueMap TrackContainer::automatedValuesFromTracks(const TrackList &tracks, TimePos time, int clipNum)
+void TrackContainer::collectAutomatedValues(TimePos time, int clipNum, AutomatedValues & values) const
 {
-	Track::clipVector clips;
-
-	for (Track* track: tracks)
+	Track::clipVector & clips = automationClips(clipNum);
+	for (Track* track : tracks())
 	{
-		if (track->isMuted()) {
-			continue;
-		}
+		addAutomationClips(track, time, clipNum, clips);
+	}
+	collectAutomatedValuesFromClips(clips, time, values);
+}
 
-		switch(track->type())
-		{
-		case Track::AutomationTrack:
-		case Track::HiddenAutomationTrack:
-		case Track::PatternTrack:
-			if (clipNum < 0) {
-				track->getClipsInRange(clips, 0, time);
-			} else {
-				Q_ASSERT(track->numOfClips() > clipNum);
-				clips << track->getClip(clipNum);
-			}
-		default:
-			break;
+
+Track::clipVector & TrackContainer::automationClips(int clipNum)
+{
+	// the song level collects the pattern clips, whose automation gets
+	// collected at the pattern level while the song level still iterates
+	static thread_local Track::clipVector songClips;
+	static thread_local Track::clipVector patternClips;
+	Track::clipVector & clips = clipNum < 0 ? songClips : patternClips;
+	clips.clear();
+	return clips;
+}
+
+
+void TrackContainer::addAutomationClips(Track * track, TimePos time, int clipNum, Track::clipVector & clips)
+{
+	if (track->isMuted()) {
+		return;
+	}
+
+	switch(track->type())
+	{
+	case Track::AutomationTrack:
+	case Track::HiddenAutomationTrack:
+	case Track::PatternTrack:
+		if (clipNum < 0) {
+			track->getClipsUpTo(clips, time);
+		} else {
+			Q_ASSERT(track->numOfClips() > clipNum);
+			clips << track->getClip(clipNum);
 		}
+	default:
+		break;
 	}
+}
 
-	AutomatedValueMap valueMap;
 
+void TrackContainer::collectAutomatedValuesFromClips(const Track::clipVector & clips, TimePos time, AutomatedValues & values)
+{
 	Q_ASSERT(std::is_sorted(clips.begin(), clips.end(), Clip::comparePosition));
 
 	for(Clip* clip : clips)
@@ -301,11 +329,11 @@ AutomatedValueMap TrackContainer::automatedValuesFromTracks(const TrackList &tra
 			if (! p->getAutoResize()) {
 				relTime = qMin(relTime, p->length());
 			}
-			float value = p->valueAt(relTime);
+			float value = p->playbackValueAt(relTime);
 
 			for (AutomatableModel* model : p->objects())
 			{
-				valueMap[model] = value;
+				values.set(model, value);
 			}
 		}
 		else if (auto* pattern = dynamic_cast<PatternClip*>(clip))
@@ -317,21 +345,11 @@ AutomatedValueMap TrackContainer::automatedValuesFromTracks(const TrackList &tra
 			patTime = std::min(patTime, clip->length());
 			patTime = patTime % (patStore->lengthOfPattern(patIndex) * TimePos::ticksPerBar());
 
-			auto patValues = patStore->automatedValuesAt(patTime, patIndex);
-			for (auto it=patValues.begin(); it != patValues.end(); it++)
-			{
-				// override old values, pattern track with the highest index takes precedence
-				valueMap[it.key()] = it.value();
-			}
-		}
-		else
-		{
-			continue;
+			// override old values, pattern track with the highest index takes precedence
+			patStore->collectAutomatedValues(patTime, patIndex, values);
 		}
 	}
-
-	return valueMap;
-};
+}
 
 
 } // namespace lmms
@@ -0,0 +1,192 @@
+/*
+ * TrackFreezer.cpp - renders the output of an instrument track for freezing it
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "TrackFreezer.h"
+
+#include "AudioDevice.h"
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "InstrumentTrack.h"
+#include "MemoryManager.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+
+TrackFreezer::TrackFreezer(InstrumentTrack* track) :
+	QThread(Engine::audioEngine()),
+	m_track(track),
+	m_audio(std::make_unique<FrozenAudio>(Engine::audioEngine()->framesPerPeriod(),
+						Engine::audioEngine()->processingSampleRate())),
+	m_trackWasMuted(track->isMuted()),
+	m_deviceStored(false),
+	m_progress(0),
+	m_abort(false),
+	m_succeeded(false)
+{
+}
+
+
+
+
+TrackFreezer::~TrackFreezer()
+{
+	abortProcessing();
+
+	if (m_deviceStored)
+	{
+		Engine::audioEngine()->restoreAudioDevice();  // Also deletes our device.
+	}
+
+	for (Track* track : m_muted)
+	{
+		track->setMuted(false);
+	}
+	m_track->setMuted(m_trackWasMuted);
+	m_track->audioPort()->setPreFader(false);
+}
+
+
+
+
+bool TrackFreezer::startProcessing()
+{
+	if (!m_audio->open())
+	{
+		return false;
+	}
+
+	Song* song = Engine::getSong();
+
+	// nothing but the track itself and automation is needed
+	for (Track* track : song->tracks())
+	{
+		if (track != m_track && !track->isMuted() &&
+			track->type() != Track::AutomationTrack &&
+			track->type() != Track::HiddenAutomationTrack)
+		{
+			track->setMuted(true);
+			m_muted.push_back(track);
+		}
+	}
+	m_track->setMuted(false);
+
+	// volume, panning and the effects stay live
+	m_track->audioPort()->setPreFader(true);
+
+	// the frozen audio has to follow the song from its beginning
+	song->setRenderBetweenMarkers(false);
+	song->setExportLoop(false);
+	song->setLoopRenderCount(1);
+
+	// Have to do audio engine stuff with GUI-thread affinity in order to
+	// make slots connected to sampleRateChanged()-signals being called immediately.
+	AudioEngine* audioEngine = Engine::audioEngine();
+	audioEngine->storeAudioDevice();
+	m_deviceStored = true;
+	audioEngine->setAudioDevice(new AudioDevice(DEFAULT_CHANNELS, audioEngine),
+					audioEngine->currentQualitySettings(), false, false);
+
+	start(
+#ifndef LMMS_BUILD_WIN32
+		QThread::HighPriority
+#endif
+	);
+	return true;
+}
+
+
+
+
+void TrackFreezer::abortProcessing()
+{
+	m_abort = true;
+	wait();
+}
+
+
+
+
+std::unique_ptr<FrozenAudio> TrackFreezer::takeAudio()
+{
+	if (!m_succeeded)
+	{
+		return nullptr;
+	}
+	return std::move(m_audio);
+}
+
+
+
+
+void TrackFreezer::run()
+{
+	MemoryManager::ThreadGuard mmThreadGuard; Q_UNUSED(mmThreadGuard);
+
+	AudioEngine* audioEngine = Engine::audioEngine();
+	audioEngine->m_threadSettings.applyToCurrentThread("freeze thread", false);
+
+	Song* song = Engine::getSong();
+	song->startExport();
+
+	const Song::PlayPos& pos = song->getPlayPos(Song::Mode_PlaySong);
+	bool written = true;
+	bool started = false;
+	while (!song->isExportDone() && !m_abort)
+	{
+		const double ticks = pos.getTicks() + pos.currentFrame() / Engine::framesPerTick();
+
+		// the master output of the first call is an old buffer, but the
+		// port already holds the first period of the song
+		audioEngine->nextBuffer();
+		if (!started)
+		{
+			audioEngine->startProcessing(false);
+			started = true;
+		}
+
+		// the port keeps what the instrument delivered until the next period
+		if (!m_audio->append(m_track->audioPort()->buffer(), ticks))
+		{
+			written = false;
+			break;
+		}
+
+		const int progress = song->getExportProgress();
+		if (m_progress != progress)
+		{
+			m_progress = progress;
+			emit progressChanged(m_progress);
+		}
+	}
+
+	audioEngine->stopProcessing();
+	song->stopExport();
+
+	m_succeeded = written && !m_abort && m_audio->finish();
+}
+
+
+} // namespace lmms
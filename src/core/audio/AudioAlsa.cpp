@@ -295,8 +295,8 @@ void AudioAlsa::applyQualitySettings()
 
 void AudioAlsa::run()
 {
-	auto temp = new surroundSampleFrame[audioEngine()->framesPerPeriod()];
-	auto outbuf = new int_sample_t[audioEngine()->framesPerPeriod() * channels()];
+	auto temp = new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()];
+	auto outbuf = new int_sample_t[audioEngine()->maxFramesPerPeriod() * channels()];
 	auto pcmbuf = new int_sample_t[m_periodSize * channels()];
 
 	int outbuf_size = audioEngine()->framesPerPeriod() * channels();
@@ -23,6 +23,7 @@
  */
 
 #include <cstring>
+#include <vector>
 
 #include "AudioDevice.h"
 #include "AudioEngine.h"
@@ -37,7 +38,7 @@ AudioDevice::AudioDevice( const ch_cnt_t _channels, AudioEngine*  _audioEngine )
 	m_sampleRate( _audioEngine->processingSampleRate() ),
 	m_channels( _channels ),
 	m_audioEngine( _audioEngine ),
-	m_buffer( new surroundSampleFrame[audioEngine()->framesPerPeriod()] )
+	m_buffer( new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()] )
 {
 	int error;
 	if( ( m_srcState = src_new(
@@ -79,10 +80,33 @@ void AudioDevice::processNextBuffer()
 
 
 
+void AudioDevice::processBuffer( const surroundSampleFrame * _ab,
+							const fpp_t _frames )
+{
+	const sample_rate_t processingRate = audioEngine()->processingSampleRate();
+	if( processingRate == m_sampleRate )
+	{
+		writeBuffer( _ab, _frames, audioEngine()->masterGain() );
+		return;
+	}
+
+	// the device never runs at a higher rate than the audio engine, so
+	// the resampled buffer can't be longer
+	std::vector<surroundSampleFrame> resampled( _frames );
+	lock();
+	const fpp_t frames = resample( _ab, _frames, resampled.data(), processingRate, m_sampleRate );
+	unlock();
+
+	writeBuffer( resampled.data(), frames, audioEngine()->masterGain() );
+}
+
+
+
+
 fpp_t AudioDevice::getNextBuffer( surroundSampleFrame * _ab )
 {
-	fpp_t frames = audioEngine()->framesPerPeriod();
-	const surroundSampleFrame * b = audioEngine()->nextBuffer();
+	fpp_t frames = 0;
+	const surroundSampleFrame * b = audioEngine()->nextBuffer( &frames );
 	if( !b )
 	{
 		return 0;
@@ -52,7 +52,7 @@ AudioJack::AudioJack( bool & _success_ful, AudioEngine*  _audioEngine ) :
 	m_active( false ),
 	m_midiClient( nullptr ),
 	m_tempOutBufs( new jack_default_audio_sample_t *[channels()] ),
-	m_outBuf( new surroundSampleFrame[audioEngine()->framesPerPeriod()] ),
+	m_outBuf( new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()] ),
 	m_framesDoneInCurBuf( 0 ),
 	m_framesToDoInCurBuf( 0 )
 {
@@ -292,8 +292,8 @@ void AudioOss::applyQualitySettings()
 
 void AudioOss::run()
 {
-	auto temp = new surroundSampleFrame[audioEngine()->framesPerPeriod()];
-	auto outbuf = new int_sample_t[audioEngine()->framesPerPeriod() * channels()];
+	auto temp = new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()];
+	auto outbuf = new int_sample_t[audioEngine()->maxFramesPerPeriod() * channels()];
 
 	while( true )
 	{
@@ -25,6 +25,7 @@
 #include "AudioPort.h"
 #include "AudioDevice.h"
 #include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
 #include "EffectChain.h"
 #include "Mixer.h"
 #include "Engine.h"
@@ -38,9 +39,15 @@ AudioPort::AudioPort( const QString & _name, bool _has_effect_chain,
 		FloatModel * volumeModel, FloatModel * panningModel,
 		BoolModel * mutedModel ) :
 	m_bufferUsage( false ),
+	m_bufferSilent( false ),
+	m_hasOutput( false ),
 	m_portBuffer( BufferManager::acquire() ),
 	m_extOutputEnabled( false ),
 	m_nextMixerChannel( 0 ),
+	m_preFader( false ),
+	m_mixerChannel( nullptr ),
+	m_pendingInputs( 0 ),
+	m_inputLatency( 0 ),
 	m_name( "unnamed port" ),
 	m_effects( _has_effect_chain ? new EffectChain( nullptr ) : nullptr ),
 	m_volumeModel( volumeModel ),
@@ -83,6 +90,37 @@ void AudioPort::setExtOutputEnabled( bool _enabled )
 
 
 
+void AudioPort::setNextMixerChannel( const mix_ch_t _chnl )
+{
+	if( _chnl != m_nextMixerChannel )
+	{
+		m_nextMixerChannel = _chnl;
+		Engine::audioEngine()->invalidateRenderGraph();
+	}
+}
+
+
+
+
+f_cnt_t AudioPort::latency() const
+{
+	return m_inputLatency + ( m_effects ? m_effects->latency() : 0 );
+}
+
+
+
+
+void AudioPort::setInputLatency( f_cnt_t frames )
+{
+	if( m_inputLatency.exchange( frames ) != frames )
+	{
+		Engine::audioEngine()->invalidateRenderGraph();
+	}
+}
+
+
+
+
 void AudioPort::setName( const QString & _name )
 {
 	m_name = _name;
@@ -105,16 +143,27 @@ bool AudioPort::processEffects()
 
 void AudioPort::doProcessing()
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+
 	if( m_mutedModel && m_mutedModel->value() )
 	{
+		// let what is still delayed run out silently
+		m_compensator.process( m_portBuffer, fpp, false );
+		m_hasOutput = false;
+		signalMixerChannel();
 		return;
 	}
 
-	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
-
-	// clear the buffer
-	BufferManager::clear( m_portBuffer, fpp );
+	// clear the buffer unless nothing was written to it last period
+	if( !m_bufferSilent )
+	{
+		BufferManager::clear( m_portBuffer, fpp );
+		m_bufferSilent = true;
+	}
 
+	// other tracks may add play handles to us (e.g. through MIDI
+	// forwarding) while we're mixing
+	m_playHandleLock.lock();
 	//qDebug( "Playhandles: %d", m_playHandles.size() );
 	for( PlayHandle * ph : m_playHandles ) // now we mix all playhandle buffers into the audioport buffer
 	{
@@ -131,102 +180,60 @@ void AudioPort::doProcessing()
 									// pointer to null, so if it doesn't get re-acquired we know to skip it next time
 		}
 	}
+	m_playHandleLock.unlock();
 
-	if( m_bufferUsage )
+	if( m_bufferUsage && !m_preFader )
 	{
-		// handle volume and panning
-		// has both vol and pan models
-		if( m_volumeModel && m_panningModel )
+		// handle volume and panning, using sample-exact data if there is any
+		if( m_volumeModel )
 		{
-			ValueBuffer * volBuf = m_volumeModel->valueBuffer();
-			ValueBuffer * panBuf = m_panningModel->valueBuffer();
+			MixHelpers::multiplyByVolumeAndPanning( m_portBuffer,
+				m_volumeModel->value(), m_volumeModel->valueBuffer(),
+				m_panningModel ? m_panningModel->value() : 0.0f,
+				m_panningModel ? m_panningModel->valueBuffer() : nullptr, fpp );
+		}
+	}
+	// as of now there's no situation where we only have panning model but no volume model
+	// if we have neither, we don't have to do anything here - just pass the audio as is
 
-			// both vol and pan have s.ex.data:
-			if( volBuf && panBuf )
-			{
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float v = volBuf->values()[ f ] * 0.01f;
-					float p = panBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
-					m_portBuffer[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
-				}
-			}
+	// handle effects - without input they only have to run while one of
+	// them is still producing a tail
+	const bool runEffects = !m_preFader && m_effects &&
+				( m_bufferUsage || m_effects->isRunning() );
+	const bool me = runEffects && processEffects();
+	m_bufferSilent = !m_bufferUsage && !runEffects;
+	// the mixer channel sums our output itself once we signal it
+	m_hasOutput = me || m_bufferUsage;
+	m_bufferUsage = false;
+
+	if( m_compensator.delay() > 0 )
+	{
+		m_hasOutput = m_compensator.process( m_portBuffer, fpp, m_hasOutput );
+	}
 
-			// only vol has s.ex.data:
-			else if( volBuf )
-			{
-				float p = m_panningModel->value() * 0.01f;
-				float l = ( p <= 0 ? 1.0f : 1.0f - p );
-				float r = ( p >= 0 ? 1.0f : 1.0f + p );
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float v = volBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= v * l;
-					m_portBuffer[f][1] *= v * r;
-				}
-			}
+	signalMixerChannel();
+}
 
-			// only pan has s.ex.data:
-			else if( panBuf )
-			{
-				float v = m_volumeModel->value() * 0.01f;
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float p = panBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
-					m_portBuffer[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
-				}
-			}
 
-			// neither has s.ex.data:
-			else
-			{
-				float p = m_panningModel->value() * 0.01f;
-				float v = m_volumeModel->value() * 0.01f;
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					m_portBuffer[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
-					m_portBuffer[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
-				}
-			}
-		}
 
-		// has vol model only
-		else if( m_volumeModel )
-		{
-			ValueBuffer * volBuf = m_volumeModel->valueBuffer();
 
-			if( volBuf )
-			{
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float v = volBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= v;
-					m_portBuffer[f][1] *= v;
-				}
-			}
-			else
-			{
-				float v = m_volumeModel->value() * 0.01f;
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					m_portBuffer[f][0] *= v;
-					m_portBuffer[f][1] *= v;
-				}
-			}
-		}
+void AudioPort::inputDone()
+{
+	if( --m_pendingInputs == 0 )
+	{
+		AudioEngineWorkerThread::addJob( this );
 	}
-	// as of now there's no situation where we only have panning model but no volume model
-	// if we have neither, we don't have to do anything here - just pass the audio as is
+}
 
-	// handle effects
-	const bool me = processEffects();
-	if( me || m_bufferUsage )
+
+
+
+void AudioPort::signalMixerChannel()
+{
+	// muted channels don't wait for their inputs
+	if( m_mixerChannel && !m_mixerChannel->m_muted )
 	{
-		Engine::mixer()->mixToChannel( m_portBuffer, m_nextMixerChannel ); 	// send output to mixer
-																			// TODO: improve the flow here - convert to pull model
-		m_bufferUsage = false;
+		m_mixerChannel->incrementDeps();
 	}
 }
 
@@ -234,7 +241,10 @@ void AudioPort::doProcessing()
 void AudioPort::addPlayHandle( PlayHandle * handle )
 {
 	m_playHandleLock.lock();
-		m_playHandles.append( handle );
+		if( !m_playHandles.contains( handle ) )
+		{
+			m_playHandles.append( handle );
+		}
 	m_playHandleLock.unlock();
 }
 
@@ -242,11 +252,7 @@ void AudioPort::addPlayHandle( PlayHandle * handle )
 void AudioPort::removePlayHandle( PlayHandle * handle )
 {
 	m_playHandleLock.lock();
-		PlayHandleList::Iterator it =	std::find( m_playHandles.begin(), m_playHandles.end(), handle );
-		if( it != m_playHandles.end() )
-		{
-			m_playHandles.erase( it );
-		}
+		m_playHandles.remove( handle );
 	m_playHandleLock.unlock();
 }
 
@@ -68,7 +68,7 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, AudioEngine * _audioEngine
 		SURROUND_CHANNELS ), _audioEngine ),
 	m_paStream( nullptr ),
 	m_wasPAInitError( false ),
-	m_outBuf( new surroundSampleFrame[audioEngine()->framesPerPeriod()] ),
+	m_outBuf( new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()] ),
 	m_outBufPos( 0 )
 {
 	_success_ful = false;
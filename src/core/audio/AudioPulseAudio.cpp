@@ -246,8 +246,7 @@ void AudioPulseAudio::run()
 	}
 	else
 	{
-		const fpp_t fpp = audioEngine()->framesPerPeriod();
-		auto temp = new surroundSampleFrame[fpp];
+		auto temp = new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()];
 		while( getNextBuffer( temp ) )
 		{
 		}
@@ -265,7 +264,7 @@ void AudioPulseAudio::run()
 
 void AudioPulseAudio::streamWriteCallback( pa_stream *s, size_t length )
 {
-	const fpp_t fpp = audioEngine()->framesPerPeriod();
+	const fpp_t fpp = audioEngine()->maxFramesPerPeriod();
 	auto temp = new surroundSampleFrame[fpp];
 	auto pcmbuf = (int_sample_t*)pa_xmalloc(fpp * channels() * sizeof(int_sample_t));
 
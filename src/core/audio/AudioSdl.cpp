@@ -39,7 +39,7 @@ namespace lmms
 
 AudioSdl::AudioSdl( bool & _success_ful, AudioEngine*  _audioEngine ) :
 	AudioDevice( DEFAULT_CHANNELS, _audioEngine ),
-	m_outBuf( new surroundSampleFrame[audioEngine()->framesPerPeriod()] )
+	m_outBuf( new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()] )
 {
 	_success_ful = false;
 
@@ -47,7 +47,7 @@ AudioSdl::AudioSdl( bool & _success_ful, AudioEngine*  _audioEngine ) :
 	m_currentBufferFramesCount = 0;
 	m_currentBufferFramePos = 0;
 #else
-	m_convertedBufSize = audioEngine()->framesPerPeriod() * channels()
+	m_convertedBufSize = audioEngine()->maxFramesPerPeriod() * channels()
 						* sizeof( int_sample_t );
 	m_convertedBufPos = 0;
 	m_convertedBuf = new Uint8[m_convertedBufSize];
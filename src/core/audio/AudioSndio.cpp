@@ -156,8 +156,8 @@ void AudioSndio::applyQualitySettings()
 
 void AudioSndio::run()
 {
-	surroundSampleFrame * temp = new surroundSampleFrame[audioEngine()->framesPerPeriod()];
-	int_sample_t * outbuf = new int_sample_t[audioEngine()->framesPerPeriod() * channels()];
+	surroundSampleFrame * temp = new surroundSampleFrame[audioEngine()->maxFramesPerPeriod()];
+	int_sample_t * outbuf = new int_sample_t[audioEngine()->maxFramesPerPeriod() * channels()];
 
 	while( true )
 	{
@@ -219,7 +219,7 @@ void AudioSoundIo::startProcessing()
 	
 	m_outBufFrameIndex = 0;
 	m_outBufFramesTotal = 0;
-	m_outBufSize = audioEngine()->framesPerPeriod();
+	m_outBufSize = audioEngine()->maxFramesPerPeriod();
 
 	m_outBuf = new surroundSampleFrame[m_outBufSize];
 
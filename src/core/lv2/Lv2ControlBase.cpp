@@ -33,6 +33,7 @@
 #include "Engine.h"
 #include "Lv2Manager.h"
 #include "Lv2Proc.h"
+#include "PlanarBuffer.h"
 
 
 namespace lmms
@@ -155,6 +156,27 @@ void Lv2ControlBase::run(fpp_t frames) {
 
 
 
+void Lv2ControlBase::run(const PlanarBuffer &in, PlanarBuffer &out) {
+	unsigned firstChan = 0;
+	for (const auto& c : m_procs) {
+		c->run(in, out, firstChan, m_channelsPerProc);
+		firstChan += m_channelsPerProc;
+	}
+}
+
+
+
+
+f_cnt_t Lv2ControlBase::latency() const
+{
+	f_cnt_t res = 0;
+	for (const auto& c : m_procs) { res = std::max(res, c->latency()); }
+	return res;
+}
+
+
+
+
 void Lv2ControlBase::saveSettings(QDomDocument &doc, QDomElement &that)
 {
 	LinkedModelGroups::saveSettings(doc, that);
@@ -191,6 +213,14 @@ void Lv2ControlBase::reloadPlugin()
 
 
 
+void Lv2ControlBase::updateBlockLength()
+{
+	for (const auto& c : m_procs) { c->updateBlockLength(); }
+}
+
+
+
+
 std::size_t Lv2ControlBase::controlCount() const {
 	std::size_t res = 0;
 	for (const auto& c : m_procs) { res += c->controlCount(); }
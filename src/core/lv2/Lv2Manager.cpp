@@ -148,7 +148,9 @@ Lv2Manager::Lv2Manager() :
 	m_supportedFeatureURIs.insert(LV2_OPTIONS__options);
 	// min/max is always passed in the options
 	m_supportedFeatureURIs.insert(LV2_BUF_SIZE__boundedBlockLength);
-	// block length is only changed initially in AudioEngine CTOR
+	// block length only changes between two periods, when the user picks
+	// another period size. Plugins relying on it are instantiated anew then
+	// (see Lv2Proc::updateBlockLength()).
 	m_supportedFeatureURIs.insert(LV2_BUF_SIZE__fixedBlockLength);
 
 	auto supportOpt = [this](Lv2UridCache::Id id)
@@ -29,6 +29,7 @@
 
 #include <lv2/lv2plug.in/ns/ext/atom/atom.h>
 #include <lv2/lv2plug.in/ns/ext/port-props/port-props.h>
+#include <algorithm>
 
 #include "Engine.h"
 #include "Lv2Basics.h"
@@ -347,6 +348,33 @@ void Audio::copyBuffersToCore(sampleFrame *lmmsBuf,
 
 
 
+void Audio::copyBuffersFromCore(const sample_t *lmmsChannel, fpp_t frames)
+{
+	std::copy_n(lmmsChannel, frames, m_buffer.begin());
+}
+
+
+
+
+void Audio::averageWithBuffersFromCore(const sample_t *lmmsChannel, fpp_t frames)
+{
+	for (std::size_t f = 0; f < static_cast<unsigned>(frames); ++f)
+	{
+		m_buffer[f] = (m_buffer[f] + lmmsChannel[f]) / 2.0f;
+	}
+}
+
+
+
+
+void Audio::copyBuffersToCore(sample_t *lmmsChannel, fpp_t frames) const
+{
+	std::copy_n(m_buffer.begin(), frames, lmmsChannel);
+}
+
+
+
+
 void AtomSeq::Lv2EvbufDeleter::operator()(LV2_Evbuf *n) { lv2_evbuf_free(n); }
 
 
@@ -26,9 +26,11 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <algorithm>
 #include <cmath>
 #include <lv2/lv2plug.in/ns/ext/midi/midi.h>
 #include <lv2/lv2plug.in/ns/ext/atom/atom.h>
+#include <lv2/lv2plug.in/ns/ext/buf-size/buf-size.h>
 #include <lv2/lv2plug.in/ns/ext/resize-port/resize-port.h>
 #include <QDebug>
 #include <QtGlobal>
@@ -43,6 +45,7 @@
 #include "Lv2Evbuf.h"
 #include "MidiEvent.h"
 #include "MidiEventToByteSeq.h"
+#include "PlanarBuffer.h"
 
 
 namespace lmms
@@ -329,8 +332,86 @@ void Lv2Proc::copyBuffersToCore(sampleFrame* buf,
 
 
 
+void Lv2Proc::copyBuffersFromCore(const PlanarBuffer &buf,
+									unsigned firstChan, unsigned num)
+{
+	const fpp_t frames = buf.frames();
+	inPorts().m_left->copyBuffersFromCore(buf.channel(firstChan), frames);
+	if (num > 1)
+	{
+		// see the interleaved version
+		if (inPorts().m_right)
+		{
+			inPorts().m_right->copyBuffersFromCore(buf.channel(firstChan + 1), frames);
+		}
+		else
+		{
+			inPorts().m_left->averageWithBuffersFromCore(buf.channel(firstChan + 1), frames);
+		}
+	}
+}
+
+
+
+
+void Lv2Proc::copyBuffersToCore(PlanarBuffer &buf,
+								unsigned firstChan, unsigned num) const
+{
+	const fpp_t frames = buf.frames();
+	outPorts().m_left->copyBuffersToCore(buf.channel(firstChan), frames);
+	if (num > 1)
+	{
+		// see the interleaved version
+		Lv2Ports::Audio* ap = outPorts().m_right
+			? outPorts().m_right : outPorts().m_left;
+		ap->copyBuffersToCore(buf.channel(firstChan + 1), frames);
+	}
+}
+
+
+
+
+void Lv2Proc::run(const PlanarBuffer &in, PlanarBuffer &out,
+								unsigned firstChan, unsigned num)
+{
+	if (!m_instance) { return; }
+
+	const fpp_t frames = in.frames();
+	// a mono port for two channels needs them averaged or duplicated
+	const bool direct = num == 1 ||
+		(inPorts().m_right && outPorts().m_right);
+	if (!direct)
+	{
+		copyBuffersFromCore(in, firstChan, num);
+		run(frames);
+		copyBuffersToCore(out, firstChan, num);
+		return;
+	}
+
+	connectAudioPort(inPorts().m_left, in.channel(firstChan));
+	connectAudioPort(outPorts().m_left, out.channel(firstChan));
+	if (num > 1)
+	{
+		connectAudioPort(inPorts().m_right, in.channel(firstChan + 1));
+		connectAudioPort(outPorts().m_right, out.channel(firstChan + 1));
+	}
+
+	run(frames);
+
+	for (const Lv2Ports::Audio* port : { inPorts().m_left, outPorts().m_left,
+		inPorts().m_right, outPorts().m_right })
+	{
+		if (port) { connectPort(portIndex(port)); }
+	}
+}
+
+
+
+
 void Lv2Proc::run(fpp_t frames)
 {
+	// a failed new instance (see updateBlockLength()) stays silent
+	if (!m_instance) { return; }
 	lilv_instance_run(m_instance, static_cast<uint32_t>(frames));
 }
 
@@ -393,6 +474,17 @@ void Lv2Proc::initPlugin()
 
 	createPorts();
 
+	AutoLilvNode fixedBlockLength = uri(LV2_BUF_SIZE__fixedBlockLength);
+	m_fixedBlockLength = lilv_plugin_has_feature(m_plugin, fixedBlockLength.get());
+
+	instantiate();
+}
+
+
+
+
+void Lv2Proc::instantiate()
+{
 	m_instance = lilv_plugin_instantiate(m_plugin,
 		Engine::audioEngine()->processingSampleRate(),
 		m_features.featurePointers());
@@ -453,15 +545,21 @@ void Lv2Proc::initMOptions()
 		So, if the sampleRate would change, the plugin will need to
 		re-initialize, and this code section will be
 		executed again, creating a new option vector.
+
+		block length:
+		The period size can change at any time (see updateBlockLength()),
+		but never exceeds the maximum one the port buffers are made for.
 	*/
 	float sampleRate = Engine::audioEngine()->processingSampleRate();
+	int32_t maxBlockLength = Engine::audioEngine()->maxFramesPerPeriod();
+	int32_t minBlockLength = MINIMUM_BUFFER_SIZE;
 	int32_t blockLength = Engine::audioEngine()->framesPerPeriod();
 	int32_t sequenceSize = defaultEvbufSize();
 
 	using Id = Lv2UridCache::Id;
 	m_options.initOption<float>(Id::param_sampleRate, sampleRate);
-	m_options.initOption<int32_t>(Id::bufsz_maxBlockLength, blockLength);
-	m_options.initOption<int32_t>(Id::bufsz_minBlockLength, blockLength);
+	m_options.initOption<int32_t>(Id::bufsz_maxBlockLength, maxBlockLength);
+	m_options.initOption<int32_t>(Id::bufsz_minBlockLength, minBlockLength);
 	m_options.initOption<int32_t>(Id::bufsz_nominalBlockLength, blockLength);
 	m_options.initOption<int32_t>(Id::bufsz_sequenceSize, sequenceSize);
 	m_options.createOptionVectors();
@@ -470,6 +568,52 @@ void Lv2Proc::initMOptions()
 
 
 
+void Lv2Proc::updateBlockLength()
+{
+	if (!m_valid) { return; }
+
+	using Id = Lv2UridCache::Id;
+	const int32_t blockLength = Engine::audioEngine()->framesPerPeriod();
+	m_options.updateOption<int32_t>(Id::bufsz_nominalBlockLength, blockLength);
+
+	if (m_fixedBlockLength)
+	{
+		// the block length was promised not to change, so the plugin gets
+		// a new instance with the new options. The ports keep their
+		// values, the plugin's internal state is lost.
+		shutdownPlugin();
+		instantiate();
+		return;
+	}
+
+	// plugins with the options interface are told directly, all others
+	// only see that the next run() is called with a different length
+	const auto iface = static_cast<const LV2_Options_Interface*>(
+		lilv_instance_get_extension_data(m_instance, LV2_OPTIONS__interface));
+	if (iface && iface->set)
+	{
+		const Lv2UridCache& cache = Engine::getLv2Manager()->uridCache();
+		const LV2_Options_Option options[] =
+		{
+			{ LV2_OPTIONS_INSTANCE, 0, cache[Id::bufsz_nominalBlockLength],
+				sizeof(int32_t), cache[Lv2UridCache::IdForType<int32_t>::value], &blockLength },
+			{ LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, nullptr }
+		};
+		iface->set(lilv_instance_get_handle(m_instance), options);
+	}
+}
+
+
+
+
+f_cnt_t Lv2Proc::latency() const
+{
+	return m_latencyPort ? static_cast<f_cnt_t>(std::max(m_latencyPort->m_val, 0.f)) : 0;
+}
+
+
+
+
 void Lv2Proc::initPluginSpecificFeatures()
 {
 	initMOptions();
@@ -576,7 +720,7 @@ void Lv2Proc::createPort(std::size_t portNum)
 		}
 		case Lv2Ports::Type::Audio:
 		{
-			auto audio = new Lv2Ports::Audio(static_cast<std::size_t>(Engine::audioEngine()->framesPerPeriod()),
+			auto audio = new Lv2Ports::Audio(static_cast<std::size_t>(Engine::audioEngine()->maxFramesPerPeriod()),
 				portIsSideChain(m_plugin, lilvPort));
 			port = audio;
 			break;
@@ -721,6 +865,16 @@ void Lv2Proc::createPorts()
 		m_ports[portNum]->accept(registerPort);
 	}
 
+	// the plugin writes its latency in frames to this port in each run
+	if (lilv_plugin_has_latency(m_plugin))
+	{
+		const uint32_t latencyPort = lilv_plugin_get_latency_port_index(m_plugin);
+		if (latencyPort < maxPorts)
+		{
+			m_latencyPort = Lv2Ports::dcast<Lv2Ports::Control>(m_ports[latencyPort].get());
+		}
+	}
+
 	// initially assign model values to port values
 	copyModelsFromCore();
 
@@ -766,6 +920,25 @@ void Lv2Proc::connectPort(std::size_t num)
 
 
 
+// !This function must be realtime safe!
+void Lv2Proc::connectAudioPort(const Lv2Ports::Audio *port, const sample_t *location)
+{
+	// plugins never write to input ports, so the input may be const
+	lilv_instance_connect_port(m_instance,
+		static_cast<uint32_t>(portIndex(port)), const_cast<sample_t*>(location));
+}
+
+
+
+
+std::size_t Lv2Proc::portIndex(const Lv2Ports::PortBase *port) const
+{
+	return lilv_port_get_index(m_plugin, port->m_port);
+}
+
+
+
+
 void Lv2Proc::dumpPort(std::size_t num)
 {
 	struct DumpPortDetail : public Lv2Ports::ConstVisitor
@@ -58,6 +58,7 @@
 #include <csignal>
 
 #include "MainApplication.h"
+#include "AudioThreadSettings.h"
 #include "ConfigManager.h"
 #include "DataFile.h"
 #include "NotePlayHandle.h"
@@ -175,7 +176,12 @@ void printHelp()
 		"      --allowroot                Bypass root user startup check (use with\n"
 		"          caution).\n"
 		"  -c, --config <configfile>      Get the configuration from <configfile>\n"
+		"      --cpuset <cpus>            Pin the audio threads to <cpus>, e.g. 2-5,8\n"
 		"  -h, --help                     Show this usage information and exit.\n"
+		"      --rtpriority <priority>    Request SCHED_FIFO scheduling with\n"
+		"          <priority> for the audio threads, 0 disables it\n"
+		"      --workers <count>          Number of audio worker threads\n"
+		"          Default: one less than the number of CPUs\n"
 		"  -v, --version                  Show version information and exit.\n"
 		"\nOptions if no action is given:\n"
 		"      --geometry <geometry>      Specify the size and position of\n"
@@ -208,11 +214,21 @@ void printHelp()
 		"          If not specified, render will overwrite the input file\n"
 		"          For \"rendertracks\", this might be required\n"
 		"  -p, --profile <out>            Dump profiling information to file <out>\n"
+		"          One line per period with six columns: period time and\n"
+		"          job scheduling overhead, both in microseconds, the most\n"
+		"          period buffers in use, how often they ran out, then the\n"
+		"          capacity and the most note play handles in use of the\n"
+		"          note play handle pool\n"
 		"  -s, --samplerate <samplerate>  Specify output samplerate in Hz\n"
 		"          Range: 44100 (default) to 192000\n"
 		"  -x, --oversampling <value>     Specify oversampling\n"
 		"          Possible values: 1, 2, 4, 8\n"
-		"          Default: 2\n\n",
+		"          Default: 2\n"
+		"  --stems                        Render all tracks in a single pass\n"
+		"          For \"rendertracks\" only. The track files don't include\n"
+		"          mixer effects, the master output is rendered as well\n"
+		"  --mixer-stems                  Like --stems, but also render each\n"
+		"          mixer channel\n\n",
 		LMMS_VERSION, LMMS_PROJECT_COPYRIGHT );
 }
 
@@ -308,6 +324,8 @@ int main( int argc, char * * argv )
 	bool allowRoot = false;
 	bool renderLoop = false;
 	bool renderTracks = false;
+	bool renderStems = false;
+	bool renderMixerStems = false;
 	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, configFile;
 
 	// first of two command-line parsing stages
@@ -491,6 +509,15 @@ int main( int argc, char * * argv )
 		{
 			renderLoop = true;
 		}
+		else if( arg == "--stems" )
+		{
+			renderStems = true;
+		}
+		else if( arg == "--mixer-stems" )
+		{
+			renderStems = true;
+			renderMixerStems = true;
+		}
 		else if( arg == "--output" || arg == "-o" )
 		{
 			++i;
@@ -719,6 +746,56 @@ int main( int argc, char * * argv )
 
 			configFile = QString::fromLocal8Bit( argv[i] );
 		}
+		else if( arg == "--workers" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No worker count specified" );
+			}
+
+			bool ok = false;
+			const int workers = QString( argv[i] ).toInt( &ok );
+			if( !ok || workers < 0 )
+			{
+				return usageError( QString( "Invalid worker count %1" ).arg( argv[i] ) );
+			}
+			AudioThreadSettings::overrideWorkers( workers );
+		}
+		else if( arg == "--cpuset" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No CPU set specified" );
+			}
+
+			const QString cpuSet = QString::fromLocal8Bit( argv[i] );
+			if( AudioThreadSettings::parseCpuSet( cpuSet ).isEmpty() )
+			{
+				return usageError( QString( "Invalid CPU set %1" ).arg( argv[i] ) );
+			}
+			AudioThreadSettings::overrideCpuSet( cpuSet );
+		}
+		else if( arg == "--rtpriority" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No realtime priority specified" );
+			}
+
+			bool ok = false;
+			const int priority = QString( argv[i] ).toInt( &ok );
+			if( !ok || priority < 0 || priority > 99 )
+			{
+				return usageError( QString( "Invalid realtime priority %1" ).arg( argv[i] ) );
+			}
+			AudioThreadSettings::overrideRealtimePriority( priority );
+		}
 		else
 		{
 			if( argv[i][0] == '-' )
@@ -830,6 +907,10 @@ int main( int argc, char * * argv )
 
 		// create renderer
 		auto r = new RenderManager(qs, os, eff, renderOut);
+		QObject::connect( r, &RenderManager::finished, [r]()
+		{
+			printf( "\nRendered at %.1fx realtime\n", r->realtimeFactor() );
+		} );
 		QCoreApplication::instance()->connect( r,
 				SIGNAL(finished()), SLOT(quit()));
 
@@ -845,7 +926,11 @@ int main( int argc, char * * argv )
 		}
 
 		// start now!
-		if ( renderTracks )
+		if ( renderTracks && renderStems )
+		{
+			r->renderStems( renderMixerStems );
+		}
+		else if ( renderTracks )
 		{
 			r->renderTracks();
 		}
@@ -31,6 +31,7 @@
 
 
 #include "TimeLineWidget.h"
+#include "AudioEngine.h"
 #include "embed.h"
 #include "NStateButton.h"
 #include "GuiApplication.h"
@@ -217,6 +218,7 @@ void TimeLineWidget::toggleAutoScroll( int _n )
 void TimeLineWidget::toggleLoopPoints( int _n )
 {
 	m_loopPoints = static_cast<LoopPointStates>( _n );
+	Engine::audioEngine()->markLiveActivity();
 	update();
 }
 
@@ -404,6 +406,7 @@ void TimeLineWidget::mouseMoveEvent( QMouseEvent* event )
 				if (m_action == MoveLoopBegin) { m_loopPos[0] -= offset; }
 				else { m_loopPos[1] += offset; }
 			}
+			Engine::audioEngine()->markLiveActivity();
 			update();
 			break;
 		}
@@ -98,6 +98,12 @@ ExportProjectDialog::ExportProjectDialog( const QString & _file_name,
 	compressionWidget->setVisible(false);
 #endif
 
+	// stems only make sense when exporting tracks individually
+	singlePassCB->setVisible( m_multiExport );
+	mixerStemsCB->setVisible( m_multiExport );
+	connect( singlePassCB, SIGNAL(toggled(bool)),
+			mixerStemsCB, SLOT(setEnabled(bool)));
+
 	connect( startButton, SIGNAL(clicked()),
 			this, SLOT(startBtnClicked()));
 }
@@ -199,7 +205,11 @@ void ExportProjectDialog::startExport()
 	connect( m_renderManager.get(), SIGNAL(finished()),
 			getGUI()->mainWindow(), SLOT(resetWindowTitle()));
 
-	if ( m_multiExport )
+	if ( m_multiExport && singlePassCB->isChecked() )
+	{
+		m_renderManager->renderStems( mixerStemsCB->isChecked() );
+	}
+	else if ( m_multiExport )
 	{
 		m_renderManager->renderTracks();
 	}
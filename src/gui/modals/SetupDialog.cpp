@@ -29,9 +29,11 @@
 #include <QLayout>
 #include <QLineEdit>
 #include <QScrollArea>
+#include <QSpinBox>
 
 #include "AudioDeviceSetupWidget.h"
 #include "AudioEngine.h"
+#include "AudioThreadSettings.h"
 #include "debug.h"
 #include "embed.h"
 #include "Engine.h"
@@ -138,6 +140,8 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 			"ui", "vstalwaysontop").toInt()),
 	m_disableAutoQuit(ConfigManager::inst()->value(
 			"ui", "disableautoquit", "1").toInt()),
+	m_pipelineRemotePlugins(ConfigManager::inst()->value(
+			"audioengine", "pipelineremoteplugins", "0").toInt()),
 	m_NaNHandler(ConfigManager::inst()->value(
 			"app", "nanhandler", "1").toInt()),
 	m_hqAudioDev(ConfigManager::inst()->value(
@@ -426,6 +430,18 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 
 	addLedCheckBox(tr("Keep effects running even without input"), plugins_tw, counter,
 		m_disableAutoQuit, SLOT(toggleDisableAutoQuit(bool)), false);
+	addLedCheckBox(tr("Run VST and ZynAddSubFX in parallel (one period latency)"), plugins_tw, counter,
+		m_pipelineRemotePlugins, SLOT(togglePipelineRemotePlugins(bool)), true);
+
+	// applies to instruments created afterwards
+	auto remoteInstancesLbl = new QLabel(tr("Remote plugins per process"), plugins_tw);
+	remoteInstancesLbl->setGeometry(XDelta, YDelta * ++counter, 220, 24);
+	m_remoteInstancesSpinBox = new QSpinBox(plugins_tw);
+	m_remoteInstancesSpinBox->setRange(1, 64);
+	m_remoteInstancesSpinBox->setValue(ConfigManager::inst()->value(
+			"audioengine", "remoteinstancesperprocess", "1").toInt());
+	m_remoteInstancesSpinBox->setGeometry(240, YDelta * counter, 110, 24);
+	++counter;
 
 	plugins_tw->setFixedHeight(YDelta + YDelta * counter);
 
@@ -552,7 +568,7 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 
 	// Buffer size tab.
 	auto bufferSize_tw = new TabWidget(tr("Buffer size"), audio_w);
-	bufferSize_tw->setFixedHeight(76);
+	bufferSize_tw->setFixedHeight(104);
 
 	m_bufferSizeSlider = new QSlider(Qt::Horizontal, bufferSize_tw);
 	m_bufferSizeSlider->setRange(1, 128);
@@ -564,8 +580,6 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 
 	connect(m_bufferSizeSlider, SIGNAL(valueChanged(int)),
 			this, SLOT(setBufferSize(int)));
-	connect(m_bufferSizeSlider, SIGNAL(valueChanged(int)),
-			this, SLOT(showRestartWarning()));
 
 	m_bufferSizeLbl = new QLabel(bufferSize_tw);
 	m_bufferSizeLbl->setGeometry(10, 40, 200, 24);
@@ -578,12 +592,71 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 	bufferSize_reset_btn->setToolTip(
 			tr("Reset to default value"));
 
+	auto renderAheadLbl = new QLabel(tr("Render ahead (periods, 0 = off)"), bufferSize_tw);
+	renderAheadLbl->setGeometry(10, 74, 220, 24);
+	m_renderAheadSpinBox = new QSpinBox(bufferSize_tw);
+	m_renderAheadSpinBox->setRange(0, 64);
+	m_renderAheadSpinBox->setValue(ConfigManager::inst()->value(
+			"audioengine", "renderahead", "0").toInt());
+	m_renderAheadSpinBox->setGeometry(240, 74, 110, 24);
+	m_renderAheadSpinBox->setToolTip(
+			tr("Render this many periods ahead of the audio device while "
+				"the song plays and nothing is played or edited live."));
+	connect(m_renderAheadSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(showRestartWarning()));
+
+
+	// Audio threads tab.
+	auto audioThreads_tw = new TabWidget(tr("Audio threads"), audio_w);
+	audioThreads_tw->setFixedHeight(150);
+
+	auto workersLbl = new QLabel(tr("Worker threads (0 = auto)"), audioThreads_tw);
+	workersLbl->setGeometry(10, 18, 220, 24);
+	m_workersSpinBox = new QSpinBox(audioThreads_tw);
+	m_workersSpinBox->setRange(0, 64);
+	m_workersSpinBox->setValue(ConfigManager::inst()->value(
+			"audioengine", "workers", "0").toInt());
+	m_workersSpinBox->setGeometry(240, 18, 110, 24);
+	connect(m_workersSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(showRestartWarning()));
+
+	auto cpuSetLbl = new QLabel(tr("CPUs (e.g. 2-5,8)"), audioThreads_tw);
+	cpuSetLbl->setGeometry(10, 46, 220, 24);
+	m_cpuSetLineEdit = new QLineEdit(ConfigManager::inst()->value(
+			"audioengine", "cpuset"), audioThreads_tw);
+	m_cpuSetLineEdit->setGeometry(240, 46, 110, 24);
+	m_cpuSetLineEdit->setToolTip(
+			tr("Pin the audio threads to these CPUs. Leave empty to use all CPUs."));
+	connect(m_cpuSetLineEdit, SIGNAL(textChanged(const QString&)),
+			this, SLOT(showRestartWarning()));
+
+	auto rtPriorityLbl = new QLabel(tr("Realtime priority (0 = off)"), audioThreads_tw);
+	rtPriorityLbl->setGeometry(10, 74, 220, 24);
+	m_rtPrioritySpinBox = new QSpinBox(audioThreads_tw);
+	m_rtPrioritySpinBox->setRange(0, 99);
+	m_rtPrioritySpinBox->setValue(ConfigManager::inst()->value(
+			"audioengine", "rtpriority", "0").toInt());
+	m_rtPrioritySpinBox->setGeometry(240, 74, 110, 24);
+	connect(m_rtPrioritySpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(showRestartWarning()));
+
+	// what the running audio threads actually got
+	const QStringList granted = AudioThreadSettings::grantedReport();
+	auto grantedLbl = new QLabel(audioThreads_tw);
+	grantedLbl->setGeometry(10, 102, 340, 44);
+	grantedLbl->setWordWrap(true);
+	grantedLbl->setText(granted.isEmpty()
+			? tr("Audio threads not started yet")
+			: granted.first());
+	grantedLbl->setToolTip(granted.join("\n"));
+
 
 	// Audio layout ordering.
 	audio_layout->addWidget(audioiface_tw);
 	audio_layout->addWidget(as_w);
 	audio_layout->addWidget(hqaudio);
 	audio_layout->addWidget(bufferSize_tw);
+	audio_layout->addWidget(audioThreads_tw);
 	audio_layout->addStretch();
 
 
@@ -919,6 +992,8 @@ void SetupDialog::accept()
 					QString::number(m_vstAlwaysOnTop));
 	ConfigManager::inst()->setValue("ui", "disableautoquit",
 					QString::number(m_disableAutoQuit));
+	ConfigManager::inst()->setValue("audioengine", "pipelineremoteplugins",
+					QString::number(m_pipelineRemotePlugins));
 	ConfigManager::inst()->setValue("audioengine", "audiodev",
 					m_audioIfaceNames[m_audioInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("app", "nanhandler",
@@ -927,6 +1002,18 @@ void SetupDialog::accept()
 					QString::number(m_hqAudioDev));
 	ConfigManager::inst()->setValue("audioengine", "framesperaudiobuffer",
 					QString::number(m_bufferSize));
+	// takes effect immediately, the audio device keeps its own buffer
+	Engine::audioEngine()->setFramesPerPeriod(m_bufferSize);
+	ConfigManager::inst()->setValue("audioengine", "renderahead",
+					QString::number(m_renderAheadSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "workers",
+					QString::number(m_workersSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "remoteinstancesperprocess",
+					QString::number(m_remoteInstancesSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "cpuset",
+					m_cpuSetLineEdit->text().trimmed());
+	ConfigManager::inst()->setValue("audioengine", "rtpriority",
+					QString::number(m_rtPrioritySpinBox->value()));
 	ConfigManager::inst()->setValue("audioengine", "mididev",
 					m_midiIfaceNames[m_midiInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("midi", "midiautoassign",
@@ -1116,6 +1203,12 @@ void SetupDialog::toggleDisableAutoQuit(bool enabled)
 }
 
 
+void SetupDialog::togglePipelineRemotePlugins(bool enabled)
+{
+	m_pipelineRemotePlugins = enabled;
+}
+
+
 
 
 // Audio settings slots.
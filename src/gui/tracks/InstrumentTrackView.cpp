@@ -27,9 +27,12 @@
 #include <QAction>
 #include <QApplication>
 #include <QDragEnterEvent>
+#include <QEventLoop>
 #include <QMdiArea>
 #include <QMdiSubWindow>
 #include <QMenu>
+#include <QMessageBox>
+#include <QProgressDialog>
 
 #include "AudioEngine.h"
 #include "ConfigManager.h"
@@ -45,6 +48,7 @@
 #include "MainWindow.h"
 #include "MidiClient.h"
 #include "MidiPortMenu.h"
+#include "TrackFreezer.h"
 #include "TrackLabelButton.h"
 
 
@@ -204,6 +208,47 @@ void InstrumentTrackView::toggleMidiCCRack()
 
 
 
+void InstrumentTrackView::toggleFrozen()
+{
+	if (model()->isFrozen())
+	{
+		model()->unfreeze();
+		return;
+	}
+
+	std::unique_ptr<FrozenAudio> audio;
+	{
+		TrackFreezer freezer(model());
+
+		QProgressDialog progress(tr("Freezing %1...").arg(model()->name()), tr("Cancel"), 0, 100,
+						getGUI()->mainWindow());
+		progress.setWindowModality(Qt::WindowModal);
+		progress.setMinimumDuration(0);
+		connect(&freezer, SIGNAL(progressChanged(int)), &progress, SLOT(setValue(int)));
+		connect(&progress, SIGNAL(canceled()), &freezer, SLOT(abortProcessing()));
+
+		QEventLoop loop;
+		connect(&freezer, SIGNAL(finished()), &loop, SLOT(quit()));
+		if (!freezer.startProcessing())
+		{
+			QMessageBox::warning(getGUI()->mainWindow(), tr("Freeze failed"),
+						tr("Could not create a temporary file for the frozen audio."));
+			return;
+		}
+		loop.exec();
+
+		audio = freezer.takeAudio();
+	}  // the freezer restores the audio device and the muted tracks
+
+	if (audio)
+	{
+		model()->freeze(std::move(audio));
+	}
+}
+
+
+
+
 InstrumentTrackWindow * InstrumentTrackView::topLevelInstrumentTrackWindow()
 {
 	InstrumentTrackWindow * w = nullptr;
@@ -341,6 +341,11 @@ void TrackOperationsWidget::updateMenu()
 	{
 		toMenu->addSeparator();
 		toMenu->addMenu(trackView->midiMenu());
+		if (trackView->model()->trackContainer() == Engine::getSong())
+		{
+			toMenu->addAction(trackView->model()->isFrozen() ? tr("Unfreeze") : tr("Freeze"),
+						trackView, SLOT(toggleFrozen()));
+		}
 	}
 	if( dynamic_cast<AutomationTrackView *>( m_trackView ) )
 	{
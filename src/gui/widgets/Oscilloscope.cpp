@@ -43,7 +43,7 @@ namespace lmms::gui
 Oscilloscope::Oscilloscope( QWidget * _p ) :
 	QWidget( _p ),
 	m_background( embed::getIconPixmap( "output_graph" ) ),
-	m_points( new QPointF[Engine::audioEngine()->framesPerPeriod()] ),
+	m_points( new QPointF[Engine::audioEngine()->maxFramesPerPeriod()] ),
 	m_active( false ),
 	m_normalColor(71, 253, 133),
 	m_clippingColor(255, 64, 64)
@@ -52,7 +52,7 @@ Oscilloscope::Oscilloscope( QWidget * _p ) :
 	setAttribute( Qt::WA_OpaquePaintEvent, true );
 	setActive( ConfigManager::inst()->value( "ui", "displaywaveform").toInt() );
 
-	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+	const fpp_t frames = Engine::audioEngine()->maxFramesPerPeriod();
 	m_buffer = new sampleFrame[frames];
 
 	BufferManager::clear( m_buffer, frames );
@@ -23,11 +23,16 @@
  */
 #include "InstrumentTrack.h"
 
+#include <algorithm>
+
 #include "AudioEngine.h"
 #include "AutomationClip.h"
 #include "ConfigManager.h"
 #include "ControllerConnection.h"
 #include "DataFile.h"
+#include "DummyInstrument.h"
+#include "FrozenPlayHandle.h"
+#include "InstrumentPlayHandle.h"
 #include "Mixer.h"
 #include "InstrumentTrackView.h"
 #include "Instrument.h"
@@ -57,6 +62,9 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_firstKeyModel(0, 0, NumKeys - 1, this, tr("First note")),
 	m_lastKeyModel(0, 0, NumKeys - 1, this, tr("Last note")),
 	m_hasAutoMidiDev( false ),
+	m_noteScheduleCursor( 0 ),
+	m_noteScheduleTick( -1 ),
+	m_noteScheduleDirty( true ),
 	m_volumeModel( DefaultVolume, MinVolume, MaxVolume, 0.1f, this, tr( "Volume" ) ),
 	m_panningModel( DefaultPanning, PanningLeft, PanningRight, 0.1f, this, tr( "Panning" ) ),
 	m_audioPort( tr( "unnamed_track" ), true, &m_volumeModel, &m_panningModel, &m_mutedModel ),
@@ -69,7 +77,8 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_arpeggio( this ),
 	m_noteStacking( this ),
 	m_piano(this),
-	m_microtuner()
+	m_microtuner(),
+	m_frozenPlayHandle( nullptr )
 {
 	m_pitchModel.setCenterValue( 0 );
 	m_panningModel.setCenterValue( DefaultPanning );
@@ -107,6 +116,8 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	connect(&m_pitchModel, SIGNAL(dataChanged()), this, SLOT(updatePitch()), Qt::DirectConnection);
 	connect(&m_pitchRangeModel, SIGNAL(dataChanged()), this, SLOT(updatePitchRange()), Qt::DirectConnection);
 	connect(&m_mixerChannelModel, SIGNAL(dataChanged()), this, SLOT(updateMixerChannel()), Qt::DirectConnection);
+	connect(Engine::audioEngine(), SIGNAL(sampleRateChanged()), this, SLOT(checkFrozenSampleRate()));
+	connect(this, SIGNAL(clipAdded(lmms::Clip*)), this, SLOT(watchClip(lmms::Clip*)), Qt::DirectConnection);
 }
 
 
@@ -209,6 +220,7 @@ InstrumentTrack::~InstrumentTrack()
 
 	// kill all running notes and the iph
 	silenceAllNotes( true );
+	dropFrozenAudio();
 
 	// now we're save deleting the instrument
 	if( m_instrument ) delete m_instrument;
@@ -324,6 +336,14 @@ void InstrumentTrack::processInEvent( const MidiEvent& event, const TimePos& tim
 		return;
 	}
 
+	// there's no instrument to play while frozen
+	if( isFrozen() )
+	{
+		return;
+	}
+
+	Engine::audioEngine()->markLiveActivity();
+
 	bool eventHandled = false;
 
 	switch( event.type() )
@@ -686,27 +706,19 @@ void InstrumentTrack::removeMidiPortNode( DataFile & _dataFile )
 bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 							const f_cnt_t _offset, int _clip_num )
 {
-	if( ! m_instrument || ! tryLock() )
-	{
-		return false;
-	}
-	const float frames_per_tick = Engine::framesPerTick();
-
-	clipVector clips;
-	class PatternTrack * pattern_track = nullptr;
-	if( _clip_num >= 0 )
+	if( isFrozen() )
 	{
-		Clip * clip = getClip( _clip_num );
-		clips.push_back( clip );
-		if (trackContainer() == Engine::patternStore())
+		// only song playback has been rendered
+		if( _clip_num < 0 )
 		{
-			pattern_track = PatternTrack::findPatternTrack(_clip_num);
+			m_frozenPlayHandle->tickStarted( _start.getTicks(), _offset );
 		}
+		return false;
 	}
-	else
+
+	if( ! m_instrument || ! tryLock() )
 	{
-		getClipsInRange( clips, _start, _start + static_cast<int>(
-					_frames / frames_per_tick ) );
+		return false;
 	}
 
 	// Handle automation: detuning
@@ -715,71 +727,146 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 		processHandle->processTimePos(_start);
 	}
 
-	if ( clips.size() == 0 )
-	{
-		unlock();
-		return false;
-	}
-
 	bool played_a_note = false;	// will be return variable
 
-	for (const auto& clip : clips)
+	// A MIDI clip playing in the Piano Roll window will always play
+	const bool playMuted = Engine::getSong()->playMode() == Song::Mode_PlayMidiClip;
+
+	if( _clip_num < 0 )
 	{
-		auto c = dynamic_cast<MidiClip*>(clip);
-		// everything which is not a MIDI clip won't be played
-		// A MIDI clip playing in the Piano Roll window will always play
-		if (c == nullptr || (Engine::getSong()->playMode() != Song::Mode_PlayMidiClip && clip->isMuted()))
+		if( m_noteScheduleDirty.exchange( false ) )
 		{
-			continue;
+			compileNoteSchedule();
 		}
-		TimePos cur_start = _start;
-		if( _clip_num < 0 )
+
+		// the song plays tick after tick, the cursor only has to be
+		// searched for after jumps and loops
+		const tick_t tick = _start.getTicks();
+		if( tick != m_noteScheduleTick )
 		{
-			cur_start -= c->startPosition();
+			m_noteScheduleCursor = std::lower_bound( m_noteSchedule.begin(), m_noteSchedule.end(), tick,
+				[]( const ScheduledNote & n, tick_t t ) { return n.tick < t; } ) - m_noteSchedule.begin();
 		}
+		m_noteScheduleTick = tick + 1;
 
-		// get all notes from the given clip...
-		const NoteVector & notes = c->notes();
-		// ...and set our index to zero
-		NoteVector::ConstIterator nit = notes.begin();
-
-		// very effective algorithm for playing notes that are
-		// posated within the current sample-frame
-
-
-		if( cur_start > 0 )
+		for( ; m_noteScheduleCursor < m_noteSchedule.size() &&
+			m_noteSchedule[m_noteScheduleCursor].tick == tick; ++m_noteScheduleCursor )
 		{
-			// skip notes which are posated before start-bar
-			while( nit != notes.end() && ( *nit )->pos() < cur_start )
+			const ScheduledNote & n = m_noteSchedule[m_noteScheduleCursor];
+			if( playMuted || !n.clip->isMuted() )
 			{
-				++nit;
+				playNote( n.clip, *n.note, _offset, true, nullptr );
+				played_a_note = true;
 			}
 		}
+		unlock();
+		return played_a_note;
+	}
+
+	auto c = dynamic_cast<MidiClip*>( getClip( _clip_num ) );
+	// everything which is not a MIDI clip won't be played
+	if( c == nullptr || ( !playMuted && c->isMuted() ) )
+	{
+		unlock();
+		return false;
+	}
+
+	class PatternTrack * pattern_track = nullptr;
+	if (trackContainer() == Engine::patternStore())
+	{
+		pattern_track = PatternTrack::findPatternTrack(_clip_num);
+	}
+
+	// the notes are sorted by position, skip the ones before _start
+	const NoteVector & notes = c->notes();
+	NoteVector::ConstIterator nit = std::lower_bound( notes.begin(), notes.end(), _start,
+		[]( const Note * n, const TimePos & pos ) { return n->pos() < pos; } );
+
+	for( ; nit != notes.end() && ( *nit )->pos() == _start; ++nit )
+	{
+		playNote( c, **nit, _offset, false, pattern_track );
+		played_a_note = true;
+	}
+	unlock();
+	return played_a_note;
+}
+
+
+
+
+void InstrumentTrack::playNote( MidiClip* clip, const Note& note, f_cnt_t offset, bool inSong, PatternTrack* patternTrack )
+{
+	const f_cnt_t note_frames = note.length().frames( Engine::framesPerTick() );
+
+	NotePlayHandle* notePlayHandle = NotePlayHandleManager::acquire( this, offset, note_frames, note );
+	notePlayHandle->setPatternTrack( patternTrack );
+	// are we playing global song?
+	if( inSong )
+	{
+		// then set song-global offset of clip in order to
+		// properly perform the note detuning
+		notePlayHandle->setSongGlobalParentOffset( clip->startPosition() );
+	}
+
+	Engine::audioEngine()->addPlayHandle( notePlayHandle );
+}
+
+
+
 
-		Note * cur_note;
-		while( nit != notes.end() &&
-					( cur_note = *nit )->pos() == cur_start )
+void InstrumentTrack::compileNoteSchedule()
+{
+	m_noteSchedule.clear();
+	m_noteScheduleTick = -1;
+
+	for( Clip* clip : getClips() )
+	{
+		auto c = dynamic_cast<MidiClip*>( clip );
+		if( c == nullptr )
 		{
-			const f_cnt_t note_frames =
-				cur_note->length().frames( frames_per_tick );
+			continue;
+		}
 
-			NotePlayHandle* notePlayHandle = NotePlayHandleManager::acquire( this, _offset, note_frames, *cur_note );
-			notePlayHandle->setPatternTrack(pattern_track);
-			// are we playing global song?
-			if( _clip_num < 0 )
+		// a clip plays the notes from its start up to and including
+		// its end
+		const tick_t start = c->startPosition();
+		for( Note* note : c->notes() )
+		{
+			if( note->pos() >= 0 && note->pos() <= c->length() )
 			{
-				// then set song-global offset of clip in order to
-				// properly perform the note detuning
-				notePlayHandle->setSongGlobalParentOffset( c->startPosition() );
+				m_noteSchedule.push_back( { start + note->pos(), c, note } );
 			}
-
-			Engine::audioEngine()->addPlayHandle( notePlayHandle );
-			played_a_note = true;
-			++nit;
 		}
 	}
-	unlock();
-	return played_a_note;
+
+	// notes of the same tick are played in the order of their clips'
+	// positions, as before
+	std::stable_sort( m_noteSchedule.begin(), m_noteSchedule.end(),
+		[]( const ScheduledNote & a, const ScheduledNote & b )
+		{
+			return a.tick < b.tick ||
+				( a.tick == b.tick && a.clip->startPosition() < b.clip->startPosition() );
+		} );
+}
+
+
+
+
+void InstrumentTrack::invalidateNoteSchedule()
+{
+	m_noteScheduleDirty = true;
+}
+
+
+
+
+void InstrumentTrack::watchClip( Clip* clip )
+{
+	connect( clip, SIGNAL(positionChanged()), this, SLOT(invalidateNoteSchedule()), Qt::DirectConnection );
+	connect( clip, SIGNAL(lengthChanged()), this, SLOT(invalidateNoteSchedule()), Qt::DirectConnection );
+	connect( clip, SIGNAL(dataChanged()), this, SLOT(invalidateNoteSchedule()), Qt::DirectConnection );
+	connect( clip, SIGNAL(destroyedClip()), this, SLOT(invalidateNoteSchedule()), Qt::DirectConnection );
+	invalidateNoteSchedule();
 }
 
 
@@ -826,15 +913,14 @@ void InstrumentTrack::saveTrackSpecificSettings( QDomDocument& doc, QDomElement
 		m_midiCCModel[i]->saveSettings(doc, midiCC, "cc" + QString::number(i));
 	}
 
-	if( m_instrument != nullptr )
+	if( !m_frozenInstrument.documentElement().isNull() )
 	{
-		QDomElement i = doc.createElement( "instrument" );
-		i.setAttribute( "name", m_instrument->descriptor()->name );
-		QDomElement ins = m_instrument->saveState( doc, i );
-		if(m_instrument->key().isValid()) {
-			ins.appendChild( m_instrument->key().saveXML( doc ) );
-		}
-		thisElement.appendChild( i );
+		// the instrument is unloaded, save what it had been
+		thisElement.appendChild( doc.importNode( m_frozenInstrument.documentElement(), true ) );
+	}
+	else
+	{
+		saveInstrument( doc, thisElement );
 	}
 	m_soundShaping.saveState( doc, thisElement );
 	m_noteStacking.saveState( doc, thisElement );
@@ -863,6 +949,7 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 {
 	// don't delete instrument in preview mode if it's the same
 	// we can't do this for other situations due to some issues with linked models
+	unfreeze();
 	bool reuseInstrument = m_previewMode && m_instrument && m_instrument->nodeName() == getSavedInstrumentName(thisElement);
 	// remove the InstrumentPlayHandle if and only if we need to delete the instrument
 	silenceAllNotes(!reuseInstrument);
@@ -932,6 +1019,7 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 					m_instrument = Instrument::instantiate(
 						node.toElement().attribute("name"), this, &key);
 					m_instrument->restoreState(node.firstChildElement());
+					m_audioPort.setInputLatency(m_instrument->latency());
 					emit instrumentChanged();
 				}
 			}
@@ -957,6 +1045,7 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 				{
 					m_instrument->restoreState(node.toElement());
 				}
+				m_audioPort.setInputLatency(m_instrument->latency());
 				emit instrumentChanged();
 			}
 		}
@@ -1026,12 +1115,14 @@ Instrument * InstrumentTrack::loadInstrument(const QString & _plugin_name,
 	if(keyFromDnd)
 		Q_ASSERT(!key);
 
+	unfreeze();
 	silenceAllNotes( true );
 
 	lock();
 	delete m_instrument;
 	m_instrument = Instrument::instantiate(_plugin_name, this,
 					key, keyFromDnd);
+	m_audioPort.setInputLatency(m_instrument->latency());
 	unlock();
 	setName(m_instrument->displayName());
 
@@ -1042,6 +1133,134 @@ Instrument * InstrumentTrack::loadInstrument(const QString & _plugin_name,
 
 
 
+
+void InstrumentTrack::freeze( std::unique_ptr<FrozenAudio> audio )
+{
+	unfreeze();
+
+	// the instrument isn't played anymore, stop its notes and its
+	// instrument play handle
+	silenceAllNotes( true );
+
+	auto handle = new FrozenPlayHandle( this, std::move( audio ) );
+	Engine::audioEngine()->requestChangeInModel();
+	if( Engine::audioEngine()->addPlayHandle( handle ) )
+	{
+		m_frozenPlayHandle = handle;
+	}
+	Engine::audioEngine()->doneChangeInModel();
+
+	if( !isFrozen() || m_instrument == nullptr )
+	{
+		return;
+	}
+
+	// unloading the instrument would disconnect its automation
+	for( const AutomatableModel * model : m_instrument->findChildren<AutomatableModel *>() )
+	{
+		if( model->isAutomatedOrControlled() )
+		{
+			return;
+		}
+	}
+
+	saveInstrument( m_frozenInstrument, m_frozenInstrument );
+
+	// the input latency of the port stays, the frozen audio lags behind
+	// the song like the instrument's output did
+	lock();
+	delete m_instrument;
+	m_instrument = new DummyInstrument( this );
+	unlock();
+
+	emit instrumentChanged();
+}
+
+
+
+
+void InstrumentTrack::unfreeze()
+{
+	if( !isFrozen() )
+	{
+		return;
+	}
+
+	dropFrozenAudio();
+
+	const QDomElement node = m_frozenInstrument.documentElement();
+	if( !node.isNull() )
+	{
+		using PluginKey = Plugin::Descriptor::SubPluginFeatures::Key;
+		PluginKey key( node.elementsByTagName( "key" ).item( 0 ).toElement() );
+
+		lock();
+		delete m_instrument;
+		m_instrument = Instrument::instantiate( node.attribute( "name" ), this, &key );
+		m_instrument->restoreState( node.firstChildElement() );
+		m_audioPort.setInputLatency( m_instrument->latency() );
+		unlock();
+
+		m_frozenInstrument.clear();
+		emit instrumentChanged();
+	}
+	else if( m_instrument != nullptr && m_instrument->flags().testFlag( Instrument::IsSingleStreamed ) )
+	{
+		// the instrument has been kept, it only needs its play handle back
+		Engine::audioEngine()->addPlayHandle( new InstrumentPlayHandle( m_instrument, this ) );
+	}
+}
+
+
+
+
+void InstrumentTrack::checkFrozenSampleRate()
+{
+	// the frozen audio can't be resampled while playing it
+	if( isFrozen() && m_frozenPlayHandle->audio()->sampleRate() !=
+					Engine::audioEngine()->processingSampleRate() )
+	{
+		unfreeze();
+	}
+}
+
+
+
+
+void InstrumentTrack::saveInstrument( QDomDocument & doc, QDomNode & parent )
+{
+	if( m_instrument != nullptr )
+	{
+		QDomElement i = doc.createElement( "instrument" );
+		i.setAttribute( "name", m_instrument->descriptor()->name );
+		QDomElement ins = m_instrument->saveState( doc, i );
+		if(m_instrument->key().isValid()) {
+			ins.appendChild( m_instrument->key().saveXML( doc ) );
+		}
+		parent.appendChild( i );
+	}
+}
+
+
+
+
+void InstrumentTrack::dropFrozenAudio()
+{
+	if( m_frozenPlayHandle == nullptr )
+	{
+		return;
+	}
+
+	Engine::audioEngine()->requestChangeInModel();
+	// removed right away, as the track and its audio port may be deleted
+	// next, which the handle plays through
+	Engine::audioEngine()->removePlayHandlesOfTypes( this, PlayHandle::TypeFrozenPlayHandle );
+	m_frozenPlayHandle = nullptr;
+	Engine::audioEngine()->doneChangeInModel();
+}
+
+
+
 InstrumentTrack *InstrumentTrack::s_autoAssignedTrack = nullptr;
 
 /*! \brief Automatically assign a midi controller to this track, based on the midiautoassign setting
@@ -93,6 +93,9 @@ MidiClip::~MidiClip()
 {
 	emit destroyedMidiClip( this );
 
+	// song playback must not get to our notes anymore
+	m_instrumentTrack->invalidateNoteSchedule();
+
 	for (const auto& note : m_notes)
 	{
 		delete note;
@@ -229,6 +232,8 @@ void MidiClip::removeNote( Note * _note_to_del )
 		}
 		++it;
 	}
+	// before anybody else can lock the track, the note is gone
+	instrumentTrack()->invalidateNoteSchedule();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -258,6 +263,7 @@ void MidiClip::rearrangeAllNotes()
 {
 	// sort notes by start time
 	std::sort(m_notes.begin(), m_notes.end(), Note::lessThan);
+	instrumentTrack()->invalidateNoteSchedule();
 }
 
 
@@ -270,6 +276,7 @@ void MidiClip::clearNotes()
 		delete note;
 	}
 	m_notes.clear();
+	instrumentTrack()->invalidateNoteSchedule();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -98,10 +98,29 @@ bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 	}
 	else
 	{
+		// only the clips around _start can be playing, after edits and
+		// jumps the others may still think they are
+		bool restarted;
+		m_endedClips.clear();
+		const clipVector & current = playbackClips( _start, _start, &restarted, &m_endedClips );
+		if( restarted )
+		{
+			for( Clip * clip : getClips() )
+			{
+				if( _start < clip->startPosition() || _start >= clip->endPosition() )
+				{
+					static_cast<SampleClip*>( clip )->setIsPlaying( false );
+				}
+			}
+		}
+		for( Clip * clip : m_endedClips )
+		{
+			static_cast<SampleClip*>( clip )->setIsPlaying( false );
+		}
+
 		bool nowPlaying = false;
-		for( int i = 0; i < numOfClips(); ++i )
+		for( Clip * clip : current )
 		{
-			Clip * clip = getClip( i );
 			auto sClip = dynamic_cast<SampleClip*>(clip);
 
 			if( _start >= sClip->startPosition() && _start < sClip->endPosition() )
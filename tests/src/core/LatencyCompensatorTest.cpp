@@ -0,0 +1,137 @@
+/*
+ * LatencyCompensatorTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <vector>
+
+#include "LatencyCompensator.h"
+
+using namespace lmms;
+
+class LatencyCompensatorTest : QTestSuite
+{
+	Q_OBJECT
+
+	//! Frame @p f of a signal which is never silent
+	static sampleFrame signal(int f)
+	{
+		return { static_cast<float>(f + 1), -static_cast<float>(f + 1) };
+	}
+
+	//! Feeds @p total frames of signal() in periods of @p period frames and
+	//! checks that each comes out @p delay frames later
+	static void checkDelay(LatencyCompensator& compensator, int delay, int period, int total)
+	{
+		std::vector<sampleFrame> input(period);
+		for (int start = 0; start < total; start += period)
+		{
+			for (int f = 0; f < period; ++f) { input[f] = signal(start + f); }
+			// only the first period may be reported as silent, and only if
+			// nothing of it passes through
+			const bool hasOutput = compensator.process(input.data(), period, true);
+			QCOMPARE(hasOutput, start > 0 || period > delay);
+			if (!hasOutput) { continue; }
+
+			for (int f = 0; f < period; ++f)
+			{
+				const int from = start + f - delay;
+				const sampleFrame expected = from >= 0 ? signal(from) : sampleFrame{ 0.0f, 0.0f };
+				QCOMPARE(compensator.output()[f][0], expected[0]);
+				QCOMPARE(compensator.output()[f][1], expected[1]);
+			}
+		}
+	}
+
+private slots:
+	void ReserveTest()
+	{
+		LatencyCompensator compensator;
+		QVERIFY(!compensator.setDelay(100));
+		QCOMPARE(compensator.delay(), 0);
+		QVERIFY(compensator.needsReserve());
+
+		compensator.reserve();
+		QCOMPARE(compensator.delay(), 100);
+		QVERIFY(!compensator.needsReserve());
+
+		// shorter delays use the existing delay line
+		QVERIFY(compensator.setDelay(30));
+		QCOMPARE(compensator.delay(), 30);
+		QCOMPARE(compensator.capacity(), 100);
+
+		QVERIFY(!compensator.setDelay(150));
+		QCOMPARE(compensator.delay(), 100);
+		QVERIFY(compensator.setDelay(0));
+		QVERIFY(!compensator.needsReserve());
+	}
+
+	void DelayTest()
+	{
+		// delays shorter and longer than a period, crossing the end of the
+		// delay line within a period
+		for (int delay : { 1, 5, 64, 100, 257 })
+		{
+			LatencyCompensator compensator;
+			compensator.setDelay(delay);
+			compensator.reserve();
+			checkDelay(compensator, delay, 64, 1024);
+		}
+	}
+
+	void ShorterDelayTest()
+	{
+		LatencyCompensator compensator;
+		compensator.setDelay(200);
+		compensator.reserve();
+		checkDelay(compensator, 200, 64, 512);
+
+		// the delay line gets cleared when the delay changes
+		QVERIFY(compensator.setDelay(37));
+		checkDelay(compensator, 37, 64, 512);
+	}
+
+	void TailTest()
+	{
+		const int delay = 100;
+		const int period = 64;
+		LatencyCompensator compensator;
+		compensator.setDelay(delay);
+		compensator.reserve();
+
+		std::vector<sampleFrame> input(period, signal(0));
+		QVERIFY(!compensator.process(input.data(), period, true));
+
+		// what is still delayed comes out after the input stopped
+		QVERIFY(compensator.process(input.data(), period, false));
+		QCOMPARE(compensator.output()[delay - period - 1][0], 0.0f);
+		QCOMPARE(compensator.output()[delay - period][0], signal(0)[0]);
+		QVERIFY(compensator.process(input.data(), period, false));
+		QCOMPARE(compensator.output()[delay - period - 1][0], signal(0)[0]);
+		QCOMPARE(compensator.output()[delay - period][0], 0.0f);
+		QVERIFY(!compensator.process(input.data(), period, false));
+	}
+} LatencyCompensatorTests;
+
+#include "LatencyCompensatorTest.moc"
@@ -0,0 +1,220 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "ValueBuffer.h"
+
+using namespace lmms;
+
+using Buffer = std::vector<sampleFrame>;
+
+//! Compares the optimized versions of the mixing functions bit by bit with
+//! the generic ones, for all instruction sets the CPU supports
+class MixHelpersTest : QTestSuite
+{
+	Q_OBJECT
+
+	using Set = MixHelpers::InstructionSet;
+
+	// frame counts including ones which aren't a multiple of any vector size
+	const std::vector<int> m_frameCounts = { 0, 1, 3, 8, 15, 64, 257 };
+
+	static Buffer makeBuffer(int frames, int seed, bool withBadValues)
+	{
+		Buffer buf(frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			// deterministic, irregular values in [-1500, 1500]
+			buf[f][0] = std::sin(f * 0.73f + seed) * 1500.0f;
+			buf[f][1] = std::cos(f * 1.31f + seed) * 0.001f;
+		}
+		if (frames > 2)
+		{
+			buf[0][0] = -0.0f;
+		}
+		if (withBadValues && frames > 4)
+		{
+			buf[frames / 2][1] = std::numeric_limits<float>::quiet_NaN();
+			buf[frames - 1][0] = -std::numeric_limits<float>::infinity();
+		}
+		return buf;
+	}
+
+	static ValueBuffer makeValueBuffer(int frames, float scale)
+	{
+		ValueBuffer buf(frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			buf.values()[f] = std::sin(f * 0.37f) * scale;
+		}
+		return buf;
+	}
+
+	static bool isBitExact(const Buffer& a, const Buffer& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(sampleFrame)) == 0;
+	}
+
+	//! Runs @p op on a fresh buffer with each instruction set and compares
+	//! the results with the generic version's
+	void compareWithGeneric(const char* name, const std::function<void(Buffer&, int)>& op)
+	{
+		const Set sets[] = { Set::SSE2, Set::AVX2, Set::AVX512, Set::NEON };
+		for (bool nanHandler : { false, true })
+		{
+			MixHelpers::setNaNHandler(nanHandler);
+			for (int frames : m_frameCounts)
+			{
+				QVERIFY(MixHelpers::setInstructionSet(Set::Generic));
+				Buffer expected;
+				op(expected, frames);
+
+				for (Set set : sets)
+				{
+					if (!MixHelpers::setInstructionSet(set)) { continue; }
+					Buffer actual;
+					op(actual, frames);
+					if (!isBitExact(expected, actual))
+					{
+						QFAIL(qPrintable(QString("%1 differs for instruction set %2 with %3 frames")
+							.arg(name).arg(static_cast<int>(set)).arg(frames)));
+					}
+				}
+			}
+		}
+	}
+
+private slots:
+	void init()
+	{
+		m_previousSet = MixHelpers::instructionSet();
+		m_previousNaNHandler = MixHelpers::useNaNHandler();
+	}
+
+	void cleanup()
+	{
+		MixHelpers::setInstructionSet(m_previousSet);
+		MixHelpers::setNaNHandler(m_previousNaNHandler);
+	}
+
+	void GenericIsAlwaysSupportedTest()
+	{
+		QVERIFY(MixHelpers::isSupported(Set::Generic));
+		QVERIFY(MixHelpers::isSupported(MixHelpers::instructionSet()));
+	}
+
+	void AddTests()
+	{
+		compareWithGeneric("add", [](Buffer& out, int frames) {
+			out = makeBuffer(frames, 1, false);
+			const Buffer src = makeBuffer(frames, 2, true);
+			MixHelpers::add(out.data(), src.data(), frames);
+		});
+		compareWithGeneric("addMultiplied", [](Buffer& out, int frames) {
+			out = makeBuffer(frames, 1, false);
+			const Buffer src = makeBuffer(frames, 2, false);
+			MixHelpers::addMultiplied(out.data(), src.data(), 0.3f, frames);
+		});
+		compareWithGeneric("addSanitizedMultiplied", [](Buffer& out, int frames) {
+			out = makeBuffer(frames, 1, false);
+			const Buffer src = makeBuffer(frames, 2, true);
+			MixHelpers::addSanitizedMultiplied(out.data(), src.data(), 0.7f, frames);
+		});
+	}
+
+	void AddByBufferTests()
+	{
+		compareWithGeneric("addSanitizedMultipliedByBuffer", [](Buffer& out, int frames) {
+			out = makeBuffer(frames, 1, false);
+			const Buffer src = makeBuffer(frames, 2, true);
+			ValueBuffer coeffs = makeValueBuffer(frames, 1.5f);
+			MixHelpers::addSanitizedMultipliedByBuffer(out.data(), src.data(), 0.7f, &coeffs, frames);
+		});
+		compareWithGeneric("addSanitizedMultipliedByBuffers", [](Buffer& out, int frames) {
+			out = makeBuffer(frames, 1, false);
+			const Buffer src = makeBuffer(frames, 2, true);
+			ValueBuffer coeffs1 = makeValueBuffer(frames, 1.5f);
+			ValueBuffer coeffs2 = makeValueBuffer(frames, -0.25f);
+			MixHelpers::addSanitizedMultipliedByBuffers(out.data(), src.data(), &coeffs1, &coeffs2, frames);
+		});
+	}
+
+	void VolumeAndPanningTests()
+	{
+		for (int useBuffers = 0; useBuffers < 4; ++useBuffers)
+		{
+			compareWithGeneric("multiplyByVolumeAndPanning", [useBuffers](Buffer& out, int frames) {
+				out = makeBuffer(frames, 3, false);
+				ValueBuffer volume = makeValueBuffer(frames, 150.0f);
+				ValueBuffer panning = makeValueBuffer(frames, 100.0f);
+				MixHelpers::multiplyByVolumeAndPanning(out.data(),
+					80.0f, (useBuffers & 1) ? &volume : nullptr,
+					-30.0f, (useBuffers & 2) ? &panning : nullptr, frames);
+			});
+		}
+	}
+
+	void SanitizeAndSilenceTests()
+	{
+		for (bool withBadValues : { false, true })
+		{
+			compareWithGeneric("sanitize", [withBadValues](Buffer& out, int frames) {
+				out = makeBuffer(frames, 4, withBadValues);
+				const bool found = MixHelpers::sanitize(out.data(), frames);
+				out.push_back({ found ? 1.0f : 0.0f, 0.0f });
+			});
+		}
+		compareWithGeneric("isSilent", [](Buffer& out, int frames) {
+			Buffer quiet(frames);
+			if (frames > 0) { quiet[frames - 1][1] = 0.000001f; }
+			const Buffer loud = makeBuffer(frames, 5, false);
+			out = { { MixHelpers::isSilent(quiet.data(), frames) ? 1.0f : 0.0f,
+				MixHelpers::isSilent(loud.data(), frames) ? 1.0f : 0.0f } };
+		});
+	}
+
+	void PeakValuesTests()
+	{
+		compareWithGeneric("peakValues", [](Buffer& out, int frames) {
+			const Buffer src = makeBuffer(frames, 6, true);
+			float left, right;
+			MixHelpers::peakValues(src.data(), frames, left, right);
+			out = { { left, right } };
+		});
+	}
+
+private:
+	Set m_previousSet;
+	bool m_previousNaNHandler;
+} MixHelpersTests;
+
+#include "MixHelpersTest.moc"
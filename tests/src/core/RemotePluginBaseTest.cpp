@@ -0,0 +1,121 @@
+/*
+ * RemotePluginBaseTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <string>
+#include <thread>
+
+#include "RemotePluginBase.h"
+
+#ifndef SYNC_WITH_SHM_FIFO
+#include <sys/socket.h>
+#endif
+
+using namespace lmms;
+
+//! Messages over a socket, which are written whole and read through a
+//! buffer, so several of them may arrive with one read
+class RemotePluginBaseTest : QTestSuite
+{
+	Q_OBJECT
+
+	class Endpoint : public RemotePluginBase
+	{
+	public:
+#ifndef SYNC_WITH_SHM_FIFO
+		~Endpoint() override
+		{
+			if (m_socket != -1) { close(m_socket); }
+		}
+
+		using RemotePluginBase::setSocket;
+#endif
+
+		bool processMessage(const message&) override
+		{
+			return true;
+		}
+	};
+
+	//! Message @p n, with a string bigger than the receive buffer now and then
+	static RemotePluginBase::message makeMessage(int n)
+	{
+		RemotePluginBase::message m(n);
+		m.addInt(n * 3);
+		m.addString(n % 50 == 0 ? std::string(100000, static_cast<char>('a' + n % 26)) : "x");
+		if (n % 2) { m.addFloat(0.5f); }
+		return m;
+	}
+
+	static bool isMessage(const RemotePluginBase::message& m, int n)
+	{
+		const RemotePluginBase::message expected = makeMessage(n);
+		return m.id == expected.id && m.data == expected.data;
+	}
+
+private slots:
+	void SocketMessageTest()
+	{
+#ifdef SYNC_WITH_SHM_FIFO
+		QSKIP("Remote plugins sync through shmFifo here");
+#else
+		int sockets[2];
+		QCOMPARE(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+		Endpoint out;
+		Endpoint in;
+		out.setSocket(sockets[0]);
+		in.setSocket(sockets[1]);
+
+		const int count = 500;
+		std::thread writer([&out]() {
+			for (int n = 0; n < count; ++n) { out.sendMessage(makeMessage(n)); }
+		});
+		bool intact = true;
+		for (int n = 0; n < count; ++n)
+		{
+			intact = isMessage(in.receiveMessage(), n) && intact;
+		}
+		writer.join();
+		QVERIFY(intact);
+		QVERIFY(!in.isInvalid());
+
+		// messages which arrived with an earlier read are still left
+		out.sendMessage(makeMessage(1));
+		out.sendMessage(makeMessage(2));
+		QVERIFY(isMessage(in.receiveMessage(), 1));
+		QVERIFY(in.messagesLeft());
+		QVERIFY(isMessage(in.receiveMessage(), 2));
+		QVERIFY(!in.messagesLeft());
+
+		// a closed channel invalidates the reading side
+		close(sockets[0]);
+		out.setSocket(-1);
+		QCOMPARE(in.receiveMessage().id, static_cast<int>(RemotePluginBase::IdUndefined));
+		QVERIFY(in.isInvalid());
+#endif
+	}
+} RemotePluginBaseTests;
+
+#include "RemotePluginBaseTest.moc"
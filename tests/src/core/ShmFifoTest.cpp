@@ -0,0 +1,158 @@
+/*
+ * ShmFifoTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "ShmFifo.h"
+
+using namespace lmms;
+
+//! The writing and the reading side are the master and the client of the
+//! same FIFO, like the host and a remote plugin
+class ShmFifoTest : QTestSuite
+{
+	Q_OBJECT
+
+	// not a divisor of SHM_FIFO_SIZE, so messages end up crossing the end
+	// of the ring
+	static constexpr int MessageSize = 100003;
+
+	static std::string makeMessage(int n)
+	{
+		std::string s(MessageSize, '\0');
+		for (int i = 0; i < MessageSize; ++i)
+		{
+			s[i] = static_cast<char>((i * 7 + n * 13) & 0xff);
+		}
+		return s;
+	}
+
+	static void send(shmFifo& fifo, int n)
+	{
+		fifo.lock();
+		fifo.writeInt(n);
+		fifo.writeString(makeMessage(n));
+		fifo.unlock();
+		fifo.messageSent();
+	}
+
+	//! Returns whether message @p n arrived intact
+	static bool receive(shmFifo& fifo, int n)
+	{
+		fifo.waitForMessage();
+		fifo.lock();
+		const int id = fifo.readInt();
+		const std::string data = fifo.readString();
+		fifo.unlock();
+		return id == n && data == makeMessage(n);
+	}
+
+private slots:
+	void WrapAroundTest()
+	{
+		shmFifo out;
+		shmFifo in(out.shmKey());
+
+		// more than twice the size of the ring, one message at a time
+		const int count = 2 * SHM_FIFO_SIZE / MessageSize + 2;
+		for (int n = 0; n < count; ++n)
+		{
+			send(out, n);
+			QVERIFY(in.messagesLeft());
+			QVERIFY(receive(in, n));
+			QVERIFY(!in.messagesLeft());
+		}
+	}
+
+	void FullFifoTest()
+	{
+		shmFifo out;
+		shmFifo in(out.shmKey());
+
+		// the writer has to wait for the reader to make room again
+		const int count = 4 * SHM_FIFO_SIZE / MessageSize;
+		std::thread writer([&out, count]() {
+			for (int n = 0; n < count; ++n) { send(out, n); }
+		});
+		bool intact = true;
+		for (int n = 0; n < count; ++n)
+		{
+			intact = receive(in, n) && intact;
+		}
+		writer.join();
+		QVERIFY(intact);
+		QVERIFY(!in.messagesLeft());
+	}
+
+	void SleepAndWakeTest()
+	{
+		shmFifo out;
+		shmFifo in(out.shmKey());
+
+		// the reader finds no message and sleeps on the semaphore until
+		// the writer announces one
+		std::atomic_bool received(false);
+		std::atomic_bool intact(false);
+		std::thread reader([&in, &received, &intact]() {
+			intact = receive(in, 1);
+			received = true;
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		const bool receivedEarly = received;
+
+		send(out, 1);
+		reader.join();
+		QVERIFY(!receivedEarly);
+		QVERIFY(intact);
+
+		// messages sent while the reader is busy are only counted
+		send(out, 2);
+		send(out, 3);
+		QVERIFY(in.messagesLeft());
+		QVERIFY(receive(in, 2));
+		QVERIFY(in.messagesLeft());
+		QVERIFY(receive(in, 3));
+		QVERIFY(!in.messagesLeft());
+
+		// and the reader sleeps again afterwards
+		received = false;
+		std::thread reader2([&in, &received, &intact]() {
+			intact = receive(in, 4);
+			received = true;
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		const bool receivedEarly2 = received;
+		send(out, 4);
+		reader2.join();
+		QVERIFY(!receivedEarly2);
+		QVERIFY(intact);
+	}
+} ShmFifoTests;
+
+#include "ShmFifoTest.moc"
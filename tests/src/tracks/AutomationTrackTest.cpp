@@ -115,6 +115,51 @@ private slots:
 		QCOMPARE(song->automatedValuesAt(150)[&model], 0.5f);
 	}
 
+	void testClipsAcrossTracks()
+	{
+		using namespace lmms;
+
+		FloatModel model;
+
+		auto song = Engine::getSong();
+		AutomationTrack track1(song);
+		AutomationTrack track2(song);
+
+		// the clip starting last takes precedence, whatever track it's on
+		AutomationClip c1(&track1);
+		c1.setProgressionType(AutomationClip::DiscreteProgression);
+		c1.putValue(0, 0.1, false);
+		c1.movePosition(0);
+		c1.addObject(&model);
+
+		AutomationClip c2(&track2);
+		c2.setProgressionType(AutomationClip::DiscreteProgression);
+		c2.putValue(0, 0.2, false);
+		c2.movePosition(100);
+		c2.addObject(&model);
+
+		AutomationClip c3(&track1);
+		c3.setProgressionType(AutomationClip::DiscreteProgression);
+		c3.putValue(0, 0.3, false);
+		c3.movePosition(200);
+		c3.addObject(&model);
+
+		// tick by tick, after jumps ahead and back
+		for (int tick = 0; tick < 300; ++tick)
+		{
+			const float expected = tick < 100 ? 0.1f : tick < 200 ? 0.2f : 0.3f;
+			QCOMPARE(song->automatedValuesAt(tick)[&model], expected);
+		}
+		QCOMPARE(song->automatedValuesAt(150)[&model], 0.2f);
+		QCOMPARE(song->automatedValuesAt(5000)[&model], 0.3f);
+		QCOMPARE(song->automatedValuesAt(50)[&model], 0.1f);
+
+		// moving a clip is picked up
+		c2.movePosition(250);
+		QCOMPARE(song->automatedValuesAt(150)[&model], 0.1f);
+		QCOMPARE(song->automatedValuesAt(260)[&model], 0.2f);
+	}
+
 	void testLengthRespected()
 	{
 		using namespace lmms;